@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <mutex>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "decaf/lang/Monitor.hpp"
+#include "decaf/lang/MonitorProfiler.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/ObjectHeader.hpp"
+#include "decaf/lang/SlabAllocator.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, bench)
+
+namespace {
+
+struct Benchmark {
+    std::string m_name;
+    size_t m_threads;
+    Function m_function;
+};
+
+struct Result {
+    std::string m_name;
+    size_t m_threads;
+    uint64_t m_iterations;
+    size_t m_samples;
+    double m_mean;
+    double m_min;
+    double m_p50;
+    double m_p90;
+    double m_p99;
+    double m_max;
+    double m_opsPerSecond;
+    std::map<std::string, double> m_counters;
+};
+
+struct Options {
+    Options() : m_list(false), m_samples(30), m_warmupNanos(50000000), m_sampleNanos(5000000) { }
+
+    std::string m_filter;
+    std::string m_json;
+    bool m_list;
+    size_t m_samples;
+    uint64_t m_warmupNanos;
+    uint64_t m_sampleNanos;
+};
+
+std::vector<Benchmark>& registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+std::mutex s_countersMutex;
+std::map<std::string, double> s_counters;
+
+uint64_t now() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<uint64_t> (time.tv_sec) * 1000000000u + static_cast<uint64_t> (time.tv_nsec);
+}
+
+/*
+ * Runs one batch of iterations on every thread of the benchmark and returns
+ * the wall time it took, in nanoseconds. Threads are started before the clock
+ * and released together.
+ */
+uint64_t runBatch(const Benchmark& benchmark, uint64_t iterations) {
+    if (benchmark.m_threads == 1) {
+        Batch batch(iterations, 0, 1);
+        const uint64_t start = now();
+        benchmark.m_function(batch);
+        return now() - start;
+    }
+
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < benchmark.m_threads; ++i) {
+        threads.emplace_back([&benchmark, &ready, &go, iterations, i]() {
+            Batch batch(iterations, i, benchmark.m_threads);
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire))
+                sched_yield();
+            benchmark.m_function(batch);
+        });
+    }
+    while (ready.load() < benchmark.m_threads)
+        sched_yield();
+
+    const uint64_t start = now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& thread : threads)
+        thread.join();
+    return now() - start;
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    const size_t rank = static_cast<size_t> (fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+Result run(const Benchmark& benchmark, const Options& options) {
+    {
+        std::lock_guard<std::mutex> guard(s_countersMutex);
+        s_counters.clear();
+    }
+
+    // The first call does whatever lazy set-up the benchmark needs. Then grow
+    // the batch until it takes a sample's worth of time, and keep running it
+    // until the warm-up time is used up.
+    const uint64_t warmupStart = now();
+    runBatch(benchmark, 1);
+    uint64_t iterations = 1;
+    while (runBatch(benchmark, iterations) < options.m_sampleNanos && iterations < (1ull << 40))
+        iterations *= 2;
+    while (now() - warmupStart < options.m_warmupNanos)
+        runBatch(benchmark, iterations);
+
+    std::vector<double> samples;
+    double totalNanos = 0;
+    for (size_t i = 0; i < options.m_samples; ++i) {
+        const uint64_t elapsed = runBatch(benchmark, iterations);
+        totalNanos += elapsed;
+        samples.push_back(static_cast<double> (elapsed) / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.m_name = benchmark.m_name;
+    result.m_threads = benchmark.m_threads;
+    result.m_iterations = iterations;
+    result.m_samples = samples.size();
+    result.m_mean = totalNanos / (static_cast<double> (iterations) * samples.size());
+    result.m_min = samples.front();
+    result.m_p50 = percentile(samples, 0.50);
+    result.m_p90 = percentile(samples, 0.90);
+    result.m_p99 = percentile(samples, 0.99);
+    result.m_max = samples.back();
+    result.m_opsPerSecond = 1e9 * benchmark.m_threads / result.m_mean;
+
+    std::lock_guard<std::mutex> guard(s_countersMutex);
+    result.m_counters = s_counters;
+    return result;
+}
+
+void printResult(const Result& result) {
+    printf("%-48s %3zu %12llu %10.2f %10.2f %10.2f %10.2f %10.3f\n", result.m_name.c_str(),
+      result.m_threads, static_cast<unsigned long long> (result.m_iterations), result.m_mean,
+      result.m_p50, result.m_p90, result.m_p99, result.m_opsPerSecond / 1e6);
+    for (const auto& counter : result.m_counters)
+        printf("    %-44s %g\n", counter.first.c_str(), counter.second);
+    fflush(stdout);
+}
+
+std::string quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+void writeJson(FILE* out, const std::vector<Result>& results) {
+    char date[32];
+    const time_t seconds = time(0);
+    strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%SZ", gmtime(&seconds));
+
+    fprintf(out, "{\n  \"context\": {\n");
+    fprintf(out, "    \"date\": \"%s\",\n", date);
+    fprintf(out, "    \"cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+    fprintf(out, "    \"compiler\": %s,\n", quote(__VERSION__).c_str());
+    fprintf(out, "    \"sizeof_object\": %zu,\n", sizeof (lang::Object));
+    fprintf(out, "    \"sizeof_monitor\": %zu,\n", sizeof (lang::detail::Monitor));
+    fprintf(out, "    \"biased_locking\": %s,\n",
+      lang::detail::ObjectHeader::isBiasingEnabled() ? "true" : "false");
+    fprintf(out, "    \"slab_allocator\": %s,\n",
+      lang::detail::SlabAllocator::isEnabledForObjects() ? "true" : "false");
+    fprintf(out, "    \"monitor_profiler\": %s\n",
+      lang::MonitorProfiler::isEnabled() ? "true" : "false");
+    fprintf(out, "  },\n  \"benchmarks\": [");
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        fprintf(out, "%s\n    {\"name\": %s, \"threads\": %zu, \"iterations\": %llu, "
+          "\"samples\": %zu, \"ns_per_op\": %.3f, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+          "\"p99\": %.3f, \"max\": %.3f, \"ops_per_sec\": %.1f", (i == 0) ? "" : ",",
+          quote(result.m_name).c_str(), result.m_threads,
+          static_cast<unsigned long long> (result.m_iterations), result.m_samples, result.m_mean,
+          result.m_min, result.m_p50, result.m_p90, result.m_p99, result.m_max,
+          result.m_opsPerSecond);
+        if (!result.m_counters.empty()) {
+            fprintf(out, ", \"counters\": {");
+            const char* separator = "";
+            for (const auto& counter : result.m_counters) {
+                fprintf(out, "%s%s: %g", separator, quote(counter.first).c_str(), counter.second);
+                separator = ", ";
+            }
+            fprintf(out, "}");
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+void usage(const char* program) {
+    fprintf(stderr,
+      "usage: %s [options]\n"
+      "  --filter=TEXT     run only the benchmarks whose name contains TEXT\n"
+      "  --list            list the benchmarks and exit\n"
+      "  --json=FILE       also write the results as JSON to FILE (- for stdout)\n"
+      "  --samples=N       timed samples per benchmark (default 30)\n"
+      "  --warmup-ms=N     warm-up time per benchmark (default 50)\n"
+      "  --sample-ms=N     minimum duration of a sample (default 5)\n", program);
+}
+
+bool parse(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        const size_t equals = argument.find('=');
+        const std::string name = argument.substr(0, equals);
+        const std::string value = (equals == std::string::npos) ? "" : argument.substr(equals + 1);
+
+        if (name == "--filter")
+            options.m_filter = value;
+        else if (name == "--list")
+            options.m_list = true;
+        else if (name == "--json")
+            options.m_json = value;
+        else if (name == "--samples" && atol(value.c_str()) > 0)
+            options.m_samples = atol(value.c_str());
+        else if (name == "--warmup-ms")
+            options.m_warmupNanos = strtoull(value.c_str(), 0, 10) * 1000000u;
+        else if (name == "--sample-ms" && atol(value.c_str()) > 0)
+            options.m_sampleNanos = strtoull(value.c_str(), 0, 10) * 1000000u;
+        else
+            return false;
+    }
+    return true;
+}
+
+}
+
+// ----------------------------------------------------------------------------
+
+void Batch::setCounter(const std::string& name, double value) {
+    std::lock_guard<std::mutex> guard(s_countersMutex);
+    s_counters[name] = value;
+}
+
+// ----------------------------------------------------------------------------
+
+Registration::Registration(const char* name, size_t threads, Function function) {
+    Benchmark benchmark = { name, threads, function };
+    registry().push_back(benchmark);
+}
+
+// ----------------------------------------------------------------------------
+
+int runSuite(int argc, char* argv[]) {
+    Options options;
+    if (!parse(argc, argv, options)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Benchmark> benchmarks;
+    for (const Benchmark& benchmark : registry()) {
+        if (benchmark.m_name.find(options.m_filter) != std::string::npos)
+            benchmarks.push_back(benchmark);
+    }
+    std::stable_sort(benchmarks.begin(), benchmarks.end(),
+      [](const Benchmark& lhs, const Benchmark& rhs) { return lhs.m_name < rhs.m_name; });
+
+    if (options.m_list) {
+        for (const Benchmark& benchmark : benchmarks)
+            printf("%s (%zu threads)\n", benchmark.m_name.c_str(), benchmark.m_threads);
+        return 0;
+    }
+
+    printf("%-48s %3s %12s %10s %10s %10s %10s %10s\n", "benchmark", "thr", "iterations",
+      "ns/op", "p50", "p90", "p99", "Mops/s");
+    std::vector<Result> results;
+    for (const Benchmark& benchmark : benchmarks) {
+        results.push_back(run(benchmark, options));
+        printResult(results.back());
+    }
+
+    if (!options.m_json.empty()) {
+        FILE* out = (options.m_json == "-") ? stdout : fopen(options.m_json.c_str(), "w");
+        if (out == 0) {
+            perror(options.m_json.c_str());
+            return 1;
+        }
+        writeJson(out, results);
+        if (out != stdout)
+            fclose(out);
+    }
+    return 0;
+}
+
+DECAF_CLOSE_NAMESPACE2
+
+int main(int argc, char* argv[]) {
+    return decaf::bench::runSuite(argc, argv);
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_BENCH_BENCHMARK_HPP
+#define DECAF_BENCH_BENCHMARK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "decaf/lang/compatibility.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, bench)
+
+/**
+ * What a benchmark function is asked to do: run its operation iterations()
+ * times, on behalf of thread threadIndex() of threads(). The harness times
+ * the whole call, so any set-up a function does is amortized over the batch;
+ * state shared by the threads of a benchmark lives in function-local statics.
+ */
+class Batch {
+  public:
+    Batch(uint64_t iterations, size_t threadIndex, size_t threads) :
+      m_iterations(iterations), m_threadIndex(threadIndex), m_threads(threads) { }
+
+    uint64_t iterations() const {
+        return m_iterations;
+    }
+
+    size_t threadIndex() const {
+        return m_threadIndex;
+    }
+
+    size_t threads() const {
+        return m_threads;
+    }
+
+    /**
+     * Reports a value other than time along with the results, e.g. the number
+     * of hash collisions. The value of the last batch wins.
+     */
+    void setCounter(const std::string& name, double value);
+
+  private:
+    uint64_t m_iterations;
+    size_t m_threadIndex;
+    size_t m_threads;
+};
+
+typedef void (*Function)(Batch& batch);
+
+/**
+ * Adds a benchmark to the suite; see DECAF_BENCHMARK.
+ */
+class Registration {
+  public:
+    Registration(const char* name, size_t threads, Function function);
+};
+
+/**
+ * Keeps the compiler from optimizing @a value, and the computation of it,
+ * away.
+ */
+template<typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m" (value) : "memory");
+}
+
+DECAF_CLOSE_NAMESPACE2
+
+/**
+ * Registers @a function under @a name, to be run by @a threads threads at
+ * once. Names are grouped as "Class/operation".
+ */
+#define DECAF_BENCHMARK(name, function, threads) \
+    static decaf::bench::Registration DECAF_UNIQUE_IDENTIFIER(decaf_benchmark_)(name, threads, function)
+
+#endif // DECAF_BENCH_BENCHMARK_HPP
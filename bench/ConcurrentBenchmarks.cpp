@@ -0,0 +1,1399 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <sys/prctl.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "decaf/util/concurrent/CountDownLatch.hpp"
+#include "decaf/util/concurrent/CyclicBarrier.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/ForkJoinPool.hpp"
+#include "decaf/util/concurrent/Phaser.hpp"
+#include "decaf/util/concurrent/RecursiveAction.hpp"
+#include "decaf/util/concurrent/RecursiveTask.hpp"
+#include "decaf/util/concurrent/Semaphore.hpp"
+#include "decaf/util/concurrent/Stopwatch.hpp"
+#include "decaf/util/concurrent/ThreadPoolExecutor.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+#include "decaf/util/concurrent/TimingWheelExecutor.hpp"
+#include "decaf/util/concurrent/locks/ConditionObject.hpp"
+#include "decaf/util/concurrent/locks/HybridLock.hpp"
+#include "decaf/util/concurrent/locks/LockGuard.hpp"
+#include "decaf/util/concurrent/locks/MCSLock.hpp"
+#include "decaf/util/concurrent/locks/ReentrantLock.hpp"
+#include "decaf/util/concurrent/locks/ReentrantReadWriteLock.hpp"
+#include "decaf/util/concurrent/locks/SpinLock.hpp"
+#include "decaf/util/concurrent/locks/StampedLock.hpp"
+#include "decaf/util/concurrent/locks/TicketLock.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, bench)
+
+using decaf::util::concurrent::CountDownLatch;
+using decaf::util::concurrent::CyclicBarrier;
+using decaf::util::concurrent::Deadline;
+using decaf::util::concurrent::ForkJoinPool;
+using decaf::util::concurrent::Phaser;
+using decaf::util::concurrent::RecursiveAction;
+using decaf::util::concurrent::RecursiveTask;
+using decaf::util::concurrent::ScheduledFuture;
+using decaf::util::concurrent::Semaphore;
+using decaf::util::concurrent::Stopwatch;
+using decaf::util::concurrent::ThreadPoolExecutor;
+using decaf::util::concurrent::TimeUnit;
+using decaf::util::concurrent::TimingWheelExecutor;
+using decaf::util::concurrent::locks::ConditionObject;
+using decaf::util::concurrent::locks::HybridLock;
+using decaf::util::concurrent::locks::Lock;
+using decaf::util::concurrent::locks::LockGuard;
+using decaf::util::concurrent::locks::MCSLock;
+using decaf::util::concurrent::locks::ReentrantLock;
+using decaf::util::concurrent::locks::ReentrantReadWriteLock;
+using decaf::util::concurrent::locks::SpinLock;
+using decaf::util::concurrent::locks::StampedLock;
+using decaf::util::concurrent::locks::TicketLock;
+
+namespace {
+
+// ----- ReentrantLock --------------------------------------------------------
+
+void reentrantLockUncontended(Batch& batch) {
+    ReentrantLock lock;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        lock.lock();
+        doNotOptimize(lock);
+        lock.unlock();
+    }
+}
+
+/*
+ * The threads increment a shared counter under the lock; the counters report
+ * the worst wait of this thread for the lock, which shows starvation.
+ */
+void lockContended(ReentrantLock& lock, Batch& batch) {
+    static int64_t value = 0;
+    uint64_t worst = 0;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        lock.lock();
+        const uint64_t waited = static_cast<uint64_t> (std::chrono::duration_cast<std::chrono::nanoseconds> (
+          std::chrono::steady_clock::now() - start).count());
+        worst = std::max(worst, waited);
+        ++value;
+        lock.unlock();
+    }
+    batch.setCounter("worst-wait-ns", static_cast<double> (worst));
+}
+
+void reentrantLockContended(Batch& batch) {
+    static ReentrantLock lock;
+    lockContended(lock, batch);
+}
+
+void fairReentrantLockUncontended(Batch& batch) {
+    ReentrantLock lock(true);
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        lock.lock();
+        doNotOptimize(lock);
+        lock.unlock();
+    }
+}
+
+/*
+ * Under contention every release hands the lock over to the next queued
+ * thread: the price of fairness next to reentrantLockContended.
+ */
+void fairReentrantLockContended(Batch& batch) {
+    static ReentrantLock lock(true);
+    lockContended(lock, batch);
+}
+
+void reentrantLockTryLock(Batch& batch) {
+    ReentrantLock lock;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        if (lock.tryLock())
+            lock.unlock();
+    }
+}
+
+void reentrantLockTimedTryLock(Batch& batch) {
+    ReentrantLock lock;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        if (lock.tryLock(10, TimeUnit::MILLISECONDS))
+            lock.unlock();
+    }
+}
+
+/*
+ * A lock some other thread holds for good, so that every timed attempt on it
+ * expires.
+ */
+ReentrantLock& heldReentrantLock() {
+    static ReentrantLock lock;
+    static const bool held = []() {
+        std::thread([]() {
+            lock.lock();
+            for (;;)
+                std::this_thread::sleep_for(std::chrono::hours(1));
+        }).detach();
+        while (lock.tryLock())
+            lock.unlock();
+        return true;
+    }();
+    doNotOptimize(held);
+    return lock;
+}
+
+/*
+ * Times out on a lock some other thread holds for good: measures how late
+ * a 100us timeout fires.
+ */
+void reentrantLockTimedTryLockExpires(Batch& batch) {
+    ReentrantLock& lock = heldReentrantLock();
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(lock.tryLock(100, TimeUnit::MICROSECONDS));
+}
+
+DECAF_BENCHMARK("ReentrantLock/lock-unlock", reentrantLockUncontended, 1);
+DECAF_BENCHMARK("ReentrantLock/lock-unlock", reentrantLockContended, 4);
+DECAF_BENCHMARK("ReentrantLock/lock-unlock", reentrantLockContended, 16);
+DECAF_BENCHMARK("ReentrantLock/fair-lock-unlock", fairReentrantLockUncontended, 1);
+DECAF_BENCHMARK("ReentrantLock/fair-lock-unlock", fairReentrantLockContended, 4);
+DECAF_BENCHMARK("ReentrantLock/fair-lock-unlock", fairReentrantLockContended, 16);
+DECAF_BENCHMARK("ReentrantLock/tryLock", reentrantLockTryLock, 1);
+DECAF_BENCHMARK("ReentrantLock/tryLock-timed", reentrantLockTimedTryLock, 1);
+DECAF_BENCHMARK("ReentrantLock/tryLock-timed-expiring-100us", reentrantLockTimedTryLockExpires, 1);
+
+// ----- ReentrantReadWriteLock -----------------------------------------------
+
+/*
+ * Every thread takes the same read lock: the cost of a read-side critical
+ * section should stay flat as threads are added, which a single reader count
+ * cannot do.
+ */
+void readWriteLockRead(Batch& batch) {
+    static ReentrantReadWriteLock lock;
+    static uint64_t value = 0;
+    ReentrantReadWriteLock::ReadLock* readLock = lock.readLock();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        readLock->lock();
+        doNotOptimize(value);
+        readLock->unlock();
+    }
+}
+
+void pthreadRwlockRead(Batch& batch) {
+    static pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    static uint64_t value = 0;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        pthread_rwlock_rdlock(&lock);
+        doNotOptimize(value);
+        pthread_rwlock_unlock(&lock);
+    }
+}
+
+/*
+ * Thread 0 writes once every 1024 operations, the others only read: the
+ * writer pays for revoking the reader bias, which must stay rare enough not
+ * to matter.
+ */
+void readWriteLockReadMostly(Batch& batch) {
+    static ReentrantReadWriteLock lock;
+    static uint64_t value = 0;
+    const bool writer = (batch.threadIndex() == 0);
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        if (writer && i % 1024 == 0) {
+            lock.writeLock()->lock();
+            ++value;
+            lock.writeLock()->unlock();
+        } else {
+            lock.readLock()->lock();
+            doNotOptimize(value);
+            lock.readLock()->unlock();
+        }
+    }
+}
+
+void pthreadRwlockReadMostly(Batch& batch) {
+    static pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    static uint64_t value = 0;
+    const bool writer = (batch.threadIndex() == 0);
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        if (writer && i % 1024 == 0) {
+            pthread_rwlock_wrlock(&lock);
+            ++value;
+            pthread_rwlock_unlock(&lock);
+        } else {
+            pthread_rwlock_rdlock(&lock);
+            doNotOptimize(value);
+            pthread_rwlock_unlock(&lock);
+        }
+    }
+}
+
+void readWriteLockWrite(Batch& batch) {
+    ReentrantReadWriteLock lock;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        lock.writeLock()->lock();
+        doNotOptimize(lock);
+        lock.writeLock()->unlock();
+    }
+}
+
+/*
+ * Registers a reader-scaling series of @a function: 1, 2, 4, ... threads, up
+ * to every processor.
+ */
+void registerReaderScaling(const char* name, Function function) {
+    const size_t processors = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads < processors; threads *= 2)
+        Registration(name, threads, function);
+    Registration(name, processors, function);
+}
+
+const bool readerScaling = (
+  registerReaderScaling("ReentrantReadWriteLock/read", readWriteLockRead),
+  registerReaderScaling("pthread_rwlock/read", pthreadRwlockRead),
+  registerReaderScaling("ReentrantReadWriteLock/read-mostly", readWriteLockReadMostly),
+  registerReaderScaling("pthread_rwlock/read-mostly", pthreadRwlockReadMostly),
+  true);
+
+DECAF_BENCHMARK("ReentrantReadWriteLock/write", readWriteLockWrite, 1);
+
+// ----- StampedLock ----------------------------------------------------------
+
+/*
+ * A configuration snapshot of two fields, read through optimistic reads that
+ * fall back on the read lock; thread 0 writes once every writeEvery
+ * operations unless writeEvery is zero.
+ */
+void stampedLockOptimistic(Batch& batch, uint64_t writeEvery) {
+    static StampedLock lock;
+    static std::atomic<uint64_t> low(0), high(0);
+    const bool writer = (batch.threadIndex() == 0 && writeEvery != 0);
+    uint64_t retries = 0;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        if (writer && i % writeEvery == 0) {
+            const uint64_t stamp = lock.writeLock();
+            low.store(i, std::memory_order_relaxed);
+            high.store(i, std::memory_order_relaxed);
+            lock.unlockWrite(stamp);
+            continue;
+        }
+
+        uint64_t stamp = lock.tryOptimisticRead();
+        uint64_t sum = low.load(std::memory_order_relaxed) + high.load(std::memory_order_relaxed);
+        if (!lock.validate(stamp)) {
+            ++retries;
+            stamp = lock.readLock();
+            sum = low.load(std::memory_order_relaxed) + high.load(std::memory_order_relaxed);
+            lock.unlockRead(stamp);
+        }
+        doNotOptimize(sum);
+    }
+    batch.setCounter("read-lock-fallbacks", static_cast<double> (retries));
+}
+
+void stampedLockOptimisticRead(Batch& batch) {
+    stampedLockOptimistic(batch, 0);
+}
+
+void stampedLockOptimisticReadMostly(Batch& batch) {
+    stampedLockOptimistic(batch, 1024);
+}
+
+void stampedLockRead(Batch& batch) {
+    static StampedLock lock;
+    static uint64_t value = 0;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const uint64_t stamp = lock.readLock();
+        doNotOptimize(value);
+        lock.unlockRead(stamp);
+    }
+}
+
+void stampedLockWrite(Batch& batch) {
+    StampedLock lock;
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        lock.unlockWrite(lock.writeLock());
+}
+
+/*
+ * The Lock view, as a drop-in replacement of a ReentrantLock.
+ */
+void stampedLockWriteView(Batch& batch) {
+    StampedLock stampedLock;
+    Lock* lock = stampedLock.asWriteLock();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        lock->lock();
+        doNotOptimize(lock);
+        lock->unlock();
+    }
+}
+
+const bool stampedReaderScaling = (
+  registerReaderScaling("StampedLock/optimistic-read", stampedLockOptimisticRead),
+  registerReaderScaling("StampedLock/optimistic-read-mostly", stampedLockOptimisticReadMostly),
+  registerReaderScaling("StampedLock/read", stampedLockRead),
+  true);
+
+DECAF_BENCHMARK("StampedLock/write", stampedLockWrite, 1);
+DECAF_BENCHMARK("StampedLock/asWriteLock", stampedLockWriteView, 1);
+
+// ----- Lock policies --------------------------------------------------------
+
+/*
+ * pthread_mutex_t with the lock() and unlock() of a Lock, for LockGuard.
+ */
+class PthreadMutex {
+  public:
+    PthreadMutex() {
+        pthread_mutex_init(&m_mutex, 0);
+    }
+
+    ~PthreadMutex() {
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    void lock() {
+        pthread_mutex_lock(&m_mutex);
+    }
+
+    void unlock() {
+        pthread_mutex_unlock(&m_mutex);
+    }
+
+  private:
+    pthread_mutex_t m_mutex;
+};
+
+/*
+ * The lengths of the critical sections, in dependent multiply-adds of about
+ * three cycles each: empty, short, and long enough for spinning to stop
+ * paying off.
+ */
+constexpr uint32_t CRITICAL_SECTIONS[] = { 0, 64, 512 };
+
+/*
+ * The threads go through a critical section of WORK steps on shared data,
+ * holding the lock L through a LockGuard<G>: with G = L the lock calls of the
+ * final lock types inline, with G = Lock they stay virtual. The compiler must
+ * not see which lock it is given, or it would devirtualize the calls anyway.
+ */
+template<typename L, typename G, uint32_t WORK>
+void lockPolicy(Batch& batch) {
+    static L lock;
+    static uint64_t shared = 0;
+    G* opaque = &lock;
+    asm volatile("" : "+r" (opaque));
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        LockGuard<G> guard(*opaque);
+        uint64_t value = shared;
+        for (uint32_t step = 0; step < WORK; ++step)
+            value = value * 31 + step;
+        shared = value + 1;
+    }
+}
+
+struct LockPolicy {
+    const char* m_name;
+    Function m_functions[3];
+};
+
+template<typename L, typename G = L>
+LockPolicy lockPolicyOf(const char* name) {
+    const LockPolicy policy = { name, { lockPolicy<L, G, CRITICAL_SECTIONS[0]>,
+      lockPolicy<L, G, CRITICAL_SECTIONS[1]>, lockPolicy<L, G, CRITICAL_SECTIONS[2]> } };
+    return policy;
+}
+
+/*
+ * Registers every lock for every critical section length at 1, 4 and 16
+ * threads, grouped so that a filter on "LockPolicy/cs64/" lists the locks
+ * side by side.
+ */
+bool registerLockPolicies() {
+    const LockPolicy policies[] = {
+        lockPolicyOf<SpinLock>("SpinLock"),
+        lockPolicyOf<SpinLock, Lock>("SpinLock-virtual"),
+        lockPolicyOf<TicketLock>("TicketLock"),
+        lockPolicyOf<MCSLock>("MCSLock"),
+        lockPolicyOf<HybridLock>("HybridLock"),
+        lockPolicyOf<ReentrantLock>("ReentrantLock"),
+        lockPolicyOf<PthreadMutex>("pthread_mutex"),
+        lockPolicyOf<std::mutex>("std::mutex")
+    };
+    const size_t threads[] = { 1, 4, 16 };
+
+    for (size_t length = 0; length < 3; ++length) {
+        for (size_t t = 0; t < 3; ++t) {
+            for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); ++p) {
+                const std::string name = std::string("LockPolicy/cs") + std::to_string(CRITICAL_SECTIONS[length]) +
+                  "/" + policies[p].m_name;
+                Registration(name.c_str(), threads[t], policies[p].m_functions[length]);
+            }
+        }
+    }
+    return true;
+}
+
+const bool lockPolicies = registerLockPolicies();
+
+// ----- ConditionObject ------------------------------------------------------
+
+/*
+ * The ReentrantLock counterpart of Object/wait-notify-ping-pong.
+ */
+void conditionPingPong(Batch& batch) {
+    static ReentrantLock lock;
+    static ConditionObject turn(lock);
+    static int64_t value = 0;
+    const int64_t self = batch.threadIndex();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        lock.lock();
+        while (value % 2 != self)
+            turn.await();
+        ++value;
+        turn.signal();
+        lock.unlock();
+    }
+}
+
+/*
+ * The ReentrantLock counterpart of Object/wait-notifyAll-producer-consumer,
+ * with a condition per side, as the monitor cannot have.
+ */
+void conditionProducerConsumer(Batch& batch) {
+    static const uint64_t CAPACITY = 64;
+    static ReentrantLock lock;
+    static ConditionObject notFull(lock), notEmpty(lock);
+    static uint64_t items[CAPACITY];
+    static uint64_t head = 0, tail = 0;
+
+    const bool producer = (batch.threadIndex() == 0);
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        lock.lock();
+        if (producer) {
+            while (tail - head == CAPACITY)
+                notFull.await();
+            items[tail++ % CAPACITY] = i;
+            notEmpty.signal();
+        } else {
+            while (tail == head)
+                notEmpty.await();
+            doNotOptimize(items[head++ % CAPACITY]);
+            notFull.signal();
+        }
+        lock.unlock();
+    }
+}
+
+/*
+ * One thread signals a crowd with signalAll() and waits for all of them to
+ * have gone through the lock: the woken threads are handed the lock one
+ * release at a time instead of all contending for it at once.
+ */
+void conditionSignalAll(Batch& batch) {
+    static ReentrantLock lock;
+    static ConditionObject changed(lock), allArrived(lock);
+    static uint64_t generation = 0;
+    static uint64_t arrived = 0;
+
+    const uint64_t waiters = static_cast<uint64_t> (batch.threads()) - 1;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        lock.lock();
+        if (batch.threadIndex() == 0) {
+            while (arrived != waiters)
+                allArrived.await();
+            arrived = 0;
+            ++generation;
+            changed.signalAll();
+        } else {
+            const uint64_t seen = generation;
+            ++arrived;
+            if (arrived == waiters)
+                allArrived.signal();
+            while (generation == seen)
+                changed.await();
+        }
+        lock.unlock();
+    }
+}
+
+DECAF_BENCHMARK("ConditionObject/ping-pong", conditionPingPong, 2);
+DECAF_BENCHMARK("ConditionObject/producer-consumer", conditionProducerConsumer, 2);
+DECAF_BENCHMARK("ConditionObject/signalAll", conditionSignalAll, 8);
+
+// ----- Semaphore ------------------------------------------------------------
+
+void semaphoreUncontended(Batch& batch) {
+    Semaphore semaphore(1);
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        semaphore.acquire();
+        doNotOptimize(semaphore);
+        semaphore.release();
+    }
+}
+
+/*
+ * Twice as many threads as permits: in fair mode every release hands its
+ * permit over to the longest waiting thread.
+ */
+template<bool FAIR>
+void semaphoreContended(Batch& batch) {
+    static Semaphore semaphore(2, FAIR);
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        semaphore.acquire();
+        doNotOptimize(i);
+        semaphore.release();
+    }
+}
+
+/*
+ * The threads take one to four of eight permits at a time: a waiter for many
+ * permits must not be overtaken forever by waiters for few.
+ */
+void semaphoreBulk(Batch& batch) {
+    static Semaphore semaphore(8, true);
+    const int32_t permits = static_cast<int32_t> (batch.threadIndex() % 4) + 1;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        semaphore.acquire(permits);
+        doNotOptimize(i);
+        semaphore.release(permits);
+    }
+}
+
+DECAF_BENCHMARK("Semaphore/acquire-release", semaphoreUncontended, 1);
+DECAF_BENCHMARK("Semaphore/acquire-release-2-permits", semaphoreContended<false>, 4);
+DECAF_BENCHMARK("Semaphore/acquire-release-2-permits", semaphoreContended<false>, 16);
+DECAF_BENCHMARK("Semaphore/fair-acquire-release-2-permits", semaphoreContended<true>, 4);
+DECAF_BENCHMARK("Semaphore/fair-acquire-release-2-permits", semaphoreContended<true>, 16);
+DECAF_BENCHMARK("Semaphore/bulk-acquire-release-8-permits", semaphoreBulk, 8);
+
+// ----- CountDownLatch -------------------------------------------------------
+
+void countDownLatchCountDown(Batch& batch) {
+    static CountDownLatch latch(INT32_MAX);
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        latch.countDown();
+}
+
+/*
+ * Waiting on a latch already counted down: the hot path of a latch used as a
+ * one-time initialization gate.
+ */
+void countDownLatchAwaitOpen(Batch& batch) {
+    static CountDownLatch latch(0);
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        latch.await();
+}
+
+DECAF_BENCHMARK("CountDownLatch/countDown", countDownLatchCountDown, 1);
+DECAF_BENCHMARK("CountDownLatch/countDown", countDownLatchCountDown, 4);
+DECAF_BENCHMARK("CountDownLatch/await-open", countDownLatchAwaitOpen, 4);
+
+// ----- CyclicBarrier --------------------------------------------------------
+
+/*
+ * A barrier as hand-rolled on ReentrantLock before CyclicBarrier: every
+ * arrival and every wakeup goes through the one lock.
+ */
+class LockBarrier {
+  public:
+    explicit LockBarrier(uint64_t parties) : m_tripped(m_lock), m_parties(parties), m_arrived(0),
+      m_generation(0) { }
+
+    void await() {
+        m_lock.lock();
+        if (++m_arrived == m_parties) {
+            m_arrived = 0;
+            ++m_generation;
+            m_tripped.signalAll();
+        } else {
+            const uint64_t generation = m_generation;
+            while (generation == m_generation)
+                m_tripped.await();
+        }
+        m_lock.unlock();
+    }
+
+  private:
+    ReentrantLock m_lock;
+    ConditionObject m_tripped;
+    const uint64_t m_parties;
+    uint64_t m_arrived;
+    uint64_t m_generation;
+};
+
+template<int32_t PARTIES>
+void cyclicBarrierAwait(Batch& batch) {
+    static CyclicBarrier barrier(PARTIES);
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        barrier.await();
+}
+
+/*
+ * Three threads per party, so that the next generation fills the tree while
+ * the last one is still being released. Threads take their turns from a
+ * shared count, which keeps any of them from being left at the barrier
+ * without enough others to trip it.
+ */
+template<int32_t PARTIES>
+void cyclicBarrierAwaitOversubscribed(Batch& batch) {
+    static CyclicBarrier barrier(PARTIES);
+    static CyclicBarrier start(static_cast<int32_t> (batch.threads()));
+    static std::atomic<int64_t> turns(0);
+
+    turns.fetch_add(static_cast<int64_t> (batch.iterations()), std::memory_order_relaxed);
+    start.await();
+    while (turns.fetch_sub(1, std::memory_order_relaxed) > 0)
+        barrier.await();
+    turns.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<int32_t PARTIES>
+void lockBarrierAwait(Batch& batch) {
+    static LockBarrier barrier(PARTIES);
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        barrier.await();
+}
+
+DECAF_BENCHMARK("CyclicBarrier/await", cyclicBarrierAwait<2>, 2);
+DECAF_BENCHMARK("CyclicBarrier/await", cyclicBarrierAwait<4>, 4);
+DECAF_BENCHMARK("CyclicBarrier/await", cyclicBarrierAwait<16>, 16);
+DECAF_BENCHMARK("CyclicBarrier/await", cyclicBarrierAwait<128>, 128);
+DECAF_BENCHMARK("CyclicBarrier/await-oversubscribed", cyclicBarrierAwaitOversubscribed<16>, 48);
+DECAF_BENCHMARK("ReentrantLock-barrier/await", lockBarrierAwait<2>, 2);
+DECAF_BENCHMARK("ReentrantLock-barrier/await", lockBarrierAwait<4>, 4);
+DECAF_BENCHMARK("ReentrantLock-barrier/await", lockBarrierAwait<16>, 16);
+DECAF_BENCHMARK("ReentrantLock-barrier/await", lockBarrierAwait<128>, 128);
+
+// ----- Phaser ---------------------------------------------------------------
+
+/*
+ * Builds a tree of phasers under @a phaser with four parties per leaf and
+ * four children per inner phaser, and returns the leaves in order: thread n
+ * arrives at leaf n / 4.
+ */
+void buildPhaserTree(Phaser* phaser, int32_t parties, std::vector<Phaser*>& leaves) {
+    const int32_t groups = (parties + 3) / 4;
+    if (groups == 1) {
+        phaser->bulkRegister(parties);
+        leaves.push_back(phaser);
+        return;
+    }
+
+    const int32_t children = std::min(groups, 4);
+    for (int32_t i = 0; i < children; ++i) {
+        const int32_t childGroups = groups / children + (i < groups % children ? 1 : 0);
+        const int32_t childParties = std::min(parties, childGroups * 4);
+        buildPhaserTree(new Phaser(phaser, 0), childParties, leaves);
+        parties -= childParties;
+    }
+}
+
+template<int32_t PARTIES>
+void phaserFlat(Batch& batch) {
+    static Phaser phaser(PARTIES);
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        phaser.arriveAndAwaitAdvance();
+}
+
+/*
+ * The tiered counterpart of phaserFlat: only the last arrival at each leaf
+ * goes up to the shared phasers.
+ */
+template<int32_t PARTIES>
+void phaserTiered(Batch& batch) {
+    static Phaser root;
+    static std::vector<Phaser*> leaves;
+    static std::once_flag built;
+    std::call_once(built, [] { buildPhaserTree(&root, PARTIES, leaves); });
+
+    Phaser* leaf = leaves[batch.threadIndex() / 4];
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        leaf->arriveAndAwaitAdvance();
+}
+
+DECAF_BENCHMARK("Phaser/arriveAndAwaitAdvance", phaserFlat<2>, 2);
+DECAF_BENCHMARK("Phaser/arriveAndAwaitAdvance", phaserFlat<16>, 16);
+DECAF_BENCHMARK("Phaser/arriveAndAwaitAdvance", phaserFlat<128>, 128);
+DECAF_BENCHMARK("Phaser/tiered-arriveAndAwaitAdvance", phaserTiered<16>, 16);
+DECAF_BENCHMARK("Phaser/tiered-arriveAndAwaitAdvance", phaserTiered<128>, 128);
+
+// ----- TimeUnit -------------------------------------------------------------
+
+void timeUnitToNanos(Batch& batch) {
+    volatile uint64_t duration = 1500;
+    const TimeUnit* const units[] = { TimeUnit::MICROSECONDS, TimeUnit::MILLISECONDS,
+      TimeUnit::SECONDS, TimeUnit::MINUTES };
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(units[i & 3]->toNanos(duration));
+}
+
+void timeUnitConvert(Batch& batch) {
+    volatile uint64_t duration = 1500;
+    const TimeUnit* const units[] = { TimeUnit::NANOSECONDS, TimeUnit::MILLISECONDS,
+      TimeUnit::SECONDS, TimeUnit::HOURS };
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(units[i & 3]->convert(duration, units[(i >> 2) & 3]));
+}
+
+/*
+ * The unit is known at compile time: the conversion folds to a saturating
+ * multiplication by a constant.
+ */
+void timeUnitToNanosConstant(Batch& batch) {
+    volatile uint64_t duration = 1500;
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(TimeUnit::of<std::chrono::milliseconds>().toNanos(duration));
+}
+
+void timeUnitConvertChrono(Batch& batch) {
+    volatile int64_t duration = 1500;
+    const TimeUnit* const units[] = { TimeUnit::NANOSECONDS, TimeUnit::MILLISECONDS,
+      TimeUnit::SECONDS, TimeUnit::HOURS };
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(units[i & 3]->convert(std::chrono::milliseconds(duration)));
+}
+
+void timeUnitToDuration(Batch& batch) {
+    volatile uint64_t duration = 1500;
+    const TimeUnit* const units[] = { TimeUnit::MICROSECONDS, TimeUnit::MILLISECONDS,
+      TimeUnit::SECONDS, TimeUnit::MINUTES };
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(units[i & 3]->toDuration<std::chrono::nanoseconds>(duration).count());
+}
+
+/*
+ * The baseline for TimeUnit/toNanos-constant: std::chrono neither checks the
+ * sign nor saturates.
+ */
+void chronoDurationCast(Batch& batch) {
+    volatile int64_t duration = 1500;
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::milliseconds(duration)).count());
+}
+
+DECAF_BENCHMARK("TimeUnit/toNanos", timeUnitToNanos, 1);
+DECAF_BENCHMARK("TimeUnit/toNanos-constant", timeUnitToNanosConstant, 1);
+DECAF_BENCHMARK("TimeUnit/convert", timeUnitConvert, 1);
+DECAF_BENCHMARK("TimeUnit/convert-chrono", timeUnitConvertChrono, 1);
+DECAF_BENCHMARK("TimeUnit/toDuration", timeUnitToDuration, 1);
+DECAF_BENCHMARK("TimeUnit/std-duration_cast", chronoDurationCast, 1);
+
+// ----- Deadline -------------------------------------------------------------
+
+/*
+ * Collects how late each timed wait of a batch returned past its deadline and
+ * reports the percentiles: the accuracy of a timeout rather than its cost.
+ * Waits that return before their deadline are counted apart, as they are
+ * bugs.
+ */
+class Lateness {
+  public:
+    explicit Lateness(uint64_t iterations) : m_early(0) {
+        m_samples.reserve(iterations);
+    }
+
+    void record(uint64_t deadline) {
+        const uint64_t now = Deadline::now();
+        if (now < deadline)
+            ++m_early;
+        m_samples.push_back(now >= deadline ? now - deadline : 0);
+    }
+
+    void report(Batch& batch) {
+        std::sort(m_samples.begin(), m_samples.end());
+        const size_t last = m_samples.size() - 1;
+        batch.setCounter("late-p50-ns", static_cast<double> (m_samples[last / 2]));
+        batch.setCounter("late-p99-ns", static_cast<double> (m_samples[last * 99 / 100]));
+        batch.setCounter("late-max-ns", static_cast<double> (m_samples[last]));
+        batch.setCounter("early", static_cast<double> (m_early));
+    }
+
+  private:
+    std::vector<uint64_t> m_samples;
+    uint64_t m_early;
+};
+
+const uint64_t TIMEOUT_NANOS = 100000;
+
+/*
+ * Lowers the timer slack of the calling thread, which lets the kernel fire
+ * its timers up to 50us late by default, for as long as it is in scope.
+ */
+class NoTimerSlack {
+  public:
+    NoTimerSlack() : m_slack(static_cast<unsigned long> (prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0))) {
+        prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+    }
+
+    ~NoTimerSlack() {
+        prctl(PR_SET_TIMERSLACK, m_slack, 0, 0, 0);
+    }
+
+  private:
+    unsigned long m_slack;
+};
+
+void reentrantLockTryLockUntil(Batch& batch) {
+    ReentrantLock& lock = heldReentrantLock();
+    Lateness lateness(batch.iterations());
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const Deadline deadline = Deadline::afterNanos(TIMEOUT_NANOS);
+        doNotOptimize(lock.tryLockUntil(deadline));
+        lateness.record(deadline.nanos());
+    }
+    lateness.report(batch);
+}
+
+void conditionAwaitUntil(Batch& batch) {
+    ReentrantLock lock;
+    ConditionObject condition(lock);
+    Lateness lateness(batch.iterations());
+    lock.lock();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const Deadline deadline = Deadline::afterNanos(TIMEOUT_NANOS);
+        doNotOptimize(condition.awaitUntil(deadline));
+        lateness.record(deadline.nanos());
+    }
+    lock.unlock();
+    lateness.report(batch);
+}
+
+void reentrantLockTryLockUntilNoSlack(Batch& batch) {
+    NoTimerSlack noSlack;
+    reentrantLockTryLockUntil(batch);
+}
+
+void conditionAwaitUntilNoSlack(Batch& batch) {
+    NoTimerSlack noSlack;
+    conditionAwaitUntil(batch);
+}
+
+/*
+ * The POSIX timed lock measures its absolute timeout on CLOCK_REALTIME, the
+ * way ReentrantLock used to.
+ */
+void pthreadMutexTimedlock(Batch& batch) {
+    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    static const bool held = []() {
+        std::thread([]() {
+            pthread_mutex_lock(&mutex);
+            for (;;)
+                std::this_thread::sleep_for(std::chrono::hours(1));
+        }).detach();
+        while (pthread_mutex_trylock(&mutex) == 0)
+            pthread_mutex_unlock(&mutex);
+        return true;
+    }();
+    doNotOptimize(held);
+
+    Lateness lateness(batch.iterations());
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const uint64_t deadline = Deadline::now() + TIMEOUT_NANOS;
+        struct timespec time;
+        clock_gettime(CLOCK_REALTIME, &time);
+        time.tv_nsec += static_cast<long> (TIMEOUT_NANOS);
+        if (time.tv_nsec >= 1000000000L) {
+            time.tv_sec += 1;
+            time.tv_nsec -= 1000000000L;
+        }
+        doNotOptimize(pthread_mutex_timedlock(&mutex, &time));
+        lateness.record(deadline);
+    }
+    lateness.report(batch);
+}
+
+DECAF_BENCHMARK("Deadline/ReentrantLock-tryLockUntil-100us", reentrantLockTryLockUntil, 1);
+DECAF_BENCHMARK("Deadline/ConditionObject-awaitUntil-100us", conditionAwaitUntil, 1);
+DECAF_BENCHMARK("Deadline/pthread_mutex_timedlock-100us", pthreadMutexTimedlock, 1);
+DECAF_BENCHMARK("Deadline/ReentrantLock-tryLockUntil-100us-no-slack", reentrantLockTryLockUntilNoSlack, 1);
+DECAF_BENCHMARK("Deadline/ConditionObject-awaitUntil-100us-no-slack", conditionAwaitUntilNoSlack, 1);
+
+// ----- Sleep ----------------------------------------------------------------
+
+void timeUnitSleep(Batch& batch) {
+    Lateness lateness(batch.iterations());
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const uint64_t deadline = Deadline::now() + TIMEOUT_NANOS;
+        TimeUnit::NANOSECONDS->sleep(TIMEOUT_NANOS);
+        lateness.record(deadline);
+    }
+    lateness.report(batch);
+}
+
+/*
+ * A pacing loop: one tick every 100us, each sleeping until its own deadline.
+ */
+void timeUnitSleepUntil(Batch& batch) {
+    Lateness lateness(batch.iterations());
+    Deadline deadline = Deadline::at(Deadline::now());
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        deadline = Deadline::at(deadline.nanos() + TIMEOUT_NANOS);
+        TimeUnit::sleepUntil(deadline);
+        lateness.record(deadline.nanos());
+    }
+    lateness.report(batch);
+}
+
+void nanosleep(Batch& batch) {
+    Lateness lateness(batch.iterations());
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const uint64_t deadline = Deadline::now() + TIMEOUT_NANOS;
+        const struct timespec time = { 0, static_cast<long> (TIMEOUT_NANOS) };
+        ::nanosleep(&time, 0);
+        lateness.record(deadline);
+    }
+    lateness.report(batch);
+}
+
+void nanosleepNoSlack(Batch& batch) {
+    NoTimerSlack noSlack;
+    nanosleep(batch);
+}
+
+void stopwatchElapsed(Batch& batch) {
+    const Stopwatch stopwatch = Stopwatch::createStarted();
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(stopwatch.elapsed(TimeUnit::MICROSECONDS));
+}
+
+DECAF_BENCHMARK("Sleep/TimeUnit-sleep-100us", timeUnitSleep, 1);
+DECAF_BENCHMARK("Sleep/TimeUnit-sleepUntil-100us-pacing", timeUnitSleepUntil, 1);
+DECAF_BENCHMARK("Sleep/nanosleep-100us", nanosleep, 1);
+DECAF_BENCHMARK("Sleep/nanosleep-100us-no-slack", nanosleepNoSlack, 1);
+DECAF_BENCHMARK("Stopwatch/elapsed", stopwatchElapsed, 1);
+
+
+// ----- TimingWheelExecutor --------------------------------------------------
+
+const uint64_t PENDING_TIMERS = 10000000;
+
+class NoOp : public decaf::lang::Runnable {
+  public:
+    virtual void Run() { }
+};
+
+class CountDown : public decaf::lang::Runnable {
+  public:
+    explicit CountDown(CountDownLatch& latch) : m_latch(latch) { }
+
+    virtual void Run() {
+        m_latch.countDown();
+    }
+
+  private:
+    CountDownLatch& m_latch;
+};
+
+const decaf::lang::Ref<decaf::lang::Runnable>& noOp() {
+    static decaf::lang::Ref<decaf::lang::Runnable> command(decaf::lang::Ref<decaf::lang::Runnable>(new NoOp).share());
+    return command;
+}
+
+/*
+ * Never destroyed: cancelling the timers would only slow the exit down.
+ */
+TimingWheelExecutor& loadedWheel() {
+    static TimingWheelExecutor* executor = [] {
+        TimingWheelExecutor* wheel = new TimingWheelExecutor();
+        for (uint64_t i = 0; i < PENDING_TIMERS; ++i)
+            wheel->schedule(noOp(), 3600 + i % 3600, TimeUnit::SECONDS);
+        return wheel;
+    }();
+    return *executor;
+}
+
+typedef std::multimap<uint64_t, decaf::lang::Runnable*> TimerTree;
+
+/*
+ * The usual alternative: a balanced tree of deadlines under a lock.
+ */
+struct LockedTimerTree {
+    std::mutex m_lock;
+    TimerTree m_timers;
+};
+
+LockedTimerTree& loadedTree() {
+    static LockedTimerTree* tree = [] {
+        LockedTimerTree* timers = new LockedTimerTree();
+        const uint64_t now = Deadline::now();
+        for (uint64_t i = 0; i < PENDING_TIMERS; ++i)
+            timers->m_timers.insert(std::make_pair(now + (3600 + i % 3600) * 1000000000ull, noOp().get()));
+        return timers;
+    }();
+    return *tree;
+}
+
+void scheduleCancel(Batch& batch, TimingWheelExecutor& executor) {
+    const decaf::lang::Ref<decaf::lang::Runnable>& command = noOp();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        decaf::lang::Ref<ScheduledFuture> future = executor.schedule(command, 30 + i % 60, TimeUnit::SECONDS);
+        future->cancel(false);
+    }
+    batch.setCounter("pending", static_cast<double> (executor.getPendingCount()));
+}
+
+void timingWheelScheduleCancel(Batch& batch) {
+    static TimingWheelExecutor executor;
+    scheduleCancel(batch, executor);
+}
+
+void timingWheelScheduleCancelLoaded(Batch& batch) {
+    scheduleCancel(batch, loadedWheel());
+}
+
+void timerTreeInsertEraseLoaded(Batch& batch) {
+    LockedTimerTree& tree = loadedTree();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const uint64_t deadline = Deadline::now() + (30 + i % 60) * 1000000000ull;
+        TimerTree::iterator timer;
+        {
+            std::lock_guard<std::mutex> guard(tree.m_lock);
+            timer = tree.m_timers.insert(std::make_pair(deadline, noOp().get()));
+        }
+        std::lock_guard<std::mutex> guard(tree.m_lock);
+        tree.m_timers.erase(timer);
+    }
+    batch.setCounter("pending", static_cast<double> (tree.m_timers.size()));
+}
+
+void timingWheelExpire(Batch& batch) {
+    static TimingWheelExecutor executor(100, TimeUnit::MICROSECONDS);
+    CountDownLatch latch(static_cast<int32_t> (batch.iterations()));
+    decaf::lang::Ref<decaf::lang::Runnable> command(new CountDown(latch));
+    command.share();
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        executor.schedule(command, i % 1000, TimeUnit::MICROSECONDS);
+    latch.await();
+}
+
+DECAF_BENCHMARK("TimingWheel/schedule-cancel", timingWheelScheduleCancel, 1);
+DECAF_BENCHMARK("TimingWheel/schedule-cancel", timingWheelScheduleCancel, 4);
+DECAF_BENCHMARK("TimingWheel/schedule-cancel-10M-pending", timingWheelScheduleCancelLoaded, 1);
+DECAF_BENCHMARK("TimingWheel/schedule-cancel-10M-pending", timingWheelScheduleCancelLoaded, 4);
+DECAF_BENCHMARK("TimingWheel/multimap-insert-erase-10M-pending", timerTreeInsertEraseLoaded, 1);
+DECAF_BENCHMARK("TimingWheel/multimap-insert-erase-10M-pending", timerTreeInsertEraseLoaded, 4);
+DECAF_BENCHMARK("TimingWheel/expire-1ms-spread", timingWheelExpire, 1);
+
+
+// ----- ThreadPoolExecutor ---------------------------------------------------
+
+/*
+ * Each batch runs on a pool of its own, started before and shut down after
+ * the tasks: pool threads are not daemons, and a static pool would hold the
+ * exit up.
+ */
+void threadPoolExecute(Batch& batch, uint32_t poolSize, size_t queueCapacity) {
+    ThreadPoolExecutor executor(poolSize, poolSize, 60, TimeUnit::SECONDS, queueCapacity,
+      decaf::lang::Ref<decaf::util::concurrent::RejectedExecutionHandler>(new ThreadPoolExecutor::CallerRunsPolicy));
+    executor.prestartAllCoreThreads();
+    CountDownLatch latch(static_cast<int32_t> (batch.iterations()));
+    decaf::lang::Ref<decaf::lang::Runnable> command(new CountDown(latch));
+    command.share();
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        executor.execute(command);
+    latch.await();
+
+    batch.setCounter("cpu-ns/task", static_cast<double> (executor.getThreadGroup()->getCpuTimeNanos()) /
+      static_cast<double> (batch.iterations()));
+    executor.shutdown();
+    executor.awaitTermination(60, TimeUnit::SECONDS);
+}
+
+void threadPoolExecute1(Batch& batch) {
+    threadPoolExecute(batch, 1, ThreadPoolExecutor::UNBOUNDED);
+}
+
+void threadPoolExecute4(Batch& batch) {
+    threadPoolExecute(batch, 4, ThreadPoolExecutor::UNBOUNDED);
+}
+
+void threadPoolExecute4Bounded(Batch& batch) {
+    threadPoolExecute(batch, 4, 64);
+}
+
+/*
+ * The usual alternative: a deque under a mutex, and a condition variable
+ * signalled for every task.
+ */
+class MutexPool {
+  public:
+    explicit MutexPool(uint32_t threads) : m_stopped(false) {
+        for (uint32_t i = 0; i < threads; ++i)
+            m_threads.emplace_back(&MutexPool::work, this);
+    }
+
+    ~MutexPool() {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_stopped = true;
+        }
+        m_ready.notify_all();
+        for (std::thread& thread : m_threads)
+            thread.join();
+    }
+
+    void execute(decaf::lang::Runnable* command) {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_queue.push_back(command);
+        }
+        m_ready.notify_one();
+    }
+
+  private:
+    void work() {
+        std::unique_lock<std::mutex> guard(m_lock);
+        for (;;) {
+            m_ready.wait(guard, [this] { return m_stopped || !m_queue.empty(); });
+            if (m_queue.empty())
+                return;
+            decaf::lang::Runnable* command = m_queue.front();
+            m_queue.pop_front();
+            guard.unlock();
+            command->Run();
+            guard.lock();
+        }
+    }
+
+    std::mutex m_lock;
+    std::condition_variable m_ready;
+    std::deque<decaf::lang::Runnable*> m_queue;
+    std::vector<std::thread> m_threads;
+    bool m_stopped;
+};
+
+void mutexPoolExecute4(Batch& batch) {
+    MutexPool pool(4);
+    CountDownLatch latch(static_cast<int32_t> (batch.iterations()));
+    CountDown command(latch);
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        pool.execute(&command);
+    latch.await();
+}
+
+DECAF_BENCHMARK("ThreadPool/execute-1-thread", threadPoolExecute1, 1);
+DECAF_BENCHMARK("ThreadPool/execute-4-threads", threadPoolExecute4, 1);
+DECAF_BENCHMARK("ThreadPool/execute-4-threads-bounded-64", threadPoolExecute4Bounded, 1);
+DECAF_BENCHMARK("ThreadPool/mutex-condvar-execute-4-threads", mutexPoolExecute4, 1);
+
+
+// ----- ForkJoinPool ---------------------------------------------------------
+
+/*
+ * One pool per parallelism, 0 standing for all cores, kept for the whole
+ * run: its threads are daemons, and park between batches.
+ */
+ForkJoinPool& forkJoinPool(uint32_t parallelism) {
+    static std::map<uint32_t, ForkJoinPool*> pools;
+    ForkJoinPool*& pool = pools[parallelism];
+    if (pool == 0)
+        pool = new ForkJoinPool(parallelism == 0 ? ForkJoinPool::defaultParallelism() : parallelism);
+    return *pool;
+}
+
+void reportSteals(Batch& batch, ForkJoinPool& pool, uint64_t stealsBefore) {
+    batch.setCounter("steals/job", static_cast<double> (pool.getStealCount() - stealsBefore) /
+      static_cast<double> (batch.iterations()));
+}
+
+/*
+ * Measures the cost of forking and joining itself: the leaves do next to no
+ * work.
+ */
+class Fib : public RecursiveTask<int64_t> {
+  public:
+    explicit Fib(int32_t n) : m_n(n) { }
+
+  protected:
+    virtual int64_t compute() {
+        if (m_n < 10)
+            return sequential(m_n);
+        Fib left(m_n - 1);
+        Fib right(m_n - 2);
+        invokeAll(left, right);
+        return left.getRawResult() + right.getRawResult();
+    }
+
+  private:
+    static int64_t sequential(int32_t n) {
+        return n < 2 ? n : sequential(n - 1) + sequential(n - 2);
+    }
+
+    int32_t m_n;
+};
+
+template<uint32_t Parallelism>
+void forkJoinFib(Batch& batch) {
+    ForkJoinPool& pool = forkJoinPool(Parallelism);
+    const uint64_t steals = pool.getStealCount();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        Fib fib(27);
+        doNotOptimize(pool.invoke(fib));
+    }
+    reportSteals(batch, pool, steals);
+}
+
+/*
+ * Sorts 1M ints, splitting down to 8K runs that std::sort handles, and
+ * merging back through a buffer as the halves are joined.
+ */
+class MergeSort : public RecursiveAction {
+  public:
+    MergeSort(int32_t* data, int32_t* buffer, size_t size) : m_data(data), m_buffer(buffer), m_size(size) { }
+
+  protected:
+    virtual void compute() {
+        if (m_size <= 8192) {
+            std::sort(m_data, m_data + m_size);
+            return;
+        }
+        const size_t half = m_size / 2;
+        MergeSort left(m_data, m_buffer, half);
+        MergeSort right(m_data + half, m_buffer + half, m_size - half);
+        invokeAll(left, right);
+        std::merge(m_data, m_data + half, m_data + half, m_data + m_size, m_buffer);
+        std::copy(m_buffer, m_buffer + m_size, m_data);
+    }
+
+  private:
+    int32_t* m_data;
+    int32_t* m_buffer;
+    size_t m_size;
+};
+
+template<uint32_t Parallelism>
+void forkJoinMergeSort(Batch& batch) {
+    static const size_t SIZE = 1 << 20;
+    std::vector<int32_t> input(SIZE);
+    uint32_t seed = 2463534242u;
+    for (size_t i = 0; i < SIZE; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        input[i] = static_cast<int32_t> (seed);
+    }
+    std::vector<int32_t> data(SIZE);
+    std::vector<int32_t> buffer(SIZE);
+
+    ForkJoinPool& pool = forkJoinPool(Parallelism);
+    const uint64_t steals = pool.getStealCount();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        std::copy(input.begin(), input.end(), data.begin());
+        MergeSort sort(data.data(), buffer.data(), SIZE);
+        pool.invoke(sort);
+        doNotOptimize(data[SIZE / 2]);
+    }
+    reportSteals(batch, pool, steals);
+}
+
+/*
+ * Sums a complete binary tree of 1M heap allocated nodes, forking down to
+ * subtrees of 4K nodes: mostly pointer chasing.
+ */
+struct TreeNode {
+    int64_t m_value;
+    TreeNode* m_left;
+    TreeNode* m_right;
+};
+
+TreeNode* buildTree(uint32_t depth, int64_t& next) {
+    if (depth == 0)
+        return 0;
+    TreeNode* node = new TreeNode;
+    node->m_value = next++;
+    node->m_left = buildTree(depth - 1, next);
+    node->m_right = buildTree(depth - 1, next);
+    return node;
+}
+
+class TreeSum : public RecursiveTask<int64_t> {
+  public:
+    TreeSum(const TreeNode* node, uint32_t depth) : m_node(node), m_depth(depth) { }
+
+  protected:
+    virtual int64_t compute() {
+        if (m_depth <= 12)
+            return sequential(m_node);
+        TreeSum left(m_node->m_left, m_depth - 1);
+        TreeSum right(m_node->m_right, m_depth - 1);
+        invokeAll(left, right);
+        return m_node->m_value + left.getRawResult() + right.getRawResult();
+    }
+
+  private:
+    static int64_t sequential(const TreeNode* node) {
+        return node == 0 ? 0 : node->m_value + sequential(node->m_left) + sequential(node->m_right);
+    }
+
+    const TreeNode* m_node;
+    uint32_t m_depth;
+};
+
+template<uint32_t Parallelism>
+void forkJoinTreeSum(Batch& batch) {
+    static const uint32_t DEPTH = 20;
+    static const TreeNode* tree = 0;
+    if (tree == 0) {
+        int64_t next = 0;
+        tree = buildTree(DEPTH, next);
+    }
+
+    ForkJoinPool& pool = forkJoinPool(Parallelism);
+    const uint64_t steals = pool.getStealCount();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        TreeSum sum(tree, DEPTH);
+        doNotOptimize(pool.invoke(sum));
+    }
+    reportSteals(batch, pool, steals);
+}
+
+DECAF_BENCHMARK("ForkJoin/fib-27-1-worker", forkJoinFib<1>, 1);
+DECAF_BENCHMARK("ForkJoin/fib-27-2-workers", forkJoinFib<2>, 1);
+DECAF_BENCHMARK("ForkJoin/fib-27-4-workers", forkJoinFib<4>, 1);
+DECAF_BENCHMARK("ForkJoin/fib-27-8-workers", forkJoinFib<8>, 1);
+DECAF_BENCHMARK("ForkJoin/fib-27-all-cores", forkJoinFib<0>, 1);
+DECAF_BENCHMARK("ForkJoin/mergesort-1M-1-worker", forkJoinMergeSort<1>, 1);
+DECAF_BENCHMARK("ForkJoin/mergesort-1M-2-workers", forkJoinMergeSort<2>, 1);
+DECAF_BENCHMARK("ForkJoin/mergesort-1M-4-workers", forkJoinMergeSort<4>, 1);
+DECAF_BENCHMARK("ForkJoin/mergesort-1M-8-workers", forkJoinMergeSort<8>, 1);
+DECAF_BENCHMARK("ForkJoin/mergesort-1M-all-cores", forkJoinMergeSort<0>, 1);
+DECAF_BENCHMARK("ForkJoin/tree-sum-1M-1-worker", forkJoinTreeSum<1>, 1);
+DECAF_BENCHMARK("ForkJoin/tree-sum-1M-2-workers", forkJoinTreeSum<2>, 1);
+DECAF_BENCHMARK("ForkJoin/tree-sum-1M-4-workers", forkJoinTreeSum<4>, 1);
+DECAF_BENCHMARK("ForkJoin/tree-sum-1M-8-workers", forkJoinTreeSum<8>, 1);
+DECAF_BENCHMARK("ForkJoin/tree-sum-1M-all-cores", forkJoinTreeSum<0>, 1);
+
+}
+
+DECAF_CLOSE_NAMESPACE2
@@ -0,0 +1,641 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <pthread.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "decaf/lang/IllegalStateException.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/Ref.hpp"
+#include "decaf/lang/SlabAllocator.hpp"
+#include "decaf/lang/Synchronized.hpp"
+#include "decaf/lang/System.hpp"
+#include "decaf/lang/Thread.hpp"
+#include "decaf/lang/ThreadGroup.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, bench)
+
+namespace {
+
+/*
+ * A small Object subclass, about the size of a typical value class.
+ */
+class Small : public Object {
+  public:
+    Small() : m_value(0) { }
+
+    int64_t m_value;
+    int64_t m_padding[3];
+};
+
+const size_t ALLOCATION_SIZE = sizeof (Small);
+const size_t ALLOCATION_BURST = 64;
+
+// ----- Object life cycle ----------------------------------------------------
+
+void objectOnStack(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        Small object;
+        doNotOptimize(object);
+    }
+}
+
+void objectNewDelete(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        Object* object = new Small();
+        doNotOptimize(object);
+        delete object;
+    }
+}
+
+/*
+ * Allocates bursts of blocks and frees them in reverse order, which is closer
+ * to real churn than alternating single allocations and frees.
+ */
+template<typename Allocate, typename Free>
+void allocateBursts(Batch& batch, Allocate allocate, Free free) {
+    void* blocks[ALLOCATION_BURST];
+    for (uint64_t i = 0; i < batch.iterations(); i += ALLOCATION_BURST) {
+        for (size_t j = 0; j < ALLOCATION_BURST; ++j)
+            blocks[j] = allocate();
+        doNotOptimize(blocks);
+        for (size_t j = ALLOCATION_BURST; j > 0; --j)
+            free(blocks[j - 1]);
+    }
+}
+
+void slabAllocate(Batch& batch) {
+    allocateBursts(batch,
+      []() { return lang::detail::SlabAllocator::allocate(ALLOCATION_SIZE); },
+      [](void* block) { lang::detail::SlabAllocator::deallocate(block, ALLOCATION_SIZE); });
+}
+
+void mallocAllocate(Batch& batch) {
+    allocateBursts(batch, []() { return malloc(ALLOCATION_SIZE); }, [](void* block) { free(block); });
+}
+
+DECAF_BENCHMARK("Object/construct-on-stack", objectOnStack, 1);
+DECAF_BENCHMARK("Object/new-delete", objectNewDelete, 1);
+DECAF_BENCHMARK("Object/new-delete", objectNewDelete, 8);
+DECAF_BENCHMARK("Object/new-delete", objectNewDelete, 64);
+DECAF_BENCHMARK("SlabAllocator/allocate-free", slabAllocate, 1);
+DECAF_BENCHMARK("SlabAllocator/allocate-free", slabAllocate, 8);
+DECAF_BENCHMARK("SlabAllocator/allocate-free", slabAllocate, 64);
+DECAF_BENCHMARK("malloc/allocate-free", mallocAllocate, 1);
+DECAF_BENCHMARK("malloc/allocate-free", mallocAllocate, 8);
+DECAF_BENCHMARK("malloc/allocate-free", mallocAllocate, 64);
+
+// ----- Footprint ------------------------------------------------------------
+
+/*
+ * What every Object carried before the lock word: an identity hash, a mutex
+ * for synchronized blocks, and a mutex and condition variable for wait and
+ * notify.
+ */
+class PthreadObject {
+  public:
+    PthreadObject() : m_hashCode(0) {
+        pthread_mutex_init(&m_mutex, 0);
+        pthread_mutex_init(&m_monitorMutex, 0);
+        pthread_cond_init(&m_monitorCondition, 0);
+    }
+
+    virtual ~PthreadObject() {
+        pthread_cond_destroy(&m_monitorCondition);
+        pthread_mutex_destroy(&m_monitorMutex);
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    uint64_t m_hashCode;
+    pthread_mutex_t m_mutex;
+    pthread_mutex_t m_monitorMutex;
+    pthread_cond_t m_monitorCondition;
+};
+
+const size_t FOOTPRINT_POPULATION = 64 * 1024;
+
+size_t residentSetBytes() {
+    long pages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm != 0) {
+        if (fscanf(statm, "%*s %ld", &pages) != 1)
+            pages = 0;
+        fclose(statm);
+    }
+    return static_cast<size_t> (pages) * static_cast<size_t> (sysconf(_SC_PAGESIZE));
+}
+
+/*
+ * Keeps FOOTPRINT_POPULATION objects alive at once and reports the heap and
+ * resident bytes each of them takes. Both kinds of object come from malloc,
+ * so that only their layout differs; the slab allocator is measured on its
+ * own above. Freed memory is trimmed back to the system after every round,
+ * or the next round would find its pages resident already.
+ */
+template<typename T>
+void footprint(Batch& batch) {
+    std::vector<T*> objects(FOOTPRINT_POPULATION);
+    size_t heapBytes = 0;
+    size_t residentBytes = 0;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const size_t heapBefore = mallinfo2().uordblks;
+        const size_t residentBefore = residentSetBytes();
+        for (T*& object : objects)
+            object = new (::operator new(sizeof (T))) T();
+        heapBytes = mallinfo2().uordblks - heapBefore;
+        residentBytes = residentSetBytes() - residentBefore;
+
+        for (T* object : objects) {
+            object->~T();
+            ::operator delete(object);
+        }
+        malloc_trim(0);
+    }
+
+    batch.setCounter("sizeof", sizeof (T));
+    batch.setCounter("heap-bytes/object", static_cast<double> (heapBytes) / FOOTPRINT_POPULATION);
+    batch.setCounter("resident-bytes/object", static_cast<double> (residentBytes) / FOOTPRINT_POPULATION);
+}
+
+DECAF_BENCHMARK("Object/footprint-64K-live", footprint<Object>, 1);
+DECAF_BENCHMARK("Object/footprint-64K-live-pthread-layout", footprint<PthreadObject>, 1);
+
+// ----- Identity hash --------------------------------------------------------
+
+const unsigned HASH_BITS = 16;
+const size_t HASH_SAMPLE = 1u << HASH_BITS;
+
+typedef uint64_t (*HashFunction)(const Object& object);
+
+uint64_t identityHash(const Object& object) {
+    return object.hashCode();
+}
+
+/*
+ * The identity hash before per-thread seeds: Knuth's multiplicative hash of
+ * the address.
+ */
+uint64_t knuthAddressHash(const Object& object) {
+    return (reinterpret_cast<uint64_t> (&object) >> 3) * 2654435761u;
+}
+
+/*
+ * Inserts HASH_SAMPLE keys into a half-full linear-probing table, as used by
+ * open-addressing hash maps, each at the slot chosen by shift. Reports the
+ * probe lengths and the longest run of occupied slots: the tail, more than
+ * the mean, is what clustering costs.
+ */
+void linearProbe(const std::vector<uint64_t>& hashes, unsigned shift, const std::string& prefix,
+  std::map<std::string, double>& counters) {
+    std::vector<bool> table(2 * HASH_SAMPLE);
+    std::vector<uint32_t> probes;
+    probes.reserve(hashes.size());
+    for (uint64_t hash : hashes) {
+        size_t slot = (hash >> shift) & (table.size() - 1);
+        uint32_t length = 1;
+        for (; table[slot]; ++length)
+            slot = (slot + 1) & (table.size() - 1);
+        table[slot] = true;
+        probes.push_back(length);
+    }
+
+    // Start counting runs at an empty slot, so that none wraps around.
+    const size_t start = std::find(table.begin(), table.end(), false) - table.begin();
+    size_t cluster = 0;
+    size_t longestCluster = 0;
+    for (size_t i = 1; i <= table.size(); ++i) {
+        cluster = table[(start + i) & (table.size() - 1)] ? cluster + 1 : 0;
+        longestCluster = std::max(longestCluster, cluster);
+    }
+
+    const uint64_t total = std::accumulate(probes.begin(), probes.end(), uint64_t(0));
+    std::sort(probes.begin(), probes.end());
+    counters[prefix + "_probe_mean_length"] = total / static_cast<double> (probes.size());
+    counters[prefix + "_probe_p99_length"] = probes[probes.size() * 99 / 100];
+    counters[prefix + "_probe_max_length"] = probes.back();
+    counters[prefix + "_longest_cluster"] = longestCluster;
+}
+
+/*
+ * Describes how the hashes of HASH_SAMPLE objects, allocated one after the
+ * other from the heap as identity-hashed objects usually are, spread over as
+ * many buckets, picking the bucket from the low and from the high bits of
+ * the hash: an ideal hash leaves 1/e (36.8%) of the buckets empty. Tables
+ * that mask the hash use the low bits, those that multiply it the high ones.
+ */
+std::map<std::string, double> hashDistribution(HashFunction function) {
+    std::vector<std::unique_ptr<Small> > objects(HASH_SAMPLE);
+    std::vector<uint64_t> hashes;
+    hashes.reserve(HASH_SAMPLE);
+    for (std::unique_ptr<Small>& object : objects) {
+        object.reset(new Small());
+        hashes.push_back(function(*object));
+    }
+
+    std::vector<uint32_t> low(HASH_SAMPLE), high(HASH_SAMPLE);
+    for (uint64_t hash : hashes) {
+        ++low[hash & (HASH_SAMPLE - 1)];
+        ++high[hash >> (64 - HASH_BITS)];
+    }
+
+    std::map<std::string, double> counters;
+    counters["low_bits_empty_fraction"] =
+      std::count(low.begin(), low.end(), 0u) / static_cast<double> (HASH_SAMPLE);
+    counters["low_bits_max_bucket"] = *std::max_element(low.begin(), low.end());
+    counters["high_bits_empty_fraction"] =
+      std::count(high.begin(), high.end(), 0u) / static_cast<double> (HASH_SAMPLE);
+    counters["high_bits_max_bucket"] = *std::max_element(high.begin(), high.end());
+    linearProbe(hashes, 0, "low_bits", counters);
+    linearProbe(hashes, 64 - HASH_BITS - 1, "high_bits", counters);
+    return counters;
+}
+
+template<HashFunction FUNCTION>
+void hashCodeFresh(Batch& batch) {
+    static const std::map<std::string, double> distribution = hashDistribution(FUNCTION);
+    for (const auto& counter : distribution)
+        batch.setCounter(counter.first, counter.second);
+
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        Small object;
+        doNotOptimize(FUNCTION(object));
+    }
+}
+
+void hashCodeCached(Batch& batch) {
+    Small object;
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(object.hashCode());
+}
+
+DECAF_BENCHMARK("Object/hashCode-first", hashCodeFresh<identityHash>, 1);
+DECAF_BENCHMARK("Object/hashCode-first-knuth-address", hashCodeFresh<knuthAddressHash>, 1);
+DECAF_BENCHMARK("Object/hashCode-cached", hashCodeCached, 1);
+
+// ----- Type names -----------------------------------------------------------
+
+void getTypeName(Batch& batch) {
+    Small object;
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(object.getTypeName());
+}
+
+void objectToString(Batch& batch) {
+    Small object;
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(object.toString());
+}
+
+void throwableToString(Batch& batch) {
+    IllegalStateException exception("monitor is not owned");
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(exception.toString());
+}
+
+DECAF_BENCHMARK("Object/getTypeName", getTypeName, 1);
+DECAF_BENCHMARK("Object/toString", objectToString, 1);
+DECAF_BENCHMARK("Throwable/toString", throwableToString, 1);
+
+// ----- Monitors -------------------------------------------------------------
+
+/*
+ * Run with DECAF_BIASED_LOCKING=0 to measure thin locks instead of biased
+ * ones, and with DECAF_MONITOR_PROFILE=1 to measure the profiler's overhead.
+ */
+void synchronizedUncontended(Batch& batch) {
+    Small object;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        synchronized(&object) {
+            doNotOptimize(object);
+        }
+    }
+}
+
+void synchronizedContended(Batch& batch) {
+    static Small object;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        synchronized(&object) {
+            ++object.m_value;
+        }
+    }
+}
+
+void mutexUncontended(Batch& batch) {
+    std::mutex mutex;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        std::lock_guard<std::mutex> guard(mutex);
+        doNotOptimize(mutex);
+    }
+}
+
+void mutexContended(Batch& batch) {
+    static std::mutex mutex;
+    static int64_t value = 0;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        std::lock_guard<std::mutex> guard(mutex);
+        ++value;
+    }
+}
+
+/*
+ * Two threads take turns through wait() and notify(): one round trip per
+ * iteration, which is twice the wake-up latency.
+ */
+void waitNotifyPingPong(Batch& batch) {
+    static Small monitor;
+    const int64_t self = batch.threadIndex();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        synchronized(&monitor) {
+            while (monitor.m_value % 2 != self)
+                monitor.wait();
+            ++monitor.m_value;
+            monitor.notify();
+        }
+    }
+}
+
+/*
+ * A bounded buffer guarded by a monitor: thread 0 produces, thread 1 consumes
+ * one item per iteration.
+ */
+void waitNotifyProducerConsumer(Batch& batch) {
+    static const uint64_t CAPACITY = 64;
+    static Small monitor;
+    static uint64_t items[CAPACITY];
+    static uint64_t head = 0, tail = 0;
+
+    const bool producer = (batch.threadIndex() == 0);
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        synchronized(&monitor) {
+            if (producer) {
+                while (tail - head == CAPACITY)
+                    monitor.wait();
+                items[tail++ % CAPACITY] = i;
+            } else {
+                while (tail == head)
+                    monitor.wait();
+                doNotOptimize(items[head++ % CAPACITY]);
+            }
+            monitor.notifyAll();
+        }
+    }
+}
+
+DECAF_BENCHMARK("synchronized/uncontended", synchronizedUncontended, 1);
+DECAF_BENCHMARK("synchronized/contended", synchronizedContended, 4);
+DECAF_BENCHMARK("std::mutex/uncontended", mutexUncontended, 1);
+DECAF_BENCHMARK("std::mutex/contended", mutexContended, 4);
+DECAF_BENCHMARK("Object/wait-notify-ping-pong", waitNotifyPingPong, 2);
+DECAF_BENCHMARK("Object/wait-notifyAll-producer-consumer", waitNotifyProducerConsumer, 2);
+
+// ----- References -----------------------------------------------------------
+
+void refCopyConfined(Batch& batch) {
+    Ref<Small> reference(new Small());
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        Ref<Small> copy(reference);
+        doNotOptimize(copy);
+    }
+}
+
+void refCopyShared(Batch& batch) {
+    static Ref<Small> reference = Ref<Small>(new Small()).share();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        Ref<Small> copy(reference);
+        doNotOptimize(copy);
+    }
+}
+
+void sharedPtrCopy(Batch& batch) {
+    static std::shared_ptr<Small> reference = std::make_shared<Small>();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        std::shared_ptr<Small> copy(reference);
+        doNotOptimize(copy);
+    }
+}
+
+DECAF_BENCHMARK("Ref/copy-confined", refCopyConfined, 1);
+DECAF_BENCHMARK("Ref/copy-shared", refCopyShared, 1);
+DECAF_BENCHMARK("Ref/copy-shared", refCopyShared, 4);
+DECAF_BENCHMARK("std::shared_ptr/copy", sharedPtrCopy, 1);
+DECAF_BENCHMARK("std::shared_ptr/copy", sharedPtrCopy, 4);
+
+// ----- Clocks ---------------------------------------------------------------
+
+void systemNanoTime(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(System::nanoTime());
+}
+
+void systemFastNanoTime(Batch& batch) {
+    if (batch.threadIndex() == 0)
+        batch.setCounter("tsc", System::isFastNanoTimeTsc() ? 1 : 0);
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(System::fastNanoTime());
+}
+
+void systemCoarseNanoTime(Batch& batch) {
+    batch.setCounter("resolution-ns", static_cast<double> (System::coarseNanoTimeResolution()));
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(System::coarseNanoTime());
+}
+
+void systemCurrentTimeMillis(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(System::currentTimeMillis());
+}
+
+void steadyClockNow(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(std::chrono::steady_clock::now());
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+/*
+ * The floor of System/fastNanoTime: the bare TSC read.
+ */
+void rdtsc(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(__builtin_ia32_rdtsc());
+}
+#endif
+
+/*
+ * Returns the one of a and b farthest from 0.
+ */
+int64_t farthest(int64_t a, int64_t b) {
+    return (a < 0 ? -a : a) >= (b < 0 ? -b : b) ? a : b;
+}
+
+/*
+ * The drift test of fastNanoTime(): brackets each of its readings between two
+ * of nanoTime() and reports, over the whole run, the worst offset from the
+ * middle of the bracket, the worst distance outside of it, and how many
+ * readings went backwards. The pauses between readings stretch the run across
+ * several recalibrations.
+ */
+void systemFastNanoTimeDrift(Batch& batch) {
+    static int64_t maxOffset = 0;
+    static int64_t maxDrift = 0;
+    static uint64_t backwards = 0;
+    static uint64_t last = 0;
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        const uint64_t before = System::nanoTime();
+        const uint64_t reading = System::fastNanoTime();
+        const uint64_t after = System::nanoTime();
+        if (reading < last)
+            ++backwards;
+        last = reading;
+        const uint64_t middle = before + (after - before) / 2;
+        maxOffset = farthest(maxOffset, static_cast<int64_t> (reading - middle));
+        if (reading < before)
+            maxDrift = farthest(maxDrift, -static_cast<int64_t> (before - reading));
+        else if (reading > after)
+            maxDrift = farthest(maxDrift, static_cast<int64_t> (reading - after));
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    batch.setCounter("offset-max-ns", static_cast<double> (maxOffset));
+    batch.setCounter("drift-max-ns", static_cast<double> (maxDrift));
+    batch.setCounter("backwards", static_cast<double> (backwards));
+}
+
+DECAF_BENCHMARK("System/nanoTime", systemNanoTime, 1);
+DECAF_BENCHMARK("System/nanoTime", systemNanoTime, 4);
+DECAF_BENCHMARK("System/fastNanoTime", systemFastNanoTime, 1);
+DECAF_BENCHMARK("System/fastNanoTime", systemFastNanoTime, 4);
+DECAF_BENCHMARK("System/coarseNanoTime", systemCoarseNanoTime, 1);
+DECAF_BENCHMARK("System/currentTimeMillis", systemCurrentTimeMillis, 1);
+DECAF_BENCHMARK("std::chrono::steady_clock/now", steadyClockNow, 1);
+#if defined(__x86_64__) || defined(__i386__)
+DECAF_BENCHMARK("rdtsc", rdtsc, 1);
+#endif
+DECAF_BENCHMARK("System/fastNanoTime-drift", systemFastNanoTimeDrift, 1);
+
+
+// ----- Threads --------------------------------------------------------------
+
+class Idle : public Runnable {
+  public:
+    virtual void Run() { }
+};
+
+void threadCurrentThread(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(Thread::currentThread());
+}
+
+void pthreadSelf(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(pthread_self());
+}
+
+void stdThisThreadGetId(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(std::this_thread::get_id());
+}
+
+void threadStartJoin(Batch& batch, int cpu) {
+    const Ref<Runnable> idle = Ref<Runnable>(new Idle).share();
+    for (uint64_t i = 0; i < batch.iterations(); ++i) {
+        Thread thread(idle);
+        if (cpu >= 0)
+            thread.setAffinity(cpu);
+        thread.start();
+        thread.join();
+    }
+}
+
+void threadStartJoin(Batch& batch) {
+    threadStartJoin(batch, -1);
+}
+
+void threadStartJoinPinned(Batch& batch) {
+    threadStartJoin(batch, 0);
+}
+
+void stdThreadStartJoin(Batch& batch) {
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        std::thread([] { }).join();
+}
+
+const int GROUP_THREADS = 16;
+
+class Parked : public Runnable {
+  public:
+    virtual void Run() {
+        Thread::sleep(UINT64_MAX / 1000000 - 1);
+    }
+};
+
+/*
+ * A group of parked daemon threads, never destroyed.
+ */
+ThreadGroup& parkedGroup() {
+    static ThreadGroup* group = [] {
+        Ref<ThreadGroup> pool(new ThreadGroup("parked"));
+        pool.share();
+        const Ref<Runnable> parked = Ref<Runnable>(new Parked).share();
+        for (int i = 0; i < GROUP_THREADS; ++i) {
+            Ref<Thread> thread(new Thread(pool, parked, "parked-" + std::to_string(i)));
+            thread->setDaemon(true);
+            thread->start();
+        }
+        return pool.get();
+    }();
+    return *group;
+}
+
+void threadGroupGetUsage(Batch& batch) {
+    ThreadGroup& group = parkedGroup();
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(group.getUsage());
+    batch.setCounter("threads", static_cast<double> (GROUP_THREADS));
+}
+
+void threadGroupActiveCount(Batch& batch) {
+    ThreadGroup& group = parkedGroup();
+    for (uint64_t i = 0; i < batch.iterations(); ++i)
+        doNotOptimize(group.activeCount());
+}
+
+DECAF_BENCHMARK("Thread/currentThread", threadCurrentThread, 1);
+DECAF_BENCHMARK("Thread/currentThread", threadCurrentThread, 4);
+DECAF_BENCHMARK("pthread_self", pthreadSelf, 1);
+DECAF_BENCHMARK("std::this_thread::get_id", stdThisThreadGetId, 1);
+DECAF_BENCHMARK("Thread/start-join", threadStartJoin, 1);
+DECAF_BENCHMARK("Thread/start-join-pinned", threadStartJoinPinned, 1);
+DECAF_BENCHMARK("std::thread/start-join", stdThreadStartJoin, 1);
+DECAF_BENCHMARK("ThreadGroup/getUsage-16-threads", threadGroupGetUsage, 1);
+DECAF_BENCHMARK("ThreadGroup/activeCount-16-threads", threadGroupActiveCount, 1);
+
+}
+
+DECAF_CLOSE_NAMESPACE2
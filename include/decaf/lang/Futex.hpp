@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_FUTEX_HPP
+#define DECAF_FUTEX_HPP
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "decaf/lang/compatibility.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * Thin wrappers over the Linux futex(2) system call. Every futex used by the
+ * library is process private, so the private variants are always requested.
+ */
+inline uint32_t* futexAddress(std::atomic<uint32_t>& word) {
+    return reinterpret_cast<uint32_t*> (&word);
+}
+
+/**
+ * @internal
+ * Blocks the calling thread for as long as @a word holds @a expected.
+ * Returns immediately if the value differs. Spurious returns are possible.
+ */
+inline void futexWait(std::atomic<uint32_t>& word, uint32_t expected) {
+    syscall(SYS_futex, futexAddress(word), FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
+}
+
+/**
+ * @internal
+ * Blocks the calling thread for as long as @a word holds @a expected, or
+ * until the absolute CLOCK_MONOTONIC time @a deadline passes. A null
+ * @a deadline waits forever. Spurious returns are possible.
+ *
+ * @return false if the deadline passed, true otherwise
+ */
+inline bool futexWaitUntil(std::atomic<uint32_t>& word, uint32_t expected,
+  const struct timespec* deadline) {
+    if (syscall(SYS_futex, futexAddress(word), FUTEX_WAIT_BITSET_PRIVATE, expected,
+      deadline, 0, FUTEX_BITSET_MATCH_ANY) == -1 && errno == ETIMEDOUT)
+        return false;
+    return true;
+}
+
+/**
+ * @internal
+ * Wakes at most @a count threads blocked on @a word.
+ */
+inline void futexWake(std::atomic<uint32_t>& word, int count) {
+    syscall(SYS_futex, futexAddress(word), FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+}
+
+/**
+ * @internal
+ * Wakes at most @a wakeCount threads blocked on @a from and moves up to
+ * @a requeueCount of the remaining ones onto @a to, without waking them,
+ * provided @a from still holds @a expected.
+ */
+inline void futexRequeue(std::atomic<uint32_t>& from, int wakeCount, int requeueCount,
+  std::atomic<uint32_t>& to, uint32_t expected) {
+    syscall(SYS_futex, futexAddress(from), FUTEX_CMP_REQUEUE_PRIVATE, wakeCount,
+      static_cast<long> (requeueCount), futexAddress(to), expected);
+}
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_FUTEX_HPP
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_IDENTITYHASH_HPP
+#define DECAF_IDENTITYHASH_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+
+/**
+ * IdentityHash generates the identity hash codes returned by Object::hashCode().
+ *
+ * The first time an object is asked for its hash code it is assigned a 32-bit
+ * seed, which is stored in its header and never changes. Seeds are taken from
+ * a per-thread counter, refilled in blocks from a global one, so they cost no
+ * shared-memory traffic and do not depend on the address of the object. Two
+ * live objects share a seed only after 2^32 objects have been hashed.
+ *
+ * The hash code itself is the seed run through a mixer, a bijective function
+ * which spreads consecutive seeds over all 64 bits. Since it is bijective,
+ * distinct seeds never collide, and every bit of the result, low or high,
+ * is usable as a bucket index by power-of-two tables.
+ *
+ * The mixer may be replaced, but only before the first hash code has been
+ * handed out, or hash codes would not be stable.
+ */
+class IdentityHash {
+  public:
+    /**
+     * A bijective function from seeds to hash codes.
+     */
+    typedef uint64_t (*Mixer)(uint64_t seed);
+
+    /**
+     * The 64-bit finalizer of MurmurHash3. This is the default mixer.
+     */
+    static uint64_t murmur3(uint64_t seed) {
+        seed ^= seed >> 33;
+        seed *= 0xff51afd7ed558ccdull;
+        seed ^= seed >> 33;
+        seed *= 0xc4ceb9fe1a85ec53ull;
+        seed ^= seed >> 33;
+        return seed;
+    }
+
+    /**
+     * The finalizer of SplitMix64 (Stafford's "Mix13" variant).
+     */
+    static uint64_t splitMix64(uint64_t seed) {
+        seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ull;
+        seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebull;
+        return seed ^ (seed >> 31);
+    }
+
+    /**
+     * Returns the mixer in use.
+     */
+    static Mixer getMixer() {
+        return s_mixer.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Replaces the mixer. Must be called before any hash code is handed out,
+     * typically at the start of main().
+     *
+     * @param mixer the new mixer; it must be a bijection
+     * @throws IllegalArgumentException if mixer is null
+     * @throws IllegalStateException if identity hash codes were already handed out
+     */
+    static void setMixer(Mixer mixer);
+
+    /**
+     * Returns the hash code for @a seed.
+     */
+    static uint64_t mix(uint32_t seed) {
+        return getMixer()(seed);
+    }
+
+    /**
+     * Returns a fresh seed, never 0.
+     */
+    static uint32_t nextSeed();
+
+  private:
+    static std::atomic<Mixer> s_mixer;
+};
+
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_IDENTITYHASH_HPP
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_MONITOR_HPP
+#define DECAF_MONITOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/MonitorStatistics.hpp"
+#include "decaf/lang/SpinWait.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * A full (inflated) object monitor. Objects start out with nothing but a
+ * lock word in their header; a Monitor is only taken from the pool when the
+ * lock word can no longer describe the state of the lock, i.e. when a second
+ * thread contends for it. The monitor stays bound to its object until the
+ * object is destroyed, at which point it returns to the pool.
+ *
+ * Monitors are addressed by a 30-bit index so that the index fits in the lock
+ * word next to its tag bits.
+ */
+class alignas(64) Monitor {
+  public:
+    /**
+     * Acquires the monitor on behalf of the thread identified by @a self.
+     * If another thread owns it, spins for a while in case it is released
+     * soon, then parks.
+     */
+    void lock(uint32_t self);
+
+    /**
+     * Releases one level of ownership held by @a self. Does nothing if
+     * @a self does not own the monitor.
+     */
+    void unlock(uint32_t self);
+
+    /**
+     * Releases the monitor, which @a self must own, and waits until another
+     * thread notifies it or the absolute CLOCK_MONOTONIC time @a deadline
+     * passes (never, if @a deadline is null). The monitor is re-acquired,
+     * with its full recursion count, before returning.
+     */
+    void wait(uint32_t self, const struct timespec* deadline);
+
+    /**
+     * Moves one waiting thread, or all of them if @a all is true, from the
+     * wait set onto the monitor itself. The moved threads are not woken: each
+     * of them is handed the monitor in turn as it gets released. Must be
+     * called by the owner.
+     */
+    void notify(bool all);
+
+    /**
+     * Returns the identifier of the owning thread, or 0 if the monitor is free.
+     */
+    uint32_t owner() const {
+        return m_owner.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Starts collecting MonitorProfiler statistics for this monitor, which is
+     * being bound to @a obj. Must be called before the monitor is published.
+     */
+    void profile(const Object& obj);
+
+    /**
+     * Takes a monitor out of the pool. If @a owner is not 0, the monitor is
+     * handed out already locked by that thread with @a recursions extra
+     * levels of ownership.
+     *
+     * @return the index of the monitor
+     */
+    static uint32_t allocate(uint32_t owner, uint32_t recursions);
+
+    /**
+     * Returns the monitor at @a index to the pool.
+     */
+    static void release(uint32_t index);
+
+    /**
+     * Returns the monitor at @a index.
+     */
+    static Monitor& at(uint32_t index) {
+        return s_chunks[index >> CHUNK_SHIFT].load(std::memory_order_acquire)[index & CHUNK_MASK];
+    }
+
+    static const uint32_t CHUNK_SHIFT = 10;
+    static const uint32_t CHUNK_MASK = (1u << CHUNK_SHIFT) - 1;
+    static const uint32_t MAX_CHUNKS = 1u << 14;
+
+  private:
+    Monitor() : m_lock(0), m_owner(0), m_recursions(0), m_waitSequence(0),
+      m_waiters(0), m_nextFree(0), m_statistics(0) { }
+    Monitor(const Monitor& other) = delete;
+    Monitor& operator=(const Monitor& rhs) = delete;
+
+    void lockProfiled(uint32_t self);
+
+    /*
+     * Takes the lock word once the fast path failed: spins, then parks.
+     */
+    void lockContended();
+
+    /*
+     * 0 = unlocked, 1 = locked, 2 = locked and some thread may be sleeping
+     * on the futex.
+     */
+    std::atomic<uint32_t> m_lock;
+    std::atomic<uint32_t> m_owner;
+    uint32_t m_recursions;
+    AdaptiveSpin m_spin;
+
+    /*
+     * The futex waiting threads sleep on. Bumped by every notification so
+     * that a thread which released the monitor but has not gone to sleep yet
+     * cannot miss it.
+     */
+    std::atomic<uint32_t> m_waitSequence;
+
+    /*
+     * Threads that called wait() and have not re-acquired the monitor yet.
+     * Only accessed by the owner.
+     */
+    uint32_t m_waiters;
+    uint32_t m_nextFree;
+
+    /*
+     * Set while MonitorProfiler is enabled; 0 otherwise. lock() tests it once,
+     * up front, and takes lockProfiled() when it is set.
+     */
+    MonitorStatistics* m_statistics;
+
+    static std::atomic<Monitor*> s_chunks[MAX_CHUNKS];
+
+    friend class MonitorPool;
+};
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_MONITOR_HPP
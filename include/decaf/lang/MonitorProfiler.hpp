@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_MONITORPROFILER_HPP
+#define DECAF_MONITORPROFILER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "decaf/lang/compatibility.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+
+/**
+ * Records how often, and for how long, object monitors are contended.
+ *
+ * Profiling is turned on by setting the DECAF_MONITOR_PROFILE environment
+ * variable to a positive number N before the program starts; the N most
+ * contended monitors are then reported on the standard error stream at exit,
+ * and can be dumped at any time with dump(). When it is off, the monitors pay
+ * a single, well-predicted branch for it.
+ *
+ * To see every acquisition, profiling keeps monitors from being biased or
+ * thin-locked: each monitor gets a full Monitor the first time it is entered,
+ * which makes uncontended locking slower than usual. Monitors are identified
+ * by the Object::toString() of their object at that time. Statistics of
+ * destroyed objects are merged by type.
+ */
+class MonitorProfiler {
+  public:
+    /**
+     * The statistics of one monitor, or of all destroyed monitors of a type.
+     */
+    struct Entry {
+        std::string m_identity;
+        bool m_destroyed;
+        uint64_t m_acquires;
+        uint64_t m_contendedAcquires;
+        uint64_t m_totalWaitNanos;
+        uint64_t m_maxWaitNanos;
+        uint64_t m_totalHoldNanos;
+        uint64_t m_maxHoldNanos;
+    };
+
+    /**
+     * Returns true if monitors are being profiled.
+     */
+    static bool isEnabled() {
+        return s_enabled;
+    }
+
+    /**
+     * Returns the statistics of the @a top most contended monitors, ordered
+     * by number of contended acquisitions, then by total wait time. Returns
+     * nothing if profiling is off.
+     */
+    static std::vector<Entry> snapshot(size_t top);
+
+    /**
+     * Writes a table of the @a top most contended monitors to @a out.
+     */
+    static void dump(std::ostream& out, size_t top);
+
+  private:
+    static bool s_enabled;
+};
+
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_MONITORPROFILER_HPP
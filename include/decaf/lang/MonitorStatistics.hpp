@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_MONITORSTATISTICS_HPP
+#define DECAF_MONITORSTATISTICS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "decaf/lang/compatibility.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+
+class MonitorProfiler;
+class Object;
+
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * The statistics MonitorProfiler keeps for one Monitor. Only the owner of the
+ * monitor updates them, so plain loads and stores do; they are atomic so that
+ * a report can read them at any time.
+ */
+class MonitorStatistics {
+  public:
+    /**
+     * Creates the statistics of the monitor of @a obj. If @a owned, the
+     * monitor is being inflated by or for its current owner, whose hold time
+     * starts now.
+     */
+    MonitorStatistics(const Object& obj, bool owned);
+
+    /**
+     * Records an acquisition by the new owner. @a waitedSince is the time it
+     * started waiting for the monitor, or 0 if it did not have to.
+     */
+    void acquired(uint64_t waitedSince);
+
+    /**
+     * Records the release of the monitor by its owner.
+     */
+    void released();
+
+    /**
+     * Called when the monitor goes back to the pool: merges these statistics
+     * into those of the destroyed objects of the same type and deletes them.
+     */
+    static void retire(MonitorStatistics* statistics);
+
+    /**
+     * Returns the current CLOCK_MONOTONIC time in nanoseconds, read from the
+     * time stamp counter where possible: it is taken on every acquisition.
+     */
+    static uint64_t now();
+
+    /**
+     * Returns the number of monitors DECAF_MONITOR_PROFILE asks to report,
+     * 0 if profiling is off.
+     */
+    static size_t configuredTop();
+
+  private:
+    MonitorStatistics(const MonitorStatistics& other) = delete;
+    MonitorStatistics& operator=(const MonitorStatistics& rhs) = delete;
+
+    static void raise(std::atomic<uint64_t>& maximum, uint64_t value) {
+        if (value > maximum.load(std::memory_order_relaxed))
+            maximum.store(value, std::memory_order_relaxed);
+    }
+
+    static void add(std::atomic<uint64_t>& total, uint64_t value) {
+        total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::string m_identity;
+    const std::string* m_type;
+
+    std::atomic<uint64_t> m_acquires;
+    std::atomic<uint64_t> m_contendedAcquires;
+    std::atomic<uint64_t> m_totalWaitNanos;
+    std::atomic<uint64_t> m_maxWaitNanos;
+    std::atomic<uint64_t> m_totalHoldNanos;
+    std::atomic<uint64_t> m_maxHoldNanos;
+
+    /*
+     * When the current owner acquired the monitor. Owner only.
+     */
+    uint64_t m_acquiredAt;
+
+    /*
+     * The list of live statistics, guarded by the registry mutex.
+     */
+    MonitorStatistics* m_previous;
+    MonitorStatistics* m_next;
+
+    friend class decaf::lang::MonitorProfiler;
+};
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_MONITORSTATISTICS_HPP
@@ -19,14 +19,20 @@
 #define DECAF_OBJECT_HPP
 
 #include <typeinfo>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <string>
-#include <pthread.h>
 
 #include "decaf/lang/compatibility.hpp"
 
 DECAF_OPEN_NAMESPACE2(decaf, lang)
 
+DECAF_OPEN_NAMESPACE(detail)
+class ObjectHeader;
+class ReferenceCount;
+DECAF_CLOSE_NAMESPACE
+
 /**
  * Class Object is the root of the class hierarchy. Every class in the
  * Decaf Class Library has Object as a base class.
@@ -35,21 +41,58 @@ class Object {
   public:
     typedef std::type_info Type;
 
-    Object() throw () : m_hashCode(0),
-      m_mutex(PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP),
-      m_monitorMutex(PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP),
-      m_monitorCondition(PTHREAD_COND_INITIALIZER) { }
+    Object() throw () : m_header(0), m_references(0) { }
+
+    /**
+     * Copies an object. The identity of an object, i.e. its hash code, its
+     * monitor and its reference count, is never copied: the new object gets
+     * its own.
+     */
+    Object(const Object& other) throw () : m_header(0), m_references(0) { }
+
+    virtual ~Object();
+
+    /**
+     * Allocates storage for an object. If the library was built with
+     * DECAF_SLAB_ALLOCATOR, objects of up to 512 bytes come from per-thread
+     * caches of size-class slabs (see detail::SlabAllocator); otherwise, and
+     * for larger objects, from the global operator new.
+     *
+     * @throws std::bad_alloc if memory is exhausted
+     */
+    static void* operator new(std::size_t size);
+
+    /**
+     * Frees storage allocated by operator new. The size is that of the
+     * dynamic type, as passed by the virtual destructor.
+     */
+    static void operator delete(void* object, std::size_t size) throw ();
+
+    /**
+     * Placement forms, which declaring the above would otherwise hide.
+     */
+    static void* operator new(std::size_t size, void* where) throw () {
+        return where;
+    }
 
-    virtual ~Object() = default;
+    static void operator delete(void* object, void* where) throw () { }
+
+    /**
+     * Assigns an object. The identity of this object is left untouched.
+     */
+    Object& operator=(const Object& rhs) throw () {
+        return *this;
+    }
 
     /**
      * Returns a hash code value for the object. This returns distinct integers
-     * for distinct objects. This is typically implemented by converting the
-     * internal address of an object into an integer, but this implementation
-     * technique is not required. Note that two objects are "the same" if their
-     * hash codes are equal.
+     * for distinct objects. The identity hash code is derived from a sequence
+     * number assigned to the object when it is first hashed, not from its
+     * address, and is spread over all 64 bits by the mixer of IdentityHash.
+     * Note that two objects are "the same" if their hash codes are equal.
      *
      * @return A hash code value for this object.
+     * @see IdentityHash
      */
     virtual uint64_t hashCode() const throw ();
 
@@ -219,9 +262,14 @@ class Object {
 
     /**
      * Returns the string type name of this object.
+     *
+     * Type names are demangled once per type and shared process-wide, so this
+     * is cheap and the returned reference remains valid for the life of the
+     * process.
+     *
      * @return The string type name of this object.
      */
-    std::string getTypeName()const;
+    const std::string& getTypeName() const;
 
     /**
      * Returns the textual representation of the object. In general, the
@@ -246,6 +294,11 @@ class Object {
      * lock this object.
      *
      * This method should only be called by a thread that is the owner of this object's monitor.
+     * The awakened thread is moved onto the monitor rather than woken up, and only gets to run
+     * once the monitor has been released.
+     *
+     * @throws IllegalMonitorStateException if the current thread is not the owner of this
+     * object's monitor.
      */
     void notify();
 
@@ -260,6 +313,11 @@ class Object {
      *
      * This method should only be called by a thread that is the owner of this object's monitor. See the
      * notify method for a description of the ways in which a thread can become the owner of a monitor.
+     * The awakened threads are queued on the monitor and handed it one at a time, so they do not
+     * all wake up only to block again.
+     *
+     * @throws IllegalMonitorStateException if the current thread is not the owner of this
+     * object's monitor.
      */
     void notifyAll();
 
@@ -267,6 +325,9 @@ class Object {
      * Causes the current thread to wait until another thread invokes the notify() method
      * or the notifyAll() method for this object. In other words, this method behaves exactly as if
      * it simply performs the call wait(0).
+     *
+     * @throws IllegalMonitorStateException if the current thread is not the owner of this
+     * object's monitor.
      */
     void wait();
 
@@ -274,9 +335,12 @@ class Object {
      * Causes the current thread to wait until either another thread invokes the notify() method or the
      * notifyAll() method for this object, or a specified amount of time has elapsed.
      *
-     * The current thread must own this object's monitor.
+     * The current thread must own this object's monitor. The timeout is measured against a
+     * monotonic clock, so it is not affected by changes to the system time.
      *
      * @param timeout the maximum time to wait in milliseconds
+     * @throws IllegalMonitorStateException if the current thread is not the owner of this
+     * object's monitor.
      */
     void wait(uint64_t timeout);
 
@@ -298,6 +362,9 @@ class Object {
      *
      * @param timeout the maximum time to wait in milliseconds
      * @param nanos additional time, in nanoseconds range 0-999999
+     * @throws IllegalArgumentException if the value of nanos is not in the range 0-999999.
+     * @throws IllegalMonitorStateException if the current thread is not the owner of this
+     * object's monitor.
      */
     void wait(uint64_t timeout, uint64_t nanos);
 
@@ -318,27 +385,38 @@ class Object {
      * will be true, this is not an absolute requirement.
      *
      * @return A pointer to the clone of this object. It is the client's responsibility to release
-     * the pointer.
+     * the pointer, e.g. by wrapping it in a Ref.
      */
     virtual Object* clone();
 
     /**
      * @internal
      */
-    void enterSynchronizedBlock() { }
+    void enterSynchronizedBlock();
 
     /**
      * @internal
      */
-    void exitSynchronizedBlock() { }
-
-  protected:
-    mutable uint64_t m_hashCode;
+    void exitSynchronizedBlock();
 
   private:
-    mutable pthread_mutex_t m_mutex;
-    pthread_mutex_t m_monitorMutex;
-    pthread_cond_t m_monitorCondition;
+    /**
+     * The object header: the identity hash code and the lock word of the
+     * object's monitor, packed in a single word. A full monitor is only
+     * allocated if the object is ever contended.
+     * @see decaf::lang::detail::ObjectHeader
+     */
+    mutable std::atomic<uint64_t> m_header;
+
+    /**
+     * The reference count maintained by Ref, and the thread the object is
+     * confined to; 0 if no Ref manages the object.
+     * @see decaf::lang::detail::ReferenceCount
+     */
+    mutable std::atomic<uint64_t> m_references;
+
+    friend class detail::ObjectHeader;
+    friend class detail::ReferenceCount;
 };
 
 DECAF_CLOSE_NAMESPACE2
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_OBJECTHEADER_HPP
+#define DECAF_OBJECTHEADER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/ThreadRecord.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+class Monitor;
+
+/**
+ * @internal
+ * Accessors for the header word every Object carries. The upper 32 bits hold
+ * the identity hash seed (0 until it is first requested), the lower 32 bits hold
+ * the lock word, whose two low bits tag its state:
+ *
+ *     00  neutral      0 while the monitor may still be biased, 4 afterwards
+ *     01  thin         bits 16-31 hold the id of the owner, bits 2-15 the
+ *                      number of times it re-entered the monitor
+ *     10  inflated     bits 2-31 hold the index of a pooled Monitor
+ *     11  biased       bits 16-31 hold the id of the thread the monitor is
+ *                      biased to; bit 2 is set while the bias is revoked
+ *
+ * The first thread to enter a monitor biases it to itself. From then on it
+ * enters and exits the monitor without any atomic read-modify-write: it only
+ * counts its entries in its ThreadRecord. Another thread wanting the monitor
+ * marks the bias as being revoked and issues an asymmetric barrier
+ * (membarrier(2)), after which either it sees the owner's count or the owner
+ * sees the mark. The monitor is released to the revoker once the owner has
+ * left it; if the owner is inside, the owner converts the bias into an
+ * inflated monitor on its next entry or exit.
+ *
+ * Unbiased monitors are thin-locked with a single compare-and-swap. A thread
+ * that finds a thin lock taken spins for a while, with a budget that adapts
+ * to how often spinning pays off, before inflating it into a Monitor and
+ * parking there.
+ */
+class ObjectHeader {
+  public:
+    static const uint32_t TAG_MASK = 3;
+    static const uint32_t NEUTRAL = 0;
+    static const uint32_t THIN = 1;
+    static const uint32_t INFLATED = 2;
+    static const uint32_t BIASED = 3;
+
+    static const uint32_t UNBIASABLE = 4;
+    static const uint32_t REVOKING = 4;
+
+    static const uint32_t OWNER_SHIFT = 16;
+    static const uint32_t MAX_OWNER = 0xffff;
+    static const uint32_t RECURSION_SHIFT = 2;
+    static const uint32_t MAX_RECURSIONS = 0x3fff;
+    static const uint32_t MONITOR_SHIFT = 2;
+
+    /**
+     * Enters the monitor of @a obj, blocking until it is available.
+     */
+    static void enter(const Object& obj);
+
+    /**
+     * Exits the monitor of @a obj. Does nothing if the calling thread does
+     * not own it.
+     */
+    static void exit(const Object& obj);
+
+    /**
+     * Returns the monitor of @a obj, which the calling thread must own. A thin
+     * or biased lock is inflated first if @a inflate is true; otherwise 0 is
+     * returned for it, as nobody can be waiting on a monitor that was never
+     * inflated.
+     *
+     * @throws IllegalMonitorStateException if the calling thread does not own
+     * the monitor of @a obj
+     */
+    static Monitor* ownedMonitor(const Object& obj, bool inflate);
+
+    /**
+     * Returns the monitor bound to @a obj to the pool, if any. Only called
+     * from the destructor of Object, when no other thread can refer to it.
+     */
+    static void destroy(const Object& obj);
+
+    /**
+     * Returns true if monitors get biased to the first thread entering them.
+     * Biasing needs membarrier(2); it can also be turned off by setting the
+     * DECAF_BIASED_LOCKING environment variable to 0.
+     */
+    static bool isBiasingEnabled();
+
+    static uint32_t lockWord(uint64_t header) {
+        return static_cast<uint32_t> (header);
+    }
+
+    static uint32_t hash(uint64_t header) {
+        return static_cast<uint32_t> (header >> 32);
+    }
+
+    static uint64_t withLockWord(uint64_t header, uint32_t lockWord) {
+        return ((header & ~static_cast<uint64_t> (0xffffffffu)) | lockWord);
+    }
+
+    static uint64_t withHash(uint64_t header, uint32_t hash) {
+        return ((static_cast<uint64_t> (hash) << 32) | lockWord(header));
+    }
+
+    static uint32_t thin(uint32_t owner, uint32_t recursions) {
+        return ((owner << OWNER_SHIFT) | (recursions << RECURSION_SHIFT) | THIN);
+    }
+
+    static uint32_t biased(uint32_t owner) {
+        return ((owner << OWNER_SHIFT) | BIASED);
+    }
+
+    static uint32_t owner(uint32_t lockWord) {
+        return (lockWord >> OWNER_SHIFT);
+    }
+
+    static uint32_t recursions(uint32_t lockWord) {
+        return ((lockWord >> RECURSION_SHIFT) & MAX_RECURSIONS);
+    }
+
+    static uint32_t inflated(uint32_t monitor) {
+        return ((monitor << MONITOR_SHIFT) | INFLATED);
+    }
+
+    static uint32_t monitorIndex(uint32_t lockWord) {
+        return (lockWord >> MONITOR_SHIFT);
+    }
+
+    static std::atomic<uint64_t>& header(const Object& obj) {
+        return obj.m_header;
+    }
+
+  private:
+    /*
+     * Binds a Monitor to obj, owned by owner (unless 0) with the given
+     * recursion count. Returns false if the header changed under us and
+     * nothing was done.
+     */
+    static bool inflate(const Object& obj, uint64_t header, uint32_t owner,
+      uint32_t recursions);
+
+    /*
+     * Binds a free Monitor that collects MonitorProfiler statistics to obj.
+     * Returns false if the header changed under us, or had to be hashed first.
+     */
+    static bool inflateProfiled(const Object& obj, uint64_t header);
+
+    /*
+     * Enters a monitor biased to the calling thread. Returns false if the
+     * bias is being revoked and the caller must start over.
+     */
+    static bool enterBiased(const Object& obj, ThreadRecord& self, uint64_t header);
+
+    /*
+     * Called by the thread a monitor is biased to, to replace the bias by an
+     * inflated monitor carrying its count of entries, or by an unbiasable
+     * neutral lock word if it holds none.
+     */
+    static void unbias(const Object& obj, ThreadRecord& self,
+      ThreadRecord::BiasedLock* entry);
+
+    /*
+     * Called by any other thread to take the bias away from its owner. Waits
+     * until the owner has left the monitor.
+     */
+    static void revokeBias(const Object& obj, uint64_t header);
+};
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_OBJECTHEADER_HPP
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_REF_HPP
+#define DECAF_REF_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/ReferenceCount.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+
+/**
+ * An intrusive reference-counted handle to an Object. Unlike std::shared_ptr
+ * it needs no separate control block: the count lives in the object itself.
+ *
+ * An object starts out confined to the thread that wrapped it in its first
+ * Ref, and that thread counts references with plain, non-atomic stores. The
+ * first time another thread copies or destroys a Ref to it, the count
+ * switches to atomic updates for good. The switch waits for an asymmetric
+ * barrier, so share() is cheaper when an object is known to be headed for
+ * other threads.
+ *
+ *     Ref<Foo> foo(new Foo());
+ *     Ref<Foo> copy = foo;            // plain increment
+ *     queue.push(foo.share());        // atomic from now on
+ *
+ * @param T Object or a class derived from it
+ */
+template<typename T>
+class Ref {
+    static_assert(std::is_base_of<Object, T>::value, "Ref<T> requires T to derive from Object");
+
+  public:
+    Ref() throw () : m_object(0) { }
+
+    Ref(std::nullptr_t) throw () : m_object(0) { }
+
+    /**
+     * Takes ownership of @a object, which must have been allocated with new
+     * and must not be managed by another Ref yet.
+     *
+     * @throws IllegalStateException if @a object is already managed by a Ref
+     */
+    explicit Ref(T* object) : m_object(object) {
+        if (object != 0)
+            detail::ReferenceCount::adopt(*object);
+    }
+
+    Ref(const Ref& other) : m_object(other.m_object) {
+        if (m_object != 0)
+            detail::ReferenceCount::retain(*m_object);
+    }
+
+    template<typename U>
+    Ref(const Ref<U>& other) : m_object(other.get()) {
+        if (m_object != 0)
+            detail::ReferenceCount::retain(*m_object);
+    }
+
+    Ref(Ref&& other) throw () : m_object(other.m_object) {
+        other.m_object = 0;
+    }
+
+    ~Ref() {
+        if (m_object != 0)
+            detail::ReferenceCount::release(*m_object);
+    }
+
+    Ref& operator=(Ref other) throw () {
+        std::swap(m_object, other.m_object);
+        return *this;
+    }
+
+    /**
+     * Drops the reference held by this handle, if any.
+     */
+    void reset() throw () {
+        Ref().swap(*this);
+    }
+
+    void swap(Ref& other) throw () {
+        std::swap(m_object, other.m_object);
+    }
+
+    /**
+     * Switches the object to atomic reference counting ahead of other
+     * threads copying and destroying Refs to it. Does nothing if it already
+     * is shared or if this handle is null.
+     *
+     * @return this handle
+     */
+    Ref& share() {
+        if (m_object != 0)
+            detail::ReferenceCount::share(*m_object);
+        return *this;
+    }
+
+    /**
+     * Returns true if the object is counted atomically.
+     */
+    bool isShared() const {
+        return (m_object != 0 && detail::ReferenceCount::isShared(*m_object));
+    }
+
+    T* get() const throw () {
+        return m_object;
+    }
+
+    T* operator->() const throw () {
+        return m_object;
+    }
+
+    T& operator*() const throw () {
+        return *m_object;
+    }
+
+    explicit operator bool() const throw () {
+        return m_object != 0;
+    }
+
+  private:
+    T* m_object;
+};
+
+template<typename T, typename U>
+inline bool operator==(const Ref<T>& lhs, const Ref<U>& rhs) {
+    return lhs.get() == rhs.get();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const Ref<T>& lhs, const Ref<U>& rhs) {
+    return lhs.get() != rhs.get();
+}
+
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_REF_HPP
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_REFERENCECOUNT_HPP
+#define DECAF_REFERENCECOUNT_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/ThreadRecord.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * The reference count of an Object managed by Ref. The count lives in the
+ * second word of the object header, next to the token of the thread it is
+ * confined to:
+ *
+ *     owner token (32 bits) | revoking (1 bit) | count (31 bits)
+ *
+ * A word of 0 means the object is not managed by any Ref. Once the first Ref
+ * adopts it, the object is confined to the adopting thread, which updates the
+ * count with plain loads and stores. The first time another thread retains or
+ * releases it, or share() is called, the count switches to shared: the owner
+ * token is cleared, and from then on every thread updates the count with
+ * atomic read-modify-writes.
+ *
+ * The switch works like the revocation of a biased monitor. The owner
+ * publishes the object in its ThreadRecord before it checks the word and
+ * stores the new count. The other thread marks the word as revoking and
+ * issues an asymmetric barrier, after which either the owner sees the mark
+ * and backs off, or the other thread sees the object published and waits
+ * for the owner to finish. Tokens are never handed to another thread, so a
+ * count confined to a thread that has exited is simply taken over.
+ */
+class ReferenceCount {
+  public:
+    static const uint64_t COUNT_MASK = 0x7fffffffull;
+    static const uint64_t REVOKING = 0x80000000ull;
+    static const uint32_t OWNER_SHIFT = 32;
+
+    /**
+     * Makes the calling thread the owner of @a object, with one reference.
+     *
+     * @throws IllegalStateException if the object is already managed
+     */
+    static void adopt(const Object& object);
+
+    /**
+     * Adds a reference to @a object.
+     */
+    static void retain(const Object& object) {
+        std::atomic<uint64_t>& word = object.m_references;
+        if (owner(word.load(std::memory_order_relaxed)) == 0)
+            word.fetch_add(1, std::memory_order_relaxed);
+        else if (updateConfined(object, 1) == 0)
+            retainShared(object);
+    }
+
+    /**
+     * Drops a reference to @a object, deleting it with the last one.
+     */
+    static void release(const Object& object) throw () {
+        std::atomic<uint64_t>& word = object.m_references;
+        uint32_t before;
+        if (owner(word.load(std::memory_order_relaxed)) == 0)
+            before = count(word.fetch_sub(1, std::memory_order_acq_rel));
+        else if ((before = updateConfined(object, -1)) == 0)
+            before = releaseShared(object);
+
+        if (before == 1)
+            delete &object;
+    }
+
+    /**
+     * Switches @a object to atomic counting ahead of other threads referring
+     * to it, which spares the first of them the switch. Does nothing if it
+     * is already shared.
+     */
+    static void share(const Object& object);
+
+    /**
+     * Returns true if @a object is managed by a Ref.
+     */
+    static bool isManaged(const Object& object) {
+        return object.m_references.load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     * Returns true if @a object may be referenced by any thread without
+     * switching its count first.
+     */
+    static bool isShared(const Object& object) {
+        return owner(object.m_references.load(std::memory_order_relaxed)) == 0;
+    }
+
+    static uint32_t owner(uint64_t references) {
+        return static_cast<uint32_t> (references >> OWNER_SHIFT);
+    }
+
+    static uint32_t count(uint64_t references) {
+        return static_cast<uint32_t> (references & COUNT_MASK);
+    }
+
+  private:
+    /*
+     * Adds delta to the count of object if it is confined to the calling
+     * thread and not being switched to shared. Returns the count before, or
+     * 0 if the caller has to go through the shared count.
+     */
+    static uint32_t updateConfined(const Object& object, int32_t delta) {
+        std::atomic<uint64_t>& word = object.m_references;
+        ThreadRecord& self = ThreadRecord::current();
+        const uint32_t token = self.token();
+        if (owner(word.load(std::memory_order_relaxed)) != token)
+            return 0;
+
+        self.m_countedObject.store(&object, std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+
+        uint32_t before = 0;
+        const uint64_t references = word.load(std::memory_order_relaxed);
+        if (owner(references) == token && (references & REVOKING) == 0) {
+            before = count(references);
+            word.store(references + static_cast<uint64_t> (static_cast<int64_t> (delta)),
+              std::memory_order_relaxed);
+        }
+        self.m_countedObject.store(0, std::memory_order_release);
+        return before;
+    }
+
+    static void retainShared(const Object& object);
+    static uint32_t releaseShared(const Object& object) throw ();
+    static void unconfine(const Object& object) throw ();
+};
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_REFERENCECOUNT_HPP
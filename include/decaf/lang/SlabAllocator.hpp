@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_SLABALLOCATOR_HPP
+#define DECAF_SLABALLOCATOR_HPP
+
+#include <cstddef>
+
+#include "decaf/lang/compatibility.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * A size-class allocator for small objects, in the style of Bonwick's
+ * magazines. Requests up to MAX_SIZE bytes are rounded up to a multiple of
+ * GRANULE and served from slabs carved into blocks of that size; larger
+ * requests go to the global operator new.
+ *
+ * Every thread caches two magazines (arrays of free blocks) per size class,
+ * so allocating and freeing touch nothing but thread-local memory until a
+ * magazine runs full or empty. Full and empty magazines are then exchanged
+ * with a mutex-protected depot. A block freed by another thread than the one
+ * that allocated it simply goes to the freeing thread's magazine, so there is
+ * no remote free queue to drain.
+ *
+ * Blocks carry no header: the caller passes the size back to deallocate(),
+ * which is what sized operator delete provides. Slabs are never returned to
+ * the system.
+ */
+class SlabAllocator {
+  public:
+    static const size_t GRANULE = 16;
+    static const size_t MAX_SIZE = 512;
+    static const size_t SIZE_CLASSES = MAX_SIZE / GRANULE;
+
+    /**
+     * Returns a block of at least @a size bytes, aligned to GRANULE.
+     *
+     * @throws std::bad_alloc if memory is exhausted
+     */
+    static void* allocate(size_t size);
+
+    /**
+     * Frees a block returned by allocate(). @a size must be the size it was
+     * allocated with.
+     */
+    static void deallocate(void* block, size_t size) throw ();
+
+    /**
+     * Returns true if Object subclasses are allocated from the slabs, i.e.
+     * the library was built with DECAF_SLAB_ALLOCATOR.
+     */
+    static bool isEnabledForObjects();
+};
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_SLABALLOCATOR_HPP
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_SPINWAIT_HPP
+#define DECAF_SPINWAIT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <sched.h>
+
+#include "decaf/lang/compatibility.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * Tells the processor that the calling thread is busy-waiting, which saves
+ * power and frees pipeline resources for a sibling hyper-thread.
+ */
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+/**
+ * @internal
+ * Returns true if busy-waiting can ever pay off, i.e. if more than one
+ * processor is online. On a single processor the owner of a lock cannot make
+ * progress while we spin, so spinning is pure waste.
+ */
+bool isSpinningUseful();
+
+/**
+ * @internal
+ * Exponential backoff for spin loops: each call to spinOnce() pauses twice as
+ * long as the previous one, up to a cap, so that spinning threads do not
+ * hammer the cache line they are waiting on.
+ */
+class SpinWait {
+  public:
+    SpinWait() : m_pauses(1) { }
+
+    /**
+     * Pauses for the current backoff period and doubles it.
+     */
+    void spinOnce() {
+        for (uint32_t i = 0; i < m_pauses; ++i)
+            cpuRelax();
+        if (m_pauses < MAX_PAUSES)
+            m_pauses <<= 1;
+    }
+
+    /**
+     * Returns the number of pauses the next call to spinOnce() performs.
+     */
+    uint32_t pauses() const {
+        return m_pauses;
+    }
+
+    static const uint32_t MAX_PAUSES = 64;
+
+  private:
+    uint32_t m_pauses;
+};
+
+/**
+ * @internal
+ * Backoff for the waiters of pure spin locks, which have nowhere to sleep:
+ * spins with exponential backoff for a while, then yields the processor on
+ * every call, so that a preempted lock holder gets to run and release the
+ * lock. Never spins on a single processor.
+ */
+class SpinThenYield {
+  public:
+    SpinThenYield() : m_spent(0) { }
+
+    /**
+     * Pauses for the current backoff period, or yields once the spin limit
+     * is spent.
+     */
+    void pause() {
+        if (m_spent < SPIN_LIMIT && isSpinningUseful()) {
+            m_spent += m_backoff.pauses();
+            m_backoff.spinOnce();
+        } else {
+            sched_yield();
+        }
+    }
+
+    static const uint32_t SPIN_LIMIT = 4096;
+
+  private:
+    SpinWait m_backoff;
+    uint32_t m_spent;
+};
+
+/**
+ * @internal
+ * An adaptive spin budget, in the spirit of the adaptive spinning of the
+ * HotSpot VM: every time spinning acquires the lock the budget doubles, every
+ * time it fails the budget halves. Locks with short critical sections thus
+ * end up spinning long enough to avoid parking, while locks held for long
+ * stretches quickly stop wasting cycles.
+ */
+class AdaptiveSpin {
+  public:
+    AdaptiveSpin() : m_budget(INITIAL_BUDGET) { }
+
+    /**
+     * Busy-waits, with exponential backoff, until @a acquired returns true or
+     * the budget is spent, and adapts the budget to the outcome. Never spins
+     * on a single processor.
+     *
+     * @return true if @a acquired returned true
+     */
+    template <typename Predicate>
+    bool spin(Predicate acquired) {
+        if (!isSpinningUseful())
+            return false;
+
+        const uint32_t budget = m_budget.load(std::memory_order_relaxed);
+        SpinWait backoff;
+        for (uint32_t spent = 0; spent < budget; spent += backoff.pauses()) {
+            backoff.spinOnce();
+            if (acquired()) {
+                if (budget < MAX_BUDGET)
+                    m_budget.store(budget << 1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        if (budget > MIN_BUDGET)
+            m_budget.store(budget >> 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    static const uint32_t MIN_BUDGET = 64;
+    static const uint32_t INITIAL_BUDGET = 1024;
+    static const uint32_t MAX_BUDGET = 16384;
+
+  private:
+    std::atomic<uint32_t> m_budget;
+};
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_SPINWAIT_HPP
@@ -25,11 +25,13 @@ DECAF_OPEN_NAMESPACE2(decaf, lang)
 
 /**
  * @internal
+ * Holds the monitor of an object for the lifetime of a synchronized block.
+ * Not copyable, so that the monitor is exited exactly once.
  */
 class Synchronized {
   public:
 
-    Synchronized(Object& lockable) : m_lockable(lockable) {
+    explicit Synchronized(Object& lockable) : m_lockable(lockable) {
         m_lockable.enterSynchronizedBlock();
     }
 
@@ -37,7 +39,10 @@ class Synchronized {
         m_lockable.exitSynchronizedBlock();
     }
 
-    operator bool() const {
+    Synchronized(const Synchronized& other) = delete;
+    Synchronized& operator=(const Synchronized& rhs) = delete;
+
+    explicit operator bool() const {
         return true;
     }
   private:
@@ -46,8 +51,22 @@ class Synchronized {
 
 DECAF_CLOSE_NAMESPACE2
 
+/**
+ * Executes the statement that follows while holding the monitor of the object
+ * @a obj points to, the way a Java synchronized block does. Blocks nest and
+ * may re-enter a monitor the current thread already holds; the monitor is
+ * released when the statement completes, normally or by an exception.
+ *
+ * @code{.cpp}
+ *    synchronized(&queue) {
+ *        while (queue.isEmpty())
+ *            queue.wait();
+ *        item = queue.take();
+ *    }
+ * @endcode
+ */
 #define synchronized(obj) \
-    if (decaf::lang::Synchronized DECAF_UNIQUE_IDENTIFIER(decaf_lock_) = *obj)
+    if (decaf::lang::Synchronized DECAF_UNIQUE_IDENTIFIER(decaf_lock_){*obj})
 
 #endif	/* DECAF_SYNCHRONIZED_HPP */
 
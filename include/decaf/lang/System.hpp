@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_SYSTEM_HPP
+#define DECAF_SYSTEM_HPP
+
+#include <cstdint>
+#include <ctime>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/TscClock.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+
+/**
+ * Access to the clocks of the system.
+ *
+ * nanoTime(), fastNanoTime() and coarseNanoTime() all read CLOCK_MONOTONIC,
+ * in nanoseconds since an arbitrary origin, so their readings may be compared
+ * and subtracted. They differ in cost and accuracy:
+ *
+ *  - nanoTime() calls clock_gettime(), which the vDSO serves without entering
+ *    the kernel when the clock source allows it. Use it for timeouts.
+ *
+ *  - fastNanoTime() extrapolates CLOCK_MONOTONIC from the time stamp counter,
+ *    recalibrated against it at least once a second, and is within a few
+ *    microseconds of nanoTime(). Use it for the timestamps of hot paths, e.g.
+ *    latency measurements. Falls back on nanoTime() where the TSC is not
+ *    invariant or not available.
+ *
+ *  - coarseNanoTime() reads CLOCK_MONOTONIC_COARSE, the time of the last
+ *    scheduler tick, which is as cheap as a memory load but lags by up to
+ *    coarseNanoTimeResolution(), a few milliseconds. Use it where that is
+ *    precise enough, e.g. for idle timeouts and cache expiry.
+ */
+class System {
+  public:
+    /**
+     * Returns the current time of CLOCK_MONOTONIC, in nanoseconds.
+     */
+    static uint64_t nanoTime() {
+        return detail::monotonicNanos();
+    }
+
+    /**
+     * Returns the current time of CLOCK_MONOTONIC, in nanoseconds, read from
+     * the time stamp counter. Readings never go backwards.
+     */
+    static uint64_t fastNanoTime() {
+#ifdef DECAF_HAS_TSC_CLOCK
+        return detail::TscClock::now();
+#else
+        return nanoTime();
+#endif
+    }
+
+    /**
+     * Returns true if fastNanoTime() reads the time stamp counter rather than
+     * calling nanoTime().
+     */
+    static bool isFastNanoTimeTsc() {
+#ifdef DECAF_HAS_TSC_CLOCK
+        return detail::TscClock::isTscUsed();
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * Returns the time of CLOCK_MONOTONIC at the last scheduler tick, in
+     * nanoseconds.
+     */
+    static uint64_t coarseNanoTime() {
+        struct timespec time;
+        clock_gettime(COARSE_CLOCK, &time);
+        return static_cast<uint64_t> (time.tv_sec) * 1000000000u + static_cast<uint64_t> (time.tv_nsec);
+    }
+
+    /**
+     * Returns the resolution of coarseNanoTime(), in nanoseconds.
+     */
+    static uint64_t coarseNanoTimeResolution() {
+        struct timespec resolution;
+        clock_getres(COARSE_CLOCK, &resolution);
+        return static_cast<uint64_t> (resolution.tv_sec) * 1000000000u + static_cast<uint64_t> (resolution.tv_nsec);
+    }
+
+    /**
+     * Returns the current wall clock time, in milliseconds since the epoch.
+     * Unlike the other clocks, it jumps when the system time is set.
+     */
+    static uint64_t currentTimeMillis() {
+        struct timespec time;
+        clock_gettime(CLOCK_REALTIME, &time);
+        return static_cast<uint64_t> (time.tv_sec) * 1000u + static_cast<uint64_t> (time.tv_nsec) / 1000000u;
+    }
+
+  private:
+    System() = delete;
+
+#ifdef CLOCK_MONOTONIC_COARSE
+    static const clockid_t COARSE_CLOCK = CLOCK_MONOTONIC_COARSE;
+#else
+    static const clockid_t COARSE_CLOCK = CLOCK_MONOTONIC;
+#endif
+};
+
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_SYSTEM_HPP
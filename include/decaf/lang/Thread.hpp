@@ -18,8 +18,19 @@
 #ifndef DECAF_THREAD_HPP
 #define DECAF_THREAD_HPP
 
-#include "decaf/lang/Commmon.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Ref.hpp"
 #include "decaf/lang/Runnable.hpp"
+#include "decaf/lang/ThreadGroup.hpp"
 
 DECAF_OPEN_NAMESPACE2(decaf, lang)
 
@@ -35,9 +46,305 @@ DECAF_OPEN_NAMESPACE2(decaf, lang)
  * Every thread has a name for identification purposes. More than one thread may have
  * the same name. If a name is not specified when a thread is created, a new name is
  * generated for it.
+ *
+ * Threads run on detached pthreads. The process waits for the threads that
+ * are not daemons when it exits normally, as the Java virtual machine does;
+ * daemon threads are simply abandoned.
+ *
+ * A started thread needs its Thread object until it terminates. A Thread
+ * managed by a Ref is kept alive by the running thread itself; any other
+ * Thread waits for its thread to terminate when it is destroyed. By then the
+ * destructors of subclasses have run, so a subclass overriding Run() must
+ * join in its own destructor.
+ *
+ * Threads not started through this class, such as the main thread, get a
+ * Thread object of their own the first time they call currentThread(), which
+ * goes away when they exit. They belong to ThreadGroup::mainGroup().
+ *
+ * A thread is interrupted by setting its interrupt status, which sleep() and
+ * join() check: they throw InterruptedException, clearing the status, if it
+ * is set when they are called or while they wait.
  */
 class Thread : public Runnable {
-} // class Thread
+  public:
+    static const int MIN_PRIORITY = 1;
+    static const int NORM_PRIORITY = 5;
+    static const int MAX_PRIORITY = 10;
+
+    /**
+     * Allocates a new Thread whose Run() method does nothing, for subclasses
+     * to override.
+     */
+    Thread();
+
+    /**
+     * Allocates a new Thread that runs @a target.
+     */
+    explicit Thread(const Ref<Runnable>& target);
+
+    /**
+     * Allocates a new Thread named @a name, for subclasses to override Run().
+     */
+    explicit Thread(const std::string& name);
+
+    /**
+     * Allocates a new Thread named @a name that runs @a target on a stack of
+     * @a stackSize bytes, or of the default size if 0.
+     */
+    Thread(const Ref<Runnable>& target, const std::string& name, size_t stackSize = 0);
+
+    /**
+     * Allocates a new Thread in @a group named @a name that runs @a target on
+     * a stack of @a stackSize bytes, or of the default size if 0. The other
+     * constructors put the thread in the group of the calling thread.
+     */
+    Thread(const Ref<ThreadGroup>& group, const Ref<Runnable>& target, const std::string& name,
+      size_t stackSize = 0);
+
+    /**
+     * Waits for the thread to terminate if it was started and this object is
+     * not managed by a Ref.
+     */
+    virtual ~Thread();
+
+    /**
+     * Runs the target this thread was created with, if any. Subclasses
+     * override this method instead of passing a target.
+     */
+    virtual void Run();
+
+    /**
+     * Causes this thread to begin execution, calling Run() on a new thread.
+     * The thread starts with the name, priority and CPU affinity set so far,
+     * or with the CPUs of its group if it was given none.
+     *
+     * @throws IllegalThreadStateException if the thread was already started
+     * @throws Error if the system cannot create another thread
+     */
+    void start();
+
+    /**
+     * Waits for this thread to terminate. Returns immediately if it was never
+     * started.
+     *
+     * @throws InterruptedException if the calling thread is interrupted
+     */
+    void join();
+
+    /**
+     * Waits at most @a millis milliseconds plus @a nanos nanoseconds for this
+     * thread to terminate. A timeout of 0 means to wait forever.
+     *
+     * @return true if the thread is not alive anymore
+     * @throws IllegalArgumentException if nanos is not in the range 0-999999
+     * @throws InterruptedException if the calling thread is interrupted
+     */
+    bool join(uint64_t millis, uint64_t nanos = 0);
+
+    /**
+     * Returns true if this thread was started and has not terminated yet.
+     */
+    bool isAlive() const;
+
+    /**
+     * Returns the identifier of this thread, a positive number unique for the
+     * life of the process.
+     */
+    uint64_t getId() const {
+        return m_id;
+    }
+
+    std::string getName() const;
+
+    /**
+     * Changes the name of this thread, and that of the system thread if it
+     * is running, which tools such as top and gdb show truncated to 15
+     * characters.
+     */
+    void setName(const std::string& name);
+
+    /**
+     * Returns the group this thread belongs to.
+     */
+    ThreadGroup* getThreadGroup() const {
+        return m_group.get();
+    }
+
+    /**
+     * Sets the interrupt status of this thread, and wakes it up if it waits
+     * in sleep() or join().
+     */
+    void interrupt();
+
+    /**
+     * Returns true if the interrupt status of this thread is set.
+     */
+    bool isInterrupted() const {
+        return m_interrupted.load(std::memory_order_acquire) != 0;
+    }
+
+    /**
+     * Returns true if the interrupt status of the calling thread was set, and
+     * clears it.
+     */
+    static bool interrupted();
+
+    bool isDaemon() const {
+        return m_daemon;
+    }
+
+    /**
+     * Marks this thread as a daemon thread, which the process does not wait
+     * for when it exits.
+     *
+     * @throws IllegalThreadStateException if the thread was already started
+     */
+    void setDaemon(bool on);
+
+    int getPriority() const;
+
+    /**
+     * Changes the priority of this thread, which maps to the nice value of
+     * the system thread: NORM_PRIORITY is a nice value of 0, and every step
+     * above or below it one less or one more. Raising a thread above the
+     * nice value of the process takes the CAP_SYS_NICE capability or a
+     * suitable RLIMIT_NICE; without them the priority is recorded but the
+     * nice value left alone.
+     *
+     * @throws IllegalArgumentException if priority is not in the range
+     * MIN_PRIORITY-MAX_PRIORITY
+     */
+    void setPriority(int priority);
+
+    /**
+     * Returns the stack size this thread was or will be started with, 0 for
+     * the default size.
+     */
+    size_t getStackSize() const;
+
+    /**
+     * Sets the size of the stack this thread starts with, rounded up to the
+     * minimum the system accepts; 0 selects the default size.
+     *
+     * @throws IllegalThreadStateException if the thread was already started
+     */
+    void setStackSize(size_t stackSize);
+
+    /**
+     * Returns the CPUs this thread may run on. For a thread not started yet,
+     * that is the CPUs it will be pinned to when started, empty if it is to
+     * inherit the affinity of the thread starting it.
+     */
+    std::vector<int> getAffinity() const;
+
+    /**
+     * Pins this thread to @a cpus. A thread not started yet is created on
+     * them, so that it never runs, nor first touches memory, anywhere else.
+     * An empty list lets a thread not started yet inherit the affinity of
+     * the thread starting it.
+     *
+     * @throws IllegalArgumentException if a CPU number is out of range, if
+     * none of the CPUs may be used by the process, or if the list is empty
+     * and the thread is running
+     */
+    void setAffinity(const std::vector<int>& cpus);
+
+    /**
+     * Pins this thread to @a cpu alone.
+     *
+     * @throws IllegalArgumentException as setAffinity(const std::vector<int>&)
+     */
+    void setAffinity(int cpu);
+
+    virtual std::string toString() const;
+
+    /**
+     * Returns the Thread object of the calling thread: a single thread-local
+     * load, once the thread has one.
+     */
+    static Thread* currentThread() {
+        Thread* thread = t_current;
+        return ((thread != 0) ? thread : attach());
+    }
+
+    /**
+     * Hints the scheduler that the calling thread is willing to give up its
+     * CPU.
+     */
+    static void yield();
+
+    /**
+     * Makes the calling thread sleep for @a millis milliseconds plus
+     * @a nanos nanoseconds, as precisely as TimeUnit::sleep() does.
+     *
+     * @throws IllegalArgumentException if nanos is not in the range 0-999999
+     * @throws InterruptedException if the calling thread is interrupted
+     */
+    static void sleep(uint64_t millis, uint64_t nanos = 0);
+
+  private:
+    Thread(const Thread& other) = delete;
+    Thread& operator=(const Thread& rhs) = delete;
+
+    enum State { NEW, ALIVE, TERMINATED, STATE_MASK = 3, JOINING = 4 };
+
+    Thread(pid_t tid, const std::string& name);
+
+    bool joinUntil(uint64_t deadline, bool interruptible);
+    void exit();
+    void checkInterrupted(const char* what);
+    void sampleUsage(ThreadGroup::Usage& usage) const;
+    void applyName();
+    void applyPriority();
+
+    static void* threadMain(void* argument);
+    static Thread* attach();
+    static void detach(Thread* thread);
+
+    static DECAF_THREAD_LOCAL Thread* t_current DECAF_INITIAL_EXEC_TLS;
+
+    Ref<Runnable> m_target;
+    const Ref<ThreadGroup> m_group;
+    uint64_t m_id;
+
+    /*
+     * NEW, ALIVE or TERMINATED, and JOINING once a thread waits in join().
+     */
+    std::atomic<uint32_t> m_state;
+
+    /*
+     * The interrupt status, which sleep() waits on, and the futex the thread
+     * waits on in join(), for interrupt() to wake it.
+     */
+    std::atomic<uint32_t> m_interrupted;
+    std::atomic<std::atomic<uint32_t>*> m_blocker;
+
+    bool m_daemon;
+    bool m_managed;
+    bool m_attached;
+
+    /*
+     * Guards the attributes below against the thread starting or exiting
+     * while another thread changes them; m_tid is the system thread's
+     * identifier while it runs, 0 otherwise.
+     */
+    mutable std::mutex m_lock;
+    std::string m_name;
+    int m_priority;
+    size_t m_stackSize;
+    std::vector<int> m_affinity;
+    pthread_t m_handle;
+    pid_t m_tid;
+
+    /*
+     * The list of live threads of m_group, guarded by its lock.
+     */
+    Thread* m_groupPrevious;
+    Thread* m_groupNext;
+
+    friend class ThreadDetacher;
+    friend class ThreadGroup;
+}; // class Thread
 
 DECAF_CLOSE_NAMESPACE2
 
@@ -18,19 +18,183 @@
 #ifndef DECAF_THREADGROUP_HPP
 #define DECAF_THREADGROUP_HPP
 
-#include "decaf/lang/Commmon.hpp"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/Ref.hpp"
 
 DECAF_OPEN_NAMESPACE2(decaf, lang)
 
+class Thread;
+
 /**
  * A thread group represents a set of threads. In addition, a thread group can also include
  * other thread groups. The thread groups form a tree in which every thread group except the
  * initial thread group has a parent.
  *
- * A thread is allowed to access information about its own thread group, but not to access information about its thread group's parent thread group or any other thread groups.
+ * Groups are the unit of resource accounting: a group sums the CPU time and
+ * context switches of the threads of its subtree, those that terminated
+ * included, so that a pool burning cores shows up without a profiler. It
+ * also pins and interrupts all of them at once.
+ *
+ * Groups are managed by Ref. Every thread holds a reference to its group, and
+ * every group to its parent, so a group lives as long as anything in its
+ * subtree; its accounting then rolls up into its parent. Threads not started
+ * through Thread, the main thread among them, belong to the initial group,
+ * named "main".
  */
 class ThreadGroup : public Object {
-} // class Thread
+  public:
+    /**
+     * A snapshot of the resources used by the threads of a subtree.
+     */
+    struct Usage {
+        Usage() : m_cpuTimeNanos(0), m_voluntarySwitches(0), m_involuntarySwitches(0), m_activeThreads(0),
+          m_terminatedThreads(0) { }
+
+        void add(const Usage& other);
+
+        /*
+         * CPU time, user and system, of every thread.
+         */
+        uint64_t m_cpuTimeNanos;
+
+        /*
+         * Switches away from the threads because they blocked, and because
+         * the scheduler preempted them. Many involuntary switches mean more
+         * runnable threads than cores.
+         */
+        uint64_t m_voluntarySwitches;
+        uint64_t m_involuntarySwitches;
+
+        uint32_t m_activeThreads;
+        uint32_t m_terminatedThreads;
+    };
+
+    /**
+     * Creates a group named @a name, child of the group of the calling
+     * thread.
+     */
+    explicit ThreadGroup(const std::string& name);
+
+    /**
+     * Creates a group named @a name, child of @a parent.
+     */
+    ThreadGroup(const Ref<ThreadGroup>& parent, const std::string& name);
+
+    virtual ~ThreadGroup();
+
+    const std::string& getName() const {
+        return m_name;
+    }
+
+    /**
+     * Returns the parent of this group, 0 for the initial group.
+     */
+    ThreadGroup* getParent() const {
+        return m_parent;
+    }
+
+    /**
+     * Returns true if this group is @a group or one of its ancestors.
+     */
+    bool parentOf(const ThreadGroup* group) const;
+
+    /**
+     * Returns the number of live threads in this group and its subgroups.
+     */
+    uint32_t activeCount() const;
+
+    /**
+     * Returns the number of groups below this one.
+     */
+    uint32_t activeGroupCount() const;
+
+    /**
+     * Returns the resources used by the threads of this group and its
+     * subgroups. The CPU time of live threads is read from their
+     * CLOCK_THREAD_CPUTIME_ID clocks and their context switches from
+     * /proc/self/task, so that it takes a few microseconds per thread.
+     */
+    Usage getUsage() const;
+
+    /**
+     * Returns the CPU time used by the threads of this group and its
+     * subgroups.
+     */
+    uint64_t getCpuTimeNanos() const {
+        return getUsage().m_cpuTimeNanos;
+    }
+
+    /**
+     * Pins every live thread of this group and its subgroups to @a cpus, and
+     * makes them the CPUs of the threads started in this subtree from then
+     * on, unless they were given CPUs of their own. An empty list pins
+     * nothing and lets new threads inherit the affinity of the thread that
+     * starts them again.
+     *
+     * @throws IllegalArgumentException as Thread::setAffinity()
+     */
+    void setAffinity(const std::vector<int>& cpus);
+
+    /**
+     * Returns the CPUs set by setAffinity(), on this group or the nearest
+     * ancestor that has some; empty if none has.
+     */
+    std::vector<int> getAffinity() const;
+
+    /**
+     * Interrupts every live thread of this group and its subgroups.
+     */
+    void interrupt();
+
+    virtual std::string toString() const;
+
+    /**
+     * Returns the initial group.
+     */
+    static const Ref<ThreadGroup>& mainGroup();
+
+  private:
+    ThreadGroup();
+    ThreadGroup(const ThreadGroup& other) = delete;
+    ThreadGroup& operator=(const ThreadGroup& rhs) = delete;
+
+    void attach();
+
+    void add(Thread* thread);
+    void remove(Thread* thread, const Usage* usage);
+
+    void collect(Usage& usage) const;
+
+    const std::string m_name;
+
+    /*
+     * Holds a reference to the parent, as a Ref would.
+     */
+    ThreadGroup* const m_parent;
+
+    /*
+     * Guards everything below. Locks are taken from the root down, and
+     * before those of threads.
+     */
+    mutable std::mutex m_lock;
+    std::vector<ThreadGroup*> m_children;
+    Thread* m_threads;
+    std::vector<int> m_affinity;
+
+    /*
+     * What the terminated threads of this group and its destroyed subgroups
+     * used.
+     */
+    Usage m_retired;
+
+    friend class Thread;
+}; // class ThreadGroup
 
 DECAF_CLOSE_NAMESPACE2
 
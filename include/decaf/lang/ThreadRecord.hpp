@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_THREADRECORD_HPP
+#define DECAF_THREADRECORD_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/SpinWait.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * Per-thread bookkeeping used by the object monitors. Every thread that
+ * touches a monitor is given a small, non-zero identifier which is what gets
+ * stored in an Object's lock word. Records are recycled when their thread
+ * exits, so identifiers stay dense and rarely exceed a few thousand.
+ */
+class ThreadRecord {
+  public:
+    /**
+     * Returns the record of the calling thread, creating it on first use.
+     */
+    static ThreadRecord& current() {
+        ThreadRecord* record = t_current;
+        return ((record != 0) ? *record : attach());
+    }
+
+    /**
+     * Returns the record last created with identifier @a id, or 0 if there
+     * is none. Only identifiers that fit in a thin lock word (up to 0xffff)
+     * are indexed. Records are recycled rather than freed, so the record
+     * stays indexed after its thread exits, and may belong to the thread
+     * that reused it since: use forToken() to tell.
+     */
+    static ThreadRecord* forId(uint32_t id) {
+        return ((id < MAX_INDEXED_IDS) ? s_records[id].load(std::memory_order_acquire) : 0);
+    }
+
+    /**
+     * Returns the record of the live thread holding @a token, or 0 if that
+     * thread has exited.
+     */
+    static ThreadRecord* forToken(uint32_t token) {
+        ThreadRecord* record = forId(token & (MAX_INDEXED_IDS - 1));
+        return ((record != 0 && record->token() == token) ? record : 0);
+    }
+
+    /**
+     * Returns the identifier of this thread, never 0.
+     */
+    uint32_t id() const {
+        return m_id;
+    }
+
+    /**
+     * Returns the token reference counts get confined to this thread with,
+     * or 0 if they cannot be. Unlike the identifier, a token is not handed on
+     * with the record to the next thread: it carries a generation that every
+     * new thread bumps, and reads 0 once its thread has exited.
+     * @see ReferenceCount
+     */
+    uint32_t token() const {
+        return m_token.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns true if asymmetricBarrier() may be used. The first call
+     * registers the process for it.
+     */
+    static bool hasAsymmetricBarrier();
+
+    /**
+     * Forces a full memory barrier on every other running thread of the
+     * process, which is what lets the owner of a bias or of a confined
+     * reference count get away with plain stores.
+     */
+    static void asymmetricBarrier();
+
+    /**
+     * A monitor this thread holds through a bias, and how many times it
+     * entered it. Only the owning thread writes these; other threads read
+     * them to find out whether a bias can be revoked.
+     * @see ObjectHeader
+     */
+    struct BiasedLock {
+        std::atomic<const void*> m_object;
+        std::atomic<uint32_t> m_count;
+    };
+
+    /**
+     * Returns the entry recording how many times this thread entered the
+     * biased monitor of @a object, claiming a free entry for it if it has
+     * none. Returns 0 if all entries are taken. Only called by the owner.
+     */
+    BiasedLock* claimBiasedLock(const void* object) {
+        BiasedLock* free = 0;
+        for (size_t i = 0; i < MAX_BIASED_LOCKS; ++i) {
+            BiasedLock& lock = m_biasedLocks[i];
+            if (lock.m_object.load(std::memory_order_relaxed) == object)
+                return &lock;
+            if (free == 0 && lock.m_count.load(std::memory_order_relaxed) == 0)
+                free = &lock;
+        }
+        if (free != 0)
+            free->m_object.store(object, std::memory_order_relaxed);
+        return free;
+    }
+
+    /**
+     * Returns the entry of a biased monitor this thread currently holds, or
+     * 0 if it holds none for @a object. Only called by the owner.
+     */
+    BiasedLock* heldBiasedLock(const void* object) {
+        for (size_t i = 0; i < MAX_BIASED_LOCKS; ++i) {
+            BiasedLock& lock = m_biasedLocks[i];
+            if (lock.m_object.load(std::memory_order_relaxed) == object)
+                return (lock.m_count.load(std::memory_order_relaxed) > 0) ? &lock : 0;
+        }
+        return 0;
+    }
+
+    /**
+     * Returns true if this thread might hold the biased monitor of
+     * @a object. Called by other threads, which must have issued an
+     * asymmetric barrier first so that the owner's entries are visible.
+     */
+    bool mightHoldBiasedLock(const void* object) const;
+
+    /**
+     * How long this thread spins on a contended thin lock before inflating
+     * it. Thin locks have no room to keep a budget of their own.
+     */
+    AdaptiveSpin m_thinSpin;
+
+    /**
+     * The object whose confined reference count this thread is updating, if
+     * any. Only the owner writes it; a thread taking the count over from it
+     * reads it after an asymmetric barrier.
+     * @see ReferenceCount
+     */
+    std::atomic<const void*> m_countedObject;
+
+    /**
+     * The block of identity hash seeds this thread hands out next.
+     * @see IdentityHash
+     */
+    uint32_t m_nextSeed;
+    uint32_t m_seedLimit;
+
+    static const size_t MAX_BIASED_LOCKS = 8;
+    static const uint32_t MAX_INDEXED_IDS = 0x10000;
+
+  private:
+    explicit ThreadRecord(uint32_t id);
+    ThreadRecord(const ThreadRecord& other) = delete;
+    ThreadRecord& operator=(const ThreadRecord& rhs) = delete;
+
+    static ThreadRecord& attach();
+    static void detach(ThreadRecord* record);
+
+    static DECAF_THREAD_LOCAL ThreadRecord* t_current DECAF_INITIAL_EXEC_TLS;
+    static std::atomic<ThreadRecord*> s_records[MAX_INDEXED_IDS];
+
+    uint32_t m_id;
+    uint32_t m_generation;
+    std::atomic<uint32_t> m_token;
+    ThreadRecord* m_nextFree;
+    BiasedLock m_biasedLocks[MAX_BIASED_LOCKS];
+
+    friend class ThreadRecordDetacher;
+};
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_THREADRECORD_HPP
@@ -95,9 +95,13 @@ class Throwable : public Object {
      *     * the result of invoking this object's getMessage() method
      */
     virtual std::string toString() const {
-        std::string name = getTypeName();
-        std::string message = getMessage();
-        return (((!message.empty()) ? name + ": " + message : name));
+        const std::string& name = getTypeName();
+        if (m_message.empty())
+            return name;
+
+        std::string result;
+        result.reserve(name.size() + 2 + m_message.size());
+        return result.append(name).append(": ").append(m_message);
     }
   private:
     /**
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_TSCCLOCK_HPP
+#define DECAF_TSCCLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+#include "decaf/lang/compatibility.hpp"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DECAF_HAS_TSC_CLOCK 1
+#endif
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * Reads CLOCK_MONOTONIC, in nanoseconds, through the vDSO.
+ */
+inline uint64_t monotonicNanos() {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<uint64_t> (time.tv_sec) * 1000000000u + static_cast<uint64_t> (time.tv_nsec);
+}
+
+#ifdef DECAF_HAS_TSC_CLOCK
+
+/**
+ * @internal
+ * CLOCK_MONOTONIC extrapolated from the time stamp counter, which costs an
+ * rdtsc and a multiplication instead of a clock_gettime() call.
+ *
+ * The clock is a chain of linear segments, each mapping the TSC to
+ * nanoseconds from a start point at a given rate. Every so often, on the
+ * first read past the end of the current segment, the reader samples
+ * CLOCK_MONOTONIC and appends a segment that steers the clock back onto it:
+ * forward at once if the clock fell behind, by running slower for an interval
+ * if it got ahead. Readings thus never go backwards and stay within a few
+ * microseconds of CLOCK_MONOTONIC, NTP slewing included, as long as the clock
+ * is read at least once per segment, at most a second long.
+ *
+ * A new segment starts a little in the future, so that a reader that raced
+ * with its publication and still uses the previous one computes the same
+ * readings.
+ *
+ * Used only where the TSC ticks at a constant rate, in sync across cores:
+ * when the processor reports an invariant TSC or the kernel itself uses the
+ * TSC as its clock source. Elsewhere now() returns CLOCK_MONOTONIC.
+ */
+class TscClock {
+  public:
+    /**
+     * Returns the current time in nanoseconds of CLOCK_MONOTONIC.
+     */
+    static uint64_t now() {
+        uint64_t tsc;
+        uint64_t nanos;
+        if (__builtin_expect(!read(tsc, nanos), 0))
+            return slowNow();
+        return nanos;
+    }
+
+    /**
+     * Returns true if now() reads the TSC, false if it falls back on
+     * clock_gettime(). Calibrates the clock on the first call.
+     */
+    static bool isTscUsed();
+
+  private:
+    static uint64_t readTsc() {
+        return __builtin_ia32_rdtsc();
+    }
+
+    /*
+     * The reading of the segment starting at the TSC value start with the
+     * reading base, at scale nanoseconds per tick in 32.32 fixed point.
+     */
+    static uint64_t extrapolate(uint64_t tsc, uint64_t start, uint64_t base, uint64_t scale) {
+        const uint64_t ticks = tsc > start ? tsc - start : 0;
+        return base + static_cast<uint64_t> ((static_cast<unsigned __int128> (ticks) * scale) >> 32);
+    }
+
+    /*
+     * Reads the TSC and extrapolates it into nanos. Returns false if the
+     * current segment has ended or the clock is not calibrated.
+     */
+    static bool read(uint64_t& tsc, uint64_t& nanos) {
+        for (;;) {
+            const uint64_t generation = s_segments.m_generation.load(std::memory_order_acquire);
+            const Segment& segment = s_segments.m_slots[generation & 1];
+            tsc = readTsc();
+            const uint64_t end = segment.m_end.load(std::memory_order_relaxed);
+            const uint64_t start = segment.m_start.load(std::memory_order_relaxed);
+            if (tsc >= start)
+                nanos = extrapolate(tsc, start, segment.m_base.load(std::memory_order_relaxed),
+                  segment.m_scale.load(std::memory_order_relaxed));
+            else
+                nanos = extrapolate(tsc, segment.m_previousStart.load(std::memory_order_relaxed),
+                  segment.m_previousBase.load(std::memory_order_relaxed),
+                  segment.m_previousScale.load(std::memory_order_relaxed));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (generation == s_segments.m_generation.load(std::memory_order_relaxed))
+                return tsc < end;
+        }
+    }
+
+    static uint64_t slowNow();
+    static void calibrate();
+
+    /*
+     * The current segment and the previous one, which readers use for TSC
+     * values before the start of the current one, and the TSC value at which
+     * the current one ends, 0 until the clock is calibrated.
+     */
+    struct Segment {
+        std::atomic<uint64_t> m_start;
+        std::atomic<uint64_t> m_base;
+        std::atomic<uint64_t> m_scale;
+        std::atomic<uint64_t> m_previousStart;
+        std::atomic<uint64_t> m_previousBase;
+        std::atomic<uint64_t> m_previousScale;
+        std::atomic<uint64_t> m_end;
+    };
+
+    /*
+     * Readers use the slot of the current generation; the calibrating thread
+     * fills the other one and then bumps the generation. A reader retries if
+     * the generation changed while it read, but never waits for a writer,
+     * which may be preempted.
+     */
+    struct alignas(64) Segments {
+        std::atomic<uint64_t> m_generation;
+        Segment m_slots[2];
+    };
+
+    static Segments s_segments;
+};
+
+#endif
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_TSCCLOCK_HPP
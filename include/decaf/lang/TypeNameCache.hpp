@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_TYPENAMECACHE_HPP
+#define DECAF_TYPENAMECACHE_HPP
+
+#include <string>
+#include <typeinfo>
+
+#include "decaf/lang/compatibility.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * A process-wide cache of demangled type names. Each type is demangled once;
+ * its name is then shared, immutable and never freed, so the reference
+ * returned by nameOf() stays valid for the life of the process.
+ *
+ * Lookups are lock-free and a hit allocates nothing: the cache is a chain of
+ * open-addressing tables keyed by the address of the std::type_info. Only the
+ * first lookup of a type demangles it and publishes the result with a
+ * compare-and-swap. Should two threads race on the same new type, one of them
+ * waits for the other's name instead of demangling it again.
+ */
+class TypeNameCache {
+  public:
+    /**
+     * Returns the demangled name of @a type.
+     */
+    static const std::string& nameOf(const std::type_info& type);
+};
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif // DECAF_TYPENAMECACHE_HPP
@@ -55,4 +55,32 @@ namespace lang {
 #define DECAF_DO_JOIN2(X, Y) X##Y
 #define DECAF_UNIQUE_IDENTIFIER(Name) DECAF_JOIN(Name, __LINE__)
 
+// ----- thread-local storage -------------------------------------------------
+
+/**
+ * Declares a thread_local variable of the library with the initial-exec TLS
+ * model: it is then reached at a fixed offset from the thread pointer rather
+ * than through a call to __tls_get_addr(), as variables of a shared library
+ * are by default. Only meant for the few small variables on hot paths, since
+ * they take space from the static TLS block the C library reserves for
+ * libraries loaded with dlopen().
+ */
+#if defined(__GNUC__)
+#define DECAF_INITIAL_EXEC_TLS __attribute__((tls_model("initial-exec")))
+#else
+#define DECAF_INITIAL_EXEC_TLS
+#endif
+
+/**
+ * Declares a thread-local variable of a trivial type, which needs no dynamic
+ * initialization: unlike an extern thread_local, whose every use from
+ * another translation unit first calls the initialization wrapper of the
+ * variable, a GCC __thread variable is accessed directly.
+ */
+#if defined(__GNUC__)
+#define DECAF_THREAD_LOCAL __thread
+#else
+#define DECAF_THREAD_LOCAL thread_local
+#endif
+
 #endif // DECAF_COMPATIBILITY_HPP
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_COUNTDOWNLATCH_HPP
+#define	DECAF_COUNTDOWNLATCH_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * A synchronization aid that allows one or more threads to wait until a set
+ * of operations being performed in other threads completes.
+ *
+ * A CountDownLatch is initialized with a given count. The await methods block
+ * until the current count reaches zero due to invocations of the countDown()
+ * method, after which all waiting threads are released and any subsequent
+ * invocations of await return immediately. This is a one-shot phenomenon: the
+ * count cannot be reset. If you need a version that resets the count,
+ * consider using a CyclicBarrier.
+ *
+ * The count is itself the futex the waiting threads sleep on, and countDown()
+ * only makes a system call when it brings the count to zero while threads
+ * are waiting. Actions in a thread prior to calling countDown() happen-before
+ * actions following a successful return from a corresponding await() in
+ * another thread.
+ */
+class CountDownLatch : public Object {
+  public:
+    /**
+     * Constructs a CountDownLatch initialized with the given count.
+     *
+     * @param count the number of times countDown() must be invoked before
+     * threads can pass through await()
+     * @throws IllegalArgumentException if count is negative
+     */
+    explicit CountDownLatch(int32_t count);
+
+    virtual ~CountDownLatch();
+    CountDownLatch(const CountDownLatch& other) = delete;
+    CountDownLatch& operator=(const CountDownLatch& rhs) = delete;
+
+    /**
+     * Causes the current thread to wait until the latch has counted down to
+     * zero.
+     */
+    void await();
+
+    /**
+     * Causes the current thread to wait until the latch has counted down to
+     * zero, unless the specified waiting time elapses.
+     *
+     * @return true if the count reached zero and false if the waiting time
+     * elapsed before the count reached zero
+     */
+    bool await(const uint64_t& timeout, const TimeUnit* unit);
+
+    /**
+     * Causes the current thread to wait until the latch has counted down to
+     * zero, unless the given deadline passes first.
+     *
+     * @return true if the count reached zero and false if the deadline passed
+     * before the count reached zero
+     */
+    bool awaitUntil(const Deadline& deadline);
+
+    /**
+     * Decrements the count of the latch, releasing all waiting threads if the
+     * count reaches zero. Does nothing if the count is already zero.
+     */
+    void countDown();
+
+    /**
+     * Returns the current count.
+     */
+    int32_t getCount() const {
+        return static_cast<int32_t> (m_count.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Returns a string identifying this latch, as well as its state: the
+     * Object representation followed by "[Count = n]".
+     */
+    virtual std::string toString() const;
+
+  private:
+    std::atomic<uint32_t> m_count;
+    std::atomic<uint32_t> m_waiters;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_COUNTDOWNLATCH_HPP */
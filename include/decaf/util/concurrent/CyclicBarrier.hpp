@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_CYCLICBARRIER_HPP
+#define	DECAF_CYCLICBARRIER_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/Runnable.hpp"
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * A synchronization aid that allows a set of threads to all wait for each
+ * other to reach a common barrier point. The barrier is called cyclic because
+ * it can be re-used after the waiting threads are released.
+ *
+ * A CyclicBarrier supports an optional Runnable command that is run once per
+ * barrier point, after the last thread in the party arrives, but before any
+ * threads are released.
+ *
+ * The barrier uses all-or-none breakage semantics for failed synchronization
+ * attempts: if a thread leaves a barrier point prematurely because of a
+ * timeout, or because the barrier action threw, all other threads waiting at
+ * that barrier point will also leave abnormally via BrokenBarrierException.
+ *
+ * Arrivals are combined in a tree whose nodes each take at most FAN_IN
+ * threads, a cache line apart: the last thread to arrive at a node goes on
+ * to arrive at its parent, while the others sleep on the node's own futex.
+ * The thread completing the root trips the barrier and wakes the threads
+ * of the nodes it climbed through, each of which in turn wakes the nodes it
+ * climbed through, so neither the arrival of many parties nor their release
+ * funnels through one cache line or one thread. A barrier of no more than
+ * FAN_IN parties is a single node.
+ *
+ * Actions in a thread prior to calling await() happen-before actions that are
+ * part of the barrier action, which in turn happen-before actions following a
+ * successful return from the corresponding await() in other threads.
+ */
+class CyclicBarrier : public Object {
+  public:
+    /**
+     * Creates a new CyclicBarrier that will trip when the given number of
+     * parties are waiting upon it, and which will run the given barrier
+     * action, unless null, when the barrier is tripped, performed by the last
+     * thread entering the barrier. The barrier does not take ownership of the
+     * action.
+     *
+     * @throws IllegalArgumentException if parties is less than 1
+     */
+    explicit CyclicBarrier(int32_t parties, lang::Runnable* barrierAction = 0);
+
+    virtual ~CyclicBarrier();
+    CyclicBarrier(const CyclicBarrier& other) = delete;
+    CyclicBarrier& operator=(const CyclicBarrier& rhs) = delete;
+
+    /**
+     * Waits until all parties have invoked await on this barrier.
+     *
+     * If the current thread is not the last to arrive then it lies dormant
+     * until the last thread arrives, the barrier is reset, or another thread
+     * times out waiting. If the current thread is the last to arrive and a
+     * barrier action was supplied, the current thread runs it before allowing
+     * the other threads to continue; if it throws, the barrier is broken and
+     * the exception propagates in the current thread.
+     *
+     * @return the arrival index of the current thread: 0 for the last thread
+     * to arrive, which tripped the barrier, and a distinct number from 1 to
+     * getParties() - 1, higher for threads that arrived earlier at the same
+     * node of the tree, for the others
+     * @throws BrokenBarrierException if the barrier was broken or reset while
+     * the current thread was waiting, or was broken when await was called
+     */
+    int32_t await();
+
+    /**
+     * Waits until all parties have invoked await on this barrier, or the
+     * specified waiting time elapses, after which the barrier is broken.
+     *
+     * @return the arrival index of the current thread, as for await()
+     * @throws TimeoutException if the specified timeout elapses
+     * @throws BrokenBarrierException if the barrier was broken or reset while
+     * the current thread was waiting, or was broken when await was called
+     */
+    int32_t await(const uint64_t& timeout, const TimeUnit* unit);
+
+    /**
+     * Waits until all parties have invoked await on this barrier, or the
+     * given deadline passes, after which the barrier is broken.
+     *
+     * @return the arrival index of the current thread, as for await()
+     * @throws TimeoutException if the deadline passes
+     * @throws BrokenBarrierException if the barrier was broken or reset while
+     * the current thread was waiting, or was broken when await was called
+     */
+    int32_t awaitUntil(const Deadline& deadline);
+
+    /**
+     * Returns the number of parties required to trip this barrier.
+     */
+    int32_t getParties() const {
+        return m_parties;
+    }
+
+    /**
+     * Returns an estimate of the number of parties currently waiting at this
+     * barrier, intended for debugging and assertions.
+     */
+    int32_t getNumberWaiting() const;
+
+    /**
+     * Queries if this barrier is in a broken state: if one or more parties
+     * broke out of it because of a timeout, or a barrier action failed, since
+     * construction or the last reset.
+     */
+    bool isBroken() const {
+        return (m_generation.load(std::memory_order_acquire) & BROKEN) != 0;
+    }
+
+    /**
+     * Resets the barrier to its initial state. If any parties are currently
+     * waiting at the barrier, they will return with a BrokenBarrierException.
+     */
+    void reset();
+
+    /**
+     * The maximum number of threads that arrive at one node of the tree.
+     */
+    static const uint32_t FAN_IN = 4;
+
+  private:
+    struct Node;
+
+    /*
+     * Arrives at the first node with room left among the leaves, starting
+     * from the one the calling thread hashes to, for the given generation.
+     * Returns the node, or 0 if every leaf is full or, as then reported in
+     * reopening, some are still being left by the last generation.
+     */
+    Node* arriveAtLeaf(uint32_t generation, uint32_t& slot, bool& reopening);
+
+    /*
+     * Breaks the given generation unless it has already ended, and wakes
+     * all of its waiters. Returns true if this call broke it.
+     */
+    bool breakGeneration(uint32_t generation);
+
+    /*
+     * Marks node as released for generation, which ended with outcome, and
+     * wakes its sleepers.
+     */
+    static void release(Node* node, uint32_t outcome);
+
+    /*
+     * Counts a thread of generation, which tripped, out of node, and opens
+     * the node to the next generation once all of them have left.
+     */
+    static void depart(Node* node, uint32_t generation);
+
+    /*
+     * The generation running, as an even number, or, once it broke, that
+     * number plus BROKEN. Waiters sleep on a node until it holds a later
+     * generation: the next one if the barrier tripped, or the broken one.
+     */
+    static const uint32_t BROKEN = 1;
+    std::atomic<uint32_t> m_generation;
+
+    /*
+     * Threads beyond the parties of the running generation sleep on
+     * m_generation until it ends.
+     */
+    std::atomic<uint32_t> m_overflowWaiters;
+
+    const int32_t m_parties;
+    lang::Runnable* m_barrierAction;
+
+    /*
+     * The nodes of the tree, leaves first and the root last, each on a cache
+     * line of its own.
+     */
+    Node* m_nodes;
+    uint32_t m_nodeCount;
+    uint32_t m_leafCount;
+
+    lang::detail::AdaptiveSpin m_spin;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_CYCLICBARRIER_HPP */
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_DEADLINE_HPP
+#define DECAF_DEADLINE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/System.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * An absolute point in time, in nanoseconds of the CLOCK_MONOTONIC clock, at
+ * which a blocking operation gives up.
+ *
+ * Blocking methods that take a relative timeout convert it to a Deadline once,
+ * on entry, and pass that down: retries after spurious wake-ups and nested
+ * waits then share one end point instead of restarting the timeout. Since the
+ * monotonic clock is not stepped by NTP or settimeofday(), the wait lasts as
+ * long as asked regardless of wall clock adjustments.
+ *
+ * @code{.cpp}
+ *    const Deadline deadline = Deadline::after(50, TimeUnit::MILLISECONDS);
+ *    if (lock.tryLockUntil(deadline)) {
+ *        while (!ready)
+ *            if (!condition->awaitUntil(deadline))
+ *                break;
+ *        lock.unlock();
+ *    }
+ * @endcode
+ *
+ * A wait may still return somewhat after its deadline: the kernel lets the
+ * timers of an ordinary thread fire up to its timer slack late, 50us unless
+ * lowered with prctl(PR_SET_TIMERSLACK).
+ *
+ * A Deadline is a plain value: copy it freely.
+ */
+class Deadline {
+  public:
+    /**
+     * Returns a deadline that never passes.
+     */
+    static Deadline never() {
+        return Deadline(NEVER);
+    }
+
+    /**
+     * Returns the deadline at the given CLOCK_MONOTONIC time, in nanoseconds.
+     */
+    static Deadline at(uint64_t nanos) {
+        return Deadline(nanos);
+    }
+
+    /**
+     * Returns the deadline @a nanos nanoseconds from now. A timeout too large
+     * to be represented never passes.
+     */
+    static Deadline afterNanos(uint64_t nanos) {
+        const uint64_t start = now();
+        return Deadline(nanos < NEVER - start ? start + nanos : NEVER);
+    }
+
+    /**
+     * Returns the deadline @a duration @a unit from now.
+     */
+    static Deadline after(uint64_t duration, const TimeUnit* unit) {
+        return afterNanos(unit->toNanos(duration));
+    }
+
+    /**
+     * Returns the deadline @a duration from now; a negative duration has
+     * already passed.
+     */
+    template<typename Rep, typename Period>
+    static Deadline after(const std::chrono::duration<Rep, Period>& duration) {
+        return afterNanos(TimeUnit::of<std::chrono::nanoseconds>().convert(duration));
+    }
+
+    /**
+     * Returns the current CLOCK_MONOTONIC time in nanoseconds.
+     */
+    static uint64_t now() {
+        return lang::System::nanoTime();
+    }
+
+    /**
+     * Returns the CLOCK_MONOTONIC time of this deadline in nanoseconds.
+     */
+    uint64_t nanos() const {
+        return m_nanos;
+    }
+
+    /**
+     * Returns true if this deadline never passes.
+     */
+    bool isNever() const {
+        return m_nanos == NEVER;
+    }
+
+    /**
+     * Returns true if this deadline has passed.
+     */
+    bool hasPassed() const {
+        return m_nanos != NEVER && now() >= m_nanos;
+    }
+
+    /**
+     * Returns the number of nanoseconds left until this deadline, negative or
+     * zero once it has passed and INT64_MAX if it never passes.
+     */
+    int64_t remainingNanos() const {
+        if (m_nanos == NEVER)
+            return INT64_MAX;
+        const uint64_t current = now();
+        return m_nanos >= current ? static_cast<int64_t> (m_nanos - current)
+                                  : -static_cast<int64_t> (current - m_nanos);
+    }
+
+    /**
+     * Stores this deadline in @a time, in the form futex(2) and the
+     * CLOCK_MONOTONIC variants of the POSIX waits expect.
+     *
+     * @return @a time, or null if this deadline never passes
+     */
+    const struct timespec* toTimespec(struct timespec& time) const {
+        if (m_nanos == NEVER)
+            return 0;
+        time.tv_sec = static_cast<time_t> (m_nanos / NANOS_PER_SECOND);
+        time.tv_nsec = static_cast<long> (m_nanos % NANOS_PER_SECOND);
+        return &time;
+    }
+
+    bool operator==(const Deadline& rhs) const {
+        return m_nanos == rhs.m_nanos;
+    }
+
+    bool operator!=(const Deadline& rhs) const {
+        return m_nanos != rhs.m_nanos;
+    }
+
+    bool operator<(const Deadline& rhs) const {
+        return m_nanos < rhs.m_nanos;
+    }
+
+  private:
+    explicit Deadline(uint64_t nanos) : m_nanos(nanos) { }
+
+    static const uint64_t NANOS_PER_SECOND = 1000000000;
+    static const uint64_t NEVER = UINT64_MAX;
+
+    uint64_t m_nanos;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif // DECAF_DEADLINE_HPP
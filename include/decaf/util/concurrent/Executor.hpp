@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_EXECUTOR_HPP
+#define	DECAF_EXECUTOR_HPP
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/Ref.hpp"
+#include "decaf/lang/Runnable.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * An object that executes submitted Runnable tasks. This interface provides a
+ * way of decoupling task submission from the mechanics of how each task will
+ * be run, including details of thread use, scheduling, etc.
+ *
+ * Tasks are handed over as Refs: the executor keeps the task alive until it
+ * has run, and shares it with its own threads, so the caller may drop its
+ * reference right away.
+ */
+class Executor : public Object {
+  public:
+    Executor() { }
+    virtual ~Executor() { }
+
+    /**
+     * Executes the given command at some time in the future. The command may
+     * execute in a new thread, in a pooled thread, or in the calling thread,
+     * at the discretion of the Executor implementation.
+     *
+     * @param command the runnable task
+     * @throws RejectedExecutionException if this task cannot be accepted for
+     * execution
+     */
+    virtual void execute(const lang::Ref<lang::Runnable>& command) = 0;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_EXECUTOR_HPP */
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_EXECUTORSERVICE_HPP
+#define	DECAF_EXECUTORSERVICE_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Ref.hpp"
+#include "decaf/lang/Runnable.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/Executor.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * An Executor that provides methods to manage termination.
+ *
+ * An ExecutorService can be shut down, which will cause it to reject new
+ * tasks. shutdown() allows previously submitted tasks to execute before
+ * terminating, while shutdownNow() prevents waiting tasks from starting.
+ * Upon termination, an executor has no tasks actively executing, no tasks
+ * awaiting execution, and no new tasks can be submitted.
+ */
+class ExecutorService : public Executor {
+  public:
+    ExecutorService() { }
+    virtual ~ExecutorService() { }
+
+    /**
+     * Initiates an orderly shutdown in which previously submitted tasks are
+     * executed, but no new tasks will be accepted. Invocation has no
+     * additional effect if already shut down. Does not wait for the tasks to
+     * complete: use awaitTermination() for that.
+     */
+    virtual void shutdown() = 0;
+
+    /**
+     * Attempts to stop all actively executing tasks, halts the processing of
+     * waiting tasks, and returns the tasks that were awaiting execution.
+     *
+     * @return the tasks that never commenced execution
+     */
+    virtual std::vector<lang::Ref<lang::Runnable> > shutdownNow() = 0;
+
+    /**
+     * Returns true if this executor has been shut down.
+     */
+    virtual bool isShutdown() const = 0;
+
+    /**
+     * Returns true if all tasks have completed following shut down. Never
+     * true unless shutdown() or shutdownNow() was called first.
+     */
+    virtual bool isTerminated() const = 0;
+
+    /**
+     * Blocks until all tasks have completed execution after a shutdown
+     * request, or the timeout occurs, whichever happens first.
+     *
+     * @return true if this executor terminated and false if the timeout
+     * elapsed before termination
+     */
+    virtual bool awaitTermination(uint64_t timeout, const TimeUnit* unit) = 0;
+
+    /**
+     * Blocks until all tasks have completed execution after a shutdown
+     * request, or the deadline passes, whichever happens first.
+     *
+     * @return true if this executor terminated and false if the deadline
+     * passed before termination
+     */
+    virtual bool awaitTerminationUntil(const Deadline& deadline) = 0;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_EXECUTORSERVICE_HPP */
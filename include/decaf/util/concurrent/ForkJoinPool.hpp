@@ -0,0 +1,419 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_FORKJOINPOOL_HPP
+#define	DECAF_FORKJOINPOOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Ref.hpp"
+#include "decaf/lang/Runnable.hpp"
+#include "decaf/lang/Thread.hpp"
+#include "decaf/lang/ThreadGroup.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/ExecutorService.hpp"
+#include "decaf/util/concurrent/ForkJoinTask.hpp"
+#include "decaf/util/concurrent/RecursiveTask.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+#include "decaf/util/concurrent/locks/HybridLock.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * The work-stealing deque of Chase and Lev, with the memory orderings of Lê
+ * et al. ("Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP
+ * 2013). Its owner pushes and pops at the bottom without atomic
+ * read-modify-writes, except when it takes the last element; any thread
+ * steals at the top with one compare-and-swap.
+ *
+ * The array doubles when full and never shrinks. Thieves may still read an
+ * array the owner replaced, so replaced arrays are only freed with the deque.
+ */
+template<typename T>
+class WorkStealingDeque {
+  public:
+    explicit WorkStealingDeque(size_t capacity = 1024) : m_top(0), m_bottom(0),
+      m_array(new Array(static_cast<int64_t> (capacity))) {
+    }
+
+    ~WorkStealingDeque() {
+        delete m_array.load(std::memory_order_relaxed);
+        for (Array* array : m_retired)
+            delete array;
+    }
+
+    /**
+     * Pushes @a item at the bottom. Owner only.
+     *
+     * @return the number of items in the deque before the push, as far as
+     * the owner knows
+     */
+    int64_t push(T* item) {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_top.load(std::memory_order_acquire);
+        Array* array = m_array.load(std::memory_order_relaxed);
+        if (bottom - top > array->m_mask)
+            array = grow(array, top, bottom);
+        array->put(bottom, item);
+        m_bottom.store(bottom + 1, std::memory_order_release);
+        return bottom - top;
+    }
+
+    /**
+     * Pops the item at the bottom, the one pushed last. Owner only.
+     *
+     * @return the item, or null if the deque is empty
+     */
+    T* pop() {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Array* array = m_array.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        T* item = 0;
+        if (top <= bottom) {
+            item = array->get(bottom);
+            if (top != bottom)
+                return item;
+            // The last item: race the thieves for it.
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = 0;
+        }
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return item;
+    }
+
+    /**
+     * Returns the item at the bottom without popping it. Owner only.
+     */
+    T* peek() const {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        if (bottom <= m_top.load(std::memory_order_acquire))
+            return 0;
+        return m_array.load(std::memory_order_relaxed)->get(bottom - 1);
+    }
+
+    /**
+     * Steals the item at the top, the oldest one. Any thread.
+     *
+     * @param lost set when the deque was not empty, but another thread took
+     * the item first
+     * @return the item, or null if the deque is empty or the race was lost
+     */
+    T* steal(bool& lost) {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+            return 0;
+
+        T* item = m_array.load(std::memory_order_acquire)->get(top);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            lost = true;
+            return 0;
+        }
+        return item;
+    }
+
+    /**
+     * Returns an estimate of the number of items, for monitoring and to tell
+     * whether there is anything to steal.
+     */
+    size_t size() const {
+        const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        const int64_t top = m_top.load(std::memory_order_acquire);
+        return bottom > top ? static_cast<size_t> (bottom - top) : 0;
+    }
+
+    bool isEmpty() const {
+        return size() == 0;
+    }
+
+  private:
+    WorkStealingDeque(const WorkStealingDeque& other) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque& rhs) = delete;
+
+    struct Array {
+        explicit Array(int64_t capacity) : m_mask(capacity - 1), m_slots(new std::atomic<T*>[capacity]) { }
+
+        ~Array() {
+            delete[] m_slots;
+        }
+
+        T* get(int64_t index) const {
+            return m_slots[index & m_mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, T* item) {
+            m_slots[index & m_mask].store(item, std::memory_order_relaxed);
+        }
+
+        const int64_t m_mask;
+        std::atomic<T*>* const m_slots;
+    };
+
+    Array* grow(Array* array, int64_t top, int64_t bottom) {
+        Array* grown = new Array(2 * (array->m_mask + 1));
+        for (int64_t index = top; index < bottom; ++index)
+            grown->put(index, array->get(index));
+        m_retired.push_back(array);
+        m_array.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    alignas(64) std::atomic<int64_t> m_top;
+    alignas(64) std::atomic<int64_t> m_bottom;
+    std::atomic<Array*> m_array;
+    std::vector<Array*> m_retired;
+};
+
+DECAF_CLOSE_NAMESPACE
+
+/**
+ * An ExecutorService for divide-and-conquer computations: ForkJoinTasks that
+ * fork subtasks and join them, such as RecursiveTask and RecursiveAction.
+ *
+ * Each pool thread has a Chase-Lev deque of its own. A task forks subtasks
+ * at the bottom of the deque of its thread, and the thread pops them back in
+ * LIFO order, without contention, as it joins them; a thread out of work
+ * steals the oldest task, the largest in divide-and-conquer, from the top of
+ * the deque of another thread, picked at random. Tasks from outside the pool
+ * go through a submission queue under a lock, which only matters for the
+ * first task of a computation.
+ *
+ * A thread that joins a task stolen from it runs other tasks in the meantime,
+ * and only parks when there are none. Idle threads park on a single futex,
+ * which a thread signals when it makes work available while threads are
+ * idle: when its deque stops being empty, or when it steals from a deque that
+ * still has tasks, which wakes the idle threads one after the other as long
+ * as there is work for them.
+ *
+ * The pool threads are daemon threads, gathered in a ThreadGroup of their
+ * own. The pool starts them all at construction, and they run until it
+ * terminates: after shutdown(), once all the tasks are done; after
+ * shutdownNow(), once the running tasks return, the others being cancelled.
+ *
+ * A pool must not be destroyed by one of its own tasks.
+ */
+class ForkJoinPool final : public ExecutorService {
+  public:
+    /**
+     * Creates a pool of @a parallelism threads, by default one per online
+     * processor, and starts them.
+     *
+     * @throws IllegalArgumentException if parallelism is 0 or above 32767
+     */
+    explicit ForkJoinPool(uint32_t parallelism = defaultParallelism());
+
+    /**
+     * Shuts the pool down, waits for the tasks to complete, and joins the
+     * threads.
+     */
+    virtual ~ForkJoinPool();
+
+    /**
+     * Returns the pool that ForkJoinTask::fork() uses outside of any pool,
+     * of the default parallelism. It is never destroyed.
+     */
+    static ForkJoinPool& commonPool();
+
+    static uint32_t defaultParallelism();
+
+    /**
+     * Runs the command in the pool as a ForkJoinTask. A command that throws
+     * has its exception reported as Thread reports uncaught exceptions.
+     *
+     * @throws IllegalArgumentException if command is null
+     * @throws RejectedExecutionException if the pool is shut down
+     */
+    virtual void execute(const lang::Ref<lang::Runnable>& command);
+
+    /**
+     * Arranges to run the task in the pool. The caller keeps the task alive
+     * until it is done, e.g. until join() returns.
+     *
+     * @throws RejectedExecutionException if the pool is shut down
+     */
+    void execute(ForkJoinTask& task);
+
+    /**
+     * Runs the task in the pool and waits until it is done; in the calling
+     * thread if it is a thread of this pool.
+     *
+     * @throws the exception the task threw, or CancellationException
+     * @throws RejectedExecutionException if the pool is shut down
+     */
+    void invoke(ForkJoinTask& task);
+
+    /**
+     * Runs the task in the pool, waits until it is done, and returns its
+     * result.
+     */
+    template<typename V>
+    V invoke(RecursiveTask<V>& task) {
+        invoke(static_cast<ForkJoinTask&> (task));
+        return task.getRawResult();
+    }
+
+    virtual void shutdown();
+
+    /**
+     * Stops the pool: cancels the tasks that have not started, and returns
+     * the commands given to execute() among them. Running tasks are not
+     * interrupted.
+     */
+    virtual std::vector<lang::Ref<lang::Runnable> > shutdownNow();
+
+    virtual bool isShutdown() const;
+
+    virtual bool isTerminated() const;
+
+    virtual bool awaitTermination(uint64_t timeout, const TimeUnit* unit);
+
+    virtual bool awaitTerminationUntil(const Deadline& deadline);
+
+    uint32_t getParallelism() const {
+        return m_parallelism;
+    }
+
+    /**
+     * Returns the number of threads that have not terminated.
+     */
+    uint32_t getPoolSize() const {
+        return m_liveCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns an estimate of the number of threads running or looking for
+     * tasks, as opposed to parked for lack of them.
+     */
+    uint32_t getActiveThreadCount() const;
+
+    /**
+     * Returns true if all threads are parked for lack of tasks.
+     */
+    bool isQuiescent() const {
+        return getActiveThreadCount() == 0;
+    }
+
+    /**
+     * Returns an estimate of the number of tasks stolen by one thread from
+     * the deque of another.
+     */
+    uint64_t getStealCount() const;
+
+    /**
+     * Returns an estimate of the number of tasks in the deques of the pool
+     * threads.
+     */
+    uint64_t getQueuedTaskCount() const;
+
+    /**
+     * Returns the number of tasks submitted from outside the pool that no
+     * thread has taken yet.
+     */
+    size_t getQueuedSubmissionCount() const {
+        return m_submissionCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the group of the pool's threads, e.g. for its CPU usage.
+     */
+    const lang::Ref<lang::ThreadGroup>& getThreadGroup() const {
+        return m_group;
+    }
+
+    virtual std::string toString() const;
+
+  private:
+    ForkJoinPool(const ForkJoinPool& other) = delete;
+    ForkJoinPool& operator=(const ForkJoinPool& rhs) = delete;
+
+    class Worker;
+    class RunnableTask;
+    friend class ForkJoinTask;
+    friend class Worker;
+
+    enum RunState { RUNNING, SHUTDOWN, STOP, TERMINATED };
+
+    static const uint32_t IDLE_MASK = 0xffff;
+    static const uint32_t WAKING = 0x10000;
+
+    static ForkJoinPool* currentPool();
+    static void push(ForkJoinTask* task);
+    static void awaitJoin(ForkJoinTask& task);
+
+    void submit(ForkJoinTask* task);
+    void runWorker(Worker* worker);
+    ForkJoinTask* scan(Worker* worker);
+    ForkJoinTask* pollSubmission();
+    void helpJoin(Worker* worker, ForkJoinTask& task);
+    bool hasWork() const;
+    bool awaitWork();
+    void leaveIdle();
+    void signalWork();
+    void wakeAll();
+    void workerTerminated();
+
+    static DECAF_THREAD_LOCAL Worker* t_worker DECAF_INITIAL_EXEC_TLS;
+
+    const uint32_t m_parallelism;
+    const lang::Ref<lang::ThreadGroup> m_group;
+
+    /*
+     * Created with the pool, and destroyed with it, after the threads.
+     */
+    std::vector<Worker*> m_workers;
+    std::vector<lang::Ref<lang::Thread> > m_threads;
+
+    /*
+     * Tasks from outside the pool, with their number for the threads to poll
+     * without locking.
+     */
+    mutable locks::HybridLock m_lock;
+    std::deque<ForkJoinTask*> m_submissions;
+    std::atomic<size_t> m_submissionCount;
+
+    /*
+     * A RunState, and the futex awaitTermination() waits on.
+     */
+    std::atomic<uint32_t> m_runState;
+
+    /*
+     * The futex idle threads park on, bumped to wake them, and a word that
+     * packs the number of threads parked or about to park with WAKING, set
+     * from the time a thread is signalled to the time one wakes up, during
+     * which there is no point in signalling another.
+     */
+    alignas(64) std::atomic<uint32_t> m_signal;
+    std::atomic<uint32_t> m_ctl;
+
+    std::atomic<uint32_t> m_liveCount;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_FORKJOINPOOL_HPP */
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_FORKJOINTASK_HPP
+#define	DECAF_FORKJOINTASK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Runnable.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+class ForkJoinPool;
+
+/**
+ * A task that runs in a ForkJoinPool, and may fork subtasks and join them,
+ * much lighter than a thread: fork() pushes the task on the deque of the pool
+ * thread that forked it, from which other pool threads steal it when idle,
+ * and join() runs it in place if nobody did. Use the subclasses
+ * RecursiveAction and RecursiveTask rather than this class.
+ *
+ * Tasks are not reference counted while in the pool: whoever forks a task
+ * keeps it alive until it is joined, which divide-and-conquer code does for
+ * free by keeping its subtasks on the stack and joining them before it
+ * returns. Like a joinable std::thread, a task destroyed while the pool still
+ * holds it, forked and not joined, terminates the program; this includes
+ * the subtasks left behind when a task throws, which invokeAll() joins
+ * before it rethrows:
+ *
+ *     Fib left(n - 1);
+ *     Fib right(n - 2);
+ *     invokeAll(left, right);
+ *     return left.getRawResult() + right.getRawResult();
+ *
+ * Running a task through Run() has the effect of invoke() without reporting
+ * the exception. A task runs once, unless reinitialize()d: a task that was
+ * forked is joined, never invoked.
+ */
+class ForkJoinTask : public lang::Runnable {
+  public:
+    ForkJoinTask() : m_status(PENDING) { }
+
+    /**
+     * Calls std::terminate() if the task was forked and not joined.
+     */
+    virtual ~ForkJoinTask();
+
+    /**
+     * Arranges to run this task asynchronously: in the pool of the calling
+     * thread, if it is a ForkJoinPool thread, and in the common pool
+     * otherwise.
+     *
+     * @throws RejectedExecutionException if the common pool is shut down
+     */
+    void fork();
+
+    /**
+     * Runs the task in the calling thread, if nobody has yet.
+     */
+    virtual void Run();
+
+    /**
+     * Waits until the task is done, and the pool done with it, without
+     * reporting its exception. A pool thread runs the task itself if it is
+     * still at the top of its deque, and otherwise runs other tasks while the
+     * task it waits for runs elsewhere, before it parks.
+     */
+    void quietlyJoin();
+
+    /**
+     * Runs the task in the calling thread, if nobody has yet, and waits
+     * until it is done, without reporting its exception.
+     */
+    void quietlyInvoke();
+
+    /**
+     * Forks @a second, runs @a first in the calling thread, and joins
+     * @a second.
+     *
+     * @throws the exception of first, if any, or otherwise that of second
+     */
+    static void invokeAll(ForkJoinTask& first, ForkJoinTask& second);
+
+    /**
+     * Cancels the task if it has not started: it will not run, and join()
+     * throws CancellationException, once the pool has dropped the task if it
+     * was forked. A task already running is not affected.
+     *
+     * @return true if the task is now cancelled
+     */
+    bool cancel();
+
+    bool isDone() const {
+        return (m_status.load(std::memory_order_acquire) & DONE_MASK) != PENDING;
+    }
+
+    bool isCompletedNormally() const {
+        return (m_status.load(std::memory_order_acquire) & DONE_MASK) == NORMAL;
+    }
+
+    /**
+     * Returns true if the task threw or was cancelled.
+     */
+    bool isCompletedAbnormally() const {
+        return (m_status.load(std::memory_order_acquire) & DONE_MASK) > NORMAL;
+    }
+
+    bool isCancelled() const {
+        return (m_status.load(std::memory_order_acquire) & DONE_MASK) == CANCELLED;
+    }
+
+    /**
+     * Resets the task so that it may run again. Only call it on a task that
+     * is done, or was never forked.
+     */
+    void reinitialize();
+
+    /**
+     * Returns the pool of the calling thread, or null if it is not a
+     * ForkJoinPool thread.
+     */
+    static ForkJoinPool* getPool();
+
+    /**
+     * Returns true if the calling thread is a ForkJoinPool thread.
+     */
+    static bool inForkJoinPool() {
+        return getPool() != 0;
+    }
+
+  protected:
+    /**
+     * Runs the computation of the task; the subclasses call their compute().
+     */
+    virtual void exec() = 0;
+
+    /**
+     * Throws the exception the task completed with, if any.
+     *
+     * @throws CancellationException if the task was cancelled
+     */
+    void reportException() const;
+
+  private:
+    ForkJoinTask(const ForkJoinTask& other) = delete;
+    ForkJoinTask& operator=(const ForkJoinTask& rhs) = delete;
+
+    friend class ForkJoinPool;
+
+    /*
+     * The low bits hold the completion. SIGNAL is set while threads wait on
+     * the futex, FORKED from the time the task is handed to a pool until a
+     * pool thread takes it out, and STARTED while it runs.
+     */
+    enum Status {
+        PENDING, NORMAL, EXCEPTIONAL, CANCELLED, DONE_MASK = 3, SIGNAL = 4, FORKED = 8, STARTED = 16
+    };
+
+    /*
+     * Returns true if the task is done and the pool done with it.
+     */
+    bool isSettled() const {
+        const uint32_t status = m_status.load(std::memory_order_acquire);
+        return (status & DONE_MASK) != PENDING && (status & FORKED) == 0;
+    }
+
+    void complete(uint32_t completion);
+    void awaitDone();
+
+    /*
+     * Drops a task the pool took out but will not run.
+     */
+    void discard() {
+        cancel();
+        Run();
+    }
+
+    std::atomic<uint32_t> m_status;
+    std::exception_ptr m_exception;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_FORKJOINTASK_HPP */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_FUTURE_HPP
+#define	DECAF_FUTURE_HPP
+
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * A Future represents the pending completion of a task handed to an
+ * executor. Methods are provided to check if the task is complete, to wait
+ * for its completion, and to cancel it.
+ *
+ * Tasks are Runnables, which have no result: get() returns once the task has
+ * run, and rethrows whatever the task threw.
+ */
+class Future : public Object {
+  public:
+    Future() { }
+    virtual ~Future() { }
+
+    /**
+     * Attempts to cancel execution of this task. This attempt will fail if the
+     * task has already completed, has already been cancelled, or could not be
+     * cancelled for some other reason. If successful, and this task has not
+     * started when cancel is called, this task should never run.
+     *
+     * @param mayInterruptIfRunning whether the thread executing this task
+     * should be interrupted; otherwise, in-progress tasks are allowed to
+     * complete
+     * @return false if the task could not be cancelled, typically because it
+     * has already completed normally; true otherwise
+     */
+    virtual bool cancel(bool mayInterruptIfRunning) = 0;
+
+    /**
+     * Returns true if this task was cancelled before it completed normally.
+     */
+    virtual bool isCancelled() const = 0;
+
+    /**
+     * Returns true if this task completed, normally, by throwing or by being
+     * cancelled.
+     */
+    virtual bool isDone() const = 0;
+
+    /**
+     * Waits if necessary for the task to complete.
+     *
+     * @throws CancellationException if the task was cancelled
+     * @throws the exception the task threw, if any
+     */
+    virtual void get() = 0;
+
+    /**
+     * Waits if necessary for at most the given time for the task to complete.
+     *
+     * @throws CancellationException if the task was cancelled
+     * @throws TimeoutException if the wait timed out
+     * @throws the exception the task threw, if any
+     */
+    virtual void get(uint64_t timeout, const TimeUnit* unit) = 0;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_FUTURE_HPP */
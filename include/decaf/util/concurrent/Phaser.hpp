@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_PHASER_HPP
+#define	DECAF_PHASER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <string>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * A reusable synchronization barrier, similar in functionality to
+ * CyclicBarrier and CountDownLatch but supporting more flexible usage.
+ *
+ * Registration. Unlike the case for other barriers, the number of parties
+ * registered to synchronize on a phaser may vary over time. Tasks may be
+ * registered at any time, using registerParty(), bulkRegister(int32_t) or the
+ * constructors, and optionally deregistered upon any arrival, using
+ * arriveAndDeregister().
+ *
+ * Synchronization. Each generation of a phaser has an associated phase
+ * number, which starts at zero and advances when all parties arrive at the
+ * phaser, wrapping around to zero after reaching INT32_MAX. arrive() and
+ * arriveAndDeregister() record arrival without blocking; awaitAdvance()
+ * waits for the phase to advance from the given phase number, and
+ * arriveAndAwaitAdvance() does both. When the final party for a given phase
+ * arrives, onAdvance() is invoked and the phase advances.
+ *
+ * Termination. A phaser may enter a termination state, which may be checked
+ * using isTerminated(), when onAdvance() returns true, by default once no
+ * parties are registered, or when forceTermination() is called. Upon
+ * termination all synchronization methods immediately return without
+ * waiting for advance, as indicated by a negative return value.
+ *
+ * Tiering. Phasers may be tiered, i.e. constructed in tree structures, to
+ * reduce contention. A phaser with a large number of parties that would
+ * otherwise experience heavy synchronization contention costs may instead be
+ * set up so that groups of sub-phasers share a common parent: the arrivals
+ * of a group then only contend on their own sub-phaser, whose last arrival
+ * alone is carried up to its parent. A sub-phaser registers with its parent
+ * once it has parties, and deregisters once it has none left.
+ *
+ * The state of a phaser is one 64-bit atomic word, and the threads waiting
+ * for the phase of a tree of phasers to advance sleep on a futex of its
+ * root, which the advance wakes with a single system call. The number of
+ * parties of one phaser is limited to 65535.
+ */
+class Phaser : public Object {
+  public:
+    /**
+     * Creates a new phaser with the given number of registered unarrived
+     * parties, no parent, and initial phase number 0.
+     *
+     * @throws IllegalArgumentException if parties is negative or greater
+     * than the maximum number of parties supported
+     */
+    explicit Phaser(int32_t parties = 0);
+
+    /**
+     * Creates a new phaser with the given parent, which must outlive it, and
+     * number of registered unarrived parties. When the given parent is
+     * non-null and the given number of parties is greater than zero, this
+     * child phaser is registered with its parent.
+     *
+     * @throws IllegalArgumentException if parties is negative or greater
+     * than the maximum number of parties supported
+     */
+    Phaser(Phaser* parent, int32_t parties);
+
+    virtual ~Phaser();
+    Phaser(const Phaser& other) = delete;
+    Phaser& operator=(const Phaser& rhs) = delete;
+
+    /**
+     * Adds a new unarrived party to this phaser. If an invocation of
+     * onAdvance() is in progress, this method may await its completion.
+     * Java calls this method register(), a reserved word in C++.
+     *
+     * @return the arrival phase number to which this registration applied,
+     * negative if this phaser has terminated
+     * @throws IllegalStateException if attempting to register more than the
+     * maximum supported number of parties
+     */
+    int32_t registerParty();
+
+    /**
+     * Adds the given number of new unarrived parties to this phaser.
+     *
+     * @return the arrival phase number to which this registration applied,
+     * negative if this phaser has terminated
+     * @throws IllegalArgumentException if parties is negative
+     * @throws IllegalStateException if attempting to register more than the
+     * maximum supported number of parties
+     */
+    int32_t bulkRegister(int32_t parties);
+
+    /**
+     * Arrives at this phaser, without waiting for others to arrive.
+     *
+     * @return the arrival phase number, negative if terminated
+     * @throws IllegalStateException if not terminated and the number of
+     * unarrived parties would become negative
+     */
+    int32_t arrive();
+
+    /**
+     * Arrives at this phaser and deregisters from it without waiting for
+     * others to arrive. Deregistration reduces the number of parties required
+     * to advance in future phases.
+     *
+     * @return the arrival phase number, negative if terminated
+     * @throws IllegalStateException if not terminated and the number of
+     * registered or unarrived parties would become negative
+     */
+    int32_t arriveAndDeregister();
+
+    /**
+     * Arrives at this phaser and awaits others.
+     *
+     * @return the arrival phase number, or the (negative) current phase if
+     * terminated
+     * @throws IllegalStateException if not terminated and the number of
+     * unarrived parties would become negative
+     */
+    int32_t arriveAndAwaitAdvance();
+
+    /**
+     * Awaits the phase of this phaser to advance from the given phase value,
+     * returning immediately if the current phase is not equal to the given
+     * phase value or this phaser is terminated.
+     *
+     * @return the next arrival phase number, or the argument if it is
+     * negative, or the (negative) current phase if terminated
+     */
+    int32_t awaitAdvance(int32_t phase);
+
+    /**
+     * Awaits the phase of this phaser to advance from the given phase value
+     * or the given timeout to elapse.
+     *
+     * @return the next arrival phase number, or the argument if it is
+     * negative, or the (negative) current phase if terminated
+     * @throws TimeoutException if the timeout elapses first
+     */
+    int32_t awaitAdvance(int32_t phase, const uint64_t& timeout, const TimeUnit* unit);
+
+    /**
+     * Awaits the phase of this phaser to advance from the given phase value
+     * or the given deadline to pass.
+     *
+     * @return the next arrival phase number, or the argument if it is
+     * negative, or the (negative) current phase if terminated
+     * @throws TimeoutException if the deadline passes first
+     */
+    int32_t awaitAdvanceUntil(int32_t phase, const Deadline& deadline);
+
+    /**
+     * Forces this phaser, and all of the phasers of its tree, to enter the
+     * termination state. Counts of registered parties are unaffected.
+     */
+    void forceTermination();
+
+    /**
+     * Returns the current phase number, negative if this phaser has
+     * terminated.
+     */
+    int32_t getPhase() const;
+
+    /**
+     * Returns the number of parties registered at this phaser.
+     */
+    int32_t getRegisteredParties() const;
+
+    /**
+     * Returns the number of registered parties that have arrived at the
+     * current phase of this phaser.
+     */
+    int32_t getArrivedParties() const;
+
+    /**
+     * Returns the number of registered parties that have not yet arrived at
+     * the current phase of this phaser.
+     */
+    int32_t getUnarrivedParties() const;
+
+    /**
+     * Returns the parent of this phaser, or null if none.
+     */
+    Phaser* getParent() const {
+        return m_parent;
+    }
+
+    /**
+     * Returns the root ancestor of this phaser, which is the same as this
+     * phaser if it has no parent.
+     */
+    Phaser* getRoot() const {
+        return m_root;
+    }
+
+    /**
+     * Returns true if this phaser has been terminated.
+     */
+    bool isTerminated() const;
+
+    /**
+     * Returns a string identifying this phaser, as well as its state: the
+     * Object representation followed by the phase and the numbers of
+     * registered and arrived parties.
+     */
+    virtual std::string toString() const;
+
+  protected:
+    /**
+     * Performs an action upon impending phase advance of the root phaser,
+     * and controls termination. It is invoked by the party whose arrival
+     * completes the phase, before the phase advances, and must not register
+     * or arrive at the phaser itself.
+     *
+     * @param phase the current phase number on entry to this method, before
+     * this phaser is advanced
+     * @param registeredParties the current number of registered parties
+     * @return true if this phaser should terminate; the default
+     * implementation returns true once no parties are registered
+     */
+    virtual bool onAdvance(int32_t phase, int32_t registeredParties);
+
+  private:
+    int32_t doArrive(uint32_t adjustment);
+    int32_t doRegister(int32_t registrations);
+
+    /*
+     * Returns the state of this phaser, first bringing it up to the phase of
+     * the root if it lags behind.
+     */
+    uint64_t reconcileState();
+
+    /*
+     * Returns the state of this phaser as reconcileState() would leave it.
+     */
+    uint64_t currentState() const;
+
+    /*
+     * Advances the phase of the root from the state s, which has the last
+     * party arrived, and wakes the threads waiting for it. Returns the new
+     * phase, or the current one if the phaser was terminated meanwhile.
+     */
+    int32_t advance(uint64_t s, int32_t phase);
+
+    /*
+     * Waits, on the root, for its phase to differ from the given one, or the
+     * absolute CLOCK_MONOTONIC time deadline, unless null, to pass. Returns
+     * the phase of the root.
+     */
+    int32_t internalAwaitAdvance(int32_t phase, const struct timespec* deadline);
+
+    /*
+     * Wakes the threads waiting for the phase of the root to change.
+     */
+    void releaseWaiters();
+
+    /*
+     * The phase in the upper half, with the sign bit set once terminated, and
+     * the numbers of registered and unarrived parties in the lower one.
+     */
+    std::atomic<uint64_t> m_state;
+    Phaser* const m_parent;
+    Phaser* const m_root;
+
+    /*
+     * Root only: the futex the waiters sleep on, bumped whenever the phase
+     * advances or the tree terminates.
+     */
+    std::atomic<uint32_t> m_wakeups;
+    std::atomic<uint32_t> m_waiters;
+    lang::detail::AdaptiveSpin m_spin;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_PHASER_HPP */
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_RECURSIVEACTION_HPP
+#define	DECAF_RECURSIVEACTION_HPP
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/util/concurrent/ForkJoinTask.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * A ForkJoinTask without a result, for computations done by side effect,
+ * such as sorting an array in place.
+ */
+class RecursiveAction : public ForkJoinTask {
+  public:
+    RecursiveAction() { }
+    virtual ~RecursiveAction() { }
+
+    /**
+     * Waits until the task is done.
+     *
+     * @throws the exception the task threw, or CancellationException
+     */
+    void join() {
+        quietlyJoin();
+        reportException();
+    }
+
+    /**
+     * Runs the task in the calling thread, if nobody has yet, and waits
+     * until it is done.
+     *
+     * @throws the exception the task threw, or CancellationException
+     */
+    void invoke() {
+        quietlyInvoke();
+        reportException();
+    }
+
+  protected:
+    /**
+     * The computation of the task.
+     */
+    virtual void compute() = 0;
+
+    virtual void exec() {
+        compute();
+    }
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_RECURSIVEACTION_HPP */
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_RECURSIVETASK_HPP
+#define	DECAF_RECURSIVETASK_HPP
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/util/concurrent/ForkJoinTask.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * A ForkJoinTask that computes a result of type V, which must be default
+ * constructible and copyable.
+ */
+template<typename V>
+class RecursiveTask : public ForkJoinTask {
+  public:
+    RecursiveTask() : m_result() { }
+    virtual ~RecursiveTask() { }
+
+    /**
+     * Waits until the task is done, and returns its result.
+     *
+     * @throws the exception the task threw, or CancellationException
+     */
+    V join() {
+        quietlyJoin();
+        reportException();
+        return m_result;
+    }
+
+    /**
+     * Runs the task in the calling thread, if nobody has yet, waits until it
+     * is done, and returns its result.
+     *
+     * @throws the exception the task threw, or CancellationException
+     */
+    V invoke() {
+        quietlyInvoke();
+        reportException();
+        return m_result;
+    }
+
+    /**
+     * Returns the result of the task, or a default constructed V if it is
+     * not done, or did not complete normally.
+     */
+    const V& getRawResult() const {
+        return m_result;
+    }
+
+  protected:
+    /**
+     * The computation of the task.
+     */
+    virtual V compute() = 0;
+
+    virtual void exec() {
+        m_result = compute();
+    }
+
+  private:
+    V m_result;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_RECURSIVETASK_HPP */
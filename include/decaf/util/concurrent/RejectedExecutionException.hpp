@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DECAF_REJECTEDEXECUTIONEXCEPTION_HPP
+#define	DECAF_REJECTEDEXECUTIONEXCEPTION_HPP
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/RuntimeException.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * Thrown by an Executor when a task cannot be accepted for execution, e.g.
+ * after the executor was shut down.
+ */
+class RejectedExecutionException : public lang::RuntimeException {
+  public:
+
+    /**
+     * Constructs a new RejectedExecutionException with null as its detail message.
+     * The cause is not initialized, and may subsequently be initialized by 
+     * a call to Throwable.initCause(decaf::lang::Throwable).
+     */
+    RejectedExecutionException() : lang::RuntimeException() { }
+
+    /**
+     * Constructs a new RejectedExecutionException with the specified detail message. 
+     * The cause is not initialized, and may subsequently be initialized by a
+     * call to Throwable.initCause(decaf::.lang::Throwable).
+     * @param message the detail message. The detail message is saved for later
+     *                 retrieval by the Throwable.getMessage() method.
+     */
+    explicit RejectedExecutionException(const std::string& message) : lang::RuntimeException(message) { }
+
+    /**
+     * Constructs a new RejectedExecutionException with the specified detail message and cause.
+     * Note that the detail message associated with cause is not automatically
+     * incorporated in this exception's detail message.
+     * @param message the detail message. The detail message is saved for later
+     *                 retrieval by the Throwable.getMessage() method.
+     * @param cause the cause (which is saved for later retrieval by the 
+     *               Throwable.getCause() method). (A null value is permitted,
+     *               and indicates that the cause is nonexistent or unknown.)
+     */
+    explicit RejectedExecutionException(const std::string& message, lang::Throwable* cause) :
+      lang::RuntimeException(message, cause) { }
+
+    /**
+     * Constructs a new RejectedExecutionException with the specified cause and a detail message 
+     * of (cause==null ? null : cause.toString()) (which typically contains the 
+     * class and detail message of cause). This constructor is useful for 
+     * exceptions that are little more than wrappers for other throwables
+     * @param cause the cause (which is saved for later retrieval by the 
+     *               Throwable.getCause() method). (A null value is permitted,
+     *               and indicates that the cause is nonexistent or unknown.)
+     */
+    explicit RejectedExecutionException(lang::Throwable* cause) : lang::RuntimeException(cause) { }
+
+    virtual ~RejectedExecutionException() = default;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_REJECTEDEXECUTIONEXCEPTION_HPP */
+
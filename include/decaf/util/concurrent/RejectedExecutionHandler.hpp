@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_REJECTEDEXECUTIONHANDLER_HPP
+#define	DECAF_REJECTEDEXECUTIONHANDLER_HPP
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/Ref.hpp"
+#include "decaf/lang/Runnable.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+class ThreadPoolExecutor;
+
+/**
+ * A handler for tasks that cannot be executed by a ThreadPoolExecutor,
+ * either because it has been shut down, or because its threads and its work
+ * queue are all in use. ThreadPoolExecutor provides the usual policies as
+ * nested classes: AbortPolicy, CallerRunsPolicy, DiscardPolicy and
+ * DiscardOldestPolicy.
+ *
+ * Handlers are shared by the threads that call execute(), and must be
+ * thread-safe.
+ */
+class RejectedExecutionHandler : public Object {
+  public:
+    RejectedExecutionHandler() { }
+    virtual ~RejectedExecutionHandler() { }
+
+    /**
+     * Invoked by ThreadPoolExecutor::execute() when it cannot accept the
+     * task, in the thread that called it and without any of the executor's
+     * locks held. The handler may throw RejectedExecutionException, which
+     * execute() lets through to its caller.
+     *
+     * @param task the task requested to be executed
+     * @param executor the executor attempting to execute the task
+     * @throws RejectedExecutionException if there is no remedy
+     */
+    virtual void rejectedExecution(const lang::Ref<lang::Runnable>& task, ThreadPoolExecutor* executor) = 0;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_REJECTEDEXECUTIONHANDLER_HPP */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_SCHEDULEDEXECUTORSERVICE_HPP
+#define	DECAF_SCHEDULEDEXECUTORSERVICE_HPP
+
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Ref.hpp"
+#include "decaf/lang/Runnable.hpp"
+#include "decaf/util/concurrent/ExecutorService.hpp"
+#include "decaf/util/concurrent/ScheduledFuture.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * An ExecutorService that can schedule commands to run after a given delay,
+ * or to execute periodically.
+ *
+ * The schedule methods create tasks with various delays and return a future
+ * that can be used to cancel or check execution. The scheduleAtFixedRate and
+ * scheduleWithFixedDelay methods create and execute tasks that run
+ * periodically until cancelled.
+ *
+ * Commands submitted using execute() are scheduled with a requested delay of
+ * zero.
+ */
+class ScheduledExecutorService : public ExecutorService {
+  public:
+    ScheduledExecutorService() { }
+    virtual ~ScheduledExecutorService() { }
+
+    /**
+     * Creates and executes a one-shot action that becomes enabled after the
+     * given delay.
+     *
+     * @return a future whose get() returns once the task has run
+     * @throws RejectedExecutionException if the task cannot be scheduled
+     */
+    virtual lang::Ref<ScheduledFuture> schedule(const lang::Ref<lang::Runnable>& command, uint64_t delay,
+      const TimeUnit* unit) = 0;
+
+    /**
+     * Creates and executes a periodic action that becomes enabled first after
+     * the given initial delay, and subsequently with the given period; that is
+     * executions will commence after initialDelay then initialDelay+period,
+     * then initialDelay + 2 * period, and so on. If any execution of the task
+     * throws, subsequent executions are suppressed. Otherwise, the task will
+     * only terminate via cancellation or termination of the executor. If any
+     * execution of this task takes longer than its period, then subsequent
+     * executions may start late, but will not concurrently execute.
+     *
+     * @throws RejectedExecutionException if the task cannot be scheduled
+     * @throws IllegalArgumentException if period is 0
+     */
+    virtual lang::Ref<ScheduledFuture> scheduleAtFixedRate(const lang::Ref<lang::Runnable>& command,
+      uint64_t initialDelay, uint64_t period, const TimeUnit* unit) = 0;
+
+    /**
+     * Creates and executes a periodic action that becomes enabled first after
+     * the given initial delay, and subsequently with the given delay between
+     * the termination of one execution and the commencement of the next. If
+     * any execution of the task throws, subsequent executions are suppressed.
+     * Otherwise, the task will only terminate via cancellation or termination
+     * of the executor.
+     *
+     * @throws RejectedExecutionException if the task cannot be scheduled
+     * @throws IllegalArgumentException if delay is 0
+     */
+    virtual lang::Ref<ScheduledFuture> scheduleWithFixedDelay(const lang::Ref<lang::Runnable>& command,
+      uint64_t initialDelay, uint64_t delay, const TimeUnit* unit) = 0;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_SCHEDULEDEXECUTORSERVICE_HPP */
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_SCHEDULEDFUTURE_HPP
+#define	DECAF_SCHEDULEDFUTURE_HPP
+
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/util/concurrent/Future.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * A delayed result-bearing action that can be cancelled. Usually a scheduled
+ * future is the result of scheduling a task with a ScheduledExecutorService.
+ */
+class ScheduledFuture : public Future {
+  public:
+    ScheduledFuture() { }
+    virtual ~ScheduledFuture() { }
+
+    /**
+     * Returns the remaining delay before the next execution of the task, in
+     * the given time unit, or 0 if it is due.
+     */
+    virtual uint64_t getDelay(const TimeUnit* unit) const = 0;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_SCHEDULEDFUTURE_HPP */
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_SEMAPHORE_HPP
+#define	DECAF_SEMAPHORE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <pthread.h>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * A thread queued for permits of a Semaphore, on its own stack.
+ */
+struct SemaphoreWaiter {
+    enum State {
+        QUEUED,
+        WOKEN,
+        GRANTED
+    };
+
+    explicit SemaphoreWaiter(int32_t permits) : m_wakeup(0), m_state(QUEUED), m_permits(permits), m_next(0) { }
+
+    /*
+     * The futex the thread sleeps on; set to 1 once the waiter has left the
+     * queue, after which the releasing thread no longer touches it.
+     */
+    std::atomic<uint32_t> m_wakeup;
+
+    /*
+     * Why the waiter left the queue: WOKEN to try again, or GRANTED its
+     * permits by a release of a fair semaphore. Guarded by the semaphore.
+     */
+    State m_state;
+    int32_t m_permits;
+    SemaphoreWaiter* m_next;
+};
+
+DECAF_CLOSE_NAMESPACE
+
+/**
+ * A counting semaphore. Conceptually, a semaphore maintains a set of permits.
+ * Each acquire() blocks if necessary until a permit is available, and then
+ * takes it. Each release() adds a permit, potentially releasing a blocking
+ * acquirer. No actual permit objects are used; the Semaphore just keeps a
+ * count of the number available and acts accordingly.
+ *
+ * The permits are a single atomic counter, taken and returned with one
+ * compare-and-swap while they last. Threads that find too few permits queue
+ * in FIFO order and sleep on a futex of their own, so a release wakes exactly
+ * the waiters its permits can satisfy rather than all of them, whatever
+ * number of permits each of them asked for.
+ *
+ * A nonfair semaphore lets arriving threads take permits ahead of queued
+ * ones, which maximizes throughput; a release wakes the queued threads the
+ * permits suffice for and they compete for them again. A fair semaphore hands
+ * the released permits straight over to the queued threads in arrival order,
+ * and only lets a thread take permits without queueing when nobody is queued.
+ * A thread that asks for many permits is then never starved by threads that
+ * ask for few, but it also holds up everyone behind it until it is served.
+ *
+ * A release by one thread happens-before a successful acquire by another.
+ * Timeouts are measured on CLOCK_MONOTONIC.
+ */
+class Semaphore : public Object {
+  public:
+    /**
+     * Creates a Semaphore with the given number of permits, which may be
+     * negative, in which case releases must occur before any acquires will
+     * be granted.
+     *
+     * @param permits the initial number of permits available
+     * @param fair true if the semaphore should grant permits in FIFO order
+     */
+    explicit Semaphore(int32_t permits, bool fair = false);
+
+    virtual ~Semaphore();
+    Semaphore(const Semaphore& other) = delete;
+    Semaphore& operator=(const Semaphore& rhs) = delete;
+
+    /**
+     * Acquires a permit, blocking until one is available.
+     */
+    void acquire();
+
+    /**
+     * Acquires the given number of permits, blocking until all are available.
+     *
+     * @throws IllegalArgumentException if permits is negative
+     */
+    void acquire(int32_t permits);
+
+    /**
+     * Acquires a permit only if one is available at the time of invocation.
+     * Even a fair semaphore grants it ahead of the queued threads.
+     *
+     * @return true if a permit was acquired, false otherwise
+     */
+    bool tryAcquire();
+
+    /**
+     * Acquires the given number of permits only if all are available at the
+     * time of invocation. Even a fair semaphore grants them ahead of the
+     * queued threads.
+     *
+     * @throws IllegalArgumentException if permits is negative
+     */
+    bool tryAcquire(int32_t permits);
+
+    /**
+     * Acquires a permit if one becomes available within the given waiting
+     * time.
+     *
+     * @return true if a permit was acquired and false if the waiting time
+     * elapsed first
+     */
+    bool tryAcquire(const uint64_t& timeout, const TimeUnit* unit);
+
+    /**
+     * Acquires the given number of permits if all become available within
+     * the given waiting time.
+     *
+     * @return true if the permits were acquired and false if the waiting
+     * time elapsed first
+     * @throws IllegalArgumentException if permits is negative
+     */
+    bool tryAcquire(int32_t permits, const uint64_t& timeout, const TimeUnit* unit);
+
+    /**
+     * Acquires the given number of permits if all become available before
+     * the given deadline passes.
+     *
+     * @return true if the permits were acquired and false if the deadline
+     * passed first
+     * @throws IllegalArgumentException if permits is negative
+     */
+    bool tryAcquireUntil(int32_t permits, const Deadline& deadline);
+
+    /**
+     * Releases a permit, returning it to the semaphore.
+     */
+    void release();
+
+    /**
+     * Releases the given number of permits, returning them to the semaphore.
+     * There is no requirement that a thread that releases a permit must have
+     * acquired it.
+     *
+     * @throws IllegalArgumentException if permits is negative
+     */
+    void release(int32_t permits);
+
+    /**
+     * Returns the current number of permits available in this semaphore.
+     */
+    int32_t availablePermits() const {
+        return m_permits.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Acquires and returns all permits that are immediately available, or if
+     * negative permits are available, releases them.
+     *
+     * @return the number of permits acquired or, if negative, the number
+     * released
+     */
+    int32_t drainPermits();
+
+    /**
+     * Returns true if this semaphore has fairness set true.
+     */
+    bool isFair() const {
+        return m_fair;
+    }
+
+    /**
+     * Returns an estimate of the number of threads waiting to acquire.
+     */
+    int32_t getQueueLength() const {
+        return m_queueLength.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns whether any threads are waiting to acquire.
+     */
+    bool hasQueuedThreads() const {
+        return getQueueLength() != 0;
+    }
+
+  protected:
+    /**
+     * Shrinks the number of available permits by the indicated reduction.
+     * Unlike acquire() it does not block waiting for permits to become
+     * available.
+     *
+     * @throws IllegalArgumentException if reduction is negative
+     */
+    void reducePermits(int32_t reduction);
+
+  private:
+    /*
+     * Takes the given number of permits if that many are available.
+     */
+    bool tryTake(int32_t permits) {
+        int32_t available = m_permits.load(std::memory_order_relaxed);
+        while (available >= permits) {
+            if (m_permits.compare_exchange_weak(available, available - permits, std::memory_order_acquire))
+                return true;
+        }
+        return false;
+    }
+
+    /*
+     * Queues for the given number of permits, which are not available, until
+     * the absolute CLOCK_MONOTONIC time deadline, unless null, passes.
+     */
+    bool acquireQueued(int32_t permits, const struct timespec* deadline);
+
+    /*
+     * Takes the waiters that the available permits can satisfy off the queue,
+     * granting them their permits if the semaphore is fair, and returns them
+     * linked together, to be woken once the mutex is released.
+     */
+    detail::SemaphoreWaiter* dequeueSatisfiableLocked();
+
+    static void wake(detail::SemaphoreWaiter* waiters);
+
+    std::atomic<int32_t> m_permits;
+    const bool m_fair;
+    std::atomic<int32_t> m_queueLength;
+
+    /*
+     * Guards the queue of waiting threads, in FIFO order.
+     */
+    pthread_mutex_t m_mutex;
+    detail::SemaphoreWaiter* m_head;
+    detail::SemaphoreWaiter* m_tail;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_SEMAPHORE_HPP */
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_STOPWATCH_HPP
+#define	DECAF_STOPWATCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * Measures elapsed time on the CLOCK_MONOTONIC clock, which wall clock
+ * adjustments do not affect.
+ *
+ * A stopwatch accumulates the time it runs across start() and stop() pairs
+ * until reset(). elapsed() may be read while it runs.
+ *
+ * @code{.cpp}
+ *    Stopwatch stopwatch = Stopwatch::createStarted();
+ *    doSomething();
+ *    log("took " + stopwatch.toString());
+ *    uint64_t millis = stopwatch.elapsed(TimeUnit::MILLISECONDS);
+ * @endcode
+ *
+ * A Stopwatch is a plain value and is not thread-safe.
+ */
+class Stopwatch {
+  public:
+    /**
+     * Creates a stopped stopwatch at zero.
+     */
+    Stopwatch() : m_running(false), m_startTick(0), m_elapsedNanos(0) { }
+
+    /**
+     * Returns a stopped stopwatch at zero.
+     */
+    static Stopwatch createUnstarted() {
+        return Stopwatch();
+    }
+
+    /**
+     * Returns a stopwatch at zero, started.
+     */
+    static Stopwatch createStarted() {
+        Stopwatch stopwatch;
+        stopwatch.start();
+        return stopwatch;
+    }
+
+    /**
+     * Returns true if start() was called more recently than stop().
+     */
+    bool isRunning() const {
+        return m_running;
+    }
+
+    /**
+     * Starts the stopwatch.
+     *
+     * @return this stopwatch
+     * @throws IllegalStateException if the stopwatch is already running
+     */
+    Stopwatch& start();
+
+    /**
+     * Stops the stopwatch, which keeps the time elapsed so far.
+     *
+     * @return this stopwatch
+     * @throws IllegalStateException if the stopwatch is already stopped
+     */
+    Stopwatch& stop();
+
+    /**
+     * Sets the elapsed time to zero and stops the stopwatch.
+     *
+     * @return this stopwatch
+     */
+    Stopwatch& reset() {
+        m_running = false;
+        m_elapsedNanos = 0;
+        return *this;
+    }
+
+    /**
+     * Returns the time elapsed while the stopwatch ran, in nanoseconds.
+     */
+    uint64_t elapsedNanos() const {
+        return m_running ? m_elapsedNanos + (Deadline::now() - m_startTick) : m_elapsedNanos;
+    }
+
+    /**
+     * Returns the time elapsed while the stopwatch ran in the given unit,
+     * truncated: 1999 microseconds are 1 in MILLISECONDS.
+     */
+    uint64_t elapsed(const TimeUnit* unit) const {
+        return elapsed(*unit);
+    }
+
+    uint64_t elapsed(const TimeUnit& unit) const {
+        return unit.convert(elapsedNanos(), TimeUnit::of<std::chrono::nanoseconds>());
+    }
+
+    /**
+     * Returns the time elapsed while the stopwatch ran as a std::chrono
+     * duration.
+     */
+    std::chrono::nanoseconds elapsed() const {
+        return TimeUnit::of<std::chrono::nanoseconds>().toDuration(elapsedNanos());
+    }
+
+    /**
+     * Returns the elapsed time in the coarsest unit in which it is at least
+     * 1, to four significant digits, e.g. "38.31 ms".
+     */
+    std::string toString() const;
+
+  private:
+    bool m_running;
+    uint64_t m_startTick;
+    uint64_t m_elapsedNanos;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif // DECAF_STOPWATCH_HPP
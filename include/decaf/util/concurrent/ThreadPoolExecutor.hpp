@@ -0,0 +1,387 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_THREADPOOLEXECUTOR_HPP
+#define	DECAF_THREADPOOLEXECUTOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Ref.hpp"
+#include "decaf/lang/Runnable.hpp"
+#include "decaf/lang/Thread.hpp"
+#include "decaf/lang/ThreadGroup.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/ExecutorService.hpp"
+#include "decaf/util/concurrent/RejectedExecutionHandler.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+#include "decaf/util/concurrent/locks/HybridLock.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+/**
+ * An ExecutorService that runs each task on one of a pool of threads, as the
+ * ThreadPoolExecutor of Java does.
+ *
+ * The pool grows and shrinks between its core and maximum sizes. execute()
+ * starts a new thread for the task while fewer than core threads run, even if
+ * others are idle; past that, it queues the task, and only when the queue is
+ * full starts threads up to the maximum. Threads beyond the core size, and
+ * core threads too after allowCoreThreadTimeOut(true), exit once they have
+ * been idle for the keep-alive time. A task that finds both the queue full
+ * and the pool at its maximum, or the executor shut down, goes to the
+ * RejectedExecutionHandler, by default an AbortPolicy.
+ *
+ * The work queue is unbounded, which makes the core size the effective
+ * maximum, or holds at most a given number of tasks; a queue of capacity 0
+ * hands tasks directly to idle threads and grows the pool when there are
+ * none. Tasks are queued under a HybridLock, and idle threads park on a futex
+ * that execute() only signals when a thread is actually idle, so that a busy
+ * pool costs one uncontended lock per task on either side.
+ *
+ * The threads are decaf Threads, named after the pool and gathered in a
+ * ThreadGroup of their own, whose getUsage() gives the CPU time the pool
+ * consumed. Together with the statistics, read without locking where possible,
+ * and the pool sizes, which may be changed at any time, this is what an
+ * autoscaler needs. They are not daemon threads: a pool must be shut down for
+ * the program to exit.
+ *
+ * A task that throws terminates its thread, which reports the exception as any
+ * Thread does and is replaced by a new one. shutdownNow() interrupts the
+ * threads, which Thread::sleep() and the interruptible waits of the library
+ * notice; tasks blocked otherwise run until they return.
+ *
+ * An executor must not be destroyed by one of its own tasks: its destructor
+ * shuts it down and waits for the tasks to complete.
+ */
+class ThreadPoolExecutor final : public ExecutorService {
+  public:
+    /**
+     * The capacity of an unbounded work queue.
+     */
+    static const size_t UNBOUNDED = SIZE_MAX;
+
+    /**
+     * Throws a RejectedExecutionException.
+     */
+    class AbortPolicy : public RejectedExecutionHandler {
+      public:
+        virtual void rejectedExecution(const lang::Ref<lang::Runnable>& task, ThreadPoolExecutor* executor);
+    };
+
+    /**
+     * Runs the task in the thread that called execute(), which slows down
+     * submission to the pace of the pool, unless the executor has been shut
+     * down, in which case the task is discarded.
+     */
+    class CallerRunsPolicy : public RejectedExecutionHandler {
+      public:
+        virtual void rejectedExecution(const lang::Ref<lang::Runnable>& task, ThreadPoolExecutor* executor);
+    };
+
+    /**
+     * Silently discards the task.
+     */
+    class DiscardPolicy : public RejectedExecutionHandler {
+      public:
+        virtual void rejectedExecution(const lang::Ref<lang::Runnable>& task, ThreadPoolExecutor* executor);
+    };
+
+    /**
+     * Discards the oldest task in the queue, if any, and retries execute()
+     * until the task is taken, unless the executor has been shut down, in
+     * which case the task is discarded. With a queue of capacity 0, there is
+     * nothing to discard, and the caller waits for a thread to go idle.
+     */
+    class DiscardOldestPolicy : public RejectedExecutionHandler {
+      public:
+        virtual void rejectedExecution(const lang::Ref<lang::Runnable>& task, ThreadPoolExecutor* executor);
+    };
+
+    /**
+     * Creates an executor without threads; they are started as tasks come.
+     *
+     * @param corePoolSize the number of threads to keep, even when idle,
+     * unless allowCoreThreadTimeOut() is set
+     * @param maximumPoolSize the maximum number of threads
+     * @param keepAliveTime how long threads beyond the core size wait for new
+     * tasks before they exit
+     * @param unit the time unit of keepAliveTime
+     * @param queueCapacity the number of tasks the work queue holds, or
+     * UNBOUNDED
+     * @param handler the handler of the tasks the executor rejects; an
+     * AbortPolicy if null
+     * @throws IllegalArgumentException if maximumPoolSize is 0 or less than
+     * corePoolSize
+     */
+    ThreadPoolExecutor(uint32_t corePoolSize, uint32_t maximumPoolSize, uint64_t keepAliveTime,
+      const TimeUnit* unit, size_t queueCapacity = UNBOUNDED,
+      const lang::Ref<RejectedExecutionHandler>& handler = lang::Ref<RejectedExecutionHandler>());
+
+    /**
+     * Shuts the executor down, and waits for the queued and running tasks to
+     * complete.
+     */
+    virtual ~ThreadPoolExecutor();
+
+    /**
+     * Runs the task on a pool thread, or queues it, or hands it to the
+     * RejectedExecutionHandler, as described above.
+     *
+     * @throws IllegalArgumentException if command is null
+     * @throws RejectedExecutionException if the handler rejects the task
+     */
+    virtual void execute(const lang::Ref<lang::Runnable>& command);
+
+    virtual void shutdown();
+
+    /**
+     * Stops the executor, interrupts its threads, and returns the tasks still
+     * in the queue, without waiting for the running ones to return.
+     */
+    virtual std::vector<lang::Ref<lang::Runnable> > shutdownNow();
+
+    virtual bool isShutdown() const;
+
+    /**
+     * Returns true if the executor is shutting down: it has been shut down,
+     * but has not terminated yet.
+     */
+    bool isTerminating() const;
+
+    virtual bool isTerminated() const;
+
+    virtual bool awaitTermination(uint64_t timeout, const TimeUnit* unit);
+
+    virtual bool awaitTerminationUntil(const Deadline& deadline);
+
+    /**
+     * Removes the oldest task from the work queue, for rejection policies and
+     * load shedding.
+     *
+     * @return the task removed, or null if the queue was empty
+     */
+    lang::Ref<lang::Runnable> pollQueue();
+
+    /**
+     * Starts a core thread to wait for tasks, if fewer than core threads run.
+     *
+     * @return true if a thread was started
+     */
+    bool prestartCoreThread();
+
+    /**
+     * Starts as many threads as it takes to reach the core size.
+     *
+     * @return the number of threads started
+     */
+    uint32_t prestartAllCoreThreads();
+
+    uint32_t getCorePoolSize() const {
+        return m_corePoolSize.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Sets the core number of threads. Threads are started right away for
+     * queued tasks when the size grows; when it shrinks, the threads beyond
+     * the new size exit once idle for the keep-alive time.
+     *
+     * @throws IllegalArgumentException if corePoolSize is greater than the
+     * maximum pool size
+     */
+    void setCorePoolSize(uint32_t corePoolSize);
+
+    uint32_t getMaximumPoolSize() const {
+        return m_maximumPoolSize.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Sets the maximum number of threads. Threads beyond the new maximum exit
+     * when they next become idle.
+     *
+     * @throws IllegalArgumentException if maximumPoolSize is 0 or less than
+     * the core pool size
+     */
+    void setMaximumPoolSize(uint32_t maximumPoolSize);
+
+    uint64_t getKeepAliveTime(const TimeUnit* unit) const {
+        return unit->convert(m_keepAliveNanos.load(std::memory_order_relaxed), TimeUnit::NANOSECONDS);
+    }
+
+    /**
+     * Sets how long threads beyond the core size wait for new tasks before
+     * they exit. Idle threads apply the new time from their next wait.
+     *
+     * @throws IllegalArgumentException if the time is 0 and core threads
+     * time out
+     */
+    void setKeepAliveTime(uint64_t time, const TimeUnit* unit);
+
+    bool allowsCoreThreadTimeOut() const {
+        return m_allowCoreThreadTimeOut.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Sets whether core threads exit after the keep-alive time without tasks,
+     * like the threads beyond the core size.
+     *
+     * @throws IllegalArgumentException if value is true and the keep-alive
+     * time is 0
+     */
+    void allowCoreThreadTimeOut(bool value);
+
+    lang::Ref<RejectedExecutionHandler> getRejectedExecutionHandler() const;
+
+    /**
+     * @throws IllegalArgumentException if handler is null
+     */
+    void setRejectedExecutionHandler(const lang::Ref<RejectedExecutionHandler>& handler);
+
+    /**
+     * Returns the capacity of the work queue, or UNBOUNDED.
+     */
+    size_t getQueueCapacity() const {
+        return m_queueCapacity;
+    }
+
+    /**
+     * Returns the number of tasks in the work queue, waiting for a thread.
+     */
+    size_t getQueueSize() const {
+        return m_queueSize.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the current number of threads in the pool.
+     */
+    uint32_t getPoolSize() const {
+        return m_poolSize.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the largest number of threads that have ever simultaneously
+     * been in the pool.
+     */
+    uint32_t getLargestPoolSize() const {
+        return m_largestPoolSize.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of threads running a task.
+     */
+    uint32_t getActiveCount() const;
+
+    /**
+     * Returns the number of tasks that have completed execution, normally or
+     * by throwing.
+     */
+    uint64_t getCompletedTaskCount() const;
+
+    /**
+     * Returns the number of tasks ever accepted: completed, running, and
+     * queued.
+     */
+    uint64_t getTaskCount() const;
+
+    /**
+     * Returns the group of the pool's threads, e.g. for its CPU usage.
+     */
+    const lang::Ref<lang::ThreadGroup>& getThreadGroup() const {
+        return m_group;
+    }
+
+    virtual std::string toString() const;
+
+  private:
+    ThreadPoolExecutor(const ThreadPoolExecutor& other) = delete;
+    ThreadPoolExecutor& operator=(const ThreadPoolExecutor& rhs) = delete;
+
+    class Worker;
+    friend class Worker;
+
+    enum RunState { RUNNING, SHUTDOWN, STOP, TERMINATED };
+
+    /*
+     * The threads to start once m_lock is released.
+     */
+    typedef std::vector<lang::Ref<lang::Thread> > Starts;
+
+    void addWorker(const lang::Ref<lang::Runnable>& firstTask, Starts& starts);
+    void start(Starts& starts);
+
+    /*
+     * Does the work of execute(), but leaves a rejected task to the caller.
+     * Returns the handler to give it to, or null if the task was taken.
+     */
+    lang::Ref<RejectedExecutionHandler> submit(lang::Ref<lang::Runnable>& task);
+    bool enqueue(lang::Ref<lang::Runnable>& command);
+    void runWorker(Worker* worker);
+    lang::Ref<lang::Runnable> getTask(Worker* worker);
+    void retire(Worker* worker, uint32_t poolSize);
+    void workerExited(Worker* worker, Starts& starts);
+    void tryTerminate();
+    uint32_t claimIdle(uint32_t count);
+    void wakeIdle(uint32_t count);
+
+    const lang::Ref<lang::ThreadGroup> m_group;
+    const size_t m_queueCapacity;
+
+    /*
+     * Guards the queue, the workers, the sizes and the handler. The sizes and
+     * counts are atomic only for the getters that read them without it.
+     */
+    mutable locks::HybridLock m_lock;
+    std::deque<lang::Ref<lang::Runnable> > m_queue;
+    std::vector<Worker*> m_workers;
+    lang::Ref<RejectedExecutionHandler> m_handler;
+    uint64_t m_threadNumber;
+    uint64_t m_retiredTaskCount;
+
+    /*
+     * The threads waiting for tasks, and how many of them were signalled and
+     * have yet to wake up, which execute() need not signal again.
+     */
+    uint32_t m_idleCount;
+    uint32_t m_wakeups;
+
+    std::atomic<uint32_t> m_corePoolSize;
+    std::atomic<uint32_t> m_maximumPoolSize;
+    std::atomic<uint64_t> m_keepAliveNanos;
+    std::atomic<bool> m_allowCoreThreadTimeOut;
+    std::atomic<uint32_t> m_poolSize;
+    std::atomic<uint32_t> m_largestPoolSize;
+    std::atomic<size_t> m_queueSize;
+
+    /*
+     * A RunState, and the futex awaitTermination() waits on.
+     */
+    std::atomic<uint32_t> m_runState;
+
+    /*
+     * The futex idle threads wait on, bumped to wake them.
+     */
+    std::atomic<uint32_t> m_signal;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_THREADPOOLEXECUTOR_HPP */
@@ -18,14 +18,57 @@
 #ifndef DECAF_TIMEUNIT_H
 #define DECAF_TIMEUNIT_H
 
+#include <chrono>
 #include <cstdint>
+#include <ratio>
 #include <string>
+#include <type_traits>
 
 #include "decaf/lang/compatibility.hpp"
-#include "decaf/lang/Object.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+class Object;
+DECAF_CLOSE_NAMESPACE2
 
 DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
 
+class Deadline;
+
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * The ordinal of the TimeUnit whose granularity is the std::ratio Period, in
+ * seconds, or NO_TIME_UNIT if there is none.
+ */
+const uint32_t NO_TIME_UNIT = 7;
+
+template<typename Period>
+struct TimeUnitOrdinal {
+    static const uint32_t value =
+      std::ratio_equal<Period, std::nano>::value ? 0 :
+      std::ratio_equal<Period, std::micro>::value ? 1 :
+      std::ratio_equal<Period, std::milli>::value ? 2 :
+      std::ratio_equal<Period, std::ratio<1> >::value ? 3 :
+      std::ratio_equal<Period, std::ratio<60> >::value ? 4 :
+      std::ratio_equal<Period, std::ratio<3600> >::value ? 5 :
+      std::ratio_equal<Period, std::ratio<86400> >::value ? 6 : NO_TIME_UNIT;
+};
+
+/**
+ * @internal
+ * The number of nanoseconds in the std::ratio Period, in seconds, which must
+ * be a whole number.
+ */
+template<typename Period>
+struct PeriodNanos {
+    typedef std::ratio_divide<Period, std::nano> Nanos;
+    static_assert(Nanos::den == 1, "the period must be a whole number of nanoseconds");
+    static const uint64_t value = static_cast<uint64_t> (Nanos::num);
+};
+
+DECAF_CLOSE_NAMESPACE
+
 /**
  * A TimeUnit represents time durations at a given unit of granularity and provides utility methods
  * to convert across units, and to perform timing and delay operations in these units. A TimeUnit
@@ -37,432 +80,299 @@ DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
  * A TimeUnit is mainly used to inform time-based methods how a given timing parameter should be interpreted.
  * For example, the following code will timeout in 50 milliseconds:
  *
- *     TimeUnit::MILLISECONDS->sleep(50);
+ *     lock.tryLock(50, TimeUnit::MILLISECONDS);
+ *
+ * while this code will sleep for 50 seconds
  *
- * while this code will timeout in 50 seconds
+ *     TimeUnit::SECONDS->sleep(50);
  *
- *     TimeUnit* timeUnit = TimeUnit::SECONDS;
- *     timeUnit->sleep(50);
+ * Conversions truncate from finer to coarser units and saturate at MAX from coarser to finer ones, as
+ * the scale() of Java does. A TimeUnit is a value type with no virtual methods: conversions are inline
+ * constexpr functions which, for a unit known at compile time, fold to a constant, and otherwise cost a
+ * branch on the unit and a multiplication or a division by a constant.
  *
- * It is important to note that TimeUnit::NANOSECONDS, TimeUnit::MICROSECONDS, and so forth are static pointers
- * maintained by TimeUnit. You would not need to delete it.
+ * TimeUnit::NANOSECONDS, TimeUnit::MICROSECONDS, and so forth are pointers to units maintained by
+ * TimeUnit. You would not need to delete them. In constant expressions, where those pointers cannot be
+ * followed, TimeUnit::of() gives the unit of a std::chrono::duration type instead:
  *
- *     TimeUnit* timeUnit = TimeUnit::NANOSECONDS;
- *     delete timeUnit; // README: Do not do this. The compiler won't allow you to do this anyway
+ *     constexpr uint64_t timeout = TimeUnit::of<std::chrono::seconds>().toNanos(5);
  *
+ * std::chrono::duration values convert to and from any unit with convert(duration) and toDuration().
  */
-class TimeUnit : public Object {
+class TimeUnit {
   public:
-    TimeUnit();
-
-    virtual uint64_t convert(const uint64_t sourceDuration, TimeUnit* sourceUnit) = 0;
-    virtual uint64_t toNanos(const uint64_t duration) = 0;
-    virtual uint64_t toMicros(const uint64_t duration) = 0;
-    virtual uint64_t toMillis(const uint64_t duration) = 0;
-    virtual uint64_t toSeconds(const uint64_t duration) = 0;
-    virtual uint64_t toMinutes(const uint64_t duration) = 0;
-    virtual uint64_t toHours(const uint64_t duration) = 0;
-    virtual uint64_t toDays(const uint64_t duration) = 0;
-
-    void Sleep(uint64_t timeout) { } // TODO
-
-    virtual std::string toShortString() = 0;
-
-    static const uint64_t MIN;
-    static const uint64_t MAX;
-
-    /*
-     * Pre-allocated/constructed TimeUnits
-     */
-    static TimeUnit* const NANOSECONDS;
-    static TimeUnit* const MICROSECONDS;
-    static TimeUnit* const MILLISECONDS;
-    static TimeUnit* const SECONDS;
-    static TimeUnit* const MINUTES;
-    static TimeUnit* const HOURS;
-    static TimeUnit* const DAYS;
-
-  protected:
-    virtual ~TimeUnit() throw () = default;
-
-    static const uint64_t C0 = 1L;
-    static const uint64_t C1 = C0 * 1000L;
-    static const uint64_t C2 = C1 * 1000L;
-    static const uint64_t C3 = C2 * 1000L;
-    static const uint64_t C4 = C3 * 60L;
-    static const uint64_t C5 = C4 * 60L;
-    static const uint64_t C6 = C5 * 24L;
-
-    /*
-     * scale d by m, checking for overflow
+    /**
+     * Converts the given time duration in the given unit to this unit.
+     *
+     * @param sourceDuration the time duration in the given sourceUnit
+     * @param sourceUnit the unit of the sourceDuration argument
+     * @return the converted duration, truncated towards zero, or MAX if it would overflow
      */
-    static uint64_t scale(const uint64_t d, const uint64_t m, const uint64_t over);
-
-  private:
-    //SleepingStopwatch m_stopwatch; TODO
-};
-
-DECAF_OPEN_NAMESPACE(detail)
-
-/**
- * A TimeUnit that represents nanoseconds
- */
-class Nanoseconds : public TimeUnit {
-  public:
-    Nanoseconds() = default;
-
-    virtual uint64_t toNanos(const uint64_t d) {
-        return d;
-    }
-
-    virtual uint64_t toMicros(const uint64_t d) {
-        return (d / (C1 / C0));
-    }
-
-    virtual uint64_t toMillis(const uint64_t d) {
-        return (d / (C2 / C0));
-    }
-
-    virtual uint64_t toSeconds(const uint64_t d) {
-        return (d / (C3 / C0));
-    }
-
-    virtual uint64_t toMinutes(const uint64_t d) {
-        return (d / (C4 / C0));
-    }
-
-    virtual uint64_t toHours(const uint64_t d) {
-        return (d / (C5 / C0));
-    }
-
-    virtual uint64_t toDays(const uint64_t d) {
-        return (d / (C6 / C0));
-    }
-
-    virtual uint64_t convert(const uint64_t d, TimeUnit* u) {
-        return u->toNanos(d);
-    }
-
-    virtual std::string toString() const  {
-        return "NANOSECONDS";
-    };
-
-    virtual std::string toShortString() {
-        return "ns";
-    };
-
-  protected:
-    virtual ~Nanoseconds() throw () = default;
-};
-
-/**
- * A TimeUnit that represents microseconds
- */
-class Microseconds : public TimeUnit {
-  public:
-    Microseconds() = default;
-
-    virtual uint64_t toNanos(const uint64_t d) {
-        return scale(d, (C1 / C0), (TimeUnit::MAX / (C1 / C0)));
-        ;
-    }
-
-    virtual uint64_t toMicros(const uint64_t d) {
-        return d;
-    }
-
-    virtual uint64_t toMillis(const uint64_t d) {
-        return (d / (C2 / C1));
-    }
-
-    virtual uint64_t toSeconds(const uint64_t d) {
-        return (d / (C3 / C1));
-    }
-
-    virtual uint64_t toMinutes(const uint64_t d) {
-        return (d / (C4 / C1));
-    }
-
-    virtual uint64_t toHours(const uint64_t d) {
-        return (d / (C5 / C1));
-    }
-
-    virtual uint64_t toDays(const uint64_t d) {
-        return (d / (C6 / C1));
-    }
-
-    virtual uint64_t convert(const uint64_t d, TimeUnit* u) {
-        return u->toMicros(d);
-    }
-
-    virtual std::string toString() const  {
-        return "MICROSECONDS";
-    };
-
-    virtual std::string toShortString() {
-        return "us";
-    };
-
-  protected:
-    virtual ~Microseconds() throw () = default;
-};
-
-/**
- * A TimeUnit that represents milliseconds
- */
-class Milliseconds : public TimeUnit {
-  public:
-    Milliseconds() = default;
-
-    virtual uint64_t toNanos(const uint64_t d) {
-        return scale(d, (C2 / C0), (TimeUnit::MAX / (C2 / C0)));
+    constexpr uint64_t convert(const uint64_t sourceDuration, const TimeUnit* sourceUnit) const {
+        return convert(sourceDuration, *sourceUnit);
     }
 
-    virtual uint64_t toMicros(const uint64_t d) {
-        return scale(d, (C2 / C1), (TimeUnit::MAX / (C2 / C1)));
+    constexpr uint64_t convert(const uint64_t sourceDuration, const TimeUnit& sourceUnit) const {
+        return convertOrdinal(sourceDuration, sourceUnit.m_ordinal, m_ordinal);
     }
 
-    virtual uint64_t toMillis(const uint64_t d) {
-        return d;
-    }
-
-    virtual uint64_t toSeconds(const uint64_t d) {
-        return (d / (C3 / C2));
-    }
-
-    virtual uint64_t toMinutes(const uint64_t d) {
-        return (d / (C4 / C2));
-    }
-
-    virtual uint64_t toHours(const uint64_t d) {
-        return (d / (C5 / C2));
-    }
-
-    virtual uint64_t toDays(const uint64_t d) {
-        return (d / (C6 / C2));
-    }
-
-    virtual uint64_t convert(const uint64_t d, TimeUnit* u) {
-        return u->toMillis(d);
-    }
-
-    virtual std::string toString() const  {
-        return "MILLISECONDS";
-    };
-
-    virtual std::string toShortString() {
-        return "ms";
-    };
-
-  protected:
-    virtual ~Milliseconds() throw () = default;
-};
-
-/**
- * A TimeUnit that represents seconds
- */
-class Seconds : public TimeUnit {
-  public:
-    Seconds() = default;
-
-    virtual uint64_t toNanos(const uint64_t d) {
-        return scale(d, (C3 / C0), (TimeUnit::MAX / (C3 / C0)));
-    }
-
-    virtual uint64_t toMicros(const uint64_t d) {
-        return scale(d, (C3 / C1), (TimeUnit::MAX / (C3 / C1)));
-    }
-
-    virtual uint64_t toMillis(const uint64_t d) {
-        return scale(d, (C3 / C2), (TimeUnit::MAX / (C3 / C2)));
-    }
-
-    virtual uint64_t toSeconds(const uint64_t d) {
-        return d;
+    /**
+     * Converts the given std::chrono::duration, of an integral representation and a whole number of
+     * nanoseconds per tick, to this unit. Negative durations convert to MIN.
+     *
+     * @return the converted duration, truncated towards zero, or MAX if it would overflow
+     */
+    template<typename Rep, typename Period>
+    constexpr uint64_t convert(const std::chrono::duration<Rep, Period>& duration) const {
+        static_assert(std::is_integral<Rep>::value, "the duration must have an integral representation");
+        return (duration.count() <= 0) ? MIN : fromPeriod<Period>(static_cast<uint64_t> (duration.count()));
     }
 
-    virtual uint64_t toMinutes(const uint64_t d) {
-        return (d / (C4 / C3));
+    constexpr uint64_t toNanos(const uint64_t duration) const {
+        return convertTo<ORDINAL_NANOSECONDS>(duration, m_ordinal);
     }
 
-    virtual uint64_t toHours(const uint64_t d) {
-        return (d / (C5 / C3));
+    constexpr uint64_t toMicros(const uint64_t duration) const {
+        return convertTo<ORDINAL_MICROSECONDS>(duration, m_ordinal);
     }
 
-    virtual uint64_t toDays(const uint64_t d) {
-        return (d / (C6 / C3));
+    constexpr uint64_t toMillis(const uint64_t duration) const {
+        return convertTo<ORDINAL_MILLISECONDS>(duration, m_ordinal);
     }
 
-    virtual uint64_t convert(const uint64_t d, TimeUnit* u) {
-        return u->toSeconds(d);
+    constexpr uint64_t toSeconds(const uint64_t duration) const {
+        return convertTo<ORDINAL_SECONDS>(duration, m_ordinal);
     }
 
-    virtual std::string toString() const  {
-        return "SECONDS";
-    };
-
-    virtual std::string toShortString() {
-        return "s";
-    };
-
-  protected:
-    virtual ~Seconds() throw () = default;
-};
-
-/**
- * A TimeUnit that represents minutes
- */
-class Minutes : public TimeUnit {
-  public:
-    Minutes() = default;
-
-    virtual uint64_t toNanos(const uint64_t d) {
-        return scale(d, (C4 / C0), (TimeUnit::MAX / (C4 / C0)));
+    constexpr uint64_t toMinutes(const uint64_t duration) const {
+        return convertTo<ORDINAL_MINUTES>(duration, m_ordinal);
     }
 
-    virtual uint64_t toMicros(const uint64_t d) {
-        return scale(d, (C4 / C1), (TimeUnit::MAX / (C4 / C1)));
+    constexpr uint64_t toHours(const uint64_t duration) const {
+        return convertTo<ORDINAL_HOURS>(duration, m_ordinal);
     }
 
-    virtual uint64_t toMillis(const uint64_t d) {
-        return scale(d, (C4 / C2), (TimeUnit::MAX / (C4 / C2)));
+    constexpr uint64_t toDays(const uint64_t duration) const {
+        return convertTo<ORDINAL_DAYS>(duration, m_ordinal);
     }
 
-    virtual uint64_t toSeconds(const uint64_t d) {
-        return scale(d, (C4 / C3), (TimeUnit::MAX / (C4 / C3)));
-    }
-
-    virtual uint64_t toMinutes(const uint64_t d) {
-        return d;
-    }
-
-    virtual uint64_t toHours(const uint64_t d) {
-        return (d / (C5 / C4));
-    }
-
-    virtual uint64_t toDays(const uint64_t d) {
-        return (d / (C6 / C4));
-    }
-
-    virtual uint64_t convert(const uint64_t d, TimeUnit* u) {
-        return u->toMinutes(d);
+    /**
+     * Converts the given duration in this unit to the std::chrono::duration type Duration, which
+     * must have an integral representation and a whole number of nanoseconds per tick.
+     *
+     * @return the converted duration, truncated towards zero, or Duration::max() if it would
+     * overflow
+     */
+    template<typename Duration = std::chrono::nanoseconds>
+    constexpr Duration toDuration(const uint64_t duration) const {
+        static_assert(std::is_integral<typename Duration::rep>::value,
+          "the duration must have an integral representation");
+        return clampDuration<Duration>(toPeriod<typename Duration::period>(duration));
     }
 
-    virtual std::string toString() const  {
-        return "MINUTES";
-    };
-
-    virtual std::string toShortString() {
-        return "m";
-    };
-
-  protected:
-    virtual ~Minutes() throw () = default;
-};
-
-/**
- * A TimeUnit that represents hours
- */
-class Hours : public TimeUnit {
-  public:
-    Hours() = default;
+    /**
+     * Returns the unit of the ticks of the std::chrono::duration type Duration, e.g. SECONDS for
+     * std::chrono::seconds. Fails to compile if the period of Duration is none of the units.
+     */
+    template<typename Duration>
+    static constexpr TimeUnit of() {
+        static_assert(detail::TimeUnitOrdinal<typename Duration::period>::value != detail::NO_TIME_UNIT,
+          "the period of the duration is not a TimeUnit");
+        return TimeUnit(detail::TimeUnitOrdinal<typename Duration::period>::value);
+    }
+
+    /**
+     * Makes the calling thread sleep for the given duration in this unit, to within a few
+     * microseconds.
+     *
+     * A plain nanosleep() returns up to the timer slack of the thread, 50us by default, plus the
+     * scheduler wake-up latency late. This method instead sleeps in clock_nanosleep() until a margin
+     * short of the end and spins for the rest. The margin follows how late the sleeps of the calling
+     * thread recently woke, so the spin stays short where the kernel is punctual and the sleep still
+     * ends on time where it is not. The spin is capped at 2ms: a thread that wakes later than that
+     * past its timer oversleeps.
+     *
+     * @param timeout the duration to sleep; nothing happens if it is 0
+     */
+    void sleep(uint64_t timeout) const;
 
-    virtual uint64_t toNanos(const uint64_t d) {
-        return scale(d, (C5 / C0), (TimeUnit::MAX / (C5 / C0)));
+    /**
+     * Same as sleep(), kept for source compatibility.
+     */
+    void Sleep(uint64_t timeout) const {
+        sleep(timeout);
     }
 
-    virtual uint64_t toMicros(const uint64_t d) {
-        return scale(d, (C5 / C1), (TimeUnit::MAX / (C5 / C1)));
+    /**
+     * Makes the calling thread sleep until the given deadline, the way sleep() does. Pacing
+     * loops should sleep until successive deadlines rather than for successive durations, so that
+     * the time spent between sleeps does not add up.
+     */
+    static void sleepUntil(const Deadline& deadline);
+
+    /**
+     * Waits on the monitor of the given object for at most the given duration in this unit, by
+     * calling obj->wait(millis, nanos). The calling thread must own the monitor of obj.
+     *
+     * @param obj the object to wait on
+     * @param timeout the maximum duration to wait; nothing happens if it is 0
+     * @throws IllegalMonitorStateException if the calling thread does not own the monitor of obj
+     */
+    void timedWait(lang::Object* obj, uint64_t timeout) const;
+
+    /**
+     * Waits at most the given duration in this unit for the given thread to terminate, by calling
+     * thread->join(millis, nanos).
+     *
+     * @param thread the thread to wait for
+     * @param timeout the maximum duration to wait; nothing happens if it is 0
+     */
+    template<typename Thread>
+    void timedJoin(Thread* thread, uint64_t timeout) const {
+        if (timeout == 0)
+            return;
+        const uint64_t nanos = toNanos(timeout);
+        thread->join(nanos / NANOS_PER_MILLI, nanos % NANOS_PER_MILLI);
     }
 
-    virtual uint64_t toMillis(const uint64_t d) {
-        return scale(d, (C5 / C2), (TimeUnit::MAX / (C5 / C2)));
+    /**
+     * Returns the position of this unit among the units, from 0 for NANOSECONDS to 6 for DAYS.
+     */
+    constexpr uint32_t ordinal() const {
+        return m_ordinal;
     }
 
-    virtual uint64_t toSeconds(const uint64_t d) {
-        return scale(d, (C5 / C3), (TimeUnit::MAX / (C5 / C3)));
-    }
+    /**
+     * Returns the name of this unit, e.g. "MILLISECONDS".
+     */
+    std::string toString() const;
 
-    virtual uint64_t toMinutes(const uint64_t d) {
-        return scale(d, (C5 / C4), (TimeUnit::MAX / (C5 / C4)));
-    }
+    /**
+     * Returns the symbol of this unit, e.g. "ms".
+     */
+    std::string toShortString() const;
 
-    virtual uint64_t toHours(const uint64_t d) {
-        return d;
+    constexpr bool operator==(const TimeUnit& rhs) const {
+        return m_ordinal == rhs.m_ordinal;
     }
 
-    virtual uint64_t toDays(const uint64_t d) {
-        return (d / (C6 / C5));
+    constexpr bool operator!=(const TimeUnit& rhs) const {
+        return m_ordinal != rhs.m_ordinal;
     }
 
-    virtual uint64_t convert(const uint64_t d, TimeUnit* u) {
-        return u->toHours(d);
+    /**
+     * Returns true if this unit is finer than the given one.
+     */
+    constexpr bool operator<(const TimeUnit& rhs) const {
+        return m_ordinal < rhs.m_ordinal;
     }
 
-    virtual std::string toString() const  {
-        return "HOURS";
-    };
-
-    virtual std::string toShortString() {
-        return "h";
-    };
+    static constexpr uint64_t MIN = 0;
+    static constexpr uint64_t MAX = UINT64_MAX;
 
-  protected:
-    virtual ~Hours() throw () = default;
-};
+    /*
+     * Pre-allocated/constructed TimeUnits
+     */
+    static TimeUnit* const NANOSECONDS;
+    static TimeUnit* const MICROSECONDS;
+    static TimeUnit* const MILLISECONDS;
+    static TimeUnit* const SECONDS;
+    static TimeUnit* const MINUTES;
+    static TimeUnit* const HOURS;
+    static TimeUnit* const DAYS;
 
-/**
- * A TimeUnit that represents days
- */
-class Days : public TimeUnit {
-  public:
-    Days() = default;
+  private:
+    explicit constexpr TimeUnit(uint32_t ordinal) : m_ordinal(ordinal) { }
+
+    static const uint32_t ORDINAL_NANOSECONDS = 0;
+    static const uint32_t ORDINAL_MICROSECONDS = 1;
+    static const uint32_t ORDINAL_MILLISECONDS = 2;
+    static const uint32_t ORDINAL_SECONDS = 3;
+    static const uint32_t ORDINAL_MINUTES = 4;
+    static const uint32_t ORDINAL_HOURS = 5;
+    static const uint32_t ORDINAL_DAYS = 6;
+
+    static constexpr uint64_t C0 = 1;
+    static constexpr uint64_t C1 = C0 * 1000;
+    static constexpr uint64_t C2 = C1 * 1000;
+    static constexpr uint64_t C3 = C2 * 1000;
+    static constexpr uint64_t C4 = C3 * 60;
+    static constexpr uint64_t C5 = C4 * 60;
+    static constexpr uint64_t C6 = C5 * 24;
+
+    static const uint64_t NANOS_PER_MILLI = C2;
 
-    virtual uint64_t toNanos(const uint64_t d) {
-        return scale(d, (C6 / C0), (TimeUnit::MAX / (C6 / C0)));
+    /*
+     * Returns the number of nanoseconds in the unit of the given ordinal.
+     */
+    static constexpr uint64_t nanosOf(uint32_t ordinal) {
+        return (ordinal == 0) ? C0 : (ordinal == 1) ? C1 : (ordinal == 2) ? C2 : (ordinal == 3) ? C3 :
+          (ordinal == 4) ? C4 : (ordinal == 5) ? C5 : C6;
     }
 
-    virtual uint64_t toMicros(const uint64_t d) {
-        return scale(d, (C6 / C1), (TimeUnit::MAX / (C6 / C1)));
+    /*
+     * Scales d by m, saturating at MAX.
+     */
+    static constexpr uint64_t scale(const uint64_t d, const uint64_t m) {
+        return (d > MAX / m) ? MAX : d * m;
     }
 
-    virtual uint64_t toMillis(const uint64_t d) {
-        return scale(d, (C6 / C2), (TimeUnit::MAX / (C6 / C2)));
+    /*
+     * Converts d between the units of the ordinals FROM and TO, which are
+     * known at compile time: a multiplication by, or a division by, a
+     * constant.
+     */
+    template<uint32_t FROM, uint32_t TO>
+    static constexpr uint64_t convertBetween(const uint64_t d) {
+        return (FROM >= TO) ? scale(d, nanosOf(FROM) / nanosOf(TO)) : d / (nanosOf(TO) / nanosOf(FROM));
     }
 
-    virtual uint64_t toSeconds(const uint64_t d) {
-        return scale(d, (C6 / C3), (TimeUnit::MAX / (C6 / C3)));
+    /*
+     * Converts d from the unit of the ordinal from to that of the ordinal TO.
+     */
+    template<uint32_t TO>
+    static constexpr uint64_t convertTo(const uint64_t d, const uint32_t from) {
+        return (from == 0) ? convertBetween<0, TO>(d) : (from == 1) ? convertBetween<1, TO>(d) :
+          (from == 2) ? convertBetween<2, TO>(d) : (from == 3) ? convertBetween<3, TO>(d) :
+          (from == 4) ? convertBetween<4, TO>(d) : (from == 5) ? convertBetween<5, TO>(d) :
+          convertBetween<6, TO>(d);
     }
 
-    virtual uint64_t toMinutes(const uint64_t d) {
-        return scale(d, (C6 / C4), (TimeUnit::MAX / (C6 / C4)));
+    static constexpr uint64_t convertOrdinal(const uint64_t d, const uint32_t from, const uint32_t to) {
+        return (to == 0) ? convertTo<0>(d, from) : (to == 1) ? convertTo<1>(d, from) :
+          (to == 2) ? convertTo<2>(d, from) : (to == 3) ? convertTo<3>(d, from) :
+          (to == 4) ? convertTo<4>(d, from) : (to == 5) ? convertTo<5>(d, from) : convertTo<6>(d, from);
     }
 
-    virtual uint64_t toHours(const uint64_t d) {
-        return scale(d, (C6 / C5), (TimeUnit::MAX / (C6 / C5)));
+    /*
+     * Converts count ticks of the std::ratio Period to this unit, or the
+     * reverse. Periods other than the units go through nanoseconds.
+     */
+    template<typename Period>
+    constexpr uint64_t fromPeriod(const uint64_t count) const {
+        return (detail::TimeUnitOrdinal<Period>::value != detail::NO_TIME_UNIT) ?
+          convertOrdinal(count, detail::TimeUnitOrdinal<Period>::value, m_ordinal) :
+          convertOrdinal(scale(count, detail::PeriodNanos<Period>::value), ORDINAL_NANOSECONDS, m_ordinal);
     }
 
-    virtual uint64_t toDays(const uint64_t d) {
-        return d;
+    template<typename Period>
+    constexpr uint64_t toPeriod(const uint64_t duration) const {
+        return (detail::TimeUnitOrdinal<Period>::value != detail::NO_TIME_UNIT) ?
+          convertOrdinal(duration, m_ordinal, detail::TimeUnitOrdinal<Period>::value) :
+          toNanos(duration) / detail::PeriodNanos<Period>::value;
     }
 
-    virtual uint64_t convert(const uint64_t d, TimeUnit* u) {
-        return u->toDays(d);
+    template<typename Duration>
+    static constexpr Duration clampDuration(const uint64_t count) {
+        return (count > static_cast<uint64_t> (Duration::max().count())) ? Duration::max() :
+          Duration(static_cast<typename Duration::rep> (count));
     }
 
-    virtual std::string toString() const  {
-        return "DAYS";
-    };
+    static TimeUnit s_units[7];
 
-    virtual std::string toShortString() {
-        return "d";
-    };
-
-  protected:
-    virtual ~Days() throw () = default;
+    uint32_t m_ordinal;
 };
 
-DECAF_CLOSE_NAMESPACE
 DECAF_CLOSE_NAMESPACE3
 
 #endif // DECAF_TIMEUNIT_H
@@ -0,0 +1,264 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_TIMINGWHEELEXECUTOR_HPP
+#define	DECAF_TIMINGWHEELEXECUTOR_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Ref.hpp"
+#include "decaf/lang/Runnable.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/ScheduledExecutorService.hpp"
+#include "decaf/util/concurrent/ScheduledFuture.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * A link of the circular, doubly-linked lists of the slots of a timing wheel.
+ * A node in no list links to itself.
+ */
+class WheelNode {
+  public:
+    WheelNode() : m_previous(this), m_next(this) { }
+
+    bool isLinked() const {
+        return m_next != this;
+    }
+
+    void linkBefore(WheelNode& node) {
+        m_previous = node.m_previous;
+        m_next = &node;
+        node.m_previous->m_next = this;
+        node.m_previous = this;
+    }
+
+    void unlink() {
+        m_previous->m_next = m_next;
+        m_next->m_previous = m_previous;
+        m_previous = this;
+        m_next = this;
+    }
+
+    /**
+     * Moves the nodes of the list headed by @a head to the list headed by
+     * this one, which must be empty.
+     */
+    void takeAll(WheelNode& head) {
+        if (!head.isLinked())
+            return;
+        m_next = head.m_next;
+        m_previous = head.m_previous;
+        m_next->m_previous = this;
+        m_previous->m_next = this;
+        head.m_previous = &head;
+        head.m_next = &head;
+    }
+
+    WheelNode* m_previous;
+    WheelNode* m_next;
+
+  private:
+    WheelNode(const WheelNode& other) = delete;
+    WheelNode& operator=(const WheelNode& rhs) = delete;
+};
+
+DECAF_CLOSE_NAMESPACE
+
+/**
+ * A ScheduledExecutorService for very large numbers of timers, such as the
+ * idle timeout of every connection and the deadline of every request, most
+ * of which are cancelled before they expire.
+ *
+ * Tasks are kept in a hierarchical timing wheel, as the timers of the Linux
+ * kernel used to be: 256 slots of one tick each, then four levels of 64
+ * slots, each slot of a level spanning the whole level below. A task goes in
+ * the slot of its deadline at the finest level that reaches it, and moves
+ * down a level each time the level below wraps around. Scheduling and
+ * cancelling are O(1) whatever the number of pending tasks, at the price of
+ * a resolution of one tick: a task never runs before its deadline, and
+ * runs up to a tick after it, plus the time the ticker takes to wake up. Deadlines beyond 2^32 ticks, 49 days at the default tick of
+ * 1ms, wait in the last level until they come in range.
+ *
+ * The wheel belongs to a dedicated ticker thread. schedule() and cancel()
+ * only push the task on a lock-free list, which the ticker drains on its next
+ * tick, so callers never contend on a lock with the ticker or each other.
+ * The ticker wakes once per tick while tasks are pending, processes all the
+ * ticks that elapsed in one batch, and parks while the wheel is empty.
+ *
+ * Tasks run on the ticker thread, one after the other, and hold up the ticks
+ * that follow while they run: hand anything longer than a few microseconds
+ * over to another executor.
+ *
+ * As with the ScheduledThreadPoolExecutor of Java, shutdown() cancels
+ * periodic tasks but lets the delayed ones run.
+ *
+ * An executor must not be destroyed by one of its own tasks.
+ */
+class TimingWheelExecutor final : public ScheduledExecutorService {
+  public:
+    /**
+     * Creates an executor whose wheel turns every @a tick @a unit, and starts
+     * its ticker thread.
+     *
+     * @throws IllegalArgumentException if tick is less than a microsecond
+     */
+    explicit TimingWheelExecutor(uint64_t tick = 1, const TimeUnit* unit = TimeUnit::MILLISECONDS);
+
+    /**
+     * Stops the executor as shutdownNow() does and waits for its ticker
+     * thread to exit.
+     */
+    virtual ~TimingWheelExecutor();
+
+    virtual void execute(const lang::Ref<lang::Runnable>& command);
+
+    virtual lang::Ref<ScheduledFuture> schedule(const lang::Ref<lang::Runnable>& command, uint64_t delay,
+      const TimeUnit* unit);
+
+    virtual lang::Ref<ScheduledFuture> scheduleAtFixedRate(const lang::Ref<lang::Runnable>& command,
+      uint64_t initialDelay, uint64_t period, const TimeUnit* unit);
+
+    virtual lang::Ref<ScheduledFuture> scheduleWithFixedDelay(const lang::Ref<lang::Runnable>& command,
+      uint64_t initialDelay, uint64_t delay, const TimeUnit* unit);
+
+    virtual void shutdown();
+
+    /**
+     * Cancels all pending tasks and waits for the ticker thread to exit,
+     * which it does once the task it may be running returns. Called from a
+     * task, returns right away, with no tasks.
+     */
+    virtual std::vector<lang::Ref<lang::Runnable> > shutdownNow();
+
+    virtual bool isShutdown() const;
+
+    virtual bool isTerminated() const;
+
+    virtual bool awaitTermination(uint64_t timeout, const TimeUnit* unit);
+
+    virtual bool awaitTerminationUntil(const Deadline& deadline);
+
+    /**
+     * Returns the length of a tick in nanoseconds.
+     */
+    uint64_t getTickNanos() const {
+        return m_tickNanos;
+    }
+
+    /**
+     * Returns the number of tasks in the wheel as of the last tick, leaving
+     * out those scheduled or cancelled since.
+     */
+    uint64_t getPendingCount() const {
+        return m_pendingCount.load(std::memory_order_relaxed);
+    }
+
+  private:
+    TimingWheelExecutor(const TimingWheelExecutor& other) = delete;
+    TimingWheelExecutor& operator=(const TimingWheelExecutor& rhs) = delete;
+
+    class Task;
+
+    enum RunState { RUNNING, SHUTDOWN, STOP, TERMINATED };
+
+    static const uint32_t ROOT_BITS = 8;
+    static const uint32_t LEVEL_BITS = 6;
+    static const uint32_t LEVELS = 4;
+    static const uint64_t ROOT_SLOTS = 1u << ROOT_BITS;
+    static const uint64_t LEVEL_SLOTS = 1u << LEVEL_BITS;
+    static const uint64_t MAX_TICKS = (1ull << (ROOT_BITS + LEVELS * LEVEL_BITS)) - 1;
+
+    lang::Ref<ScheduledFuture> enqueue(const lang::Ref<lang::Runnable>& command, uint64_t delay, uint64_t period,
+      bool fixedRate, const TimeUnit* unit);
+    void push(std::atomic<Task*>& list, Task* task);
+    void cancelled(Task* task);
+    void wakeTicker();
+
+    void runTicker();
+    void acceptScheduled();
+    void acceptCancelled();
+    void advance(uint64_t now);
+    void cascade(detail::WheelNode& slot);
+    void expire(detail::WheelNode& slot);
+    void run(Task* task);
+    void insert(Task* task);
+    void cancelPeriodic();
+    void stop();
+    void waitForTick(uint32_t signal);
+    void discardScheduled();
+
+    uint64_t tickOf(uint64_t nanos) const;
+
+    const uint64_t m_tickNanos;
+    const uint64_t m_origin;
+
+    /*
+     * Tasks scheduled, and tasks cancelled while in the wheel, since the
+     * ticker last drained the lists.
+     */
+    std::atomic<Task*> m_scheduled;
+    std::atomic<Task*> m_cancelled;
+
+    /*
+     * A RunState, and the futex awaitTermination() waits on.
+     */
+    std::atomic<uint32_t> m_runState;
+
+    /*
+     * The futex the ticker waits on, bumped to wake it, and whether it is
+     * parked with an empty wheel and needs waking for a new task.
+     */
+    std::atomic<uint32_t> m_signal;
+    std::atomic<uint32_t> m_parked;
+
+    std::atomic<uint64_t> m_pendingCount;
+
+    /*
+     * Ticker thread only: the next tick to process, the number of tasks in
+     * the wheel, the number of tasks taken out of the wheel that their
+     * cancel() has yet to push on m_cancelled, and whether the periodic tasks
+     * were cancelled after shutdown().
+     */
+    uint64_t m_nextTick;
+    uint64_t m_size;
+    uint64_t m_unclaimed;
+    bool m_periodicCancelled;
+
+    /*
+     * The commands shutdownNow() returns, handed over by the ticker when it
+     * terminates.
+     */
+    std::vector<lang::Ref<lang::Runnable> > m_drained;
+
+    detail::WheelNode m_root[ROOT_SLOTS];
+    detail::WheelNode m_levels[LEVELS][LEVEL_SLOTS];
+
+    std::thread m_ticker;
+};
+
+DECAF_CLOSE_NAMESPACE3
+
+#endif	/* DECAF_TIMINGWHEELEXECUTOR_HPP */
@@ -20,6 +20,8 @@
 
 #include "decaf/lang/compatibility.hpp"
 #include "decaf/lang/Object.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
 
 DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
 
@@ -57,6 +59,18 @@ class Condition : public Object {
      */
     virtual int64_t awaitNanos(const uint64_t& nanosTimeout) = 0;
 
+    /**
+     * Causes the current thread to wait until it is signalled or the
+     * specified deadline passes. Unlike the relative forms, the same deadline
+     * can be passed to every call of a wait loop without recomputing what is
+     * left of the timeout.
+     *
+     * @param deadline the time at which to give up waiting
+     * @return false if the deadline passed before return from the method,
+     * else true
+     */
+    virtual bool awaitUntil(const Deadline& deadline) = 0;
+
     /**
      * Wakes up one waiting thread.
      * If any threads are waiting on this condition then one is selected for 
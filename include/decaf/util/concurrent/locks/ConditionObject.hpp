@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_CONDITIONOBJECT_HPP
+#define	DECAF_CONDITIONOBJECT_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/util/concurrent/locks/Condition.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+class ReentrantLock;
+
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * A thread waiting on a ConditionObject. Waiters live on the stack of their
+ * thread and are linked, under the lock, into either the queue of the
+ * condition or the list of signalled threads of the lock.
+ */
+struct ConditionWaiter {
+    enum State {
+        WAITING,        // queued on the condition
+        TRANSFERRED,    // signalled, queued on the lock
+        WOKEN           // taken off the lock by a release, being woken
+    };
+
+    ConditionWaiter() : m_wakeup(0), m_state(WAITING), m_next(0) { }
+
+    /*
+     * The futex the thread sleeps on; set to 1 once it may proceed.
+     */
+    std::atomic<uint32_t> m_wakeup;
+    State m_state;
+    ConditionWaiter* m_next;
+};
+
+DECAF_CLOSE_NAMESPACE
+
+/**
+ * The Condition implementation of ReentrantLock.
+ *
+ * Waiting threads are queued in FIFO order, each sleeping on a futex of its
+ * own. signal() does not wake the first of them: it moves it onto the lock,
+ * and the next release of the lock wakes it, once the signalling thread no
+ * longer holds the lock the woken thread needs. signalAll() moves every
+ * waiter, and they are woken one per release, so they never stampede for
+ * the lock.
+ *
+ * Timeouts are measured on CLOCK_MONOTONIC.
+ */
+class ConditionObject : public Condition {
+  public:
+    explicit ConditionObject(ReentrantLock& lock);
+    virtual ~ConditionObject();
+    ConditionObject(const ConditionObject& other) = delete;
+    ConditionObject& operator=(const ConditionObject& rhs) = delete;
+
+    /**
+     * @throws IllegalMonitorStateException if the current thread does not
+     * hold the lock
+     */
+    virtual void await();
+
+    /**
+     * @throws IllegalMonitorStateException if the current thread does not
+     * hold the lock
+     */
+    virtual bool await(const uint64_t& t, const TimeUnit* unit);
+
+    /**
+     * @throws IllegalMonitorStateException if the current thread does not
+     * hold the lock
+     */
+    virtual int64_t awaitNanos(const uint64_t& nanosTimeout);
+
+    /**
+     * @throws IllegalMonitorStateException if the current thread does not
+     * hold the lock
+     */
+    virtual bool awaitUntil(const Deadline& deadline);
+
+    /**
+     * @throws IllegalMonitorStateException if the current thread does not
+     * hold the lock
+     */
+    virtual void signal();
+
+    /**
+     * @throws IllegalMonitorStateException if the current thread does not
+     * hold the lock
+     */
+    virtual void signalAll();
+
+  private:
+    void checkHeld() const;
+
+    ReentrantLock& m_lock;
+
+    /*
+     * The waiting threads, in FIFO order. Guarded by the lock.
+     */
+    detail::ConditionWaiter* m_head;
+    detail::ConditionWaiter* m_tail;
+};
+
+DECAF_CLOSE_NAMESPACE4
+
+#endif	/* DECAF_CONDITIONOBJECT_HPP */
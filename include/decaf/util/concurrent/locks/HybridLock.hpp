@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_HYBRIDLOCK_HPP
+#define	DECAF_HYBRIDLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/util/concurrent/locks/Lock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+/**
+ * A lock that spins while spinning pays off and parks otherwise: a futex
+ * word, taken and released with one atomic operation each, whose waiters
+ * spin for an adaptive budget before they sleep in the kernel, like those of
+ * ReentrantLock. Unlike the pure spin locks it stays efficient with long
+ * critical sections, more threads than processors, or preempted holders;
+ * unlike ReentrantLock it keeps no owner, and so no hold count, which makes
+ * it the cheaper of the two when reentrancy is not needed.
+ *
+ * The lock is unfair and not reentrant: a thread locking it twice
+ * deadlocks. Unlocking it without holding it is undefined. It has no
+ * conditions.
+ *
+ * The class is final, so that lock() and unlock() through a HybridLock, e.g.
+ * in a LockGuard<HybridLock>, are not virtual calls and inline.
+ */
+class HybridLock final : public Lock {
+  public:
+    HybridLock() : m_state(0) { }
+    virtual ~HybridLock();
+    HybridLock(const HybridLock& other) = delete;
+    HybridLock& operator=(const HybridLock& rhs) = delete;
+
+    /**
+     * Acquires the lock, spinning for a while, and then sleeping, while
+     * another thread holds it.
+     */
+    virtual void lock() {
+        if (!tryLock())
+            lockSlow(0);
+    }
+
+    /**
+     * Releases the lock, which the calling thread must hold, and wakes a
+     * sleeping waiter, if any.
+     */
+    virtual void unlock() {
+        if (m_state.exchange(0, std::memory_order_release) == 2)
+            lang::detail::futexWake(m_state, 1);
+    }
+
+    /**
+     * Acquires the lock only if it is free at the time of invocation.
+     *
+     * @return true if the lock was acquired, false otherwise
+     */
+    virtual bool tryLock() {
+        uint32_t state = 0;
+        return m_state.compare_exchange_strong(state, 1, std::memory_order_acquire);
+    }
+
+    /**
+     * Acquires the lock if it becomes free within the given waiting time.
+     *
+     * @param t the time to wait for the lock
+     * @param unit the time unit of the timeout argument
+     * @return true if the lock was acquired, false if the waiting time
+     * elapsed first
+     */
+    virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit);
+
+    /**
+     * Acquires the lock if it becomes free before the given deadline passes.
+     *
+     * @param deadline the time at which to give up waiting for the lock
+     * @return true if the lock was acquired, false if the deadline passed
+     * first
+     */
+    virtual bool tryLockUntil(const Deadline& deadline);
+
+    /**
+     * Hybrid locks have no conditions.
+     *
+     * @throws UnsupportedOperationException always
+     */
+    virtual Condition* newCondition();
+
+    /**
+     * Queries if any thread holds this lock, for monitoring rather than for
+     * synchronization.
+     */
+    bool isLocked() const {
+        return m_state.load(std::memory_order_relaxed) != 0;
+    }
+
+  private:
+    /*
+     * Spins, then sleeps, until the lock is taken, or the absolute
+     * CLOCK_MONOTONIC time deadline, unless null, passes.
+     */
+    bool lockSlow(const struct timespec* deadline);
+
+    /*
+     * 0 when free, 1 when taken, 2 when taken and threads may sleep on it.
+     */
+    std::atomic<uint32_t> m_state;
+    lang::detail::AdaptiveSpin m_spin;
+};
+
+DECAF_CLOSE_NAMESPACE4
+
+#endif	/* DECAF_HYBRIDLOCK_HPP */
@@ -20,6 +20,7 @@
 
 #include "decaf/lang/compatibility.hpp"
 #include "decaf/lang/Object.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
 #include "decaf/util/concurrent/TimeUnit.hpp"
 #include "decaf/util/concurrent/locks/Condition.hpp"
 
@@ -106,6 +107,15 @@ class Lock : public Object {
      */
     virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit) = 0;
 
+    /**
+     * Acquires the lock if it is free before the given deadline passes.
+     *
+     * @param deadline the time at which to give up waiting for the lock
+     * @return true if the lock was acquired and false if the deadline passed
+     * before the lock was acquired
+     */
+    virtual bool tryLockUntil(const Deadline& deadline) = 0;
+
     /**
      * Returns a new Condition instance that is bound to this Lock instance.
      * 
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_LOCKGUARD_HPP
+#define	DECAF_LOCKGUARD_HPP
+
+#include <mutex>
+
+#include "decaf/lang/compatibility.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+/**
+ * Holds a lock for the lifetime of a scope: the constructor locks it, the
+ * destructor unlocks it, also when the scope is left by an exception.
+ *
+ * @code{.cpp}
+ *    SpinLock lock;
+ *    ...
+ *    {
+ *        LockGuard<SpinLock> guard(lock);
+ *        // access the resource protected by the lock
+ *    }
+ * @endcode
+ *
+ * The guard calls the lock through its static type L. With one of the final
+ * lock types, SpinLock, TicketLock, MCSLock or HybridLock, the calls are
+ * therefore resolved at compile time and their fast paths inline into the
+ * guarded code; a LockGuard<Lock> still works with any lock, through virtual
+ * calls. L may be any type with lock() and unlock().
+ */
+template<typename L>
+class LockGuard {
+  public:
+    /**
+     * Acquires @a lock.
+     */
+    explicit LockGuard(L& lock) : m_lock(lock) {
+        m_lock.lock();
+    }
+
+    /**
+     * Takes over @a lock, which the calling thread already holds.
+     */
+    LockGuard(L& lock, std::adopt_lock_t) : m_lock(lock) { }
+
+    ~LockGuard() {
+        m_lock.unlock();
+    }
+
+    LockGuard(const LockGuard& other) = delete;
+    LockGuard& operator=(const LockGuard& rhs) = delete;
+
+  private:
+    L& m_lock;
+};
+
+DECAF_CLOSE_NAMESPACE4
+
+#endif	/* DECAF_LOCKGUARD_HPP */
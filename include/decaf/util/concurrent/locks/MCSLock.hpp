@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_MCSLOCK_HPP
+#define	DECAF_MCSLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/util/concurrent/locks/Lock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+DECAF_OPEN_NAMESPACE(detail)
+
+/**
+ * @internal
+ * The queue node of a thread acquiring, or holding, an MCSLock, alone on its
+ * cache line: the thread spins on m_locked, which its predecessor clears.
+ * Free nodes are cached per thread, linked through m_next.
+ */
+struct alignas(64) MCSNode {
+    std::atomic<MCSNode*> m_next;
+    std::atomic<uint32_t> m_locked;
+};
+
+DECAF_CLOSE_NAMESPACE
+
+/**
+ * The queue lock of Mellor-Crummey and Scott: threads waiting for the lock
+ * form a FIFO queue in which each spins on a flag of its own queue node,
+ * rather than on the lock, and the holder hands the lock over by clearing the
+ * flag of its successor. A release therefore touches the cache line of one
+ * waiter only, so the cost of a hand-over stays flat however many threads
+ * wait, where a test-and-set or ticket lock has every waiter re-read the lock
+ * after every release.
+ *
+ * Unlike the textbook lock, whose callers supply the queue nodes, lock() and
+ * unlock() take no arguments: the nodes come from a cache of the calling
+ * thread and the lock remembers the node of its holder. As with TicketLock,
+ * a descheduled waiter holds up the threads queued behind it, waiters yield
+ * the processor after a short spin, and the timed tryLock() polls for the
+ * lock to be free without joining the queue. The lock is not reentrant,
+ * unlocking it without holding it is undefined, and it has no conditions.
+ *
+ * The class is final, so that lock() and unlock() through an MCSLock, e.g.
+ * in a LockGuard<MCSLock>, are not virtual calls and inline.
+ */
+class MCSLock final : public Lock {
+  public:
+    MCSLock() : m_tail(0), m_holder(0) { }
+    virtual ~MCSLock();
+    MCSLock(const MCSLock& other) = delete;
+    MCSLock& operator=(const MCSLock& rhs) = delete;
+
+    /**
+     * Acquires the lock once every thread queued for it earlier has released
+     * it.
+     */
+    virtual void lock() {
+        detail::MCSNode* node = acquireNode();
+        detail::MCSNode* predecessor = m_tail.exchange(node, std::memory_order_acq_rel);
+        if (predecessor != 0)
+            lockSlow(predecessor, node);
+        m_holder = node;
+    }
+
+    /**
+     * Releases the lock, which the calling thread must hold, to the next
+     * queued thread.
+     */
+    virtual void unlock() {
+        detail::MCSNode* node = m_holder;
+        detail::MCSNode* successor = node->m_next.load(std::memory_order_acquire);
+        if (successor == 0) {
+            detail::MCSNode* expected = node;
+            if (m_tail.compare_exchange_strong(expected, 0, std::memory_order_release,
+              std::memory_order_relaxed)) {
+                releaseNode(node);
+                return;
+            }
+            successor = awaitSuccessor(node);
+        }
+        successor->m_locked.store(0, std::memory_order_release);
+        releaseNode(node);
+    }
+
+    /**
+     * Acquires the lock only if it is free, and no thread waits for it, at
+     * the time of invocation.
+     *
+     * @return true if the lock was acquired, false otherwise
+     */
+    virtual bool tryLock() {
+        if (m_tail.load(std::memory_order_relaxed) != 0)
+            return false;
+
+        detail::MCSNode* node = acquireNode();
+        detail::MCSNode* expected = 0;
+        if (!m_tail.compare_exchange_strong(expected, node, std::memory_order_acquire,
+          std::memory_order_relaxed)) {
+            releaseNode(node);
+            return false;
+        }
+        m_holder = node;
+        return true;
+    }
+
+    /**
+     * Acquires the lock if it becomes free within the given waiting time.
+     *
+     * @param t the time to wait for the lock
+     * @param unit the time unit of the timeout argument
+     * @return true if the lock was acquired, false if the waiting time
+     * elapsed first
+     */
+    virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit);
+
+    /**
+     * Acquires the lock if it becomes free before the given deadline passes.
+     *
+     * @param deadline the time at which to give up waiting for the lock
+     * @return true if the lock was acquired, false if the deadline passed
+     * first
+     */
+    virtual bool tryLockUntil(const Deadline& deadline);
+
+    /**
+     * MCS locks have no conditions.
+     *
+     * @throws UnsupportedOperationException always
+     */
+    virtual Condition* newCondition();
+
+    /**
+     * Queries if any thread holds this lock, for monitoring rather than for
+     * synchronization.
+     */
+    bool isLocked() const {
+        return m_tail.load(std::memory_order_relaxed) != 0;
+    }
+
+  private:
+    /*
+     * Takes a node, ready to be queued, from the cache of the calling thread,
+     * or gives one back to it.
+     */
+    static detail::MCSNode* acquireNode() {
+        detail::MCSNode* node = t_freeNodes;
+        if (node == 0)
+            return allocateNode();
+        t_freeNodes = node->m_next.load(std::memory_order_relaxed);
+        node->m_next.store(0, std::memory_order_relaxed);
+        node->m_locked.store(1, std::memory_order_relaxed);
+        return node;
+    }
+
+    static void releaseNode(detail::MCSNode* node) {
+        node->m_next.store(t_freeNodes, std::memory_order_relaxed);
+        t_freeNodes = node;
+    }
+
+    static detail::MCSNode* allocateNode();
+
+    /*
+     * Links @a node behind @a predecessor and waits for the lock to be
+     * handed over.
+     */
+    void lockSlow(detail::MCSNode* predecessor, detail::MCSNode* node);
+
+    /*
+     * Waits for the thread that queued behind @a node to link itself.
+     */
+    static detail::MCSNode* awaitSuccessor(detail::MCSNode* node);
+
+    class NodeCacheReleaser;
+
+    static DECAF_THREAD_LOCAL detail::MCSNode* t_freeNodes DECAF_INITIAL_EXEC_TLS;
+
+    /*
+     * The last node of the queue, 0 when the lock is free, and the node of
+     * the holder, which only the holder accesses.
+     */
+    std::atomic<detail::MCSNode*> m_tail;
+    detail::MCSNode* m_holder;
+};
+
+DECAF_CLOSE_NAMESPACE4
+
+#endif	/* DECAF_MCSLOCK_HPP */
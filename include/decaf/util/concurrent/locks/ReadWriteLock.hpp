@@ -20,6 +20,7 @@
 
 #include "decaf/lang/compatibility.hpp"
 #include "decaf/lang/Object.hpp"
+#include "decaf/util/concurrent/locks/Lock.hpp"
 
 
 DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
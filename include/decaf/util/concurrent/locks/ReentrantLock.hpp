@@ -18,14 +18,42 @@
 #ifndef DECAF_REENTRANTLOCK_HPP
 #define	DECAF_REENTRANTLOCK_HPP
 
-#include <pthread.h>
-#include <map>
+#include <atomic>
+#include <cstdint>
+#include <ctime>
 
 #include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/lang/ThreadRecord.hpp"
 #include "decaf/util/concurrent/locks/Lock.hpp"
 
 DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
 
+class ConditionObject;
+
+DECAF_OPEN_NAMESPACE(detail)
+
+struct ConditionWaiter;
+
+/**
+ * @internal
+ * A thread queued for a fair ReentrantLock, on its own stack.
+ */
+struct LockWaiter {
+    explicit LockWaiter(uint32_t thread) : m_wakeup(0), m_thread(thread), m_next(0) { }
+
+    /*
+     * The futex the thread sleeps on; set to 1 once the lock has been handed
+     * over to it.
+     */
+    std::atomic<uint32_t> m_wakeup;
+    uint32_t m_thread;
+    LockWaiter* m_next;
+};
+
+DECAF_CLOSE_NAMESPACE
+
 /**
  * A reentrant mutual exclusion Lock with the same basic behavior and semantics
  * as the implicit monitor lock accessed using synchronized statements, but with
@@ -35,10 +63,28 @@ DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
  * unlocking it. A thread invoking lock will return, successfully acquiring the
  * lock, when the lock is not owned by another thread. The method will return
  * immediately if the current thread already owns the lock.
+ *
+ * The constructor accepts an optional fairness parameter. By default the lock
+ * makes no ordering guarantee: a thread calling lock() may take it ahead of
+ * threads that have been waiting for it, which gives the best throughput but
+ * can starve some of them. A fair lock queues the threads waiting for it and
+ * hands it over, on release, to the one that has waited longest. The untimed
+ * tryLock() does not honor fairness: it takes the lock whenever it is free.
+ *
+ * The lock is a single futex word: taking and releasing a free lock costs one
+ * atomic operation each. A thread that finds the lock taken spins for a while,
+ * with exponential backoff, before it sleeps in the kernel; the spin budget
+ * adapts to how often spinning pays off on this lock.
  */
 class ReentrantLock : public Lock {
   public:
-    ReentrantLock();
+    /**
+     * Creates a lock with the given fairness policy.
+     *
+     * @param fair true if the lock should be granted to waiting threads in
+     * FIFO order
+     */
+    explicit ReentrantLock(bool fair = false);
     virtual ~ReentrantLock();
     ReentrantLock(const ReentrantLock& other) = delete;
     ReentrantLock& operator=(const ReentrantLock& rhs) = delete;   
@@ -57,6 +103,14 @@ class ReentrantLock : public Lock {
     
     /**
      * Attempts to release this lock.
+     *
+     * If the current thread is the holder of this lock then the hold count is
+     * decremented. If the hold count is now zero then the lock is released,
+     * and one of the threads signalled on a Condition of this lock, if any,
+     * is woken up to re-acquire it.
+     *
+     * @throws IllegalMonitorStateException if the current thread does not
+     * hold this lock
      */
     virtual void unlock();
     
@@ -105,12 +159,151 @@ class ReentrantLock : public Lock {
      * elapsed before the lock could be acquired
      */
     virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit);
+
+    /**
+     * Acquires the lock if it is not held by another thread before the given
+     * deadline passes, with the same semantics as the timed tryLock().
+     *
+     * @param deadline the time at which to give up waiting for the lock
+     * @return true if the lock was acquired or was already held by the
+     * current thread, false if the deadline passed first
+     */
+    virtual bool tryLockUntil(const Deadline& deadline);
     
-    virtual Condition* newCondition() { return 0; }
+    /**
+     * Returns a Condition instance for use with this Lock instance. The
+     * returned ConditionObject behaves like the monitor methods wait(),
+     * notify() and notifyAll() do with synchronized: waiters are queued in
+     * FIFO order, and signalled waiters are moved onto this lock, each to be
+     * woken by a release of it, rather than woken at once to fight for it.
+     *
+     * @return a new Condition, which the caller must delete
+     */
+    virtual Condition* newCondition();
+
+    /**
+     * @return true if this lock has fairness set true
+     */
+    bool isFair() const {
+        return m_fair;
+    }
+
+    /**
+     * Queries if this lock is held by the current thread.
+     *
+     * @return true if the current thread holds this lock
+     */
+    bool isHeldByCurrentThread() const {
+        return m_owner.load(std::memory_order_relaxed) == lang::detail::ThreadRecord::current().id();
+    }
+
+    /**
+     * Queries the number of holds on this lock by the current thread.
+     *
+     * @return the number of holds on this lock by the current thread, or zero
+     * if it is not held by the current thread
+     */
+    uint32_t getHoldCount() const;
+
+    /**
+     * Returns an estimate of the number of threads waiting to acquire this
+     * lock, in lock() or in a timed tryLock(). The value may change while it
+     * is being returned, so it is meant for monitoring, such as shedding load
+     * when the queue grows, rather than for synchronization.
+     *
+     * @return the estimated number of threads waiting for this lock
+     */
+    uint32_t getQueueLength() const {
+        return m_queueLength.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Queries whether any threads are waiting to acquire this lock. As with
+     * getQueueLength(), the answer is only an estimate.
+     *
+     * @return true if there may be other threads waiting to acquire the lock
+     */
+    bool hasQueuedThreads() const {
+        return getQueueLength() != 0;
+    }
 
   private:
-    pthread_mutex_t m_mutex;
-    pthread_mutexattr_t m_mutexAttr;
+    /*
+     * Takes the lock, which the calling thread does not own, and records it
+     * as owned @a holds times.
+     */
+    void acquire(uint32_t holds);
+
+    /*
+     * The fair counterpart of acquire(), which only returns false if the
+     * absolute CLOCK_MONOTONIC time deadline, unless null, passes first.
+     */
+    bool acquireFair(uint32_t holds, const struct timespec* deadline);
+
+    /*
+     * Releases every hold the calling thread, which owns the lock, has on it
+     * and returns how many there were.
+     */
+    uint32_t release();
+
+    /*
+     * Appends the signalled waiters first..last, already linked together, to
+     * the transferred list, or removes one that timed out from it.
+     */
+    void transfer(detail::ConditionWaiter* first, detail::ConditionWaiter* last);
+    void untransfer(detail::ConditionWaiter* waiter);
+
+    /*
+     * Locks and unlocks the futex word: 0 when free, 1 when taken, 2 when
+     * taken and threads may sleep on it. lockState() gives up, returning
+     * false, once the absolute CLOCK_MONOTONIC time deadline, unless null,
+     * has passed.
+     */
+    bool tryLockState() {
+        uint32_t state = 0;
+        return m_state.compare_exchange_strong(state, 1, std::memory_order_acquire);
+    }
+
+    bool lockState(const struct timespec* deadline);
+
+    void unlockState() {
+        if (m_state.exchange(0, std::memory_order_release) == 2)
+            lang::detail::futexWake(m_state, 1);
+    }
+
+    /*
+     * The futex word of the lock itself, unless the lock is fair, in which
+     * case it only guards the queue of waiting threads and the hand-over of
+     * the lock.
+     */
+    std::atomic<uint32_t> m_state;
+    lang::detail::AdaptiveSpin m_spin;
+    const bool m_fair;
+
+    /*
+     * The ThreadRecord identifier of the owner, 0 when the lock is free, and
+     * the number of times it acquired the lock. The hold count is only
+     * accessed by the owner.
+     */
+    std::atomic<uint32_t> m_owner;
+    uint32_t m_holdCount;
+
+    /*
+     * The number of threads blocked acquiring the lock and, if the lock is
+     * fair, the threads themselves in FIFO order, guarded by the state.
+     */
+    std::atomic<uint32_t> m_queueLength;
+    detail::LockWaiter* m_queueHead;
+    detail::LockWaiter* m_queueTail;
+
+    /*
+     * Threads signalled on a condition of this lock, in FIFO order. Guarded
+     * by the lock; every release wakes the first of them.
+     */
+    detail::ConditionWaiter* m_transferredHead;
+    detail::ConditionWaiter* m_transferredTail;
+
+    friend class ConditionObject;
 };
 
 DECAF_CLOSE_NAMESPACE4
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_REENTRANTREADWRITELOCK_HPP
+#define	DECAF_REENTRANTREADWRITELOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <pthread.h>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/util/concurrent/locks/Lock.hpp"
+#include "decaf/util/concurrent/locks/ReadWriteLock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+/**
+ * A ReadWriteLock built for read-mostly data: any number of threads may hold
+ * the read lock at once, and readers do not write to any cache line shared
+ * with the other readers.
+ *
+ * The lock follows BRAVO (Biased Locking for Reader-Writer Locks, Dice and
+ * Kogan). While the lock is biased towards readers, a reader announces itself
+ * in a process-wide table of visible readers, in a slot picked by hashing its
+ * thread and the lock, and leaves the shared state of the lock alone. A writer
+ * revokes the bias and waits for the table to drain of the readers of the
+ * lock. Readers that find the bias revoked, or their slot taken, fall back on
+ * a central count. As revocation is expensive, the bias is only restored once
+ * readers have run without it for a multiple of the time the last revocation
+ * took, which bounds the overhead for write-heavy locks.
+ *
+ * Both locks are reentrant. The write lock favors writers: once a writer
+ * waits, threads not holding the lock yet queue behind it. The thread holding
+ * the write lock may take the read lock too, and keep it after releasing the
+ * write lock (downgrading); a thread holding only the read lock must not try
+ * to take the write lock, which would deadlock.
+ *
+ * Neither lock supports conditions: newCondition() throws
+ * UnsupportedOperationException.
+ */
+class ReentrantReadWriteLock : public ReadWriteLock {
+  public:
+    /**
+     * The lock returned by ReentrantReadWriteLock::readLock().
+     */
+    class ReadLock : public Lock {
+      public:
+        virtual ~ReadLock() { }
+        ReadLock(const ReadLock& other) = delete;
+        ReadLock& operator=(const ReadLock& rhs) = delete;
+
+        /**
+         * Acquires the read lock, waiting while another thread holds the write
+         * lock or, unless the current thread already holds the read lock, a
+         * writer is waiting for it.
+         */
+        virtual void lock();
+
+        /**
+         * Releases one hold of the read lock.
+         *
+         * @throws IllegalMonitorStateException if the current thread does not
+         * hold the read lock
+         */
+        virtual void unlock();
+
+        /**
+         * Acquires the read lock if the write lock is not held by another
+         * thread, even if writers are waiting for it.
+         */
+        virtual bool tryLock();
+
+        virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit);
+
+        virtual bool tryLockUntil(const Deadline& deadline);
+
+        /**
+         * @throws UnsupportedOperationException always
+         */
+        virtual Condition* newCondition();
+
+      private:
+        explicit ReadLock(ReentrantReadWriteLock& lock) : m_lock(lock) { }
+
+        ReentrantReadWriteLock& m_lock;
+
+        friend class ReentrantReadWriteLock;
+    };
+
+    /**
+     * The lock returned by ReentrantReadWriteLock::writeLock().
+     */
+    class WriteLock : public Lock {
+      public:
+        virtual ~WriteLock() { }
+        WriteLock(const WriteLock& other) = delete;
+        WriteLock& operator=(const WriteLock& rhs) = delete;
+
+        /**
+         * Acquires the write lock, waiting until no other thread holds either
+         * lock.
+         */
+        virtual void lock();
+
+        /**
+         * Releases one hold of the write lock.
+         *
+         * @throws IllegalMonitorStateException if the current thread does not
+         * hold the write lock
+         */
+        virtual void unlock();
+
+        virtual bool tryLock();
+
+        virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit);
+
+        virtual bool tryLockUntil(const Deadline& deadline);
+
+        /**
+         * @throws UnsupportedOperationException always
+         */
+        virtual Condition* newCondition();
+
+        /**
+         * @return true if the current thread holds the write lock
+         */
+        bool isHeldByCurrentThread() const {
+            return m_lock.isWriteLockedByCurrentThread();
+        }
+
+        /**
+         * @return the number of holds on the write lock by the current thread
+         */
+        uint32_t getHoldCount() const {
+            return m_lock.getWriteHoldCount();
+        }
+
+      private:
+        explicit WriteLock(ReentrantReadWriteLock& lock) : m_lock(lock) { }
+
+        ReentrantReadWriteLock& m_lock;
+
+        friend class ReentrantReadWriteLock;
+    };
+
+    ReentrantReadWriteLock();
+    virtual ~ReentrantReadWriteLock();
+    ReentrantReadWriteLock(const ReentrantReadWriteLock& other) = delete;
+    ReentrantReadWriteLock& operator=(const ReentrantReadWriteLock& rhs) = delete;
+
+    virtual ReadLock* readLock() {
+        return &m_readLock;
+    }
+
+    virtual WriteLock* writeLock() {
+        return &m_writeLock;
+    }
+
+    /**
+     * @return true if any thread holds the write lock
+     */
+    bool isWriteLocked() const {
+        return m_writer.load(std::memory_order_relaxed) != 0;
+    }
+
+    /**
+     * @return true if the current thread holds the write lock
+     */
+    bool isWriteLockedByCurrentThread() const;
+
+    /**
+     * @return the number of holds on the write lock by the current thread, or
+     * zero if it does not hold it
+     */
+    uint32_t getWriteHoldCount() const;
+
+    /**
+     * @return the number of holds on the read lock by the current thread
+     */
+    uint32_t getReadHoldCount() const;
+
+    /**
+     * Returns an estimate of the number of threads holding the read lock,
+     * meant for monitoring: it scans the whole table of visible readers.
+     *
+     * @return the number of threads holding the read lock, where reentrant
+     * holds of a thread count once
+     */
+    uint32_t getReadLockCount() const;
+
+    /**
+     * Returns an estimate of the number of threads waiting to acquire either
+     * lock, meant for monitoring rather than for synchronization.
+     *
+     * @return the estimated number of threads waiting for this lock
+     */
+    uint32_t getQueueLength() const {
+        return m_waitingReaders.load(std::memory_order_relaxed) + m_waitingWriters.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return true if there may be threads waiting to acquire either lock
+     */
+    bool hasQueuedThreads() const {
+        return getQueueLength() != 0;
+    }
+
+  private:
+    /*
+     * Acquires the read lock for the thread self, which does not hold it yet,
+     * until the absolute CLOCK_MONOTONIC time deadline, unless null, or
+     * without waiting at all if tryOnly. Sets slot to the visible slot the
+     * thread took, or to NO_SLOT if it was counted centrally.
+     */
+    bool acquireRead(uint32_t self, const struct timespec* deadline, bool tryOnly, uint32_t& slot);
+    void releaseRead(uint32_t slot);
+
+    /*
+     * Acquires the write lock for a thread that does not hold it yet, likewise.
+     */
+    bool acquireWrite(const struct timespec* deadline, bool tryOnly);
+    void releaseWrite();
+
+    /*
+     * Registers the thread self as a visible reader, if the lock is biased
+     * and its slot is free, and returns the slot; returns NO_SLOT otherwise.
+     */
+    uint32_t enterVisible(uint32_t self);
+
+    /*
+     * Frees a slot taken by enterVisible(), and wakes the writer if it waits
+     * for the readers to leave.
+     */
+    void leaveVisible(uint32_t slot);
+
+    /*
+     * Waits until no visible reader of this lock is left in the table, or the
+     * deadline passes, or, if tryOnly, returns false at once if there is one.
+     * Past a short spin, the writer sleeps until a reader leaves.
+     */
+    bool revokeBias(const struct timespec* deadline, bool tryOnly);
+
+    /*
+     * Sleeps on the futex wakeup, counted in waiting, with the mutex released.
+     * Returns false if the deadline passed.
+     */
+    bool waitLocked(std::atomic<uint32_t>& wakeup, std::atomic<uint32_t>& waiting,
+      const struct timespec* deadline);
+
+    /*
+     * With the mutex held, picks the threads to wake now that the lock may
+     * have become available, a writer rather than readers, and bumps their
+     * futex; the caller wakes them with wake() once it dropped the mutex.
+     */
+    std::atomic<uint32_t>* nextWakeupLocked();
+    void wake(std::atomic<uint32_t>* wakeup);
+
+    /*
+     * Guards the central state: the writer, the readers without a visible
+     * slot and the waiting threads.
+     */
+    pthread_mutex_t m_mutex;
+
+    /*
+     * Whether readers may register in the table of visible readers, and the
+     * CLOCK_MONOTONIC time, in nanoseconds, before which a revoked bias is not
+     * restored.
+     */
+    std::atomic<bool> m_readBias;
+    std::atomic<uint64_t> m_inhibitUntil;
+
+    /*
+     * The ThreadRecord identifier of the writer, 0 if none, and the number of
+     * its holds; the hold count is only accessed by the writer.
+     */
+    std::atomic<uint32_t> m_writer;
+    uint32_t m_writeHolds;
+
+    /*
+     * The number of threads holding the read lock outside of the table.
+     */
+    uint32_t m_sharedReaders;
+
+    /*
+     * The waiting threads and the futex sequences they sleep on.
+     */
+    std::atomic<uint32_t> m_waitingReaders;
+    std::atomic<uint32_t> m_waitingWriters;
+    std::atomic<uint32_t> m_readersWakeup;
+    std::atomic<uint32_t> m_writersWakeup;
+
+    /*
+     * Set while the writer sleeps in revokeBias(), in which case visible
+     * readers bump the futex sequence as they leave, and wake it.
+     */
+    std::atomic<bool> m_revoking;
+    std::atomic<uint32_t> m_revocationWakeup;
+
+    ReadLock m_readLock;
+    WriteLock m_writeLock;
+};
+
+DECAF_CLOSE_NAMESPACE4
+
+#endif	/* DECAF_REENTRANTREADWRITELOCK_HPP */
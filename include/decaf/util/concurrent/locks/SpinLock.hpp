@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_SPINLOCK_HPP
+#define	DECAF_SPINLOCK_HPP
+
+#include <atomic>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/util/concurrent/locks/Lock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+/**
+ * A test-and-test-and-set spin lock: one byte, taken with a single atomic
+ * exchange and released with a plain store. Waiting threads spin on reads of
+ * the lock, which stay in their own caches until the release, and only try
+ * the exchange once they see it free; after a short spin with exponential
+ * backoff they yield the processor instead.
+ *
+ * Spin locks suit critical sections of a few dozen instructions under little
+ * contention. The lock is unfair, and it is not reentrant: a thread locking
+ * it twice deadlocks. Unlocking it without holding it is undefined. It has no
+ * conditions.
+ *
+ * The class is final, so that lock() and unlock() through a SpinLock, e.g.
+ * in a LockGuard<SpinLock>, are not virtual calls and inline.
+ */
+class SpinLock final : public Lock {
+  public:
+    SpinLock() : m_locked(false) { }
+    virtual ~SpinLock();
+    SpinLock(const SpinLock& other) = delete;
+    SpinLock& operator=(const SpinLock& rhs) = delete;
+
+    /**
+     * Acquires the lock, spinning, and then yielding, while another thread
+     * holds it.
+     */
+    virtual void lock() {
+        if (m_locked.exchange(true, std::memory_order_acquire))
+            lockSlow();
+    }
+
+    /**
+     * Releases the lock, which the calling thread must hold.
+     */
+    virtual void unlock() {
+        m_locked.store(false, std::memory_order_release);
+    }
+
+    /**
+     * Acquires the lock only if it is free at the time of invocation.
+     *
+     * @return true if the lock was acquired, false otherwise
+     */
+    virtual bool tryLock() {
+        return !m_locked.load(std::memory_order_relaxed) && !m_locked.exchange(true, std::memory_order_acquire);
+    }
+
+    /**
+     * Acquires the lock if it becomes free within the given waiting time.
+     *
+     * @param t the time to wait for the lock
+     * @param unit the time unit of the timeout argument
+     * @return true if the lock was acquired, false if the waiting time
+     * elapsed first
+     */
+    virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit);
+
+    /**
+     * Acquires the lock if it becomes free before the given deadline passes.
+     *
+     * @param deadline the time at which to give up waiting for the lock
+     * @return true if the lock was acquired, false if the deadline passed
+     * first
+     */
+    virtual bool tryLockUntil(const Deadline& deadline);
+
+    /**
+     * Spin locks have no conditions.
+     *
+     * @throws UnsupportedOperationException always
+     */
+    virtual Condition* newCondition();
+
+    /**
+     * Queries if any thread holds this lock, for monitoring rather than for
+     * synchronization.
+     */
+    bool isLocked() const {
+        return m_locked.load(std::memory_order_relaxed);
+    }
+
+  private:
+    void lockSlow();
+
+    std::atomic<bool> m_locked;
+};
+
+DECAF_CLOSE_NAMESPACE4
+
+#endif	/* DECAF_SPINLOCK_HPP */
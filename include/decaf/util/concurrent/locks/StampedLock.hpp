@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_STAMPEDLOCK_HPP
+#define	DECAF_STAMPEDLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/util/concurrent/locks/Lock.hpp"
+#include "decaf/util/concurrent/locks/ReadWriteLock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+/**
+ * A capability-based lock with three modes for controlling read/write access.
+ * The state of a StampedLock consists of a version and a mode. Lock
+ * acquisition methods return a stamp that represents and controls access with
+ * respect to a lock state; "try" versions of these methods may instead return
+ * the special value zero to represent failure. Lock release and conversion
+ * methods require stamps as arguments, and fail if they do not match the state
+ * of the lock. The three modes are:
+ *
+ *   - Writing. writeLock() possibly blocks waiting for exclusive access,
+ *     returning a stamp that can be used in unlockWrite() to release the lock.
+ *   - Reading. readLock() possibly blocks waiting for non-exclusive access,
+ *     returning a stamp that can be used in unlockRead() to release the lock.
+ *   - Optimistic reading. tryOptimisticRead() returns a non-zero stamp only if
+ *     the lock is not currently held in write mode, and validate() returns
+ *     true if the lock has not been acquired in write mode since. Neither
+ *     writes to shared memory, so optimistic readers of a small, rarely
+ *     written structure do not slow each other down at all.
+ *
+ * As optimistic reads run concurrently with writers, the fields they read
+ * must be std::atomic, loaded with std::memory_order_relaxed, and copied into
+ * locals that are only used once validate() succeeded:
+ *
+ * @code{.cpp}
+ *    uint64_t stamp = lock.tryOptimisticRead();
+ *    double x = m_x.load(std::memory_order_relaxed);
+ *    double y = m_y.load(std::memory_order_relaxed);
+ *    if (!lock.validate(stamp)) {
+ *        stamp = lock.readLock();
+ *        x = m_x.load(std::memory_order_relaxed);
+ *        y = m_y.load(std::memory_order_relaxed);
+ *        lock.unlockRead(stamp);
+ *    }
+ *    return std::sqrt(x * x + y * y);
+ * @endcode
+ *
+ * The tryConvertTo...() methods upgrade or downgrade a stamp between modes
+ * when that can be done atomically.
+ *
+ * StampedLocks are not reentrant and have no notion of ownership: a lock
+ * acquired in one thread can be released or converted in another. A waiting
+ * writer holds back new readers, so that writers are not starved. Blocked
+ * threads first spin adaptively, then sleep on a futex.
+ *
+ * asReadLock(), asWriteLock() and asReadWriteLock() return views implementing
+ * the Lock interfaces, which do not support conditions.
+ */
+class StampedLock : public Object {
+  public:
+    StampedLock();
+    virtual ~StampedLock();
+    StampedLock(const StampedLock& other) = delete;
+    StampedLock& operator=(const StampedLock& rhs) = delete;
+
+    /**
+     * Exclusively acquires the lock, blocking if necessary until available.
+     *
+     * @return a write stamp that can be used to unlock or convert mode
+     */
+    uint64_t writeLock();
+
+    /**
+     * Exclusively acquires the lock if it is immediately available.
+     *
+     * @return a write stamp that can be used to unlock or convert mode, or
+     * zero if the lock is not available
+     */
+    uint64_t tryWriteLock();
+
+    /**
+     * Exclusively acquires the lock if it is available within the given time.
+     *
+     * @return a write stamp that can be used to unlock or convert mode, or
+     * zero if the lock is not available
+     */
+    uint64_t tryWriteLock(const uint64_t& t, const TimeUnit* timeUnit);
+
+    /**
+     * Exclusively acquires the lock if it is available before the given
+     * deadline passes.
+     *
+     * @return a write stamp that can be used to unlock or convert mode, or
+     * zero if the lock is not available
+     */
+    uint64_t tryWriteLockUntil(const Deadline& deadline);
+
+    /**
+     * Non-exclusively acquires the lock, blocking if necessary until
+     * available.
+     *
+     * @return a read stamp that can be used to unlock or convert mode
+     */
+    uint64_t readLock();
+
+    /**
+     * Non-exclusively acquires the lock if it is immediately available.
+     *
+     * @return a read stamp that can be used to unlock or convert mode, or
+     * zero if the lock is not available
+     */
+    uint64_t tryReadLock();
+
+    /**
+     * Non-exclusively acquires the lock if it is available within the given
+     * time.
+     *
+     * @return a read stamp that can be used to unlock or convert mode, or
+     * zero if the lock is not available
+     */
+    uint64_t tryReadLock(const uint64_t& t, const TimeUnit* timeUnit);
+
+    /**
+     * Non-exclusively acquires the lock if it is available before the given
+     * deadline passes.
+     *
+     * @return a read stamp that can be used to unlock or convert mode, or
+     * zero if the lock is not available
+     */
+    uint64_t tryReadLockUntil(const Deadline& deadline);
+
+    /**
+     * Returns a stamp that can later be validated, or zero if exclusively
+     * locked.
+     *
+     * @return a valid optimistic read stamp, or zero if exclusively locked
+     */
+    uint64_t tryOptimisticRead() const {
+        const uint64_t state = m_state.load(std::memory_order_acquire);
+        return ((state & WBIT) == 0) ? (state & SBITS) : 0;
+    }
+
+    /**
+     * Returns true if the lock has not been exclusively acquired since
+     * issuance of the given stamp. Always returns false if the stamp is zero.
+     * Always returns true if the stamp represents a currently held lock.
+     *
+     * @param stamp a stamp
+     * @return true if the lock has not been exclusively acquired since
+     * issuance of the given stamp; else false
+     */
+    bool validate(uint64_t stamp) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return (stamp & SBITS) == (m_state.load(std::memory_order_relaxed) & SBITS);
+    }
+
+    /**
+     * If the lock state matches the given stamp, releases the exclusive lock.
+     *
+     * @throws IllegalMonitorStateException if the stamp does not match the
+     * current state of this lock
+     */
+    void unlockWrite(uint64_t stamp);
+
+    /**
+     * If the lock state matches the given stamp, releases the non-exclusive
+     * lock.
+     *
+     * @throws IllegalMonitorStateException if the stamp does not match the
+     * current state of this lock
+     */
+    void unlockRead(uint64_t stamp);
+
+    /**
+     * If the lock state matches the given stamp, releases the corresponding
+     * mode of the lock.
+     *
+     * @throws IllegalMonitorStateException if the stamp does not match the
+     * current state of this lock
+     */
+    void unlock(uint64_t stamp);
+
+    /**
+     * If the lock state matches the given stamp, atomically performs one of
+     * the following actions. If the stamp represents holding a write lock,
+     * returns it. Or, if a read lock, if the write lock is available and this
+     * is the only read hold, releases the read lock and returns a write stamp.
+     * Or, if an optimistic read, returns a write stamp only if immediately
+     * available. This method returns zero in all other cases.
+     *
+     * @return a valid write stamp, or zero on failure
+     */
+    uint64_t tryConvertToWriteLock(uint64_t stamp);
+
+    /**
+     * If the lock state matches the given stamp, atomically performs one of
+     * the following actions. If the stamp represents holding a write lock,
+     * releases it and obtains a read lock. Or, if a read lock, returns it. Or,
+     * if an optimistic read, acquires a read lock and returns a read stamp
+     * only if immediately available. This method returns zero in all other
+     * cases.
+     *
+     * @return a valid read stamp, or zero on failure
+     */
+    uint64_t tryConvertToReadLock(uint64_t stamp);
+
+    /**
+     * If the lock state matches the given stamp then, atomically, if the
+     * stamp represents holding a lock, releases it and returns an
+     * observation stamp. Or, if an optimistic read, returns it if validated.
+     * This method returns zero in all other cases.
+     *
+     * @return a valid optimistic read stamp, or zero on failure
+     */
+    uint64_t tryConvertToOptimisticRead(uint64_t stamp);
+
+    /**
+     * Releases the write lock if it is held, without requiring a stamp value.
+     *
+     * @return true if the lock was held, else false
+     */
+    bool tryUnlockWrite();
+
+    /**
+     * Releases one hold of the read lock if it is held, without requiring a
+     * stamp value.
+     *
+     * @return true if the read lock was held, else false
+     */
+    bool tryUnlockRead();
+
+    /**
+     * @return true if the lock is currently held exclusively
+     */
+    bool isWriteLocked() const {
+        return (m_state.load(std::memory_order_relaxed) & WBIT) != 0;
+    }
+
+    /**
+     * @return true if the lock is currently held non-exclusively
+     */
+    bool isReadLocked() const {
+        return (m_state.load(std::memory_order_relaxed) & RBITS) != 0;
+    }
+
+    /**
+     * @return the number of read holds on this lock
+     */
+    uint32_t getReadLockCount() const {
+        return static_cast<uint32_t> (m_state.load(std::memory_order_relaxed) & RBITS);
+    }
+
+    /**
+     * Tells whether a stamp represents holding the lock exclusively.
+     */
+    static bool isWriteLockStamp(uint64_t stamp) {
+        return (stamp & WBIT) != 0;
+    }
+
+    /**
+     * Tells whether a stamp represents holding the lock non-exclusively.
+     */
+    static bool isReadLockStamp(uint64_t stamp) {
+        return (stamp & RBITS) != 0;
+    }
+
+    /**
+     * Tells whether a stamp represents a successful optimistic read.
+     */
+    static bool isOptimisticReadStamp(uint64_t stamp) {
+        return stamp != 0 && (stamp & (WBIT | RBITS)) == 0;
+    }
+
+    /**
+     * Returns a Lock view of this StampedLock in which lock() is mapped to
+     * readLock() and unlock() to tryUnlockRead().
+     */
+    Lock* asReadLock() {
+        return &m_readLockView;
+    }
+
+    /**
+     * Returns a Lock view of this StampedLock in which lock() is mapped to
+     * writeLock() and unlock() to tryUnlockWrite().
+     */
+    Lock* asWriteLock() {
+        return &m_writeLockView;
+    }
+
+    /**
+     * Returns a ReadWriteLock view of this StampedLock, whose locks are the
+     * views of asReadLock() and asWriteLock().
+     */
+    ReadWriteLock* asReadWriteLock() {
+        return &m_readWriteLockView;
+    }
+
+  private:
+    class ReadLockView : public Lock {
+      public:
+        explicit ReadLockView(StampedLock& lock) : m_lock(lock) { }
+
+        virtual void lock();
+        virtual void unlock();
+        virtual bool tryLock();
+        virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit);
+        virtual bool tryLockUntil(const Deadline& deadline);
+        virtual Condition* newCondition();
+
+      private:
+        StampedLock& m_lock;
+    };
+
+    class WriteLockView : public Lock {
+      public:
+        explicit WriteLockView(StampedLock& lock) : m_lock(lock) { }
+
+        virtual void lock();
+        virtual void unlock();
+        virtual bool tryLock();
+        virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit);
+        virtual bool tryLockUntil(const Deadline& deadline);
+        virtual Condition* newCondition();
+
+      private:
+        StampedLock& m_lock;
+    };
+
+    class ReadWriteLockView : public ReadWriteLock {
+      public:
+        explicit ReadWriteLockView(StampedLock& lock) : m_lock(lock) { }
+
+        virtual Lock* readLock() {
+            return m_lock.asReadLock();
+        }
+
+        virtual Lock* writeLock() {
+            return m_lock.asWriteLock();
+        }
+
+      private:
+        StampedLock& m_lock;
+    };
+
+    /*
+     * The state: the number of read holds in the low RBITS, then WWAIT, set
+     * while a writer waits, then WBIT, set while write locked, and above it
+     * the version, which every write release increments. Stamps are states
+     * without WWAIT, and the version starts at ORIGIN so that no valid stamp
+     * is zero.
+     */
+    static const uint64_t RBITS = 0x7fff;
+    static const uint64_t RFULL = RBITS - 1;
+    static const uint64_t WWAIT = RBITS + 1;
+    static const uint64_t WBIT = WWAIT << 1;
+    static const uint64_t SBITS = ~(RBITS | WWAIT);
+    static const uint64_t ORIGIN = WBIT << 1;
+
+    /*
+     * Attempts to take the lock in the given mode, once; returns the stamp
+     * or zero.
+     */
+    uint64_t tryAcquireWrite();
+    uint64_t tryAcquireRead();
+
+    /*
+     * Spins, then sleeps until the lock is taken in the given mode or the
+     * absolute CLOCK_MONOTONIC time deadline, unless null, passes.
+     */
+    uint64_t acquire(bool write, const struct timespec* deadline);
+
+    /*
+     * Wakes every sleeping thread after a release, if any, to try again.
+     */
+    void signalWaiters();
+
+    std::atomic<uint64_t> m_state;
+
+    /*
+     * The number of threads about to sleep or sleeping, and the futex they
+     * sleep on, which every release that finds waiters increments.
+     */
+    std::atomic<uint32_t> m_waiters;
+    std::atomic<uint32_t> m_wakeup;
+
+    lang::detail::AdaptiveSpin m_spin;
+
+    ReadLockView m_readLockView;
+    WriteLockView m_writeLockView;
+    ReadWriteLockView m_readWriteLockView;
+};
+
+DECAF_CLOSE_NAMESPACE4
+
+#endif	/* DECAF_STAMPEDLOCK_HPP */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_TICKETLOCK_HPP
+#define	DECAF_TICKETLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/util/concurrent/locks/Lock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+/**
+ * A ticket spin lock: lock() draws the next ticket and waits for the lock to
+ * serve it, so threads acquire the lock in FIFO order and none starves.
+ * Waiters back off in proportion to the number of threads ahead of them.
+ *
+ * The fairness has a price under preemption: once the thread whose turn it
+ * is gets descheduled, every thread behind it waits too, which is why
+ * waiters yield the processor after a short spin. The timed tryLock() does
+ * not draw a ticket, which it could not give back, but polls for the lock to
+ * be free, so it may be overtaken. The lock is not reentrant, unlocking it
+ * without holding it is undefined, and it has no conditions.
+ *
+ * The class is final, so that lock() and unlock() through a TicketLock, e.g.
+ * in a LockGuard<TicketLock>, are not virtual calls and inline.
+ */
+class TicketLock final : public Lock {
+  public:
+    TicketLock() : m_next(0), m_serving(0) { }
+    virtual ~TicketLock();
+    TicketLock(const TicketLock& other) = delete;
+    TicketLock& operator=(const TicketLock& rhs) = delete;
+
+    /**
+     * Acquires the lock once every thread that asked for it earlier has
+     * released it.
+     */
+    virtual void lock() {
+        const uint32_t ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+        if (m_serving.load(std::memory_order_acquire) != ticket)
+            lockSlow(ticket);
+    }
+
+    /**
+     * Releases the lock, which the calling thread must hold, to the thread
+     * holding the next ticket.
+     */
+    virtual void unlock() {
+        // Only the holder writes m_serving.
+        m_serving.store(m_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * Acquires the lock only if it is free, and no thread waits for it, at
+     * the time of invocation.
+     *
+     * @return true if the lock was acquired, false otherwise
+     */
+    virtual bool tryLock() {
+        uint32_t serving = m_serving.load(std::memory_order_acquire);
+        return m_next.compare_exchange_strong(serving, serving + 1, std::memory_order_acquire);
+    }
+
+    /**
+     * Acquires the lock if it becomes free within the given waiting time.
+     *
+     * @param t the time to wait for the lock
+     * @param unit the time unit of the timeout argument
+     * @return true if the lock was acquired, false if the waiting time
+     * elapsed first
+     */
+    virtual bool tryLock(const uint64_t& t, const TimeUnit* timeUnit);
+
+    /**
+     * Acquires the lock if it becomes free before the given deadline passes.
+     *
+     * @param deadline the time at which to give up waiting for the lock
+     * @return true if the lock was acquired, false if the deadline passed
+     * first
+     */
+    virtual bool tryLockUntil(const Deadline& deadline);
+
+    /**
+     * Ticket locks have no conditions.
+     *
+     * @throws UnsupportedOperationException always
+     */
+    virtual Condition* newCondition();
+
+    /**
+     * Queries if any thread holds this lock, for monitoring rather than for
+     * synchronization.
+     */
+    bool isLocked() const {
+        return m_next.load(std::memory_order_relaxed) != m_serving.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Returns the number of threads waiting to acquire this lock, for
+     * monitoring rather than for synchronization.
+     */
+    uint32_t getQueueLength() const {
+        const uint32_t queued = m_next.load(std::memory_order_relaxed) - m_serving.load(std::memory_order_relaxed);
+        return (queued > 0) ? queued - 1 : 0;
+    }
+
+  private:
+    void lockSlow(uint32_t ticket);
+
+    /*
+     * The next ticket to hand out, and the ticket of the holder. The lock is
+     * free when they are equal; tickets wrap around.
+     */
+    std::atomic<uint32_t> m_next;
+    std::atomic<uint32_t> m_serving;
+};
+
+DECAF_CLOSE_NAMESPACE4
+
+#endif	/* DECAF_TICKETLOCK_HPP */
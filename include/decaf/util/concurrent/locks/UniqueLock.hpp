@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DECAF_UNIQUELOCK_HPP
+#define	DECAF_UNIQUELOCK_HPP
+
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#include "decaf/lang/compatibility.hpp"
+#include "decaf/lang/IllegalMonitorStateException.hpp"
+#include "decaf/lang/IllegalStateException.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+/**
+ * A movable owner of a lock, which, unlike LockGuard, may be constructed
+ * without locking, lock with a timeout, unlock and relock within its scope,
+ * and be handed over to another scope. The destructor unlocks the lock if the
+ * owner holds it.
+ *
+ * @code{.cpp}
+ *    UniqueLock<TicketLock> owner(lock, std::try_to_lock);
+ *    if (!owner)
+ *        return false;
+ *    // access the resource protected by the lock
+ * @endcode
+ *
+ * As with LockGuard, the lock is called through its static type L, so that
+ * the calls to a final lock type inline. L must have the methods of Lock
+ * that are used: lock(), unlock(), and the tryLock() variants.
+ */
+template<typename L>
+class UniqueLock {
+  public:
+    /**
+     * Creates an owner of no lock.
+     */
+    UniqueLock() : m_lock(0), m_owns(false) { }
+
+    /**
+     * Acquires @a lock.
+     */
+    explicit UniqueLock(L& lock) : m_lock(&lock), m_owns(false) {
+        m_lock->lock();
+        m_owns = true;
+    }
+
+    /**
+     * Associates @a lock without acquiring it.
+     */
+    UniqueLock(L& lock, std::defer_lock_t) : m_lock(&lock), m_owns(false) { }
+
+    /**
+     * Acquires @a lock if it is free; ownsLock() tells whether it was.
+     */
+    UniqueLock(L& lock, std::try_to_lock_t) : m_lock(&lock), m_owns(lock.tryLock()) { }
+
+    /**
+     * Takes over @a lock, which the calling thread already holds.
+     */
+    UniqueLock(L& lock, std::adopt_lock_t) : m_lock(&lock), m_owns(true) { }
+
+    /**
+     * Acquires @a lock if it becomes free before @a deadline passes;
+     * ownsLock() tells whether it did.
+     */
+    UniqueLock(L& lock, const Deadline& deadline) : m_lock(&lock), m_owns(lock.tryLockUntil(deadline)) { }
+
+    UniqueLock(UniqueLock&& other) : m_lock(other.m_lock), m_owns(other.m_owns) {
+        other.m_lock = 0;
+        other.m_owns = false;
+    }
+
+    UniqueLock& operator=(UniqueLock&& rhs) {
+        if (this != &rhs) {
+            if (m_owns)
+                m_lock->unlock();
+            m_lock = rhs.m_lock;
+            m_owns = rhs.m_owns;
+            rhs.m_lock = 0;
+            rhs.m_owns = false;
+        }
+        return *this;
+    }
+
+    ~UniqueLock() {
+        if (m_owns)
+            m_lock->unlock();
+    }
+
+    UniqueLock(const UniqueLock& other) = delete;
+    UniqueLock& operator=(const UniqueLock& rhs) = delete;
+
+    /**
+     * Acquires the associated lock.
+     *
+     * @throws IllegalStateException if there is no associated lock, or this
+     * owner already holds it
+     */
+    void lock() {
+        checkCanLock();
+        m_lock->lock();
+        m_owns = true;
+    }
+
+    /**
+     * Acquires the associated lock only if it is free at the time of
+     * invocation.
+     *
+     * @return true if the lock was acquired
+     * @throws IllegalStateException if there is no associated lock, or this
+     * owner already holds it
+     */
+    bool tryLock() {
+        checkCanLock();
+        m_owns = m_lock->tryLock();
+        return m_owns;
+    }
+
+    /**
+     * Acquires the associated lock if it becomes free within the given
+     * waiting time.
+     *
+     * @return true if the lock was acquired
+     * @throws IllegalStateException if there is no associated lock, or this
+     * owner already holds it
+     */
+    bool tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
+        checkCanLock();
+        m_owns = m_lock->tryLock(t, timeUnit);
+        return m_owns;
+    }
+
+    /**
+     * Acquires the associated lock if it becomes free before the given
+     * deadline passes.
+     *
+     * @return true if the lock was acquired
+     * @throws IllegalStateException if there is no associated lock, or this
+     * owner already holds it
+     */
+    bool tryLockUntil(const Deadline& deadline) {
+        checkCanLock();
+        m_owns = m_lock->tryLockUntil(deadline);
+        return m_owns;
+    }
+
+    /**
+     * Releases the associated lock.
+     *
+     * @throws IllegalMonitorStateException if this owner does not hold it
+     */
+    void unlock() {
+        if (!m_owns)
+            throw lang::IllegalMonitorStateException("the lock is not held by this owner");
+        m_lock->unlock();
+        m_owns = false;
+    }
+
+    /**
+     * Disassociates the lock without unlocking it: the caller becomes
+     * responsible for releasing it, if it is held.
+     *
+     * @return the lock, or null if there was none
+     */
+    L* release() {
+        L* lock = m_lock;
+        m_lock = 0;
+        m_owns = false;
+        return lock;
+    }
+
+    void swap(UniqueLock& other) {
+        std::swap(m_lock, other.m_lock);
+        std::swap(m_owns, other.m_owns);
+    }
+
+    /**
+     * @return true if this owner holds the associated lock
+     */
+    bool ownsLock() const {
+        return m_owns;
+    }
+
+    explicit operator bool() const {
+        return m_owns;
+    }
+
+    /**
+     * @return the associated lock, or null if there is none
+     */
+    L* getLock() const {
+        return m_lock;
+    }
+
+  private:
+    void checkCanLock() const {
+        if (m_lock == 0)
+            throw lang::IllegalStateException("no lock is associated with this owner");
+        if (m_owns)
+            throw lang::IllegalStateException("the lock is already held by this owner");
+    }
+
+    L* m_lock;
+    bool m_owns;
+};
+
+DECAF_CLOSE_NAMESPACE4
+
+#endif	/* DECAF_UNIQUELOCK_HPP */
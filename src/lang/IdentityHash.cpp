@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decaf/lang/IdentityHash.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/lang/IllegalStateException.hpp"
+#include "decaf/lang/ThreadRecord.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+
+namespace {
+
+/*
+ * The next block of seeds to hand to a thread; 0 until the first one is.
+ */
+std::atomic<uint32_t> s_nextBlock(0);
+
+const uint32_t SEEDS_PER_BLOCK = 4096;
+
+}
+
+std::atomic<IdentityHash::Mixer> IdentityHash::s_mixer(&IdentityHash::murmur3);
+
+// ----------------------------------------------------------------------------
+
+void IdentityHash::setMixer(Mixer mixer) {
+    if (mixer == 0)
+        throw IllegalArgumentException("mixer must not be null");
+    if (s_nextBlock.load(std::memory_order_relaxed) != 0)
+        throw IllegalStateException("identity hash codes have already been handed out");
+
+    s_mixer.store(mixer, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+
+uint32_t IdentityHash::nextSeed() {
+    detail::ThreadRecord& self = detail::ThreadRecord::current();
+
+    if (self.m_nextSeed == self.m_seedLimit) {
+        self.m_nextSeed = s_nextBlock.fetch_add(SEEDS_PER_BLOCK, std::memory_order_relaxed);
+        self.m_seedLimit = self.m_nextSeed + SEEDS_PER_BLOCK;
+    }
+
+    uint32_t seed = self.m_nextSeed++;
+    if (seed == 0)
+        seed = self.m_nextSeed++;
+    return seed;
+}
+
+DECAF_CLOSE_NAMESPACE2
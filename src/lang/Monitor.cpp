@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+#include <new>
+#include <pthread.h>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/Monitor.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+std::atomic<Monitor*> Monitor::s_chunks[Monitor::MAX_CHUNKS];
+
+/**
+ * The free list of monitors. Inflation is the slow path of the slow path,
+ * so a plain mutex is good enough here.
+ */
+class MonitorPool {
+  public:
+    static uint32_t pop() {
+        pthread_mutex_lock(&s_mutex);
+        if (s_freeHead == 0)
+            grow();
+        uint32_t index = s_freeHead - 1;
+        s_freeHead = Monitor::at(index).m_nextFree;
+        pthread_mutex_unlock(&s_mutex);
+        return index;
+    }
+
+    static void push(uint32_t index) {
+        pthread_mutex_lock(&s_mutex);
+        Monitor::at(index).m_nextFree = s_freeHead;
+        s_freeHead = index + 1;
+        pthread_mutex_unlock(&s_mutex);
+    }
+
+  private:
+    /*
+     * Allocates the next chunk of monitors and threads it onto the free list.
+     * Must be called with s_mutex held.
+     */
+    static void grow() {
+        if (s_chunkCount == Monitor::MAX_CHUNKS)
+            throw std::bad_alloc();
+
+        void* memory = 0;
+        const size_t chunkSize = sizeof (Monitor) << Monitor::CHUNK_SHIFT;
+        if (posix_memalign(&memory, alignof (Monitor), chunkSize) != 0)
+            throw std::bad_alloc();
+
+        Monitor* chunk = static_cast<Monitor*> (memory);
+        const uint32_t base = s_chunkCount << Monitor::CHUNK_SHIFT;
+        for (uint32_t i = 0; i <= Monitor::CHUNK_MASK; ++i) {
+            new (&chunk[i]) Monitor();
+            chunk[i].m_nextFree = (i < Monitor::CHUNK_MASK) ? base + i + 2 : s_freeHead;
+        }
+
+        Monitor::s_chunks[s_chunkCount++].store(chunk, std::memory_order_release);
+        s_freeHead = base + 1;
+    }
+
+    static pthread_mutex_t s_mutex;
+
+    /*
+     * One plus the index of the first free monitor; 0 when the list is empty.
+     */
+    static uint32_t s_freeHead;
+    static uint32_t s_chunkCount;
+};
+
+pthread_mutex_t MonitorPool::s_mutex = PTHREAD_MUTEX_INITIALIZER;
+uint32_t MonitorPool::s_freeHead = 0;
+uint32_t MonitorPool::s_chunkCount = 0;
+
+// ----------------------------------------------------------------------------
+
+uint32_t Monitor::allocate(uint32_t owner, uint32_t recursions) {
+    uint32_t index = MonitorPool::pop();
+    Monitor& monitor = at(index);
+
+    if (owner != 0) {
+        monitor.m_lock.store(1, std::memory_order_relaxed);
+        monitor.m_owner.store(owner, std::memory_order_relaxed);
+        monitor.m_recursions = recursions;
+    }
+    return index;
+}
+
+// ----------------------------------------------------------------------------
+
+void Monitor::profile(const Object& obj) {
+    m_statistics = new MonitorStatistics(obj, m_owner.load(std::memory_order_relaxed) != 0);
+}
+
+// ----------------------------------------------------------------------------
+
+void Monitor::release(uint32_t index) {
+    Monitor& monitor = at(index);
+    if (monitor.m_statistics != 0) {
+        MonitorStatistics::retire(monitor.m_statistics);
+        monitor.m_statistics = 0;
+    }
+    monitor.m_lock.store(0, std::memory_order_relaxed);
+    monitor.m_owner.store(0, std::memory_order_relaxed);
+    monitor.m_recursions = 0;
+    monitor.m_waiters = 0;
+
+    MonitorPool::push(index);
+}
+
+// ----------------------------------------------------------------------------
+
+void Monitor::lock(uint32_t self) {
+    if (m_statistics != 0) {
+        lockProfiled(self);
+        return;
+    }
+
+    if (m_owner.load(std::memory_order_relaxed) == self) {
+        ++m_recursions;
+        return;
+    }
+
+    uint32_t state = 0;
+    if (!m_lock.compare_exchange_strong(state, 1, std::memory_order_acquire))
+        lockContended();
+    m_owner.store(self, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+
+void Monitor::lockProfiled(uint32_t self) {
+    if (m_owner.load(std::memory_order_relaxed) == self) {
+        ++m_recursions;
+        return;
+    }
+
+    uint32_t state = 0;
+    uint64_t waitedSince = 0;
+    if (!m_lock.compare_exchange_strong(state, 1, std::memory_order_acquire)) {
+        waitedSince = MonitorStatistics::now();
+        lockContended();
+    }
+    m_owner.store(self, std::memory_order_relaxed);
+    m_statistics->acquired(waitedSince);
+}
+
+// ----------------------------------------------------------------------------
+
+void Monitor::lockContended() {
+    uint32_t state = 0;
+    if (!m_spin.spin([this, &state]() {
+          state = 0;
+          return (m_lock.load(std::memory_order_relaxed) == 0 &&
+            m_lock.compare_exchange_strong(state, 1, std::memory_order_acquire));
+      })) {
+        if (state != 2)
+            state = m_lock.exchange(2, std::memory_order_acquire);
+        while (state != 0) {
+            futexWait(m_lock, 2);
+            state = m_lock.exchange(2, std::memory_order_acquire);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void Monitor::unlock(uint32_t self) {
+    if (m_owner.load(std::memory_order_relaxed) != self)
+        return;
+
+    if (m_recursions > 0) {
+        --m_recursions;
+        return;
+    }
+
+    if (m_statistics != 0)
+        m_statistics->released();
+    m_owner.store(0, std::memory_order_relaxed);
+    if (m_lock.fetch_sub(1, std::memory_order_release) != 1) {
+        m_lock.store(0, std::memory_order_release);
+        futexWake(m_lock, 1);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void Monitor::wait(uint32_t self, const struct timespec* deadline) {
+    const uint32_t sequence = m_waitSequence.load(std::memory_order_relaxed);
+    const uint32_t recursions = m_recursions;
+
+    ++m_waiters;
+    m_recursions = 0;
+    unlock(self);
+
+    futexWaitUntil(m_waitSequence, sequence, deadline);
+
+    // We may have been requeued behind other notified threads, so take the
+    // monitor the way a contended thread does: leave the lock marked as
+    // having sleepers, or our own release would not wake them.
+    while (m_lock.exchange(2, std::memory_order_acquire) != 0)
+        futexWait(m_lock, 2);
+
+    m_owner.store(self, std::memory_order_relaxed);
+    m_recursions = recursions;
+    --m_waiters;
+    if (m_statistics != 0)
+        m_statistics->acquired(0);
+}
+
+// ----------------------------------------------------------------------------
+
+void Monitor::notify(bool all) {
+    if (m_waiters == 0)
+        return;
+
+    const uint32_t sequence = m_waitSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    // Requeued threads are only woken by an unlock that sees the contended
+    // state, so make sure ours will.
+    m_lock.store(2, std::memory_order_relaxed);
+    futexRequeue(m_waitSequence, 0, (all ? INT_MAX : 1), m_lock, sequence);
+}
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <pthread.h>
+
+#include "decaf/lang/MonitorProfiler.hpp"
+#include "decaf/lang/MonitorStatistics.hpp"
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/System.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+
+namespace {
+
+/*
+ * Live statistics are linked from s_live; those of destroyed monitors are
+ * merged into s_retired, keyed by type name. Neither is ever freed, so that
+ * monitors released by static destructors find them intact.
+ */
+pthread_mutex_t s_registryMutex = PTHREAD_MUTEX_INITIALIZER;
+detail::MonitorStatistics* s_live = 0;
+std::map<const std::string*, MonitorProfiler::Entry>* s_retired = 0;
+
+bool isMoreContended(const MonitorProfiler::Entry& lhs, const MonitorProfiler::Entry& rhs) {
+    if (lhs.m_contendedAcquires != rhs.m_contendedAcquires)
+        return lhs.m_contendedAcquires > rhs.m_contendedAcquires;
+    return lhs.m_totalWaitNanos > rhs.m_totalWaitNanos;
+}
+
+/**
+ * Prints the report DECAF_MONITOR_PROFILE asks for when the program exits.
+ */
+class ExitReport {
+  public:
+    ~ExitReport() {
+        if (MonitorProfiler::isEnabled())
+            MonitorProfiler::dump(std::cerr, detail::MonitorStatistics::configuredTop());
+    }
+};
+
+}
+
+bool MonitorProfiler::s_enabled = (detail::MonitorStatistics::configuredTop() > 0);
+
+namespace {
+
+// Constructed after std::cerr, hence destroyed before it.
+std::ios_base::Init s_streams;
+ExitReport s_exitReport;
+
+}
+
+DECAF_OPEN_NAMESPACE(detail)
+
+// ----------------------------------------------------------------------------
+
+MonitorStatistics::MonitorStatistics(const Object& obj, bool owned) :
+  m_identity(obj.Object::toString()), m_type(&obj.getTypeName()),
+  m_acquires(0), m_contendedAcquires(0), m_totalWaitNanos(0), m_maxWaitNanos(0),
+  m_totalHoldNanos(0), m_maxHoldNanos(0), m_acquiredAt(owned ? now() : 0),
+  m_previous(0), m_next(0) {
+    pthread_mutex_lock(&s_registryMutex);
+    m_next = s_live;
+    if (s_live != 0)
+        s_live->m_previous = this;
+    s_live = this;
+    pthread_mutex_unlock(&s_registryMutex);
+}
+
+// ----------------------------------------------------------------------------
+
+void MonitorStatistics::acquired(uint64_t waitedSince) {
+    m_acquiredAt = now();
+    add(m_acquires, 1);
+    if (waitedSince != 0) {
+        const uint64_t waited = m_acquiredAt - waitedSince;
+        add(m_contendedAcquires, 1);
+        add(m_totalWaitNanos, waited);
+        raise(m_maxWaitNanos, waited);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void MonitorStatistics::released() {
+    if (m_acquiredAt == 0)
+        return;
+
+    const uint64_t held = now() - m_acquiredAt;
+    add(m_totalHoldNanos, held);
+    raise(m_maxHoldNanos, held);
+    m_acquiredAt = 0;
+}
+
+// ----------------------------------------------------------------------------
+
+void MonitorStatistics::retire(MonitorStatistics* statistics) {
+    pthread_mutex_lock(&s_registryMutex);
+    if (statistics->m_previous != 0)
+        statistics->m_previous->m_next = statistics->m_next;
+    else
+        s_live = statistics->m_next;
+    if (statistics->m_next != 0)
+        statistics->m_next->m_previous = statistics->m_previous;
+
+    // Monitors inflated in a race that was lost were never acquired.
+    const uint64_t acquires = statistics->m_acquires.load(std::memory_order_relaxed);
+    if (acquires > 0) {
+        if (s_retired == 0)
+            s_retired = new std::map<const std::string*, MonitorProfiler::Entry>();
+
+        MonitorProfiler::Entry& entry = (*s_retired)[statistics->m_type];
+        entry.m_identity = *statistics->m_type;
+        entry.m_destroyed = true;
+        entry.m_acquires += acquires;
+        entry.m_contendedAcquires += statistics->m_contendedAcquires.load(std::memory_order_relaxed);
+        entry.m_totalWaitNanos += statistics->m_totalWaitNanos.load(std::memory_order_relaxed);
+        entry.m_maxWaitNanos = std::max(entry.m_maxWaitNanos,
+          statistics->m_maxWaitNanos.load(std::memory_order_relaxed));
+        entry.m_totalHoldNanos += statistics->m_totalHoldNanos.load(std::memory_order_relaxed);
+        entry.m_maxHoldNanos = std::max(entry.m_maxHoldNanos,
+          statistics->m_maxHoldNanos.load(std::memory_order_relaxed));
+    }
+    pthread_mutex_unlock(&s_registryMutex);
+
+    delete statistics;
+}
+
+// ----------------------------------------------------------------------------
+
+uint64_t MonitorStatistics::now() {
+    return System::fastNanoTime();
+}
+
+// ----------------------------------------------------------------------------
+
+size_t MonitorStatistics::configuredTop() {
+    const char* setting = getenv("DECAF_MONITOR_PROFILE");
+    if (setting == 0)
+        return 0;
+
+    const long top = strtol(setting, 0, 10);
+    return (top > 0) ? static_cast<size_t> (top) : 0;
+}
+
+DECAF_CLOSE_NAMESPACE
+
+// ----------------------------------------------------------------------------
+
+std::vector<MonitorProfiler::Entry> MonitorProfiler::snapshot(size_t top) {
+    std::vector<Entry> entries;
+
+    pthread_mutex_lock(&s_registryMutex);
+    for (detail::MonitorStatistics* live = s_live; live != 0; live = live->m_next) {
+        Entry entry;
+        entry.m_identity = live->m_identity;
+        entry.m_destroyed = false;
+        entry.m_acquires = live->m_acquires.load(std::memory_order_relaxed);
+        entry.m_contendedAcquires = live->m_contendedAcquires.load(std::memory_order_relaxed);
+        entry.m_totalWaitNanos = live->m_totalWaitNanos.load(std::memory_order_relaxed);
+        entry.m_maxWaitNanos = live->m_maxWaitNanos.load(std::memory_order_relaxed);
+        entry.m_totalHoldNanos = live->m_totalHoldNanos.load(std::memory_order_relaxed);
+        entry.m_maxHoldNanos = live->m_maxHoldNanos.load(std::memory_order_relaxed);
+        entries.push_back(entry);
+    }
+    if (s_retired != 0) {
+        for (const auto& retired : *s_retired)
+            entries.push_back(retired.second);
+    }
+    pthread_mutex_unlock(&s_registryMutex);
+
+    top = std::min(top, entries.size());
+    std::partial_sort(entries.begin(), entries.begin() + top, entries.end(), isMoreContended);
+    entries.resize(top);
+    return entries;
+}
+
+// ----------------------------------------------------------------------------
+
+void MonitorProfiler::dump(std::ostream& out, size_t top) {
+    const std::vector<Entry> entries = snapshot(top);
+
+    char line[160];
+    snprintf(line, sizeof line, "%12s %12s %14s %12s %14s %12s  %s\n", "contended",
+      "acquires", "wait total ms", "wait max us", "hold total ms", "hold max us", "monitor");
+    out << "decaf monitor profile: " << entries.size() << " most contended monitors\n" << line;
+
+    for (const Entry& entry : entries) {
+        snprintf(line, sizeof line, "%12" PRIu64 " %12" PRIu64 " %14.3f %12.1f %14.3f %12.1f  ",
+          entry.m_contendedAcquires, entry.m_acquires, entry.m_totalWaitNanos / 1e6,
+          entry.m_maxWaitNanos / 1e3, entry.m_totalHoldNanos / 1e6, entry.m_maxHoldNanos / 1e3);
+        out << line << entry.m_identity << (entry.m_destroyed ? " (destroyed objects)" : "") << '\n';
+    }
+    out.flush();
+}
+
+DECAF_CLOSE_NAMESPACE2
@@ -1,21 +1,85 @@
-#include <cxxabi.h>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <new>
 
 #include "decaf/lang/CloneNotSupportedException.hpp"
+#include "decaf/lang/IdentityHash.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/lang/Monitor.hpp"
 #include "decaf/lang/Object.hpp"
+#include "decaf/lang/ObjectHeader.hpp"
+#include "decaf/lang/SlabAllocator.hpp"
+#include "decaf/lang/ThreadRecord.hpp"
+#include "decaf/lang/TypeNameCache.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
 
 DECAF_OPEN_NAMESPACE2(decaf, lang)
 
-#define DECAF_OBJECT_ALIGNMENT_SHIFT    3
-
 using std::string;
 
+namespace {
+
+/*
+ * Waits on the monitor of obj for at most the given number of nanoseconds,
+ * or forever if it is 0. The timeout is measured on CLOCK_MONOTONIC so that
+ * adjustments of the wall clock do not shorten or stretch it.
+ */
+void waitOn(const Object& obj, uint64_t nanos) {
+    detail::Monitor* monitor = detail::ObjectHeader::ownedMonitor(obj, true);
+    const uint32_t self = detail::ThreadRecord::current().id();
+
+    const util::concurrent::Deadline deadline = (nanos == 0) ? util::concurrent::Deadline::never()
+                                                             : util::concurrent::Deadline::afterNanos(nanos);
+    struct timespec time;
+    monitor->wait(self, deadline.toTimespec(time));
+}
+
+}
+
+// ----------------------------------------------------------------------------
+
+Object::~Object() {
+    detail::ObjectHeader::destroy(*this);
+}
+
+// ----------------------------------------------------------------------------
+
+void* Object::operator new(std::size_t size) {
+#ifdef DECAF_SLAB_ALLOCATOR
+    return detail::SlabAllocator::allocate(size);
+#else
+    return ::operator new(size);
+#endif
+}
+
+// ----------------------------------------------------------------------------
+
+void Object::operator delete(void* object, std::size_t size) throw () {
+#ifdef DECAF_SLAB_ALLOCATOR
+    detail::SlabAllocator::deallocate(object, size);
+#else
+    ::operator delete(object);
+#endif
+}
+
 // ----------------------------------------------------------------------------
 
 uint64_t Object::hashCode() const throw () {
-    if (m_hashCode == 0)
-        m_hashCode = (reinterpret_cast<uint64_t> (this) >>
-      DECAF_OBJECT_ALIGNMENT_SHIFT) * 2654435761u;
-    return m_hashCode;
+    typedef detail::ObjectHeader Header;
+
+    uint64_t header = m_header.load(std::memory_order_relaxed);
+    if (Header::hash(header) != 0)
+        return IdentityHash::mix(Header::hash(header));
+
+    const uint32_t seed = IdentityHash::nextSeed();
+    while (!m_header.compare_exchange_weak(header, Header::withHash(header, seed),
+      std::memory_order_relaxed)) {
+        if (Header::hash(header) != 0)
+            return IdentityHash::mix(Header::hash(header));
+    }
+    return IdentityHash::mix(seed);
 }
 
 // ----------------------------------------------------------------------------
@@ -32,57 +96,76 @@ const Object::Type& Object::getType() const {
 
 // ----------------------------------------------------------------------------
 
-string Object::getTypeName() const {
-    char buf[1024]{};
-    size_t bufsz = sizeof (buf);
-    int status{0};
-
-    // TODO: Add lock here
-    char* res = abi::__cxa_demangle(getType().name(), buf, &bufsz, &status);
-    string demangledName = string(res);
-
-    return demangledName.c_str();
+const string& Object::getTypeName() const {
+    return detail::TypeNameCache::nameOf(getType());
 }
 
 // ----------------------------------------------------------------------------
 
 string Object::toString() const {
-    string demangledName = getTypeName();
-    static const uint8_t stringHashCodeValueSize{64};
+    const string& typeName = getTypeName();
+    static const uint8_t stringHashCodeValueSize{17};
     char stringHashCodeValue[stringHashCodeValueSize]{};
 
-    snprintf(stringHashCodeValue, stringHashCodeValueSize, "%llx", hashCode());
-    return string(demangledName + "@" + stringHashCodeValue);
+    snprintf(stringHashCodeValue, stringHashCodeValueSize, "%" PRIx64, hashCode());
+
+    string result;
+    result.reserve(typeName.size() + 1 + stringHashCodeValueSize);
+    result.append(typeName).append(1, '@').append(stringHashCodeValue);
+    return result;
 }
 
 // ----------------------------------------------------------------------------
 
 void Object::notify() {
-
+    detail::Monitor* monitor = detail::ObjectHeader::ownedMonitor(*this, false);
+    if (monitor != 0)
+        monitor->notify(false);
 }
 
 // ----------------------------------------------------------------------------
 
 void Object::notifyAll() {
-
+    detail::Monitor* monitor = detail::ObjectHeader::ownedMonitor(*this, false);
+    if (monitor != 0)
+        monitor->notify(true);
 }
 
 // ----------------------------------------------------------------------------
 
 void Object::wait() {
-
+    waitOn(*this, 0);
 }
 
 // ----------------------------------------------------------------------------
 
 void Object::wait(uint64_t timeout) {
-
+    wait(timeout, 0);
 }
 
 // ----------------------------------------------------------------------------
 
 void Object::wait(uint64_t timeout, uint64_t nanos) {
+    if (nanos > 999999)
+        throw IllegalArgumentException("nanosecond timeout value out of range");
+
+    static const uint64_t NANOS_PER_MILLI = 1000000;
+    if (timeout > (UINT64_MAX - nanos) / NANOS_PER_MILLI)
+        waitOn(*this, 0);
+    else
+        waitOn(*this, timeout * NANOS_PER_MILLI + nanos);
+}
+
+// ----------------------------------------------------------------------------
+
+void Object::enterSynchronizedBlock() {
+    detail::ObjectHeader::enter(*this);
+}
+
+// ----------------------------------------------------------------------------
 
+void Object::exitSynchronizedBlock() {
+    detail::ObjectHeader::exit(*this);
 }
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sched.h>
+
+#include "decaf/lang/IllegalMonitorStateException.hpp"
+#include "decaf/lang/Monitor.hpp"
+#include "decaf/lang/MonitorProfiler.hpp"
+#include "decaf/lang/ObjectHeader.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+namespace {
+
+/*
+ * Backs off while a bias revocation completes: revocations are rare and may
+ * have to wait for the owner to leave its critical section, so yield first
+ * and then sleep for increasingly long periods.
+ */
+class RevocationBackoff {
+  public:
+    RevocationBackoff() : m_rounds(0) { }
+
+    void pause() {
+        if (m_rounds < 16) {
+            sched_yield();
+        } else {
+            const long shift = (m_rounds < 26) ? m_rounds - 16 : 10;
+            struct timespec delay = { 0, 1000L << shift };
+            nanosleep(&delay, 0);
+        }
+        ++m_rounds;
+    }
+
+  private:
+    long m_rounds;
+};
+
+}
+
+// ----------------------------------------------------------------------------
+
+bool ObjectHeader::isBiasingEnabled() {
+    static const bool enabled = []() {
+        const char* setting = getenv("DECAF_BIASED_LOCKING");
+        if (setting != 0 && (strcmp(setting, "0") == 0 || strcmp(setting, "false") == 0))
+            return false;
+        if (MonitorStatistics::configuredTop() > 0)
+            return false;
+        return ThreadRecord::hasAsymmetricBarrier();
+    }();
+    return enabled;
+}
+
+// ----------------------------------------------------------------------------
+
+void ObjectHeader::enter(const Object& obj) {
+    std::atomic<uint64_t>& word = obj.m_header;
+    ThreadRecord& self = ThreadRecord::current();
+    const uint32_t id = self.id();
+
+    uint64_t header = word.load(std::memory_order_acquire);
+    for (;;) {
+        const uint32_t lock = lockWord(header);
+
+        switch (lock & TAG_MASK) {
+          case NEUTRAL: {
+            if (MonitorProfiler::isEnabled()) {
+                inflateProfiled(obj, header);
+                break;
+            }
+            if (id > MAX_OWNER) {
+                inflate(obj, header, 0, 0);
+                break;
+            }
+            const bool bias = (lock == NEUTRAL && isBiasingEnabled());
+            const uint64_t locked = withLockWord(header, bias ? biased(id) : thin(id, 0));
+            if (word.compare_exchange_weak(header, locked,
+              std::memory_order_acquire, std::memory_order_acquire)) {
+                if (!bias)
+                    return;
+                header = locked;
+            }
+            continue;
+          }
+
+          case THIN:
+            if (owner(lock) == id) {
+                if (recursions(lock) < MAX_RECURSIONS) {
+                    if (word.compare_exchange_weak(header, header + (1u << RECURSION_SHIFT),
+                      std::memory_order_acquire, std::memory_order_acquire))
+                        return;
+                    continue;
+                }
+                inflate(obj, header, id, recursions(lock));
+            } else if (!self.m_thinSpin.spin([&word, &header]() {
+                  header = word.load(std::memory_order_acquire);
+                  return ((lockWord(header) & TAG_MASK) != THIN);
+              })) {
+                // The lock may have changed hands while we spun: inflate it
+                // for whoever holds it now.
+                const uint32_t current = lockWord(header);
+                inflate(obj, header, owner(current), recursions(current));
+            }
+            break;
+
+          case INFLATED:
+            Monitor::at(monitorIndex(lock)).lock(id);
+            return;
+
+          case BIASED:
+            if (owner(lock) != id)
+                revokeBias(obj, header);
+            else if (enterBiased(obj, self, header))
+                return;
+            break;
+        }
+        header = word.load(std::memory_order_acquire);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void ObjectHeader::exit(const Object& obj) {
+    std::atomic<uint64_t>& word = obj.m_header;
+    ThreadRecord& self = ThreadRecord::current();
+    const uint32_t id = self.id();
+
+    uint64_t header = word.load(std::memory_order_acquire);
+    for (;;) {
+        const uint32_t lock = lockWord(header);
+
+        switch (lock & TAG_MASK) {
+          case THIN: {
+            if (owner(lock) != id)
+                return;
+            const uint64_t released = (recursions(lock) > 0) ?
+              header - (1u << RECURSION_SHIFT) : withLockWord(header, UNBIASABLE);
+            if (word.compare_exchange_weak(header, released,
+              std::memory_order_release, std::memory_order_acquire))
+                return;
+            continue;
+          }
+
+          case INFLATED:
+            Monitor::at(monitorIndex(lock)).unlock(id);
+            return;
+
+          case BIASED: {
+            ThreadRecord::BiasedLock* entry;
+            if (owner(lock) != id || (entry = self.heldBiasedLock(&obj)) == 0)
+                return;
+
+            const uint32_t count = entry->m_count.load(std::memory_order_relaxed);
+            entry->m_count.store(count - 1, std::memory_order_release);
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+
+            if (lockWord(word.load(std::memory_order_acquire)) != biased(id))
+                unbias(obj, self, entry);
+            return;
+          }
+
+          default:
+            return;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+Monitor* ObjectHeader::ownedMonitor(const Object& obj, bool inflate) {
+    ThreadRecord& self = ThreadRecord::current();
+    const uint32_t id = self.id();
+
+    uint64_t header = obj.m_header.load(std::memory_order_acquire);
+    for (;;) {
+        const uint32_t lock = lockWord(header);
+
+        if ((lock & TAG_MASK) == THIN && owner(lock) == id) {
+            if (!inflate)
+                return 0;
+            ObjectHeader::inflate(obj, header, id, recursions(lock));
+        } else if ((lock & TAG_MASK) == BIASED && owner(lock) == id) {
+            ThreadRecord::BiasedLock* entry = self.heldBiasedLock(&obj);
+            if (entry == 0)
+                break;
+            if (!inflate)
+                return 0;
+            unbias(obj, self, entry);
+        } else if ((lock & TAG_MASK) == INFLATED) {
+            Monitor& monitor = Monitor::at(monitorIndex(lock));
+            if (monitor.owner() == id)
+                return &monitor;
+            break;
+        } else {
+            break;
+        }
+        header = obj.m_header.load(std::memory_order_acquire);
+    }
+    throw IllegalMonitorStateException("current thread is not owner");
+}
+
+// ----------------------------------------------------------------------------
+
+void ObjectHeader::destroy(const Object& obj) {
+    const uint32_t lock = lockWord(obj.m_header.load(std::memory_order_acquire));
+    if ((lock & TAG_MASK) == INFLATED)
+        Monitor::release(monitorIndex(lock));
+}
+
+// ----------------------------------------------------------------------------
+
+bool ObjectHeader::inflate(const Object& obj, uint64_t header, uint32_t owner,
+  uint32_t recursions) {
+    const uint32_t monitor = Monitor::allocate(owner, recursions);
+    if (obj.m_header.compare_exchange_strong(header, withLockWord(header, inflated(monitor)),
+      std::memory_order_acq_rel, std::memory_order_relaxed))
+        return true;
+
+    Monitor::release(monitor);
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+bool ObjectHeader::inflateProfiled(const Object& obj, uint64_t header) {
+    // The statistics name the object by its toString(), which hashes it. Do
+    // that first and let the caller retry with the hashed header, or the CAS
+    // below would fail on every first inflation.
+    if (hash(header) == 0) {
+        obj.hashCode();
+        return false;
+    }
+
+    const uint32_t monitor = Monitor::allocate(0, 0);
+    Monitor::at(monitor).profile(obj);
+    if (obj.m_header.compare_exchange_strong(header, withLockWord(header, inflated(monitor)),
+      std::memory_order_acq_rel, std::memory_order_relaxed))
+        return true;
+
+    Monitor::release(monitor);
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+bool ObjectHeader::enterBiased(const Object& obj, ThreadRecord& self, uint64_t header) {
+    std::atomic<uint64_t>& word = obj.m_header;
+    const uint32_t id = self.id();
+
+    ThreadRecord::BiasedLock* entry = self.claimBiasedLock(&obj);
+    if (entry == 0) {
+        // No room left to count our entries: give the bias up for a thin
+        // lock. We cannot be holding the monitor, or we would have an entry.
+        if ((lockWord(header) & REVOKING) == 0)
+            word.compare_exchange_strong(header, withLockWord(header, thin(id, 0)),
+              std::memory_order_acquire, std::memory_order_relaxed);
+        else
+            sched_yield();
+        return false;
+    }
+
+    const uint32_t count = entry->m_count.load(std::memory_order_relaxed);
+    entry->m_count.store(count + 1, std::memory_order_release);
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+
+    header = word.load(std::memory_order_acquire);
+    if (lockWord(header) == biased(id))
+        return true;
+
+    if (count > 0) {
+        // Re-entered while a revocation is under way: we own the monitor,
+        // so it is up to us to hand the revoker an inflated one.
+        unbias(obj, self, entry);
+        return true;
+    }
+
+    // Not ours to take any more: back off and let the revoker finish.
+    entry->m_count.store(0, std::memory_order_release);
+    RevocationBackoff backoff;
+    while (lockWord(word.load(std::memory_order_acquire)) == (biased(id) | REVOKING))
+        backoff.pause();
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+void ObjectHeader::unbias(const Object& obj, ThreadRecord& self,
+  ThreadRecord::BiasedLock* entry) {
+    std::atomic<uint64_t>& word = obj.m_header;
+    const uint32_t id = self.id();
+
+    const uint32_t count = entry->m_count.load(std::memory_order_relaxed);
+    const uint32_t monitor = (count > 0) ? Monitor::allocate(id, count - 1) : 0;
+    const uint32_t replacement = (count > 0) ? inflated(monitor) : UNBIASABLE;
+
+    uint64_t header = word.load(std::memory_order_acquire);
+    while ((lockWord(header) & ~REVOKING) == biased(id)) {
+        if (word.compare_exchange_weak(header, withLockWord(header, replacement),
+          std::memory_order_acq_rel, std::memory_order_acquire)) {
+            // Only now may the count drop to zero: until the header changed, a
+            // revoker reading zero would have released the monitor to itself.
+            entry->m_count.store(0, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // A revoker beat us to it, which it can only do if we held nothing.
+    if (count > 0)
+        Monitor::release(monitor);
+}
+
+// ----------------------------------------------------------------------------
+
+void ObjectHeader::revokeBias(const Object& obj, uint64_t header) {
+    std::atomic<uint64_t>& word = obj.m_header;
+
+    uint32_t lock = lockWord(header);
+    if ((lock & REVOKING) == 0) {
+        if (!word.compare_exchange_strong(header, withLockWord(header, lock | REVOKING),
+          std::memory_order_acq_rel, std::memory_order_acquire))
+            return;
+        lock |= REVOKING;
+    }
+
+    // Either the owner sees the mark on its next entry or exit, or we see
+    // its count of entries below.
+    ThreadRecord::asymmetricBarrier();
+
+    // The owner's record was indexed before it could write the bias, and
+    // stays indexed for good. A thread that reused it since has the same
+    // identifier, so the bias is now that thread's to give up.
+    const ThreadRecord& owner = *ThreadRecord::forId(ObjectHeader::owner(lock));
+    RevocationBackoff backoff;
+    for (;;) {
+        header = word.load(std::memory_order_acquire);
+        if (lockWord(header) != lock)
+            return;
+
+        if (!owner.mightHoldBiasedLock(&obj)) {
+            word.compare_exchange_strong(header, withLockWord(header, UNBIASABLE),
+              std::memory_order_acq_rel, std::memory_order_relaxed);
+            return;
+        }
+        backoff.pause();
+    }
+}
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
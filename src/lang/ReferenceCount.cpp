@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sched.h>
+
+#include "decaf/lang/IllegalStateException.hpp"
+#include "decaf/lang/ReferenceCount.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+// ----------------------------------------------------------------------------
+
+void ReferenceCount::adopt(const Object& object) {
+    // Counts are only confined when another thread can take them over.
+    uint64_t self = ThreadRecord::current().token();
+    if (!ThreadRecord::hasAsymmetricBarrier())
+        self = 0;
+
+    uint64_t references = 0;
+    if (!object.m_references.compare_exchange_strong(references, (self << OWNER_SHIFT) | 1,
+      std::memory_order_relaxed))
+        throw IllegalStateException("object is already managed by a Ref");
+}
+
+// ----------------------------------------------------------------------------
+
+void ReferenceCount::retainShared(const Object& object) {
+    unconfine(object);
+    object.m_references.fetch_add(1, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+
+uint32_t ReferenceCount::releaseShared(const Object& object) throw () {
+    unconfine(object);
+    return count(object.m_references.fetch_sub(1, std::memory_order_acq_rel));
+}
+
+// ----------------------------------------------------------------------------
+
+void ReferenceCount::share(const Object& object) {
+    unconfine(object);
+}
+
+// ----------------------------------------------------------------------------
+
+void ReferenceCount::unconfine(const Object& object) throw () {
+    std::atomic<uint64_t>& word = object.m_references;
+    const uint32_t self = ThreadRecord::current().token();
+
+    uint64_t references = word.load(std::memory_order_acquire);
+    while (owner(references) != 0) {
+        const uint32_t token = owner(references);
+
+        // Our own count: only a thread switching it concurrently writes the
+        // word, and that thread retries when its compare-and-swap fails.
+        if (token == self) {
+            if (word.compare_exchange_weak(references, references & COUNT_MASK,
+              std::memory_order_acq_rel, std::memory_order_acquire))
+                return;
+            continue;
+        }
+
+        if ((references & REVOKING) == 0) {
+            if (!word.compare_exchange_weak(references, references | REVOKING,
+              std::memory_order_acq_rel, std::memory_order_acquire))
+                continue;
+            references |= REVOKING;
+        }
+
+        // Either the owner sees the mark before it stores a count again, or
+        // we see it in the middle of an update here, and wait it out.
+        ThreadRecord::asymmetricBarrier();
+        ThreadRecord* owner = ThreadRecord::forToken(token);
+        while (owner != 0 && owner->m_countedObject.load(std::memory_order_acquire) == &object &&
+          owner->token() == token)
+            sched_yield();
+
+        // Fails if the owner stored a count over the mark before it saw it;
+        // we then start over from that count.
+        if (word.compare_exchange_strong(references, references & COUNT_MASK,
+          std::memory_order_acq_rel, std::memory_order_acquire))
+            return;
+    }
+}
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
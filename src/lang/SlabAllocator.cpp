@@ -0,0 +1,309 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#include "decaf/lang/SlabAllocator.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+namespace {
+
+const size_t MAGAZINE_CAPACITY = 64;
+const size_t SLAB_SIZE = 64 * 1024;
+
+/*
+ * A stack of free blocks of one size class.
+ */
+struct Magazine {
+    bool isEmpty() const {
+        return m_count == 0;
+    }
+
+    bool isFull() const {
+        return m_count == MAGAZINE_CAPACITY;
+    }
+
+    void push(void* block) {
+        m_blocks[m_count++] = block;
+    }
+
+    void* pop() {
+        return m_blocks[--m_count];
+    }
+
+    size_t m_count;
+    Magazine* m_next;
+    void* m_blocks[MAGAZINE_CAPACITY];
+};
+
+/*
+ * The magazines of one size class that no thread holds, and the slab new
+ * blocks of that class are carved from. Depots live in static storage and
+ * must be usable before any constructor has run, hence the constant
+ * initialization.
+ */
+struct alignas(64) Depot {
+    /*
+     * Returns a magazine holding at least one block, carving a fresh one out
+     * of the slab if no thread gave one back.
+     */
+    Magazine* takeFull(size_t sizeClass) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        Magazine* magazine = m_full;
+        if (magazine != 0) {
+            m_full = magazine->m_next;
+            return magazine;
+        }
+
+        magazine = m_empty;
+        if (magazine != 0)
+            m_empty = magazine->m_next;
+        else
+            magazine = new Magazine();
+        while (!magazine->isFull())
+            magazine->push(carve(sizeClass));
+        return magazine;
+    }
+
+    /*
+     * Returns an empty magazine, or null if none is left and memory is
+     * exhausted.
+     */
+    Magazine* takeEmpty() {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        Magazine* magazine = m_empty;
+        if (magazine == 0)
+            return new (std::nothrow) Magazine();
+        m_empty = magazine->m_next;
+        return magazine;
+    }
+
+    void put(Magazine* magazine) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        Magazine*& list = magazine->isEmpty() ? m_empty : m_full;
+        magazine->m_next = list;
+        list = magazine;
+    }
+
+    /*
+     * Single-block operations, used by threads whose cache is gone.
+     */
+    void* takeOne(size_t sizeClass) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        Magazine* magazine = m_full;
+        if (magazine == 0)
+            return carve(sizeClass);
+
+        void* block = magazine->pop();
+        if (magazine->isEmpty()) {
+            m_full = magazine->m_next;
+            magazine->m_next = m_empty;
+            m_empty = magazine;
+        }
+        return block;
+    }
+
+    void putOne(void* block) {
+        std::lock_guard<std::mutex> guard(m_mutex);
+        Magazine* magazine = m_full;
+        if (magazine == 0 || magazine->isFull()) {
+            magazine = m_empty;
+            if (magazine != 0)
+                m_empty = magazine->m_next;
+            else if ((magazine = new (std::nothrow) Magazine()) == 0)
+                return;     // out of memory: the block is lost, not corrupted
+            magazine->m_next = m_full;
+            m_full = magazine;
+        }
+        magazine->push(block);
+    }
+
+    /*
+     * Returns a new block from the slab. Must be called with m_mutex held.
+     */
+    void* carve(size_t sizeClass) {
+        const size_t blockSize = (sizeClass + 1) * SlabAllocator::GRANULE;
+        if (m_slab == m_slabEnd) {
+            m_slab = static_cast<char*> (std::malloc(SLAB_SIZE));
+            if (m_slab == 0) {
+                m_slabEnd = 0;
+                throw std::bad_alloc();
+            }
+            m_slabEnd = m_slab + SLAB_SIZE / blockSize * blockSize;
+        }
+
+        void* block = m_slab;
+        m_slab += blockSize;
+        return block;
+    }
+
+    std::mutex m_mutex;
+    Magazine* m_full = 0;
+    Magazine* m_empty = 0;
+    char* m_slab = 0;
+    char* m_slabEnd = 0;
+};
+
+Depot s_depots[SlabAllocator::SIZE_CLASSES];
+
+/*
+ * The magazines held by a thread. Plain data, so that the fast paths need no
+ * thread_local initialization check.
+ */
+struct ThreadCache {
+    Magazine* m_loaded[SlabAllocator::SIZE_CLASSES];
+    Magazine* m_previous[SlabAllocator::SIZE_CLASSES];
+    bool m_attached;
+    bool m_detached;
+};
+
+thread_local ThreadCache t_cache;
+
+/**
+ * Hands the magazines of an exiting thread back to the depots. Objects
+ * deleted after that, by later thread_local destructors, go straight to the
+ * depots.
+ */
+class ThreadCacheFlusher {
+  public:
+    ThreadCacheFlusher() {
+        t_cache.m_attached = true;
+    }
+
+    ~ThreadCacheFlusher() {
+        for (size_t i = 0; i < SlabAllocator::SIZE_CLASSES; ++i) {
+            if (t_cache.m_loaded[i] != 0)
+                s_depots[i].put(t_cache.m_loaded[i]);
+            if (t_cache.m_previous[i] != 0)
+                s_depots[i].put(t_cache.m_previous[i]);
+            t_cache.m_loaded[i] = t_cache.m_previous[i] = 0;
+        }
+        t_cache.m_detached = true;
+    }
+};
+
+inline size_t sizeClassOf(size_t size) {
+    return (size == 0) ? 0 : (size - 1) / SlabAllocator::GRANULE;
+}
+
+inline void attach() {
+    static thread_local ThreadCacheFlusher t_flusher;
+}
+
+/*
+ * Slow path of allocate(): the loaded magazine is empty.
+ */
+void* refill(size_t sizeClass) {
+    Depot& depot = s_depots[sizeClass];
+    if (t_cache.m_detached)
+        return depot.takeOne(sizeClass);
+    if (!t_cache.m_attached)
+        attach();
+
+    Magazine*& loaded = t_cache.m_loaded[sizeClass];
+    Magazine*& previous = t_cache.m_previous[sizeClass];
+    if (previous != 0 && !previous->isEmpty()) {
+        std::swap(loaded, previous);
+    } else {
+        Magazine* full = depot.takeFull(sizeClass);
+        if (previous != 0)
+            depot.put(previous);
+        previous = loaded;
+        loaded = full;
+    }
+    return loaded->pop();
+}
+
+/*
+ * Slow path of deallocate(): the loaded magazine is full.
+ */
+void spill(void* block, size_t sizeClass) {
+    Depot& depot = s_depots[sizeClass];
+    if (t_cache.m_detached) {
+        depot.putOne(block);
+        return;
+    }
+    if (!t_cache.m_attached)
+        attach();
+
+    Magazine*& loaded = t_cache.m_loaded[sizeClass];
+    Magazine*& previous = t_cache.m_previous[sizeClass];
+    if (previous != 0 && previous->isEmpty()) {
+        std::swap(loaded, previous);
+    } else {
+        Magazine* empty = depot.takeEmpty();
+        if (empty == 0) {
+            depot.putOne(block);
+            return;
+        }
+        if (previous != 0)
+            depot.put(previous);
+        previous = loaded;
+        loaded = empty;
+    }
+    loaded->push(block);
+}
+
+}
+
+// ----------------------------------------------------------------------------
+
+void* SlabAllocator::allocate(size_t size) {
+    if (size > MAX_SIZE)
+        return ::operator new(size);
+
+    const size_t sizeClass = sizeClassOf(size);
+    Magazine* loaded = t_cache.m_loaded[sizeClass];
+    if (loaded != 0 && !loaded->isEmpty())
+        return loaded->pop();
+    return refill(sizeClass);
+}
+
+// ----------------------------------------------------------------------------
+
+void SlabAllocator::deallocate(void* block, size_t size) throw () {
+    if (block == 0)
+        return;
+    if (size > MAX_SIZE) {
+        ::operator delete(block);
+        return;
+    }
+
+    const size_t sizeClass = sizeClassOf(size);
+    Magazine* loaded = t_cache.m_loaded[sizeClass];
+    if (loaded != 0 && !loaded->isFull())
+        loaded->push(block);
+    else
+        spill(block, sizeClass);
+}
+
+// ----------------------------------------------------------------------------
+
+bool SlabAllocator::isEnabledForObjects() {
+#ifdef DECAF_SLAB_ALLOCATOR
+    return true;
+#else
+    return false;
+#endif
+}
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
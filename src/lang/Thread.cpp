@@ -0,0 +1,668 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <exception>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "decaf/lang/Error.hpp"
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/lang/IllegalThreadStateException.hpp"
+#include "decaf/lang/InterruptedException.hpp"
+#include "decaf/lang/ReferenceCount.hpp"
+#include "decaf/lang/System.hpp"
+#include "decaf/lang/Thread.hpp"
+#include "decaf/lang/Throwable.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+
+using detail::ReferenceCount;
+using detail::futexWait;
+using detail::futexWaitUntil;
+using detail::futexWake;
+
+namespace {
+
+const size_t MAX_SYSTEM_NAME = 15;
+const uint64_t NANOS_PER_MILLI = 1000000;
+const uint64_t NANOS_PER_SECOND = 1000000000;
+
+/*
+ * How long before its deadline sleep() stops waiting for an interrupt and
+ * leaves the rest to TimeUnit::sleepUntil(), which wakes up on time.
+ */
+const uint64_t INTERRUPTIBLE_SLEEP_MARGIN = 200000;
+
+std::atomic<uint64_t> s_nextId(1);
+std::atomic<uint32_t> s_threadNumber(0);
+
+/*
+ * The started threads that are not daemons and have not terminated yet,
+ * which the process waits for when it exits, and whether the calling thread
+ * is one of them.
+ */
+std::atomic<uint32_t> s_userThreads(0);
+pthread_once_t s_exitHook = PTHREAD_ONCE_INIT;
+DECAF_THREAD_LOCAL bool t_userThread DECAF_INITIAL_EXEC_TLS = false;
+
+void awaitUserThreads() {
+    const uint32_t self = t_userThread ? 1 : 0;
+    for (uint32_t count; (count = s_userThreads.load(std::memory_order_acquire)) > self; )
+        futexWait(s_userThreads, count);
+}
+
+void installExitHook() {
+    std::atexit(awaitUserThreads);
+}
+
+void userThreadTerminated() {
+    if (s_userThreads.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        futexWake(s_userThreads, INT_MAX);
+}
+
+std::string nextThreadName() {
+    return "Thread-" + std::to_string(s_threadNumber.fetch_add(1, std::memory_order_relaxed));
+}
+
+pid_t currentTid() {
+    return static_cast<pid_t> (syscall(SYS_gettid));
+}
+
+struct timespec* toTimespec(uint64_t nanos, struct timespec& time) {
+    time.tv_sec = static_cast<time_t> (nanos / NANOS_PER_SECOND);
+    time.tv_nsec = static_cast<long> (nanos % NANOS_PER_SECOND);
+    return &time;
+}
+
+uint64_t saturatingAdd(uint64_t lhs, uint64_t rhs) {
+    return (lhs > UINT64_MAX - rhs) ? UINT64_MAX : lhs + rhs;
+}
+
+uint64_t toNanos(uint64_t millis, uint64_t nanos) {
+    if (nanos >= NANOS_PER_MILLI)
+        throw IllegalArgumentException("nanosecond timeout value out of range");
+    return (millis > (UINT64_MAX - nanos) / NANOS_PER_MILLI) ? UINT64_MAX : millis * NANOS_PER_MILLI + nanos;
+}
+
+size_t roundStackSize(size_t stackSize) {
+    const size_t minimum = PTHREAD_STACK_MIN;
+    const size_t page = static_cast<size_t> (sysconf(_SC_PAGESIZE));
+    if (stackSize < minimum)
+        stackSize = minimum;
+    return (stackSize + page - 1) / page * page;
+}
+
+void toCpuSet(const std::vector<int>& cpus, cpu_set_t& set) {
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+            throw IllegalArgumentException("CPU " + std::to_string(cpu) + " is out of range");
+        CPU_SET(cpu, &set);
+    }
+}
+
+std::vector<int> fromCpuSet(const cpu_set_t& set) {
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set))
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+/*
+ * Adds the context switches of the live thread @a tid, which the kernel only
+ * reports to other threads through /proc.
+ */
+void readContextSwitches(pid_t tid, ThreadGroup::Usage& usage) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/self/task/%d/status", static_cast<int> (tid));
+    const int file = open(path, O_RDONLY | O_CLOEXEC);
+    if (file < 0)
+        return;
+    char status[4096];
+    const ssize_t length = read(file, status, sizeof(status) - 1);
+    close(file);
+    if (length <= 0)
+        return;
+    status[length] = '\0';
+
+    // The two counters close the file, the involuntary switches last.
+    const char* voluntary = std::strstr(status, "\nvoluntary_ctxt_switches:");
+    if (voluntary != 0) {
+        char* end;
+        usage.m_voluntarySwitches += std::strtoull(voluntary + 25, &end, 10);
+        const char* involuntary = std::strstr(end, "nonvoluntary_ctxt_switches:");
+        if (involuntary != 0)
+            usage.m_involuntarySwitches += std::strtoull(involuntary + 27, 0, 10);
+    }
+}
+
+/*
+ * Returns what the calling thread used, as it terminates.
+ */
+ThreadGroup::Usage finalUsage() {
+    ThreadGroup::Usage usage;
+    struct timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) == 0)
+        usage.m_cpuTimeNanos = static_cast<uint64_t> (time.tv_sec) * NANOS_PER_SECOND +
+          static_cast<uint64_t> (time.tv_nsec);
+    struct rusage resources;
+    if (getrusage(RUSAGE_THREAD, &resources) == 0) {
+        usage.m_voluntarySwitches = static_cast<uint64_t> (resources.ru_nvcsw);
+        usage.m_involuntarySwitches = static_cast<uint64_t> (resources.ru_nivcsw);
+    }
+    usage.m_terminatedThreads = 1;
+    return usage;
+}
+
+void reportUncaught(const Thread* thread, const std::string& what) {
+    std::fprintf(stderr, "Exception in thread \"%s\" %s\n", thread->getName().c_str(), what.c_str());
+}
+
+}
+
+/**
+ * Deletes the Thread object given to a thread that was not started through
+ * Thread, when that thread exits.
+ */
+class ThreadDetacher {
+  public:
+    ThreadDetacher() : m_thread(0) { }
+
+    ~ThreadDetacher() {
+        if (m_thread != 0)
+            Thread::detach(m_thread);
+    }
+
+    Thread* m_thread;
+};
+
+const int Thread::MIN_PRIORITY;
+const int Thread::NORM_PRIORITY;
+const int Thread::MAX_PRIORITY;
+
+DECAF_THREAD_LOCAL Thread* Thread::t_current DECAF_INITIAL_EXEC_TLS = 0;
+
+// ----------------------------------------------------------------------------
+
+Thread::Thread() : Thread(Ref<Runnable>(), nextThreadName(), 0) {
+}
+
+// ----------------------------------------------------------------------------
+
+Thread::Thread(const Ref<Runnable>& target) : Thread(target, nextThreadName(), 0) {
+}
+
+// ----------------------------------------------------------------------------
+
+Thread::Thread(const std::string& name) : Thread(Ref<Runnable>(), name, 0) {
+}
+
+// ----------------------------------------------------------------------------
+
+Thread::Thread(const Ref<Runnable>& target, const std::string& name, size_t stackSize) :
+  Thread(currentThread()->m_group, target, name, stackSize) {
+}
+
+// ----------------------------------------------------------------------------
+
+Thread::Thread(const Ref<ThreadGroup>& group, const Ref<Runnable>& target, const std::string& name,
+  size_t stackSize) : m_target(target), m_group(group), m_id(s_nextId.fetch_add(1, std::memory_order_relaxed)),
+  m_state(NEW), m_interrupted(0), m_blocker(0), m_daemon(false), m_managed(false), m_attached(false), m_lock(),
+  m_name(name), m_priority(NORM_PRIORITY), m_stackSize(stackSize), m_affinity(), m_handle(), m_tid(0),
+  m_groupPrevious(0), m_groupNext(0) {
+    if (!m_group)
+        throw IllegalArgumentException("thread group must not be null");
+    ReferenceCount::share(*m_group);
+    m_target.share();
+
+    const Thread* parent = currentThread();
+    m_daemon = parent->m_daemon;
+    m_priority = parent->getPriority();
+}
+
+// ----------------------------------------------------------------------------
+
+Thread::Thread(pid_t tid, const std::string& name) : m_target(), m_group(ThreadGroup::mainGroup()),
+  m_id(s_nextId.fetch_add(1, std::memory_order_relaxed)), m_state(ALIVE), m_interrupted(0), m_blocker(0),
+  m_daemon(false), m_managed(false), m_attached(true), m_lock(), m_name(name), m_priority(NORM_PRIORITY),
+  m_stackSize(0), m_affinity(), m_handle(pthread_self()), m_tid(tid), m_groupPrevious(0), m_groupNext(0) {
+    errno = 0;
+    const int nice = getpriority(PRIO_PROCESS, static_cast<id_t> (tid));
+    if (errno == 0)
+        m_priority = std::max(MIN_PRIORITY, std::min(MAX_PRIORITY, NORM_PRIORITY - nice));
+}
+
+// ----------------------------------------------------------------------------
+
+Thread::~Thread() {
+    // A thread managed by a Ref holds a reference to itself while it runs.
+    if (!m_attached && !m_managed && t_current != this)
+        joinUntil(UINT64_MAX, false);
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::Run() {
+    if (m_target)
+        m_target->Run();
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::start() {
+    uint32_t state = NEW;
+    if (!m_state.compare_exchange_strong(state, ALIVE, std::memory_order_acq_rel))
+        throw IllegalThreadStateException("thread " + getName() + " was already started");
+
+    m_managed = ReferenceCount::isManaged(*this);
+    if (m_managed) {
+        try {
+            ReferenceCount::share(*this);
+        } catch (...) {
+            m_state.store(NEW, std::memory_order_release);
+            throw;
+        }
+        ReferenceCount::retain(*this);
+    }
+    if (!m_daemon) {
+        pthread_once(&s_exitHook, installExitHook);
+        s_userThreads.fetch_add(1, std::memory_order_relaxed);
+    }
+    const std::vector<int> groupCpus = m_group->getAffinity();
+    m_group->add(this);
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    int result;
+    {
+        // Held until m_handle is set: the new thread takes the lock first.
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (m_affinity.empty())
+            m_affinity = groupCpus;
+        if (m_stackSize != 0)
+            pthread_attr_setstacksize(&attributes, roundStackSize(m_stackSize));
+        if (!m_affinity.empty()) {
+            cpu_set_t cpus;
+            toCpuSet(m_affinity, cpus);
+            pthread_attr_setaffinity_np(&attributes, sizeof(cpus), &cpus);
+        }
+        result = pthread_create(&m_handle, &attributes, threadMain, this);
+    }
+    pthread_attr_destroy(&attributes);
+
+    if (result != 0) {
+        m_group->remove(this, 0);
+        if (!m_daemon)
+            userThreadTerminated();
+        m_state.store(NEW, std::memory_order_release);
+        if (m_managed)
+            ReferenceCount::release(*this);
+        if (result == EINVAL && !m_affinity.empty())
+            throw IllegalArgumentException("thread " + getName() + " cannot run on any of its CPUs");
+        throw Error("cannot create thread " + getName() + ": " + std::strerror(result));
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void* Thread::threadMain(void* argument) {
+    Thread* thread = static_cast<Thread*> (argument);
+    t_current = thread;
+    t_userThread = !thread->m_daemon;
+    {
+        std::lock_guard<std::mutex> guard(thread->m_lock);
+        thread->m_tid = currentTid();
+        thread->applyName();
+        thread->applyPriority();
+
+        // Pinned at creation already, unless changed since start().
+        if (!thread->m_affinity.empty()) {
+            cpu_set_t cpus;
+            toCpuSet(thread->m_affinity, cpus);
+            sched_setaffinity(0, sizeof(cpus), &cpus);
+        }
+    }
+
+    // Also runs when the thread is cancelled or calls pthread_exit().
+    struct Terminator {
+        ~Terminator() {
+            m_thread->exit();
+        }
+        Thread* m_thread;
+    } terminator = { thread };
+
+    try {
+        thread->Run();
+    } catch (abi::__forced_unwind&) {
+        throw;
+    } catch (const Throwable& e) {
+        reportUncaught(thread, e.toString());
+    } catch (const std::exception& e) {
+        reportUncaught(thread, e.what());
+    } catch (...) {
+        reportUncaught(thread, "unknown exception");
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::exit() {
+    const ThreadGroup::Usage usage = finalUsage();
+    m_group->remove(this, &usage);
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_tid = 0;
+    }
+    t_current = 0;
+
+    const bool userThread = t_userThread;
+    const bool managed = m_managed;
+    t_userThread = false;
+
+    // Unless managed, the object may be destroyed as soon as a joiner sees
+    // the thread terminated; the futex wake on a stale address is harmless.
+    if ((m_state.exchange(TERMINATED, std::memory_order_acq_rel) & JOINING) != 0)
+        futexWake(m_state, INT_MAX);
+    if (userThread)
+        userThreadTerminated();
+    if (managed)
+        ReferenceCount::release(*this);
+}
+
+// ----------------------------------------------------------------------------
+
+Thread* Thread::attach() {
+    static thread_local ThreadDetacher t_detacher;
+
+    const pid_t tid = currentTid();
+    Thread* thread = new Thread(tid, (tid == getpid()) ? std::string("main") : nextThreadName());
+    t_detacher.m_thread = thread;
+    t_current = thread;
+    thread->m_group->add(thread);
+    return thread;
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::detach(Thread* thread) {
+    t_current = 0;
+    const ThreadGroup::Usage usage = finalUsage();
+    thread->m_group->remove(thread, &usage);
+    {
+        std::lock_guard<std::mutex> guard(thread->m_lock);
+        thread->m_tid = 0;
+    }
+    thread->m_state.store(TERMINATED, std::memory_order_release);
+    delete thread;
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::join() {
+    joinUntil(UINT64_MAX, true);
+}
+
+// ----------------------------------------------------------------------------
+
+bool Thread::join(uint64_t millis, uint64_t nanos) {
+    const uint64_t timeout = toNanos(millis, nanos);
+    return joinUntil((timeout == 0) ? UINT64_MAX : saturatingAdd(System::nanoTime(), timeout), true);
+}
+
+// ----------------------------------------------------------------------------
+
+bool Thread::joinUntil(uint64_t deadline, bool interruptible) {
+    struct timespec time;
+    const struct timespec* until = (deadline != UINT64_MAX) ? toTimespec(deadline, time) : 0;
+    Thread* self = interruptible ? currentThread() : 0;
+    if (self != 0)
+        self->checkInterrupted("join");
+
+    uint32_t state = m_state.load(std::memory_order_acquire);
+    while ((state & STATE_MASK) == ALIVE) {
+        if ((state & JOINING) == 0 && !m_state.compare_exchange_weak(state, state | JOINING,
+          std::memory_order_acquire))
+            continue;
+
+        // Pairs with interrupt(): either the blocker is seen there, or the
+        // interrupt status here.
+        if (self != 0) {
+            self->m_blocker.store(&m_state, std::memory_order_seq_cst);
+            if (self->m_interrupted.load(std::memory_order_seq_cst) != 0) {
+                self->m_blocker.store(0, std::memory_order_relaxed);
+                self->checkInterrupted("join");
+            }
+        }
+        const bool woken = futexWaitUntil(m_state, state | JOINING, until);
+        if (self != 0) {
+            self->m_blocker.store(0, std::memory_order_relaxed);
+            self->checkInterrupted("join");
+        }
+        if (!woken)
+            return (m_state.load(std::memory_order_acquire) & STATE_MASK) != ALIVE;
+        state = m_state.load(std::memory_order_acquire);
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::interrupt() {
+    m_interrupted.store(1, std::memory_order_seq_cst);
+    futexWake(m_interrupted, INT_MAX);
+
+    std::atomic<uint32_t>* blocker = m_blocker.load(std::memory_order_seq_cst);
+    if (blocker != 0)
+        futexWake(*blocker, INT_MAX);
+}
+
+// ----------------------------------------------------------------------------
+
+bool Thread::interrupted() {
+    return currentThread()->m_interrupted.exchange(0, std::memory_order_acq_rel) != 0;
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::checkInterrupted(const char* what) {
+    if (m_interrupted.load(std::memory_order_relaxed) != 0 &&
+      m_interrupted.exchange(0, std::memory_order_acq_rel) != 0)
+        throw InterruptedException(std::string(what) + " interrupted");
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::sampleUsage(ThreadGroup::Usage& usage) const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    usage.m_activeThreads++;
+    if (m_tid == 0)
+        return;
+
+    clockid_t clock;
+    struct timespec time;
+    if (pthread_getcpuclockid(m_handle, &clock) == 0 && clock_gettime(clock, &time) == 0)
+        usage.m_cpuTimeNanos += static_cast<uint64_t> (time.tv_sec) * NANOS_PER_SECOND +
+          static_cast<uint64_t> (time.tv_nsec);
+    readContextSwitches(m_tid, usage);
+}
+
+// ----------------------------------------------------------------------------
+
+bool Thread::isAlive() const {
+    return (m_state.load(std::memory_order_acquire) & STATE_MASK) == ALIVE;
+}
+
+// ----------------------------------------------------------------------------
+
+std::string Thread::getName() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_name;
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::setName(const std::string& name) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_name = name;
+    if (m_tid != 0)
+        applyName();
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::applyName() {
+    pthread_setname_np(m_handle, m_name.substr(0, MAX_SYSTEM_NAME).c_str());
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::setDaemon(bool on) {
+    if ((m_state.load(std::memory_order_acquire) & STATE_MASK) != NEW)
+        throw IllegalThreadStateException("thread " + getName() + " was already started");
+    m_daemon = on;
+}
+
+// ----------------------------------------------------------------------------
+
+int Thread::getPriority() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_priority;
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::setPriority(int priority) {
+    if (priority < MIN_PRIORITY || priority > MAX_PRIORITY)
+        throw IllegalArgumentException("priority " + std::to_string(priority) + " is out of range");
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_priority = priority;
+    if (m_tid != 0)
+        applyPriority();
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::applyPriority() {
+    // Threads start with the nice value of the thread that started them,
+    // which is likely the one wanted already.
+    const id_t tid = static_cast<id_t> (m_tid);
+    const int nice = NORM_PRIORITY - m_priority;
+    errno = 0;
+    if (getpriority(PRIO_PROCESS, tid) != nice || errno != 0)
+        setpriority(PRIO_PROCESS, tid, nice);
+}
+
+// ----------------------------------------------------------------------------
+
+size_t Thread::getStackSize() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_stackSize;
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::setStackSize(size_t stackSize) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    if ((m_state.load(std::memory_order_acquire) & STATE_MASK) != NEW)
+        throw IllegalThreadStateException("thread " + m_name + " was already started");
+    m_stackSize = stackSize;
+}
+
+// ----------------------------------------------------------------------------
+
+std::vector<int> Thread::getAffinity() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_tid == 0)
+        return m_affinity;
+
+    cpu_set_t cpus;
+    if (sched_getaffinity(m_tid, sizeof(cpus), &cpus) != 0)
+        return m_affinity;
+    return fromCpuSet(cpus);
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::setAffinity(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    toCpuSet(cpus, set);
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_tid != 0) {
+        if (cpus.empty())
+            throw IllegalArgumentException("a running thread needs at least one CPU");
+        if (sched_setaffinity(m_tid, sizeof(set), &set) != 0)
+            throw IllegalArgumentException("cannot pin thread " + m_name + ": " + std::strerror(errno));
+    }
+    m_affinity = cpus;
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::setAffinity(int cpu) {
+    setAffinity(std::vector<int>(1, cpu));
+}
+
+// ----------------------------------------------------------------------------
+
+std::string Thread::toString() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    return "Thread[" + m_name + "," + std::to_string(m_priority) + "," + m_group->getName() + "]";
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::yield() {
+    sched_yield();
+}
+
+// ----------------------------------------------------------------------------
+
+void Thread::sleep(uint64_t millis, uint64_t nanos) {
+    const uint64_t timeout = toNanos(millis, nanos);
+    Thread* self = currentThread();
+    self->checkInterrupted("sleep");
+
+    const uint64_t deadline = saturatingAdd(System::nanoTime(), timeout);
+    struct timespec time;
+    while (System::nanoTime() + INTERRUPTIBLE_SLEEP_MARGIN < deadline) {
+        futexWaitUntil(self->m_interrupted, 0, toTimespec(deadline - INTERRUPTIBLE_SLEEP_MARGIN, time));
+        self->checkInterrupted("sleep");
+    }
+    util::concurrent::TimeUnit::sleepUntil(util::concurrent::Deadline::at(deadline));
+}
+
+DECAF_CLOSE_NAMESPACE2
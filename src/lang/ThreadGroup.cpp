@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/lang/ReferenceCount.hpp"
+#include "decaf/lang/Thread.hpp"
+#include "decaf/lang/ThreadGroup.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+
+using detail::ReferenceCount;
+
+// ----------------------------------------------------------------------------
+
+void ThreadGroup::Usage::add(const Usage& other) {
+    m_cpuTimeNanos += other.m_cpuTimeNanos;
+    m_voluntarySwitches += other.m_voluntarySwitches;
+    m_involuntarySwitches += other.m_involuntarySwitches;
+    m_activeThreads += other.m_activeThreads;
+    m_terminatedThreads += other.m_terminatedThreads;
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadGroup::ThreadGroup() : m_name("main"), m_parent(0), m_lock(), m_children(), m_threads(0), m_affinity(),
+  m_retired() {
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadGroup::ThreadGroup(const std::string& name) : ThreadGroup(Thread::currentThread()->m_group, name) {
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadGroup::ThreadGroup(const Ref<ThreadGroup>& parent, const std::string& name) : m_name(name),
+  m_parent(parent.get()), m_lock(), m_children(), m_threads(0), m_affinity(), m_retired() {
+    if (m_parent == 0)
+        throw IllegalArgumentException("parent group must not be null");
+    ReferenceCount::share(*m_parent);
+    ReferenceCount::retain(*m_parent);
+    attach();
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadGroup::~ThreadGroup() {
+    // Threads and subgroups hold references to their group: this one is
+    // empty, and only needs to hand its accounting over to its parent.
+    if (m_parent != 0) {
+        {
+            std::lock_guard<std::mutex> guard(m_parent->m_lock);
+            std::vector<ThreadGroup*>& siblings = m_parent->m_children;
+            siblings.erase(std::find(siblings.begin(), siblings.end(), this));
+            m_parent->m_retired.add(m_retired);
+        }
+        ReferenceCount::release(*m_parent);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadGroup::attach() {
+    std::lock_guard<std::mutex> guard(m_parent->m_lock);
+    m_parent->m_children.push_back(this);
+}
+
+// ----------------------------------------------------------------------------
+
+bool ThreadGroup::parentOf(const ThreadGroup* group) const {
+    for (; group != 0; group = group->m_parent) {
+        if (group == this)
+            return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+uint32_t ThreadGroup::activeCount() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    uint32_t count = 0;
+    for (const Thread* thread = m_threads; thread != 0; thread = thread->m_groupNext)
+        ++count;
+    for (const ThreadGroup* child : m_children)
+        count += child->activeCount();
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+
+uint32_t ThreadGroup::activeGroupCount() const {
+    std::lock_guard<std::mutex> guard(m_lock);
+    uint32_t count = static_cast<uint32_t> (m_children.size());
+    for (const ThreadGroup* child : m_children)
+        count += child->activeGroupCount();
+    return count;
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadGroup::Usage ThreadGroup::getUsage() const {
+    Usage usage;
+    collect(usage);
+    return usage;
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadGroup::collect(Usage& usage) const {
+    // A subgroup being destroyed waits for this lock before it hands its
+    // accounting over, so it is counted exactly once.
+    std::lock_guard<std::mutex> guard(m_lock);
+    usage.add(m_retired);
+    for (const Thread* thread = m_threads; thread != 0; thread = thread->m_groupNext)
+        thread->sampleUsage(usage);
+    for (const ThreadGroup* child : m_children)
+        child->collect(usage);
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadGroup::setAffinity(const std::vector<int>& cpus) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (!cpus.empty()) {
+        for (Thread* thread = m_threads; thread != 0; thread = thread->m_groupNext)
+            thread->setAffinity(cpus);
+    }
+    m_affinity = cpus;
+    for (ThreadGroup* child : m_children)
+        child->setAffinity(cpus);
+}
+
+// ----------------------------------------------------------------------------
+
+std::vector<int> ThreadGroup::getAffinity() const {
+    for (const ThreadGroup* group = this; group != 0; group = group->m_parent) {
+        std::lock_guard<std::mutex> guard(group->m_lock);
+        if (!group->m_affinity.empty())
+            return group->m_affinity;
+    }
+    return std::vector<int>();
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadGroup::interrupt() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    for (Thread* thread = m_threads; thread != 0; thread = thread->m_groupNext)
+        thread->interrupt();
+    for (ThreadGroup* child : m_children)
+        child->interrupt();
+}
+
+// ----------------------------------------------------------------------------
+
+std::string ThreadGroup::toString() const {
+    return "ThreadGroup[name=" + m_name + "]";
+}
+
+// ----------------------------------------------------------------------------
+
+const Ref<ThreadGroup>& ThreadGroup::mainGroup() {
+    // Never destroyed: threads may still attach while the process exits.
+    static const Ref<ThreadGroup>* s_main = new Ref<ThreadGroup>(Ref<ThreadGroup>(new ThreadGroup()).share());
+    return *s_main;
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadGroup::add(Thread* thread) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    thread->m_groupPrevious = 0;
+    thread->m_groupNext = m_threads;
+    if (m_threads != 0)
+        m_threads->m_groupPrevious = thread;
+    m_threads = thread;
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadGroup::remove(Thread* thread, const Usage* usage) {
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (thread->m_groupPrevious != 0)
+        thread->m_groupPrevious->m_groupNext = thread->m_groupNext;
+    else
+        m_threads = thread->m_groupNext;
+    if (thread->m_groupNext != 0)
+        thread->m_groupNext->m_groupPrevious = thread->m_groupPrevious;
+    thread->m_groupPrevious = 0;
+    thread->m_groupNext = 0;
+
+    if (usage != 0)
+        m_retired.add(*usage);
+}
+
+DECAF_CLOSE_NAMESPACE2
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <linux/membarrier.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "decaf/lang/ThreadRecord.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+namespace {
+
+/*
+ * Records are never freed; exiting threads push theirs here so the next
+ * thread can reuse both the memory and the identifier.
+ */
+pthread_mutex_t s_registryMutex = PTHREAD_MUTEX_INITIALIZER;
+ThreadRecord* s_freeRecords = 0;
+uint32_t s_nextId = 1;
+
+}
+
+/**
+ * Hands the record of an exiting thread back to the registry.
+ */
+class ThreadRecordDetacher {
+  public:
+    ThreadRecordDetacher() : m_record(0) { }
+
+    ~ThreadRecordDetacher() {
+        if (m_record != 0)
+            ThreadRecord::detach(m_record);
+    }
+
+    ThreadRecord* m_record;
+};
+
+DECAF_THREAD_LOCAL ThreadRecord* ThreadRecord::t_current DECAF_INITIAL_EXEC_TLS = 0;
+std::atomic<ThreadRecord*> ThreadRecord::s_records[ThreadRecord::MAX_INDEXED_IDS];
+
+// ----------------------------------------------------------------------------
+
+ThreadRecord::ThreadRecord(uint32_t id) : m_thinSpin(), m_countedObject(0), m_nextSeed(0),
+  m_seedLimit(0), m_id(id), m_generation(0), m_token(0), m_nextFree(0) {
+    for (size_t i = 0; i < MAX_BIASED_LOCKS; ++i) {
+        m_biasedLocks[i].m_object.store(0, std::memory_order_relaxed);
+        m_biasedLocks[i].m_count.store(0, std::memory_order_relaxed);
+    }
+    if (id < MAX_INDEXED_IDS)
+        s_records[id].store(this, std::memory_order_release);
+}
+
+// ----------------------------------------------------------------------------
+
+bool ThreadRecord::mightHoldBiasedLock(const void* object) const {
+    for (size_t i = 0; i < MAX_BIASED_LOCKS; ++i) {
+        const BiasedLock& lock = m_biasedLocks[i];
+
+        // The owner publishes the object before the count of a fresh entry;
+        // reading the object again tells us the count we saw belongs to it.
+        if (lock.m_object.load(std::memory_order_acquire) == object &&
+          lock.m_count.load(std::memory_order_acquire) > 0 &&
+          lock.m_object.load(std::memory_order_acquire) == object)
+            return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+
+bool ThreadRecord::hasAsymmetricBarrier() {
+    static const bool available = []() {
+        const long commands = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+        return (commands > 0 && (commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED) != 0 &&
+          syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0);
+    }();
+    return available;
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadRecord::asymmetricBarrier() {
+    syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+}
+
+// ----------------------------------------------------------------------------
+
+ThreadRecord& ThreadRecord::attach() {
+    static thread_local ThreadRecordDetacher t_detacher;
+
+    pthread_mutex_lock(&s_registryMutex);
+    ThreadRecord* record = s_freeRecords;
+    if (record != 0)
+        s_freeRecords = record->m_nextFree;
+    else
+        record = new ThreadRecord(s_nextId++);
+    const uint32_t generation = ++record->m_generation & 0xffff;
+    pthread_mutex_unlock(&s_registryMutex);
+
+    record->m_nextFree = 0;
+    if (record->m_id < MAX_INDEXED_IDS)
+        record->m_token.store((generation << 16) | record->m_id, std::memory_order_release);
+    t_detacher.m_record = record;
+    t_current = record;
+    return *record;
+}
+
+// ----------------------------------------------------------------------------
+
+void ThreadRecord::detach(ThreadRecord* record) {
+    t_current = 0;
+    record->m_token.store(0, std::memory_order_release);
+
+    pthread_mutex_lock(&s_registryMutex);
+    record->m_nextFree = s_freeRecords;
+    s_freeRecords = record;
+    pthread_mutex_unlock(&s_registryMutex);
+}
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sched.h>
+
+#include "decaf/lang/TscClock.hpp"
+
+#ifdef DECAF_HAS_TSC_CLOCK
+
+#include <cpuid.h>
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+namespace {
+
+/*
+ * How long CLOCK_MONOTONIC is sampled against the TSC before the first
+ * segment, which is as long. Later segments double in length up to the
+ * maximum.
+ */
+const uint64_t WARM_UP_NANOS = 10000000;
+const uint64_t MAX_SEGMENT_NANOS = 1000000000;
+
+/*
+ * How far in the future a new segment starts, and how far before its start
+ * its publication must be done, or it is given up until the next read.
+ */
+const uint64_t SEGMENT_LEAD_NANOS = 1000000;
+const uint64_t PUBLICATION_MARGIN_NANOS = 500000;
+
+/*
+ * Added to the first segment, so that it cannot start behind a reading of
+ * CLOCK_MONOTONIC returned during the warm-up.
+ */
+const uint64_t HANDOVER_NANOS = 1000;
+
+/*
+ * A clock that got ahead of CLOCK_MONOTONIC runs at most 1/SLEW_DIVISOR
+ * slower than it to catch up. A large offset thus takes several segments to
+ * absorb, but a reader racing with a publication sees at most a negligible
+ * difference between the two segments.
+ */
+const uint64_t SLEW_DIVISOR = 1024;
+
+enum Status { UNKNOWN, WARMING_UP, CALIBRATED, UNUSABLE };
+
+std::atomic<int> s_status(UNKNOWN);
+std::atomic<bool> s_calibrating(false);
+
+/*
+ * The last sample of CLOCK_MONOTONIC against the TSC and the length of the
+ * next segment. Calibrating thread only.
+ */
+uint64_t s_sampleTsc;
+uint64_t s_sampleNanos;
+uint64_t s_segmentNanos;
+
+/*
+ * Returns true if the TSC ticks at a constant rate, in sync across cores.
+ * Hypervisors often hide the invariant TSC flag from their guests, so the
+ * clock source the kernel settled on counts as well.
+ */
+bool isTscInvariant() {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) != 0 && (edx & (1u << 8)) != 0)
+        return true;
+
+    char source[32] = "";
+    FILE* file = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+    if (file != 0) {
+        if (fgets(source, sizeof(source), file) == 0)
+            source[0] = '\0';
+        fclose(file);
+    }
+    return strcmp(source, "tsc\n") == 0;
+}
+
+/*
+ * Samples CLOCK_MONOTONIC and the TSC at the same time, give or take the
+ * tightest bracket of a few tries.
+ */
+void sample(uint64_t& tsc, uint64_t& nanos) {
+    uint64_t best = UINT64_MAX;
+    tsc = 0;
+    nanos = 0;
+    for (int i = 0; i < 4; ++i) {
+        const uint64_t before = __builtin_ia32_rdtsc();
+        const uint64_t reading = monotonicNanos();
+        const uint64_t after = __builtin_ia32_rdtsc();
+        if (after - before < best) {
+            best = after - before;
+            tsc = before + best / 2;
+            nanos = reading;
+        }
+    }
+}
+
+/*
+ * Returns the nanoseconds per tick, in 32.32 fixed point, of the given
+ * numbers of nanoseconds and ticks, and the number of ticks in the given
+ * nanoseconds at such a scale.
+ */
+uint64_t scaleOf(uint64_t nanos, uint64_t ticks) {
+    return static_cast<uint64_t> ((static_cast<unsigned __int128> (nanos) << 32) / std::max<uint64_t>(ticks, 1));
+}
+
+uint64_t ticksOf(uint64_t nanos, uint64_t scale) {
+    return static_cast<uint64_t> ((static_cast<unsigned __int128> (nanos) << 32) / std::max<uint64_t>(scale, 1));
+}
+
+}
+
+TscClock::Segments TscClock::s_segments;
+
+// -----------------------------------------------------------------------------
+
+bool TscClock::isTscUsed() {
+    while (s_status.load(std::memory_order_acquire) != CALIBRATED) {
+        if (s_status.load(std::memory_order_acquire) == UNUSABLE)
+            return false;
+        now();
+        sched_yield();
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t TscClock::slowNow() {
+    if (s_status.load(std::memory_order_acquire) == UNUSABLE)
+        return monotonicNanos();
+
+    if (!s_calibrating.exchange(true, std::memory_order_acquire)) {
+        calibrate();
+        s_calibrating.store(false, std::memory_order_release);
+    }
+
+    // Another thread may be calibrating: extrapolate the current segment past
+    // its end rather than wait.
+    uint64_t tsc;
+    uint64_t nanos;
+    if (s_status.load(std::memory_order_acquire) != CALIBRATED)
+        return monotonicNanos();
+    read(tsc, nanos);
+    return nanos;
+}
+
+// -----------------------------------------------------------------------------
+
+void TscClock::calibrate() {
+    const int status = s_status.load(std::memory_order_relaxed);
+    if (status == UNKNOWN) {
+        if (!isTscInvariant()) {
+            s_status.store(UNUSABLE, std::memory_order_release);
+            return;
+        }
+        sample(s_sampleTsc, s_sampleNanos);
+        s_segmentNanos = WARM_UP_NANOS;
+        s_status.store(WARMING_UP, std::memory_order_release);
+        return;
+    }
+
+    uint64_t tsc;
+    uint64_t nanos;
+    sample(tsc, nanos);
+    if (tsc <= s_sampleTsc || nanos - s_sampleNanos < WARM_UP_NANOS)
+        return;
+
+    // The rate of CLOCK_MONOTONIC since the last sample, and where it will be
+    // at the start of the new segment.
+    const uint64_t rate = scaleOf(nanos - s_sampleNanos, tsc - s_sampleTsc);
+    const uint64_t start = tsc + ticksOf(SEGMENT_LEAD_NANOS, rate);
+    const uint64_t length = ticksOf(s_segmentNanos, rate);
+    const uint64_t projected = extrapolate(start, tsc, nanos, rate);
+
+    const uint64_t generation = s_segments.m_generation.load(std::memory_order_relaxed);
+    const Segment& current = s_segments.m_slots[generation & 1];
+    uint64_t previousStart = current.m_start.load(std::memory_order_relaxed);
+    uint64_t previousBase = current.m_base.load(std::memory_order_relaxed);
+    uint64_t previousScale = current.m_scale.load(std::memory_order_relaxed);
+
+    uint64_t base = projected;
+    uint64_t scale = rate;
+    if (status == WARMING_UP) {
+        base += HANDOVER_NANOS;
+        previousStart = tsc;
+        previousBase = nanos + HANDOVER_NANOS;
+        previousScale = rate;
+    } else {
+        // Step forward onto CLOCK_MONOTONIC if behind, slew back if ahead.
+        const uint64_t reading = extrapolate(start, previousStart, previousBase, previousScale);
+        if (reading > projected) {
+            const uint64_t slew = scaleOf(reading - projected, length);
+            base = reading;
+            scale = rate - std::min(slew, rate / SLEW_DIVISOR);
+        }
+    }
+
+    if (__builtin_ia32_rdtsc() + ticksOf(PUBLICATION_MARGIN_NANOS, rate) >= start)
+        return;
+
+    // Readers of the generation before the current one may still read the
+    // slot: order the publication of the current one before our stores, so
+    // that they see the generation move on if they see any of them.
+    std::atomic_thread_fence(std::memory_order_release);
+    Segment& next = s_segments.m_slots[(generation + 1) & 1];
+    next.m_start.store(start, std::memory_order_relaxed);
+    next.m_base.store(base, std::memory_order_relaxed);
+    next.m_scale.store(scale, std::memory_order_relaxed);
+    next.m_previousStart.store(previousStart, std::memory_order_relaxed);
+    next.m_previousBase.store(previousBase, std::memory_order_relaxed);
+    next.m_previousScale.store(previousScale, std::memory_order_relaxed);
+    next.m_end.store(start + length, std::memory_order_relaxed);
+    s_segments.m_generation.store(generation + 1, std::memory_order_release);
+
+    s_sampleTsc = tsc;
+    s_sampleNanos = nanos;
+    s_segmentNanos = std::min(s_segmentNanos * 2, MAX_SEGMENT_NANOS);
+    s_status.store(CALIBRATED, std::memory_order_release);
+}
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
+
+#endif
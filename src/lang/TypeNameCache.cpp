@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cxxabi.h>
+
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/lang/TypeNameCache.hpp"
+
+DECAF_OPEN_NAMESPACE2(decaf, lang)
+DECAF_OPEN_NAMESPACE(detail)
+
+using std::string;
+
+namespace {
+
+struct Slot {
+    std::atomic<const std::type_info*> m_type;
+    std::atomic<const string*> m_name;
+};
+
+/*
+ * One link of the chain. Once three quarters of its slots are taken, new types
+ * go to the next, twice as large, table; lookups walk the chain until they
+ * find the type or an empty slot in the last table.
+ */
+struct Table {
+    explicit Table(size_t capacity) : m_mask(capacity - 1), m_slots(new Slot[capacity]),
+      m_size(0), m_next(0) {
+        for (size_t i = 0; i < capacity; ++i) {
+            m_slots[i].m_type.store(0, std::memory_order_relaxed);
+            m_slots[i].m_name.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    bool isFull() const {
+        return (m_size.load(std::memory_order_relaxed) >= (m_mask + 1) / 4 * 3);
+    }
+
+    Table* next() {
+        Table* next = m_next.load(std::memory_order_acquire);
+        if (next == 0) {
+            Table* grown = new Table((m_mask + 1) * 2);
+            if (m_next.compare_exchange_strong(next, grown, std::memory_order_acq_rel))
+                next = grown;
+            else
+                delete grown;
+        }
+        return next;
+    }
+
+    const size_t m_mask;
+    Slot* const m_slots;
+    std::atomic<size_t> m_size;
+    std::atomic<Table*> m_next;
+};
+
+size_t slotOf(const std::type_info& type, size_t mask) {
+    return ((reinterpret_cast<uintptr_t> (&type) >> 4) * 0x9e3779b97f4a7c15ull >> 40) & mask;
+}
+
+const string* demangle(const std::type_info& type) {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), 0, 0, &status);
+    const string* name = new string((status == 0 && demangled != 0) ? demangled : type.name());
+    free(demangled);
+    return name;
+}
+
+const string& awaitName(Slot& slot) {
+    const string* name;
+    while ((name = slot.m_name.load(std::memory_order_acquire)) == 0)
+        cpuRelax();
+    return *name;
+}
+
+}
+
+// ----------------------------------------------------------------------------
+
+const string& TypeNameCache::nameOf(const std::type_info& type) {
+    static Table s_root(256);
+
+    Table* table = &s_root;
+    for (;;) {
+        for (size_t i = slotOf(type, table->m_mask), probes = 0; probes <= table->m_mask;
+          i = (i + 1) & table->m_mask, ++probes) {
+            Slot& slot = table->m_slots[i];
+            const std::type_info* key = slot.m_type.load(std::memory_order_acquire);
+
+            if (key == &type)
+                return awaitName(slot);
+            if (key != 0)
+                continue;
+
+            if (table->isFull())
+                break;
+            if (!slot.m_type.compare_exchange_strong(key, &type, std::memory_order_acq_rel)) {
+                if (key == &type)
+                    return awaitName(slot);
+                continue;
+            }
+
+            table->m_size.fetch_add(1, std::memory_order_relaxed);
+            const string* name = demangle(type);
+            slot.m_name.store(name, std::memory_order_release);
+            return *name;
+        }
+        table = table->next();
+    }
+}
+
+DECAF_CLOSE_NAMESPACE
+DECAF_CLOSE_NAMESPACE2
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <climits>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/util/concurrent/CountDownLatch.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+using decaf::lang::detail::futexWaitUntil;
+using decaf::lang::detail::futexWake;
+
+CountDownLatch::CountDownLatch(int32_t count) : m_count(static_cast<uint32_t> (count)), m_waiters(0) {
+    if (count < 0)
+        throw lang::IllegalArgumentException("count must not be negative");
+}
+
+// -----------------------------------------------------------------------------
+
+CountDownLatch::~CountDownLatch() {
+}
+
+// -----------------------------------------------------------------------------
+
+void CountDownLatch::await() {
+    awaitUntil(Deadline::never());
+}
+
+// -----------------------------------------------------------------------------
+
+bool CountDownLatch::await(const uint64_t& timeout, const TimeUnit* unit) {
+    return awaitUntil(Deadline::after(timeout, unit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool CountDownLatch::awaitUntil(const Deadline& deadline) {
+    if (m_count.load(std::memory_order_acquire) == 0)
+        return true;
+
+    struct timespec time;
+    const struct timespec* until = deadline.toTimespec(time);
+
+    // Pairs with countDown(): either the waiter is seen here, or it sees the
+    // count at zero.
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+    bool released = true;
+    for (uint32_t count; (count = m_count.load(std::memory_order_seq_cst)) != 0; ) {
+        if (!futexWaitUntil(m_count, count, until)) {
+            released = (m_count.load(std::memory_order_acquire) == 0);
+            break;
+        }
+    }
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    return released;
+}
+
+// -----------------------------------------------------------------------------
+
+void CountDownLatch::countDown() {
+    uint32_t count = m_count.load(std::memory_order_relaxed);
+    do {
+        if (count == 0)
+            return;
+    } while (!m_count.compare_exchange_weak(count, count - 1, std::memory_order_seq_cst));
+
+    if (count == 1 && m_waiters.load(std::memory_order_seq_cst) != 0)
+        futexWake(m_count, INT_MAX);
+}
+
+// -----------------------------------------------------------------------------
+
+std::string CountDownLatch::toString() const {
+    return Object::toString() + "[Count = " + std::to_string(getCount()) + "]";
+}
+
+DECAF_CLOSE_NAMESPACE3
@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <climits>
+#include <cstdlib>
+#include <new>
+#include <sched.h>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/lang/ThreadRecord.hpp"
+#include "decaf/util/concurrent/BrokenBarrierException.hpp"
+#include "decaf/util/concurrent/CyclicBarrier.hpp"
+#include "decaf/util/concurrent/TimeoutException.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+using decaf::lang::detail::ThreadRecord;
+using decaf::lang::detail::futexWait;
+using decaf::lang::detail::futexWaitUntil;
+using decaf::lang::detail::futexWake;
+
+/*
+ * A node of the combining tree, alone on its cache line.
+ */
+struct alignas(64) CyclicBarrier::Node {
+    Node(uint32_t capacity, uint32_t firstIndex) : m_arrivals(0), m_departures(0), m_released(0),
+      m_sleepers(0), m_capacity(capacity), m_firstIndex(firstIndex), m_parent(0) { }
+
+    /*
+     * The generation the node takes arrivals for, in the upper half, and how
+     * many threads have arrived for it, in the lower half.
+     */
+    std::atomic<uint64_t> m_arrivals;
+
+    /*
+     * The generation that last tripped here, in the upper half, and how many
+     * of its threads have read the outcome and left, in the lower half. The
+     * last to leave opens the node to the next generation: any earlier, and
+     * that generation could end here before a slow waiter of this one saw
+     * its own outcome.
+     */
+    std::atomic<uint64_t> m_departures;
+
+    /*
+     * The futex the threads that arrived here, but not last, sleep on: the
+     * value of m_generation that ended the last generation released here.
+     */
+    std::atomic<uint32_t> m_released;
+    std::atomic<uint32_t> m_sleepers;
+
+    /*
+     * The number of threads, or child nodes, that arrive here.
+     */
+    uint32_t m_capacity;
+
+    /*
+     * The lowest of the m_capacity - 1 arrival indices handed out here.
+     */
+    uint32_t m_firstIndex;
+
+    Node* m_parent;
+};
+
+namespace {
+
+/*
+ * Enough levels for INT32_MAX parties.
+ */
+const uint32_t MAX_DEPTH = 16;
+
+uint64_t arrivalsFor(uint32_t generation) {
+    return static_cast<uint64_t> (generation) << 32;
+}
+
+uint32_t generationOf(uint64_t arrivals) {
+    return static_cast<uint32_t> (arrivals >> 32);
+}
+
+uint32_t countOf(uint64_t arrivals) {
+    return static_cast<uint32_t> (arrivals);
+}
+
+/*
+ * Returns true if generation a comes after generation b, allowing for
+ * wrap-around.
+ */
+bool isAfter(uint32_t a, uint32_t b) {
+    return static_cast<int32_t> (a - b) > 0;
+}
+
+}
+
+// -----------------------------------------------------------------------------
+
+CyclicBarrier::CyclicBarrier(int32_t parties, lang::Runnable* barrierAction) : m_generation(0),
+  m_overflowWaiters(0), m_parties(parties), m_barrierAction(barrierAction), m_nodes(0), m_nodeCount(0),
+  m_leafCount(0) {
+    if (parties <= 0)
+        throw lang::IllegalArgumentException("the number of parties must be positive");
+
+    // Each level takes the arrivals of the one below, FAN_IN at most per
+    // node, until a single node, the root, is left.
+    uint32_t width = static_cast<uint32_t> (parties);
+    do {
+        width = (width + FAN_IN - 1) / FAN_IN;
+        m_nodeCount += width;
+    } while (width > 1);
+    m_leafCount = (static_cast<uint32_t> (parties) + FAN_IN - 1) / FAN_IN;
+
+    void* memory;
+    if (posix_memalign(&memory, alignof(Node), m_nodeCount * sizeof(Node)) != 0)
+        throw std::bad_alloc();
+    m_nodes = static_cast<Node*> (memory);
+
+    // Spread the arrivals of each level evenly over its nodes.
+    Node* level = m_nodes;
+    uint32_t firstIndex = 1;
+    width = static_cast<uint32_t> (parties);
+    for (;;) {
+        const uint32_t nodes = (width + FAN_IN - 1) / FAN_IN;
+        for (uint32_t i = 0; i < nodes; ++i) {
+            Node* node = new (level + i) Node(width / nodes + (i < width % nodes ? 1 : 0), firstIndex);
+            firstIndex += node->m_capacity - 1;
+        }
+        if (nodes == 1)
+            break;
+
+        Node* parents = level + nodes;
+        const uint32_t parentCount = (nodes + FAN_IN - 1) / FAN_IN;
+        Node* child = level;
+        for (uint32_t i = 0; i < parentCount; ++i) {
+            const uint32_t children = nodes / parentCount + (i < nodes % parentCount ? 1 : 0);
+            for (uint32_t j = 0; j < children; ++j)
+                (child++)->m_parent = parents + i;
+        }
+        level = parents;
+        width = nodes;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+CyclicBarrier::~CyclicBarrier() {
+    for (uint32_t i = 0; i < m_nodeCount; ++i)
+        m_nodes[i].~Node();
+    free(m_nodes);
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t CyclicBarrier::await() {
+    return awaitUntil(Deadline::never());
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t CyclicBarrier::await(const uint64_t& timeout, const TimeUnit* unit) {
+    return awaitUntil(Deadline::after(timeout, unit));
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t CyclicBarrier::awaitUntil(const Deadline& deadline) {
+    uint32_t generation;
+    uint32_t slot;
+    Node* node;
+    for (;;) {
+        generation = m_generation.load(std::memory_order_acquire);
+        if ((generation & BROKEN) != 0)
+            throw BrokenBarrierException("the barrier is broken");
+
+        bool reopening;
+        node = arriveAtLeaf(generation, slot, reopening);
+        if (node != 0)
+            break;
+
+        // The threads of the last generation are still leaving some leaf,
+        // which they do without blocking.
+        if (reopening) {
+            sched_yield();
+            continue;
+        }
+
+        // Every party of the running generation has arrived, which is about
+        // to end: this thread belongs to the next one. It has not arrived at
+        // any generation yet, so timing out breaks none.
+        struct timespec time;
+        const struct timespec* until = deadline.toTimespec(time);
+        m_overflowWaiters.fetch_add(1, std::memory_order_seq_cst);
+        while (m_generation.load(std::memory_order_seq_cst) == generation) {
+            if (!futexWaitUntil(m_generation, generation, until) &&
+              m_generation.load(std::memory_order_seq_cst) == generation) {
+                m_overflowWaiters.fetch_sub(1, std::memory_order_relaxed);
+                throw TimeoutException("timed out waiting at the barrier");
+            }
+        }
+        m_overflowWaiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Climb for as long as this thread completes the nodes it arrives at.
+    Node* climbed[MAX_DEPTH];
+    uint32_t depth = 0;
+    while (slot + 1 == node->m_capacity) {
+        climbed[depth++] = node;
+
+        if (node->m_parent == 0) {
+            if (m_barrierAction != 0) {
+                try {
+                    m_barrierAction->Run();
+                } catch (...) {
+                    breakGeneration(generation);
+                    throw;
+                }
+            }
+
+            uint32_t expected = generation;
+            if (!m_generation.compare_exchange_strong(expected, generation + 2, std::memory_order_acq_rel))
+                throw BrokenBarrierException("the barrier was broken");
+            if (m_overflowWaiters.load(std::memory_order_seq_cst) != 0)
+                futexWake(m_generation, INT_MAX);
+            while (depth > 0) {
+                release(climbed[--depth], generation + 2);
+                depart(climbed[depth], generation);
+            }
+            return 0;
+        }
+
+        node = node->m_parent;
+        uint64_t arrivals = node->m_arrivals.load(std::memory_order_relaxed);
+        for (;;) {
+            if (generationOf(arrivals) != generation) {
+                // The parent may still be on its way out of the last
+                // generation; anything else means this one was broken.
+                if (!isAfter(generation, generationOf(arrivals)) ||
+                  m_generation.load(std::memory_order_acquire) != generation)
+                    throw BrokenBarrierException("the barrier was broken");
+                sched_yield();
+                arrivals = node->m_arrivals.load(std::memory_order_relaxed);
+            } else if (node->m_arrivals.compare_exchange_weak(arrivals, arrivals + 1,
+              std::memory_order_acq_rel)) {
+                break;
+            }
+        }
+        slot = countOf(arrivals);
+    }
+
+    const int32_t index = static_cast<int32_t> (node->m_firstIndex + node->m_capacity - 2 - slot);
+
+    if (!m_spin.spin([node, generation]() {
+          return isAfter(node->m_released.load(std::memory_order_acquire), generation);
+      })) {
+        struct timespec time;
+        const struct timespec* until = deadline.toTimespec(time);
+
+        // Pairs with release(): either the sleeper is seen there, or it sees
+        // the node released.
+        node->m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+        for (uint32_t released; !isAfter(released = node->m_released.load(std::memory_order_seq_cst), generation); ) {
+            if (!futexWaitUntil(node->m_released, released, until)) {
+                if (breakGeneration(generation)) {
+                    node->m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+                    throw TimeoutException("timed out waiting at the barrier");
+                }
+                // The generation tripped or broke meanwhile: its release is
+                // on its way.
+                until = 0;
+            }
+        }
+        node->m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // The node stays closed until this thread departs, so no later
+    // generation can have ended here yet.
+    const uint32_t outcome = node->m_released.load(std::memory_order_acquire);
+    if (outcome != generation + 2)
+        throw BrokenBarrierException("the barrier was broken");
+    while (depth > 0) {
+        release(climbed[--depth], outcome);
+        depart(climbed[depth], generation);
+    }
+    depart(node, generation);
+    return index;
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t CyclicBarrier::getNumberWaiting() const {
+    const uint32_t generation = m_generation.load(std::memory_order_acquire);
+    if ((generation & BROKEN) != 0)
+        return 0;
+
+    // A leaf still on an earlier generation has no arrivals for this one.
+    uint32_t waiting = 0;
+    for (uint32_t i = 0; i < m_leafCount; ++i) {
+        const uint64_t arrivals = m_nodes[i].m_arrivals.load(std::memory_order_relaxed);
+        if (generationOf(arrivals) == generation)
+            waiting += countOf(arrivals);
+    }
+    return static_cast<int32_t> (waiting);
+}
+
+// -----------------------------------------------------------------------------
+
+void CyclicBarrier::reset() {
+    uint32_t generation = m_generation.load(std::memory_order_acquire);
+    while ((generation & BROKEN) == 0) {
+        if (breakGeneration(generation))
+            generation |= BROKEN;
+        else
+            generation = m_generation.load(std::memory_order_acquire);
+    }
+
+    // Open every node to the next generation, unless a concurrent reset got
+    // there first and arrivals for it have begun, then the barrier itself.
+    const uint32_t next = (generation & ~BROKEN) + 2;
+    for (uint32_t i = 0; i < m_nodeCount; ++i) {
+        uint64_t arrivals = m_nodes[i].m_arrivals.load(std::memory_order_relaxed);
+        while (generationOf(arrivals) != next &&
+          !m_nodes[i].m_arrivals.compare_exchange_weak(arrivals, arrivalsFor(next), std::memory_order_relaxed)) {
+        }
+    }
+    if (m_generation.compare_exchange_strong(generation, next, std::memory_order_acq_rel) &&
+      m_overflowWaiters.load(std::memory_order_seq_cst) != 0)
+        futexWake(m_generation, INT_MAX);
+}
+
+// -----------------------------------------------------------------------------
+
+CyclicBarrier::Node* CyclicBarrier::arriveAtLeaf(uint32_t generation, uint32_t& slot, bool& reopening) {
+    // Consecutive thread ids spread over consecutive leaves, which keeps the
+    // threads of a generation from colliding at one leaf.
+    uint32_t leaf = ThreadRecord::current().id() % m_leafCount;
+    reopening = false;
+    for (uint32_t probes = 0; probes < m_leafCount; ++probes) {
+        Node* node = m_nodes + leaf;
+        uint64_t arrivals = node->m_arrivals.load(std::memory_order_relaxed);
+        while (generationOf(arrivals) == generation && countOf(arrivals) < node->m_capacity) {
+            if (node->m_arrivals.compare_exchange_weak(arrivals, arrivals + 1, std::memory_order_acq_rel)) {
+                slot = countOf(arrivals);
+                return node;
+            }
+        }
+        if (isAfter(generation, generationOf(arrivals)))
+            reopening = true;
+        if (++leaf == m_leafCount)
+            leaf = 0;
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+bool CyclicBarrier::breakGeneration(uint32_t generation) {
+    if (!m_generation.compare_exchange_strong(generation, generation | BROKEN, std::memory_order_acq_rel))
+        return false;
+
+    if (m_overflowWaiters.load(std::memory_order_seq_cst) != 0)
+        futexWake(m_generation, INT_MAX);
+    for (uint32_t i = 0; i < m_nodeCount; ++i)
+        release(m_nodes + i, generation | BROKEN);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void CyclicBarrier::depart(Node* node, uint32_t generation) {
+    // Departures left over from an earlier generation count for nothing; a
+    // later one means a reset has moved the node on already.
+    uint64_t departures = node->m_departures.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        if (isAfter(generationOf(departures), generation))
+            return;
+        next = (generationOf(departures) == generation) ? departures + 1 : arrivalsFor(generation) | 1;
+    } while (!node->m_departures.compare_exchange_weak(departures, next, std::memory_order_acq_rel));
+
+    if (countOf(next) == node->m_capacity) {
+        uint64_t arrivals = arrivalsFor(generation) | node->m_capacity;
+        node->m_arrivals.compare_exchange_strong(arrivals, arrivalsFor(generation + 2),
+          std::memory_order_release, std::memory_order_relaxed);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void CyclicBarrier::release(Node* node, uint32_t outcome) {
+    // Never move a node back, should a later generation have ended there
+    // already.
+    uint32_t released = node->m_released.load(std::memory_order_relaxed);
+    while (isAfter(outcome, released)) {
+        if (node->m_released.compare_exchange_weak(released, outcome, std::memory_order_seq_cst)) {
+            if (node->m_sleepers.load(std::memory_order_seq_cst) != 0)
+                futexWake(node->m_released, INT_MAX);
+            return;
+        }
+    }
+}
+
+DECAF_CLOSE_NAMESPACE3
@@ -0,0 +1,561 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <climits>
+#include <cstdio>
+#include <cxxabi.h>
+#include <memory>
+#include <unistd.h>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/lang/Throwable.hpp"
+#include "decaf/util/concurrent/ForkJoinPool.hpp"
+#include "decaf/util/concurrent/RejectedExecutionException.hpp"
+#include "decaf/util/concurrent/locks/LockGuard.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+using decaf::lang::Ref;
+using decaf::lang::Runnable;
+using decaf::lang::Thread;
+using decaf::lang::ThreadGroup;
+using decaf::lang::detail::futexWait;
+using decaf::lang::detail::futexWaitUntil;
+using decaf::lang::detail::futexWake;
+using decaf::util::concurrent::locks::HybridLock;
+using decaf::util::concurrent::locks::LockGuard;
+
+namespace {
+
+std::atomic<uint32_t> s_poolNumber(1);
+
+Ref<ThreadGroup> newPoolGroup() {
+    Ref<ThreadGroup> group(new ThreadGroup("ForkJoinPool-" +
+      std::to_string(s_poolNumber.fetch_add(1, std::memory_order_relaxed))));
+    return group.share();
+}
+
+void reportUncaught(const std::string& what) {
+    std::fprintf(stderr, "Exception in thread \"%s\" %s\n", Thread::currentThread()->getName().c_str(),
+      what.c_str());
+}
+
+}
+
+/*
+ * A pool thread: the target of its Thread, and the owner of its deque, from
+ * which the other threads steal. Created and destroyed with the pool.
+ */
+class ForkJoinPool::Worker : public Runnable {
+  public:
+    Worker(ForkJoinPool* pool, uint32_t index) : m_pool(pool), m_seed(index * 0x9e3779b9u + 1), m_steals(0) { }
+
+    virtual void Run() {
+        m_pool->runWorker(this);
+    }
+
+    /*
+     * Xorshift, to pick victims.
+     */
+    uint32_t nextRandom() {
+        m_seed ^= m_seed << 13;
+        m_seed ^= m_seed >> 17;
+        m_seed ^= m_seed << 5;
+        return m_seed;
+    }
+
+    ForkJoinPool* const m_pool;
+    detail::WorkStealingDeque<ForkJoinTask> m_queue;
+    uint32_t m_seed;
+
+    /*
+     * Written by the worker's thread only.
+     */
+    std::atomic<uint64_t> m_steals;
+};
+
+/*
+ * A command given to execute(), which nobody joins: the pool owns it, and
+ * deletes it once it has run, or been dropped.
+ */
+class ForkJoinPool::RunnableTask : public ForkJoinTask {
+  public:
+    explicit RunnableTask(const Ref<Runnable>& command) : m_command(command) {
+        m_command.share();
+    }
+
+    virtual void Run() {
+        ForkJoinTask::Run();
+        delete this;
+    }
+
+    Ref<Runnable> m_command;
+
+  protected:
+    virtual void exec() {
+        try {
+            m_command->Run();
+        } catch (abi::__forced_unwind&) {
+            throw;
+        } catch (const lang::Throwable& e) {
+            reportUncaught(e.toString());
+        } catch (const std::exception& e) {
+            reportUncaught(e.what());
+        } catch (...) {
+            reportUncaught("unknown exception");
+        }
+    }
+};
+
+const uint32_t ForkJoinPool::IDLE_MASK;
+const uint32_t ForkJoinPool::WAKING;
+
+DECAF_THREAD_LOCAL ForkJoinPool::Worker* ForkJoinPool::t_worker DECAF_INITIAL_EXEC_TLS = 0;
+
+// -----------------------------------------------------------------------------
+
+ForkJoinPool::ForkJoinPool(uint32_t parallelism) : m_parallelism(parallelism), m_group(newPoolGroup()),
+  m_submissionCount(0), m_runState(RUNNING), m_signal(0), m_ctl(0), m_liveCount(0) {
+    if (parallelism == 0 || parallelism > IDLE_MASK / 2)
+        throw lang::IllegalArgumentException("parallelism must be between 1 and 32767");
+
+    m_workers.reserve(parallelism);
+    m_threads.reserve(parallelism);
+    for (uint32_t index = 0; index < parallelism; ++index) {
+        Ref<Worker> worker(new Worker(this, index));
+        worker.share();
+        Ref<Thread> thread(new Thread(m_group, worker, m_group->getName() + "-worker-" +
+          std::to_string(index + 1)));
+        thread.share();
+        thread->setDaemon(true);
+        m_workers.push_back(worker.get());
+        m_threads.push_back(thread);
+    }
+
+    uint32_t started = 0;
+    try {
+        for (; started < parallelism; ++started) {
+            m_liveCount.fetch_add(1, std::memory_order_relaxed);
+            m_threads[started]->start();
+        }
+    } catch (...) {
+        m_liveCount.fetch_sub(1, std::memory_order_relaxed);
+        m_runState.store(STOP, std::memory_order_seq_cst);
+        wakeAll();
+        for (uint32_t index = 0; index < started; ++index)
+            m_threads[index]->join();
+        throw;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+ForkJoinPool::~ForkJoinPool() {
+    shutdown();
+    awaitTerminationUntil(Deadline::never());
+    for (Ref<Thread>& thread : m_threads)
+        thread->join();
+}
+
+// -----------------------------------------------------------------------------
+
+ForkJoinPool& ForkJoinPool::commonPool() {
+    // Never destroyed: its daemon threads may still run tasks at exit.
+    static ForkJoinPool* s_common = new ForkJoinPool();
+    return *s_common;
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ForkJoinPool::defaultParallelism() {
+    const long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    return processors > 0 ? static_cast<uint32_t> (processors) : 1;
+}
+
+// -----------------------------------------------------------------------------
+
+ForkJoinPool* ForkJoinPool::currentPool() {
+    return t_worker != 0 ? t_worker->m_pool : 0;
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::push(ForkJoinTask* task) {
+    Worker* worker = t_worker;
+    if (worker == 0) {
+        commonPool().submit(task);
+        return;
+    }
+    // The other threads only need telling when the deque stops being empty:
+    // whoever steals from it tells them again while it has tasks.
+    task->m_status.fetch_or(ForkJoinTask::FORKED, std::memory_order_relaxed);
+    if (worker->m_queue.push(task) == 0)
+        worker->m_pool->signalWork();
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::awaitJoin(ForkJoinTask& task) {
+    Worker* worker = t_worker;
+    if (worker != 0)
+        worker->m_pool->helpJoin(worker, task);
+    else
+        task.awaitDone();
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::execute(const Ref<Runnable>& command) {
+    if (!command)
+        throw lang::IllegalArgumentException("command must not be null");
+
+    std::unique_ptr<RunnableTask> task(new RunnableTask(command));
+    submit(task.get());
+    task.release();
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::execute(ForkJoinTask& task) {
+    submit(&task);
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::invoke(ForkJoinTask& task) {
+    if (currentPool() == this) {
+        task.quietlyInvoke();
+    } else {
+        submit(&task);
+        task.awaitDone();
+    }
+    task.reportException();
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::submit(ForkJoinTask* task) {
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        if (m_runState.load(std::memory_order_relaxed) != RUNNING)
+            throw RejectedExecutionException("pool has been shut down");
+        task->m_status.fetch_or(ForkJoinTask::FORKED, std::memory_order_relaxed);
+        m_submissions.push_back(task);
+        m_submissionCount.store(m_submissions.size(), std::memory_order_release);
+    }
+    signalWork();
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::runWorker(Worker* worker) {
+    t_worker = worker;
+    bool woken = false;
+    for (;;) {
+        if (m_runState.load(std::memory_order_acquire) >= STOP)
+            break;
+
+        ForkJoinTask* task = worker->m_queue.pop();
+        if (task == 0) {
+            task = scan(worker);
+            if (task == 0) {
+                if (!awaitWork())
+                    break;
+                woken = true;
+                continue;
+            }
+            // Pass the signal on: there may be more work than the thread
+            // that woke this one knew of.
+            if (woken) {
+                woken = false;
+                signalWork();
+            }
+        }
+        task->Run();
+    }
+
+    // Stopped: drop the tasks left, so that their joiners do not wait forever.
+    while (ForkJoinTask* task = worker->m_queue.pop())
+        task->discard();
+    t_worker = 0;
+    workerTerminated();
+}
+
+// -----------------------------------------------------------------------------
+
+ForkJoinTask* ForkJoinPool::scan(Worker* worker) {
+    for (;;) {
+        bool lost = false;
+        const uint32_t origin = worker->nextRandom() % m_parallelism;
+        for (uint32_t index = origin, end = origin + m_parallelism; index != end; ++index) {
+            Worker* victim = m_workers[index < m_parallelism ? index : index - m_parallelism];
+            if (victim == worker)
+                continue;
+            ForkJoinTask* task = victim->m_queue.steal(lost);
+            if (task != 0) {
+                worker->m_steals.store(worker->m_steals.load(std::memory_order_relaxed) + 1,
+                  std::memory_order_relaxed);
+                if (!victim->m_queue.isEmpty())
+                    signalWork();
+                return task;
+            }
+        }
+
+        ForkJoinTask* task = pollSubmission();
+        if (task != 0 || !lost)
+            return task;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+ForkJoinTask* ForkJoinPool::pollSubmission() {
+    if (m_submissionCount.load(std::memory_order_acquire) == 0)
+        return 0;
+
+    ForkJoinTask* task;
+    size_t remaining;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        if (m_submissions.empty())
+            return 0;
+        task = m_submissions.front();
+        m_submissions.pop_front();
+        remaining = m_submissions.size();
+        m_submissionCount.store(remaining, std::memory_order_relaxed);
+    }
+    if (remaining != 0)
+        signalWork();
+    return task;
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::helpJoin(Worker* worker, ForkJoinTask& task) {
+    // Most often the task was not stolen, and is still where it was forked.
+    if (worker->m_queue.peek() == &task && worker->m_queue.pop() == &task) {
+        task.Run();
+        return;
+    }
+
+    // Otherwise make progress on other tasks while it runs elsewhere, and
+    // only park when there are none.
+    while (!task.isSettled() && m_runState.load(std::memory_order_acquire) < STOP) {
+        ForkJoinTask* other = worker->m_queue.pop();
+        if (other == 0 && (other = scan(worker)) == 0)
+            break;
+        other->Run();
+    }
+    // Stopping: the task may be among those below it in this deque.
+    if (m_runState.load(std::memory_order_acquire) >= STOP) {
+        while (ForkJoinTask* other = worker->m_queue.pop())
+            other->discard();
+    }
+    task.awaitDone();
+}
+
+// -----------------------------------------------------------------------------
+
+bool ForkJoinPool::hasWork() const {
+    if (m_submissionCount.load(std::memory_order_seq_cst) != 0)
+        return true;
+    for (const Worker* worker : m_workers) {
+        if (!worker->m_queue.isEmpty())
+            return true;
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ForkJoinPool::awaitWork() {
+    // Pairs with signalWork(): either it sees this thread idle and bumps the
+    // signal, or the work it made available is seen below.
+    m_ctl.fetch_add(1, std::memory_order_seq_cst);
+    const uint32_t signal = m_signal.load(std::memory_order_seq_cst);
+
+    const uint32_t state = m_runState.load(std::memory_order_acquire);
+    if (state >= STOP) {
+        leaveIdle();
+        return false;
+    }
+    if (hasWork()) {
+        leaveIdle();
+        return true;
+    }
+
+    // Shut down, and nothing left to do or to make more work: stop.
+    if (state == SHUTDOWN && (m_ctl.load(std::memory_order_seq_cst) & IDLE_MASK) ==
+      m_liveCount.load(std::memory_order_relaxed)) {
+        uint32_t expected = SHUTDOWN;
+        if (m_runState.compare_exchange_strong(expected, STOP, std::memory_order_seq_cst))
+            wakeAll();
+        leaveIdle();
+        return false;
+    }
+
+    futexWait(m_signal, signal);
+    leaveIdle();
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::leaveIdle() {
+    uint32_t ctl = m_ctl.load(std::memory_order_relaxed);
+    while (!m_ctl.compare_exchange_weak(ctl, (ctl - 1) & ~WAKING, std::memory_order_seq_cst))
+        ;
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::signalWork() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t ctl = m_ctl.load(std::memory_order_relaxed);
+    do {
+        if ((ctl & IDLE_MASK) == 0 || (ctl & WAKING) != 0)
+            return;
+    } while (!m_ctl.compare_exchange_weak(ctl, ctl | WAKING, std::memory_order_seq_cst));
+
+    m_signal.fetch_add(1, std::memory_order_release);
+    futexWake(m_signal, 1);
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::wakeAll() {
+    m_signal.fetch_add(1, std::memory_order_seq_cst);
+    futexWake(m_signal, INT_MAX);
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::workerTerminated() {
+    if (m_liveCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_runState.store(TERMINATED, std::memory_order_release);
+        futexWake(m_runState, INT_MAX);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinPool::shutdown() {
+    {
+        // Under the lock, so that submit() either sees the pool shut down or
+        // has its task seen by the threads that find the pool shut down.
+        LockGuard<HybridLock> guard(m_lock);
+        if (m_runState.load(std::memory_order_relaxed) != RUNNING)
+            return;
+        m_runState.store(SHUTDOWN, std::memory_order_seq_cst);
+    }
+    // The idle threads find out whether the pool is quiescent.
+    wakeAll();
+}
+
+// -----------------------------------------------------------------------------
+
+std::vector<Ref<Runnable> > ForkJoinPool::shutdownNow() {
+    std::vector<Ref<Runnable> > drained;
+    std::deque<ForkJoinTask*> submissions;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        if (m_runState.load(std::memory_order_relaxed) >= STOP)
+            return drained;
+        m_runState.store(STOP, std::memory_order_seq_cst);
+        submissions.swap(m_submissions);
+        m_submissionCount.store(0, std::memory_order_relaxed);
+    }
+    wakeAll();
+
+    for (ForkJoinTask* task : submissions) {
+        RunnableTask* command = dynamic_cast<RunnableTask*> (task);
+        if (command != 0)
+            drained.push_back(command->m_command);
+        task->discard();
+    }
+    return drained;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ForkJoinPool::isShutdown() const {
+    return m_runState.load(std::memory_order_acquire) != RUNNING;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ForkJoinPool::isTerminated() const {
+    return m_runState.load(std::memory_order_acquire) == TERMINATED;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ForkJoinPool::awaitTermination(uint64_t timeout, const TimeUnit* unit) {
+    return awaitTerminationUntil(Deadline::after(timeout, unit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool ForkJoinPool::awaitTerminationUntil(const Deadline& deadline) {
+    struct timespec time;
+    const struct timespec* until = deadline.toTimespec(time);
+    for (uint32_t state; (state = m_runState.load(std::memory_order_acquire)) != TERMINATED; ) {
+        if (!futexWaitUntil(m_runState, state, until))
+            return m_runState.load(std::memory_order_acquire) == TERMINATED;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ForkJoinPool::getActiveThreadCount() const {
+    const uint32_t idle = m_ctl.load(std::memory_order_relaxed) & IDLE_MASK;
+    const uint32_t live = m_liveCount.load(std::memory_order_relaxed);
+    return live > idle ? live - idle : 0;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t ForkJoinPool::getStealCount() const {
+    uint64_t count = 0;
+    for (const Worker* worker : m_workers)
+        count += worker->m_steals.load(std::memory_order_relaxed);
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t ForkJoinPool::getQueuedTaskCount() const {
+    uint64_t count = 0;
+    for (const Worker* worker : m_workers)
+        count += worker->m_queue.size();
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+
+std::string ForkJoinPool::toString() const {
+    static const char* const STATES[] = { "Running", "Shutting down", "Shutting down", "Terminated" };
+    const uint32_t state = m_runState.load(std::memory_order_acquire);
+    return Object::toString() + "[" + STATES[state] + ", parallelism = " + std::to_string(m_parallelism) +
+      ", size = " + std::to_string(getPoolSize()) + ", active = " + std::to_string(getActiveThreadCount()) +
+      ", steals = " + std::to_string(getStealCount()) + ", tasks = " + std::to_string(getQueuedTaskCount()) +
+      ", submissions = " + std::to_string(getQueuedSubmissionCount()) + "]";
+}
+
+DECAF_CLOSE_NAMESPACE3
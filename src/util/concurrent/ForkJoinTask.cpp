@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <climits>
+#include <cxxabi.h>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/util/concurrent/CancellationException.hpp"
+#include "decaf/util/concurrent/ForkJoinPool.hpp"
+#include "decaf/util/concurrent/ForkJoinTask.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+using decaf::lang::detail::futexWait;
+using decaf::lang::detail::futexWake;
+
+// -----------------------------------------------------------------------------
+
+ForkJoinTask::~ForkJoinTask() {
+    if ((m_status.load(std::memory_order_acquire) & (FORKED | STARTED)) != 0)
+        std::terminate();
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinTask::fork() {
+    ForkJoinPool::push(this);
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinTask::Run() {
+    // Take the task out of the pool, and start it unless it was cancelled.
+    uint32_t status = m_status.load(std::memory_order_acquire);
+    uint32_t next;
+    do {
+        if ((status & STARTED) != 0)
+            return;
+        next = (status & DONE_MASK) == PENDING ? (status & ~FORKED) | STARTED : status & ~(FORKED | SIGNAL);
+        if (next == status)
+            return;
+    } while (!m_status.compare_exchange_weak(status, next, std::memory_order_acq_rel));
+
+    if ((status & DONE_MASK) != PENDING) {
+        if ((status & SIGNAL) != 0)
+            futexWake(m_status, INT_MAX);
+        return;
+    }
+
+    try {
+        exec();
+    } catch (abi::__forced_unwind&) {
+        throw;
+    } catch (...) {
+        m_exception = std::current_exception();
+        complete(EXCEPTIONAL);
+        return;
+    }
+    complete(NORMAL);
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinTask::quietlyJoin() {
+    if (!isSettled())
+        ForkJoinPool::awaitJoin(*this);
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinTask::quietlyInvoke() {
+    Run();
+    if (!isSettled())
+        awaitDone();
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinTask::invokeAll(ForkJoinTask& first, ForkJoinTask& second) {
+    second.fork();
+    first.quietlyInvoke();
+    second.quietlyJoin();
+    first.reportException();
+    second.reportException();
+}
+
+// -----------------------------------------------------------------------------
+
+bool ForkJoinTask::cancel() {
+    uint32_t status = m_status.load(std::memory_order_acquire);
+    do {
+        if ((status & DONE_MASK) != PENDING)
+            return (status & DONE_MASK) == CANCELLED;
+        if ((status & STARTED) != 0)
+            return false;
+    } while (!m_status.compare_exchange_weak(status, CANCELLED | (status & FORKED), std::memory_order_acq_rel));
+
+    if ((status & SIGNAL) != 0)
+        futexWake(m_status, INT_MAX);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinTask::reinitialize() {
+    m_exception = std::exception_ptr();
+    m_status.store(PENDING, std::memory_order_release);
+}
+
+// -----------------------------------------------------------------------------
+
+ForkJoinPool* ForkJoinTask::getPool() {
+    return ForkJoinPool::currentPool();
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinTask::reportException() const {
+    const uint32_t status = m_status.load(std::memory_order_acquire) & DONE_MASK;
+    if (status == CANCELLED)
+        throw CancellationException("task was cancelled");
+    if (status == EXCEPTIONAL)
+        std::rethrow_exception(m_exception);
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinTask::complete(uint32_t completion) {
+    // Only the thread that started the task completes it, and cancel() leaves
+    // a started task alone. The task may be gone as soon as a joiner sees it
+    // done; the wake on a stale address is harmless.
+    if ((m_status.exchange(completion, std::memory_order_acq_rel) & SIGNAL) != 0)
+        futexWake(m_status, INT_MAX);
+}
+
+// -----------------------------------------------------------------------------
+
+void ForkJoinTask::awaitDone() {
+    uint32_t status = m_status.load(std::memory_order_acquire);
+    while ((status & DONE_MASK) == PENDING || (status & FORKED) != 0) {
+        if ((status & SIGNAL) == 0 &&
+          !m_status.compare_exchange_weak(status, status | SIGNAL, std::memory_order_acq_rel))
+            continue;
+        futexWait(m_status, status | SIGNAL);
+        status = m_status.load(std::memory_order_acquire);
+    }
+}
+
+DECAF_CLOSE_NAMESPACE3
@@ -0,0 +1,414 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <climits>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/lang/IllegalStateException.hpp"
+#include "decaf/lang/Synchronized.hpp"
+#include "decaf/util/concurrent/Phaser.hpp"
+#include "decaf/util/concurrent/TimeoutException.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+using decaf::lang::detail::futexWaitUntil;
+using decaf::lang::detail::futexWake;
+
+namespace {
+
+/*
+ * The layout of the state, as in the Phaser of Java: the unarrived parties
+ * in bits 0-15, the registered parties in bits 16-31, the phase in bits
+ * 32-62 and the termination flag in bit 63. A phaser without parties has the
+ * otherwise impossible counts EMPTY, no parties and one unarrived, rather
+ * than zero, which would mean that all of its parties have arrived.
+ */
+const uint32_t MAX_PARTIES = 0xffff;
+const int32_t MAX_PHASE = INT32_MAX;
+const uint32_t PARTIES_SHIFT = 16;
+const uint32_t PHASE_SHIFT = 32;
+const uint32_t UNARRIVED_MASK = 0xffff;
+const uint64_t PARTIES_MASK = 0xffff0000ull;
+const uint64_t COUNTS_MASK = 0xffffffffull;
+const uint64_t TERMINATION_BIT = 1ull << 63;
+
+const uint32_t ONE_ARRIVAL = 1;
+const uint32_t ONE_PARTY = 1u << PARTIES_SHIFT;
+const uint32_t ONE_DEREGISTER = ONE_ARRIVAL | ONE_PARTY;
+const uint32_t EMPTY = 1;
+
+int32_t phaseOf(uint64_t s) {
+    return static_cast<int32_t> (s >> PHASE_SHIFT);
+}
+
+uint32_t partiesOf(uint64_t s) {
+    return static_cast<uint32_t> (s) >> PARTIES_SHIFT;
+}
+
+uint32_t unarrivedOf(uint64_t s) {
+    const uint32_t counts = static_cast<uint32_t> (s);
+    return (counts == EMPTY) ? 0 : (counts & UNARRIVED_MASK);
+}
+
+uint32_t arrivedOf(uint64_t s) {
+    const uint32_t counts = static_cast<uint32_t> (s);
+    return (counts == EMPTY) ? 0 : (counts >> PARTIES_SHIFT) - (counts & UNARRIVED_MASK);
+}
+
+uint64_t phaseBits(int32_t phase) {
+    return static_cast<uint64_t> (static_cast<uint32_t> (phase)) << PHASE_SHIFT;
+}
+
+/*
+ * Returns the state s of a sub-phaser brought to the given phase of its
+ * root: with all of its parties unarrived, unless the tree has terminated.
+ */
+uint64_t reconciled(uint64_t s, int32_t phase) {
+    if (phase < 0)
+        return phaseBits(phase) | (s & COUNTS_MASK);
+    const uint32_t parties = partiesOf(s);
+    return phaseBits(phase) | ((parties == 0) ? EMPTY : ((s & PARTIES_MASK) | parties));
+}
+
+}
+
+// -----------------------------------------------------------------------------
+
+Phaser::Phaser(int32_t parties) : Phaser(0, parties) {
+}
+
+// -----------------------------------------------------------------------------
+
+Phaser::Phaser(Phaser* parent, int32_t parties) : m_state(EMPTY), m_parent(parent),
+  m_root(parent != 0 ? parent->m_root : this), m_wakeups(0), m_waiters(0) {
+    if (parties < 0 || static_cast<uint32_t> (parties) > MAX_PARTIES)
+        throw lang::IllegalArgumentException("illegal number of parties");
+
+    if (parties != 0) {
+        const int32_t phase = (parent != 0) ? parent->doRegister(1) : 0;
+        m_state.store(phaseBits(phase) | (static_cast<uint64_t> (parties) << PARTIES_SHIFT) |
+          static_cast<uint64_t> (parties), std::memory_order_release);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+Phaser::~Phaser() {
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::registerParty() {
+    return doRegister(1);
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::bulkRegister(int32_t parties) {
+    if (parties < 0)
+        throw lang::IllegalArgumentException("the number of parties must not be negative");
+    return (parties == 0) ? getPhase() : doRegister(parties);
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::arrive() {
+    return doArrive(ONE_ARRIVAL);
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::arriveAndDeregister() {
+    return doArrive(ONE_DEREGISTER);
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::arriveAndAwaitAdvance() {
+    for (;;) {
+        uint64_t s = (m_root == this) ? m_state.load(std::memory_order_acquire) : reconcileState();
+        const int32_t phase = phaseOf(s);
+        if (phase < 0)
+            return phase;
+
+        const uint32_t unarrived = unarrivedOf(s);
+        if (unarrived == 0)
+            throw lang::IllegalStateException("attempted arrival of an unregistered party");
+
+        if (m_state.compare_exchange_weak(s, s - ONE_ARRIVAL, std::memory_order_acq_rel)) {
+            if (unarrived > 1)
+                return m_root->internalAwaitAdvance(phase, 0);
+            if (m_root != this)
+                return m_parent->arriveAndAwaitAdvance();
+            return advance(s - ONE_ARRIVAL, phase);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::awaitAdvance(int32_t phase) {
+    const uint64_t s = (m_root == this) ? m_state.load(std::memory_order_acquire) : reconcileState();
+    if (phase < 0)
+        return phase;
+    const int32_t current = phaseOf(s);
+    return (current == phase) ? m_root->internalAwaitAdvance(phase, 0) : current;
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::awaitAdvance(int32_t phase, const uint64_t& timeout, const TimeUnit* unit) {
+    return awaitAdvanceUntil(phase, Deadline::after(timeout, unit));
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::awaitAdvanceUntil(int32_t phase, const Deadline& deadline) {
+    const uint64_t s = (m_root == this) ? m_state.load(std::memory_order_acquire) : reconcileState();
+    if (phase < 0)
+        return phase;
+
+    int32_t current = phaseOf(s);
+    if (current == phase) {
+        struct timespec time;
+        current = m_root->internalAwaitAdvance(phase, deadline.toTimespec(time));
+        if (current == phase)
+            throw TimeoutException("timed out waiting for the phase to advance");
+    }
+    return current;
+}
+
+// -----------------------------------------------------------------------------
+
+void Phaser::forceTermination() {
+    uint64_t s = m_root->m_state.load(std::memory_order_acquire);
+    while ((s & TERMINATION_BIT) == 0) {
+        if (m_root->m_state.compare_exchange_weak(s, s | TERMINATION_BIT, std::memory_order_acq_rel)) {
+            m_root->releaseWaiters();
+            return;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::getPhase() const {
+    return phaseOf(m_root->m_state.load(std::memory_order_acquire));
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::getRegisteredParties() const {
+    return static_cast<int32_t> (partiesOf(m_state.load(std::memory_order_acquire)));
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::getArrivedParties() const {
+    return static_cast<int32_t> (arrivedOf(currentState()));
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::getUnarrivedParties() const {
+    return static_cast<int32_t> (unarrivedOf(currentState()));
+}
+
+// -----------------------------------------------------------------------------
+
+bool Phaser::isTerminated() const {
+    return (m_root->m_state.load(std::memory_order_acquire) & TERMINATION_BIT) != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+std::string Phaser::toString() const {
+    const uint64_t s = currentState();
+    return Object::toString() + "[phase = " + std::to_string(phaseOf(s)) + " parties = " +
+      std::to_string(partiesOf(s)) + " arrived = " + std::to_string(arrivedOf(s)) + "]";
+}
+
+// -----------------------------------------------------------------------------
+
+bool Phaser::onAdvance(int32_t phase, int32_t registeredParties) {
+    return registeredParties == 0;
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::doArrive(uint32_t adjustment) {
+    for (;;) {
+        uint64_t s = (m_root == this) ? m_state.load(std::memory_order_acquire) : reconcileState();
+        int32_t phase = phaseOf(s);
+        if (phase < 0)
+            return phase;
+
+        const uint32_t unarrived = unarrivedOf(s);
+        if (unarrived == 0)
+            throw lang::IllegalStateException("attempted arrival of an unregistered party");
+
+        if (m_state.compare_exchange_weak(s, s - adjustment, std::memory_order_acq_rel)) {
+            s -= adjustment;
+            if (unarrived == 1) {
+                if (m_root == this) {
+                    advance(s, phase);
+                } else if (partiesOf(s) == 0) {
+                    // The last party left: so does this phaser from its parent.
+                    phase = m_parent->doArrive(ONE_DEREGISTER);
+                    m_state.compare_exchange_strong(s, s | EMPTY, std::memory_order_acq_rel);
+                } else {
+                    phase = m_parent->doArrive(ONE_ARRIVAL);
+                }
+            }
+            return phase;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::doRegister(int32_t registrations) {
+    const uint64_t adjustment = (static_cast<uint64_t> (registrations) << PARTIES_SHIFT) |
+      static_cast<uint64_t> (registrations);
+    int32_t phase;
+    for (;;) {
+        uint64_t s = (m_parent == 0) ? m_state.load(std::memory_order_acquire) : reconcileState();
+        const uint32_t counts = static_cast<uint32_t> (s);
+        const uint32_t parties = counts >> PARTIES_SHIFT;
+        const uint32_t unarrived = counts & UNARRIVED_MASK;
+        if (static_cast<uint32_t> (registrations) > MAX_PARTIES - parties)
+            throw lang::IllegalStateException("attempted to register more than 65535 parties");
+
+        phase = phaseOf(s);
+        if (phase < 0)
+            break;
+
+        if (counts != EMPTY) {
+            if (m_parent == 0 || reconcileState() == s) {
+                if (unarrived == 0) {
+                    // Wait out the advance in progress.
+                    m_root->internalAwaitAdvance(phase, 0);
+                } else if (m_state.compare_exchange_weak(s, s + adjustment, std::memory_order_acq_rel)) {
+                    break;
+                }
+            }
+        } else if (m_parent == 0) {
+            if (m_state.compare_exchange_weak(s, phaseBits(phase) | adjustment, std::memory_order_acq_rel))
+                break;
+        } else {
+            // The first party of a sub-phaser registers it with its parent,
+            // which must happen once only.
+            synchronized(this) {
+                if (m_state.load(std::memory_order_acquire) == s) {
+                    phase = m_parent->doRegister(1);
+                    if (phase < 0)
+                        break;
+                    // Finish the registration even if the tree terminated
+                    // meanwhile, as the parent registration succeeded.
+                    while (!m_state.compare_exchange_weak(s, phaseBits(phase) | adjustment,
+                      std::memory_order_acq_rel))
+                        phase = phaseOf(m_root->m_state.load(std::memory_order_acquire));
+                    break;
+                }
+            }
+        }
+    }
+    return phase;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t Phaser::reconcileState() {
+    uint64_t s = m_state.load(std::memory_order_acquire);
+    if (m_root != this) {
+        int32_t phase;
+        while ((phase = phaseOf(m_root->m_state.load(std::memory_order_acquire))) != phaseOf(s)) {
+            const uint64_t next = reconciled(s, phase);
+            if (m_state.compare_exchange_weak(s, next, std::memory_order_acq_rel))
+                return next;
+        }
+    }
+    return s;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t Phaser::currentState() const {
+    const uint64_t s = m_state.load(std::memory_order_acquire);
+    if (m_root == this)
+        return s;
+    const int32_t phase = phaseOf(m_root->m_state.load(std::memory_order_acquire));
+    return (phase != phaseOf(s)) ? reconciled(s, phase) : s;
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::advance(uint64_t s, int32_t phase) {
+    uint64_t next = s & PARTIES_MASK;
+    const uint32_t nextUnarrived = static_cast<uint32_t> (next) >> PARTIES_SHIFT;
+    if (onAdvance(phase, static_cast<int32_t> (nextUnarrived)))
+        next |= TERMINATION_BIT;
+    else if (nextUnarrived == 0)
+        next |= EMPTY;
+    else
+        next |= nextUnarrived;
+    const int32_t nextPhase = (phase + 1) & MAX_PHASE;
+    next |= phaseBits(nextPhase);
+
+    // Only a forced termination can have changed the state meanwhile.
+    if (!m_state.compare_exchange_strong(s, next, std::memory_order_acq_rel))
+        return phaseOf(s);
+    releaseWaiters();
+    return phaseOf(next);
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Phaser::internalAwaitAdvance(int32_t phase, const struct timespec* deadline) {
+    int32_t current;
+    if (m_spin.spin([this, phase, &current]() {
+          return (current = phaseOf(m_state.load(std::memory_order_acquire))) != phase;
+      }))
+        return current;
+
+    // Pairs with releaseWaiters(): either the waiter is seen there, or it
+    // sees the phase advanced.
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+    for (;;) {
+        const uint32_t wakeups = m_wakeups.load(std::memory_order_seq_cst);
+        current = phaseOf(m_state.load(std::memory_order_seq_cst));
+        if (current != phase)
+            break;
+        if (!futexWaitUntil(m_wakeups, wakeups, deadline)) {
+            current = phaseOf(m_state.load(std::memory_order_acquire));
+            break;
+        }
+    }
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    return current;
+}
+
+// -----------------------------------------------------------------------------
+
+void Phaser::releaseWaiters() {
+    m_wakeups.fetch_add(1, std::memory_order_seq_cst);
+    if (m_waiters.load(std::memory_order_seq_cst) != 0)
+        futexWake(m_wakeups, INT_MAX);
+}
+
+DECAF_CLOSE_NAMESPACE3
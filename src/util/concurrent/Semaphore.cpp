@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/util/concurrent/Semaphore.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+using decaf::lang::detail::futexWait;
+using decaf::lang::detail::futexWaitUntil;
+using decaf::lang::detail::futexWake;
+using detail::SemaphoreWaiter;
+
+namespace {
+
+void checkPermits(int32_t permits) {
+    if (permits < 0)
+        throw lang::IllegalArgumentException("the number of permits must not be negative");
+}
+
+}
+
+// -----------------------------------------------------------------------------
+
+Semaphore::Semaphore(int32_t permits, bool fair) : m_permits(permits), m_fair(fair), m_queueLength(0),
+  m_head(0), m_tail(0) {
+    pthread_mutex_init(&m_mutex, 0);
+}
+
+// -----------------------------------------------------------------------------
+
+Semaphore::~Semaphore() {
+    pthread_mutex_destroy(&m_mutex);
+}
+
+// -----------------------------------------------------------------------------
+
+void Semaphore::acquire() {
+    acquire(1);
+}
+
+// -----------------------------------------------------------------------------
+
+void Semaphore::acquire(int32_t permits) {
+    checkPermits(permits);
+    if ((!m_fair || m_queueLength.load(std::memory_order_seq_cst) == 0) && tryTake(permits))
+        return;
+    acquireQueued(permits, 0);
+}
+
+// -----------------------------------------------------------------------------
+
+bool Semaphore::tryAcquire() {
+    return tryTake(1);
+}
+
+// -----------------------------------------------------------------------------
+
+bool Semaphore::tryAcquire(int32_t permits) {
+    checkPermits(permits);
+    return tryTake(permits);
+}
+
+// -----------------------------------------------------------------------------
+
+bool Semaphore::tryAcquire(const uint64_t& timeout, const TimeUnit* unit) {
+    return tryAcquireUntil(1, Deadline::after(timeout, unit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool Semaphore::tryAcquire(int32_t permits, const uint64_t& timeout, const TimeUnit* unit) {
+    return tryAcquireUntil(permits, Deadline::after(timeout, unit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool Semaphore::tryAcquireUntil(int32_t permits, const Deadline& deadline) {
+    checkPermits(permits);
+    if ((!m_fair || m_queueLength.load(std::memory_order_seq_cst) == 0) && tryTake(permits))
+        return true;
+
+    struct timespec time;
+    return acquireQueued(permits, deadline.toTimespec(time));
+}
+
+// -----------------------------------------------------------------------------
+
+void Semaphore::release() {
+    release(1);
+}
+
+// -----------------------------------------------------------------------------
+
+void Semaphore::release(int32_t permits) {
+    checkPermits(permits);
+
+    // Pairs with the queueing in acquireQueued(): either the waiter is seen
+    // queued here, or it sees the released permits itself.
+    m_permits.fetch_add(permits, std::memory_order_seq_cst);
+    if (m_queueLength.load(std::memory_order_seq_cst) == 0)
+        return;
+
+    pthread_mutex_lock(&m_mutex);
+    SemaphoreWaiter* woken = dequeueSatisfiableLocked();
+    pthread_mutex_unlock(&m_mutex);
+    wake(woken);
+}
+
+// -----------------------------------------------------------------------------
+
+int32_t Semaphore::drainPermits() {
+    return m_permits.exchange(0, std::memory_order_acquire);
+}
+
+// -----------------------------------------------------------------------------
+
+void Semaphore::reducePermits(int32_t reduction) {
+    checkPermits(reduction);
+    m_permits.fetch_sub(reduction, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+
+bool Semaphore::acquireQueued(int32_t permits, const struct timespec* deadline) {
+    for (;;) {
+        SemaphoreWaiter waiter(permits);
+
+        pthread_mutex_lock(&m_mutex);
+        if (m_tail != 0)
+            m_tail->m_next = &waiter;
+        else
+            m_head = &waiter;
+        m_tail = &waiter;
+        m_queueLength.fetch_add(1, std::memory_order_seq_cst);
+
+        // The permits may have been released since they were last looked at,
+        // before the waiter was visible: this may dequeue it right away.
+        SemaphoreWaiter* woken = dequeueSatisfiableLocked();
+        pthread_mutex_unlock(&m_mutex);
+        wake(woken);
+
+        bool timedOut = false;
+        while (waiter.m_wakeup.load(std::memory_order_acquire) == 0) {
+            if (!futexWaitUntil(waiter.m_wakeup, 0, deadline)) {
+                timedOut = true;
+                break;
+            }
+        }
+
+        if (timedOut) {
+            pthread_mutex_lock(&m_mutex);
+            if (waiter.m_state == SemaphoreWaiter::QUEUED) {
+                SemaphoreWaiter* previous = 0;
+                for (SemaphoreWaiter* current = m_head; current != &waiter; current = current->m_next)
+                    previous = current;
+                (previous != 0 ? previous->m_next : m_head) = waiter.m_next;
+                if (m_tail == &waiter)
+                    m_tail = previous;
+                m_queueLength.fetch_sub(1, std::memory_order_relaxed);
+
+                // A fair queue may have been held up by this waiter alone.
+                woken = m_fair ? dequeueSatisfiableLocked() : 0;
+                pthread_mutex_unlock(&m_mutex);
+                wake(woken);
+                return false;
+            }
+            pthread_mutex_unlock(&m_mutex);
+
+            // Dequeued just as the wait timed out: the releasing thread is
+            // about to set the futex, and the waiter must outlive that.
+            while (waiter.m_wakeup.load(std::memory_order_acquire) == 0)
+                futexWait(waiter.m_wakeup, 0);
+        }
+
+        if (waiter.m_state == SemaphoreWaiter::GRANTED || tryTake(permits))
+            return true;
+        if (timedOut)
+            return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+SemaphoreWaiter* Semaphore::dequeueSatisfiableLocked() {
+    SemaphoreWaiter* woken = 0;
+    SemaphoreWaiter** wokenTail = &woken;
+
+    int32_t available = m_permits.load(std::memory_order_seq_cst);
+    SemaphoreWaiter* previous = 0;
+    SemaphoreWaiter* waiter = m_head;
+    while (waiter != 0 && available > 0) {
+        SemaphoreWaiter* next = waiter->m_next;
+        if (waiter->m_permits <= available) {
+            if (m_fair) {
+                // Hand the permits over, so that no arriving thread can take
+                // them first.
+                if (!m_permits.compare_exchange_weak(available, available - waiter->m_permits,
+                  std::memory_order_acquire))
+                    continue;
+                waiter->m_state = SemaphoreWaiter::GRANTED;
+            } else {
+                waiter->m_state = SemaphoreWaiter::WOKEN;
+            }
+            available -= waiter->m_permits;
+
+            (previous != 0 ? previous->m_next : m_head) = next;
+            if (m_tail == waiter)
+                m_tail = previous;
+            m_queueLength.fetch_sub(1, std::memory_order_relaxed);
+
+            waiter->m_next = 0;
+            *wokenTail = waiter;
+            wokenTail = &waiter->m_next;
+        } else if (m_fair) {
+            // Nobody overtakes the head of a fair queue.
+            break;
+        } else {
+            previous = waiter;
+        }
+        waiter = next;
+    }
+    return woken;
+}
+
+// -----------------------------------------------------------------------------
+
+void Semaphore::wake(SemaphoreWaiter* waiters) {
+    while (waiters != 0) {
+        SemaphoreWaiter* next = waiters->m_next;
+        waiters->m_wakeup.store(1, std::memory_order_release);
+        futexWake(waiters->m_wakeup, 1);
+        waiters = next;
+    }
+}
+
+DECAF_CLOSE_NAMESPACE3
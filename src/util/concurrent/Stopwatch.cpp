@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdio>
+
+#include "decaf/lang/IllegalStateException.hpp"
+#include "decaf/util/concurrent/Stopwatch.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+Stopwatch& Stopwatch::start() {
+    if (m_running)
+        throw lang::IllegalStateException("this stopwatch is already running");
+    m_running = true;
+    m_startTick = Deadline::now();
+    return *this;
+}
+
+// -----------------------------------------------------------------------------
+
+Stopwatch& Stopwatch::stop() {
+    const uint64_t tick = Deadline::now();
+    if (!m_running)
+        throw lang::IllegalStateException("this stopwatch is already stopped");
+    m_running = false;
+    m_elapsedNanos += tick - m_startTick;
+    return *this;
+}
+
+// -----------------------------------------------------------------------------
+
+std::string Stopwatch::toString() const {
+    static const TimeUnit* const UNITS[] = { TimeUnit::DAYS, TimeUnit::HOURS, TimeUnit::MINUTES,
+      TimeUnit::SECONDS, TimeUnit::MILLISECONDS, TimeUnit::MICROSECONDS, TimeUnit::NANOSECONDS };
+
+    const uint64_t nanos = elapsedNanos();
+    const TimeUnit* unit = TimeUnit::NANOSECONDS;
+    for (size_t i = 0; i < sizeof(UNITS) / sizeof(UNITS[0]); ++i) {
+        if (UNITS[i]->convert(nanos, TimeUnit::NANOSECONDS) > 0) {
+            unit = UNITS[i];
+            break;
+        }
+    }
+
+    char text[48];
+    const double value = static_cast<double> (nanos) / static_cast<double> (unit->toNanos(1));
+    snprintf(text, sizeof(text), "%.4g %s", value, unit->toShortString().c_str());
+    return text;
+}
+
+DECAF_CLOSE_NAMESPACE3
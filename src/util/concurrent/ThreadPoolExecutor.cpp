@@ -0,0 +1,656 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <ctime>
+#include <sched.h>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/util/concurrent/RejectedExecutionException.hpp"
+#include "decaf/util/concurrent/ThreadPoolExecutor.hpp"
+#include "decaf/util/concurrent/locks/LockGuard.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+using decaf::lang::Ref;
+using decaf::lang::Runnable;
+using decaf::lang::Thread;
+using decaf::lang::ThreadGroup;
+using decaf::lang::detail::futexWaitUntil;
+using decaf::lang::detail::futexWake;
+using decaf::util::concurrent::locks::HybridLock;
+using decaf::util::concurrent::locks::LockGuard;
+
+namespace {
+
+std::atomic<uint32_t> s_poolNumber(1);
+
+Ref<ThreadGroup> newPoolGroup() {
+    Ref<ThreadGroup> group(new ThreadGroup("pool-" +
+      std::to_string(s_poolNumber.fetch_add(1, std::memory_order_relaxed))));
+    return group.share();
+}
+
+}
+
+/*
+ * The target of a pool thread. The thread owns it, and the executor keeps a
+ * pointer to it, from the moment the thread is created until the thread is
+ * done with the executor, together with a pointer to the thread.
+ */
+class ThreadPoolExecutor::Worker : public Runnable {
+  public:
+    Worker(ThreadPoolExecutor* executor, const Ref<Runnable>& firstTask) : m_executor(executor),
+      m_firstTask(firstTask), m_thread(0), m_completedTasks(0), m_active(false), m_retired(false) {
+    }
+
+    virtual void Run() {
+        m_executor->runWorker(this);
+    }
+
+    ThreadPoolExecutor* const m_executor;
+    Ref<Runnable> m_firstTask;
+    Thread* m_thread;
+
+    /*
+     * Written by the worker's thread only, and read under the executor's
+     * lock for the statistics.
+     */
+    std::atomic<uint64_t> m_completedTasks;
+    std::atomic<bool> m_active;
+
+    /*
+     * Set under the executor's lock once getTask() has taken the worker out
+     * of the pool size, so that workerExited() does not do it again.
+     */
+    bool m_retired;
+};
+
+const size_t ThreadPoolExecutor::UNBOUNDED;
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::AbortPolicy::rejectedExecution(const Ref<Runnable>&, ThreadPoolExecutor* executor) {
+    throw RejectedExecutionException("task rejected from " + executor->toString());
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::CallerRunsPolicy::rejectedExecution(const Ref<Runnable>& task,
+  ThreadPoolExecutor* executor) {
+    if (!executor->isShutdown())
+        task->Run();
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::DiscardPolicy::rejectedExecution(const Ref<Runnable>&, ThreadPoolExecutor*) {
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::DiscardOldestPolicy::rejectedExecution(const Ref<Runnable>& task,
+  ThreadPoolExecutor* executor) {
+    // Retries as execute() would, but in a loop rather than by recursion: with
+    // nothing queued, it takes a thread going idle to make room.
+    Ref<Runnable> command(task);
+    while (!executor->isShutdown()) {
+        const bool discarded = static_cast<bool> (executor->pollQueue());
+        if (!executor->submit(command))
+            return;
+        if (!discarded)
+            sched_yield();
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+ThreadPoolExecutor::ThreadPoolExecutor(uint32_t corePoolSize, uint32_t maximumPoolSize, uint64_t keepAliveTime,
+  const TimeUnit* unit, size_t queueCapacity, const Ref<RejectedExecutionHandler>& handler) :
+  m_group(newPoolGroup()), m_queueCapacity(queueCapacity), m_handler(handler), m_threadNumber(1),
+  m_retiredTaskCount(0), m_idleCount(0), m_wakeups(0), m_corePoolSize(corePoolSize),
+  m_maximumPoolSize(maximumPoolSize), m_keepAliveNanos(unit->toNanos(keepAliveTime)),
+  m_allowCoreThreadTimeOut(false), m_poolSize(0), m_largestPoolSize(0), m_queueSize(0), m_runState(RUNNING),
+  m_signal(0) {
+    if (maximumPoolSize == 0 || maximumPoolSize < corePoolSize)
+        throw lang::IllegalArgumentException("maximum pool size must be positive and at least the core size");
+    if (!m_handler)
+        m_handler = Ref<RejectedExecutionHandler>(new AbortPolicy());
+    m_handler.share();
+}
+
+// -----------------------------------------------------------------------------
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+    shutdown();
+    awaitTerminationUntil(Deadline::never());
+
+    // The last thread to exit terminated the executor under the lock, and
+    // may not have released it yet.
+    LockGuard<HybridLock> guard(m_lock);
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::execute(const Ref<Runnable>& command) {
+    if (!command)
+        throw lang::IllegalArgumentException("command must not be null");
+
+    Ref<Runnable> task(command);
+    task.share();
+    Ref<RejectedExecutionHandler> handler(submit(task));
+    if (handler)
+        handler->rejectedExecution(task, this);
+}
+
+// -----------------------------------------------------------------------------
+
+Ref<RejectedExecutionHandler> ThreadPoolExecutor::submit(Ref<Runnable>& task) {
+    Starts starts;
+    uint32_t wake = 0;
+    Ref<RejectedExecutionHandler> handler;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        const uint32_t poolSize = m_poolSize.load(std::memory_order_relaxed);
+        if (m_runState.load(std::memory_order_relaxed) != RUNNING) {
+            handler = m_handler;
+        } else if (poolSize < m_corePoolSize.load(std::memory_order_relaxed)) {
+            addWorker(task, starts);
+        } else if (enqueue(task)) {
+            wake = claimIdle(1);
+            // Without core threads, the queue may have no thread to drain it.
+            if (poolSize == 0)
+                addWorker(Ref<Runnable>(), starts);
+        } else if (poolSize < m_maximumPoolSize.load(std::memory_order_relaxed)) {
+            addWorker(task, starts);
+        } else {
+            handler = m_handler;
+        }
+    }
+
+    if (!handler) {
+        wakeIdle(wake);
+        start(starts);
+    }
+    return handler;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ThreadPoolExecutor::enqueue(Ref<Runnable>& command) {
+    // Past its capacity, the queue still takes the tasks the idle threads
+    // are about to take from it, which makes a queue of capacity 0 a handoff.
+    const size_t size = m_queue.size();
+    if (size >= m_queueCapacity && size >= m_idleCount - m_wakeups)
+        return false;
+    m_queue.push_back(std::move(command));
+    m_queueSize.store(size + 1, std::memory_order_relaxed);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::addWorker(const Ref<Runnable>& firstTask, Starts& starts) {
+    Ref<Worker> worker(new Worker(this, firstTask));
+    worker.share();
+    Ref<Thread> thread(new Thread(m_group, worker, m_group->getName() + "-thread-" +
+      std::to_string(m_threadNumber++)));
+    thread.share();
+    worker->m_thread = thread.get();
+    starts.push_back(thread);
+    m_workers.push_back(worker.get());
+
+    const uint32_t poolSize = m_poolSize.load(std::memory_order_relaxed) + 1;
+    m_poolSize.store(poolSize, std::memory_order_relaxed);
+    if (poolSize > m_largestPoolSize.load(std::memory_order_relaxed))
+        m_largestPoolSize.store(poolSize, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::start(Starts& starts) {
+    for (size_t i = 0; i < starts.size(); i++) {
+        try {
+            starts[i]->start();
+        } catch (...) {
+            // Forget this thread and the ones after it, and their first tasks.
+            LockGuard<HybridLock> guard(m_lock);
+            for (size_t j = i; j < starts.size(); j++) {
+                for (size_t k = 0; k < m_workers.size(); k++) {
+                    if (m_workers[k]->m_thread == starts[j].get()) {
+                        m_workers[k] = m_workers.back();
+                        m_workers.pop_back();
+                        m_poolSize.fetch_sub(1, std::memory_order_relaxed);
+                        break;
+                    }
+                }
+            }
+            tryTerminate();
+            throw;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ThreadPoolExecutor::claimIdle(uint32_t count) {
+    const uint32_t unclaimed = m_idleCount - m_wakeups;
+    if (count > unclaimed)
+        count = unclaimed;
+    m_wakeups += count;
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::wakeIdle(uint32_t count) {
+    if (count == 0)
+        return;
+    m_signal.fetch_add(1, std::memory_order_release);
+    futexWake(m_signal, static_cast<int> (std::min<uint32_t>(count, INT_MAX)));
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::runWorker(Worker* worker) {
+    // Also runs when a task throws, which ends the thread.
+    struct Exit {
+        ~Exit() {
+            Starts starts;
+            m_worker->m_executor->workerExited(m_worker, starts);
+            if (starts.empty())
+                return;
+            try {
+                m_worker->m_executor->start(starts);
+            } catch (...) {
+                // The pool makes do with fewer threads.
+            }
+        }
+        Worker* m_worker;
+    } exit = { worker };
+
+    Thread* const thread = Thread::currentThread();
+    Ref<Runnable> task;
+    task.swap(worker->m_firstTask);
+    while (task || (task = getTask(worker))) {
+        // A stopping pool keeps its threads interrupted; otherwise an
+        // interrupt meant for a task must not leak into the next one.
+        if (m_runState.load(std::memory_order_acquire) >= STOP) {
+            if (!thread->isInterrupted())
+                thread->interrupt();
+        } else if (thread->isInterrupted() && Thread::interrupted() &&
+          m_runState.load(std::memory_order_seq_cst) >= STOP) {
+            thread->interrupt();
+        }
+
+        worker->m_active.store(true, std::memory_order_relaxed);
+        task->Run();
+        worker->m_active.store(false, std::memory_order_relaxed);
+        worker->m_completedTasks.store(worker->m_completedTasks.load(std::memory_order_relaxed) + 1,
+          std::memory_order_relaxed);
+        task.reset();
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+Ref<Runnable> ThreadPoolExecutor::getTask(Worker* worker) {
+    struct timespec time;
+    const struct timespec* idleUntil = 0;
+    bool timedOut = false;
+
+    LockGuard<HybridLock> guard(m_lock);
+    for (;;) {
+        // A thread leaves the pool size as soon as it decides to exit, or the
+        // idle threads checking it behind us would all exit together.
+        const uint32_t state = m_runState.load(std::memory_order_relaxed);
+        const uint32_t poolSize = m_poolSize.load(std::memory_order_relaxed);
+        if (state >= STOP || (state == SHUTDOWN && m_queue.empty())) {
+            retire(worker, poolSize);
+            return Ref<Runnable>();
+        }
+
+        // Threads in excess exit, but the last one stays while tasks remain.
+        const bool timed = m_allowCoreThreadTimeOut.load(std::memory_order_relaxed) ||
+          poolSize > m_corePoolSize.load(std::memory_order_relaxed);
+        if ((poolSize > m_maximumPoolSize.load(std::memory_order_relaxed) || (timed && timedOut)) &&
+          (poolSize > 1 || m_queue.empty())) {
+            retire(worker, poolSize);
+            return Ref<Runnable>();
+        }
+
+        if (!m_queue.empty()) {
+            Ref<Runnable> task(std::move(m_queue.front()));
+            m_queue.pop_front();
+            m_queueSize.store(m_queue.size(), std::memory_order_relaxed);
+            return task;
+        }
+
+        // The keep-alive time counts from the first wait, whatever wakes the
+        // thread up in between.
+        if (timed && idleUntil == 0)
+            idleUntil = Deadline::afterNanos(m_keepAliveNanos.load(std::memory_order_relaxed)).toTimespec(time);
+
+        const uint32_t signal = m_signal.load(std::memory_order_acquire);
+        m_idleCount++;
+        m_lock.unlock();
+        const bool signalled = futexWaitUntil(m_signal, signal, timed ? idleUntil : 0);
+        m_lock.lock();
+        m_idleCount--;
+        if (m_wakeups != 0)
+            m_wakeups--;
+        timedOut = !signalled;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::retire(Worker* worker, uint32_t poolSize) {
+    worker->m_retired = true;
+    m_poolSize.store(poolSize - 1, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::workerExited(Worker* worker, Starts& starts) {
+    LockGuard<HybridLock> guard(m_lock);
+
+    // A task that threw still counts as completed.
+    const bool abrupt = worker->m_active.load(std::memory_order_relaxed);
+    m_retiredTaskCount += worker->m_completedTasks.load(std::memory_order_relaxed) + (abrupt ? 1 : 0);
+    m_workers.erase(std::find(m_workers.begin(), m_workers.end(), worker));
+    if (!worker->m_retired)
+        retire(worker, m_poolSize.load(std::memory_order_relaxed));
+    const uint32_t poolSize = m_poolSize.load(std::memory_order_relaxed);
+
+    // Replaced, if it threw or the pool is short, unless no task is left for
+    // the replacement to run.
+    const uint32_t state = m_runState.load(std::memory_order_relaxed);
+    if (state == RUNNING || (state == SHUTDOWN && !m_queue.empty())) {
+        uint32_t minimum = m_allowCoreThreadTimeOut.load(std::memory_order_relaxed) ? 0 :
+          m_corePoolSize.load(std::memory_order_relaxed);
+        if (minimum == 0 && !m_queue.empty())
+            minimum = 1;
+        if (abrupt || poolSize < minimum)
+            addWorker(Ref<Runnable>(), starts);
+    }
+    tryTerminate();
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::tryTerminate() {
+    const uint32_t state = m_runState.load(std::memory_order_relaxed);
+    if (state == RUNNING || state == TERMINATED)
+        return;
+    if (m_poolSize.load(std::memory_order_relaxed) != 0 || !m_queue.empty())
+        return;
+    m_runState.store(TERMINATED, std::memory_order_release);
+    futexWake(m_runState, INT_MAX);
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::shutdown() {
+    uint32_t wake = 0;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        if (m_runState.load(std::memory_order_relaxed) != RUNNING)
+            return;
+        m_runState.store(SHUTDOWN, std::memory_order_release);
+        wake = claimIdle(UINT32_MAX);
+        tryTerminate();
+    }
+    wakeIdle(wake);
+}
+
+// -----------------------------------------------------------------------------
+
+std::vector<Ref<Runnable> > ThreadPoolExecutor::shutdownNow() {
+    std::vector<Ref<Runnable> > drained;
+    uint32_t wake = 0;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        if (m_runState.load(std::memory_order_relaxed) >= STOP)
+            return drained;
+        m_runState.store(STOP, std::memory_order_seq_cst);
+
+        drained.reserve(m_queue.size());
+        for (Ref<Runnable>& task : m_queue)
+            drained.push_back(std::move(task));
+        m_queue.clear();
+        m_queueSize.store(0, std::memory_order_relaxed);
+
+        for (Worker* worker : m_workers)
+            worker->m_thread->interrupt();
+        wake = claimIdle(UINT32_MAX);
+        tryTerminate();
+    }
+    wakeIdle(wake);
+    return drained;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ThreadPoolExecutor::isShutdown() const {
+    return m_runState.load(std::memory_order_acquire) != RUNNING;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ThreadPoolExecutor::isTerminating() const {
+    const uint32_t state = m_runState.load(std::memory_order_acquire);
+    return state != RUNNING && state != TERMINATED;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ThreadPoolExecutor::isTerminated() const {
+    return m_runState.load(std::memory_order_acquire) == TERMINATED;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ThreadPoolExecutor::awaitTermination(uint64_t timeout, const TimeUnit* unit) {
+    return awaitTerminationUntil(Deadline::after(timeout, unit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool ThreadPoolExecutor::awaitTerminationUntil(const Deadline& deadline) {
+    struct timespec time;
+    const struct timespec* until = deadline.toTimespec(time);
+    for (uint32_t state; (state = m_runState.load(std::memory_order_acquire)) != TERMINATED; ) {
+        if (!futexWaitUntil(m_runState, state, until))
+            return m_runState.load(std::memory_order_acquire) == TERMINATED;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+Ref<Runnable> ThreadPoolExecutor::pollQueue() {
+    LockGuard<HybridLock> guard(m_lock);
+    if (m_queue.empty())
+        return Ref<Runnable>();
+    Ref<Runnable> task(std::move(m_queue.front()));
+    m_queue.pop_front();
+    m_queueSize.store(m_queue.size(), std::memory_order_relaxed);
+    tryTerminate();
+    return task;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ThreadPoolExecutor::prestartCoreThread() {
+    Starts starts;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        if (m_runState.load(std::memory_order_relaxed) == RUNNING &&
+          m_poolSize.load(std::memory_order_relaxed) < m_corePoolSize.load(std::memory_order_relaxed))
+            addWorker(Ref<Runnable>(), starts);
+    }
+    start(starts);
+    return !starts.empty();
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ThreadPoolExecutor::prestartAllCoreThreads() {
+    Starts starts;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        while (m_runState.load(std::memory_order_relaxed) == RUNNING &&
+          m_poolSize.load(std::memory_order_relaxed) < m_corePoolSize.load(std::memory_order_relaxed))
+            addWorker(Ref<Runnable>(), starts);
+    }
+    start(starts);
+    return static_cast<uint32_t> (starts.size());
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::setCorePoolSize(uint32_t corePoolSize) {
+    Starts starts;
+    uint32_t wake = 0;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        if (corePoolSize > m_maximumPoolSize.load(std::memory_order_relaxed))
+            throw lang::IllegalArgumentException("core pool size must not exceed the maximum");
+
+        const uint32_t previous = m_corePoolSize.exchange(corePoolSize, std::memory_order_relaxed);
+        const uint32_t poolSize = m_poolSize.load(std::memory_order_relaxed);
+        if (poolSize > corePoolSize) {
+            wake = claimIdle(poolSize - corePoolSize);
+        } else if (corePoolSize > previous && m_runState.load(std::memory_order_relaxed) == RUNNING) {
+            // As many new threads as there are queued tasks for them.
+            size_t count = std::min<size_t>(corePoolSize - previous, m_queue.size());
+            while (count-- != 0 && m_poolSize.load(std::memory_order_relaxed) < corePoolSize)
+                addWorker(Ref<Runnable>(), starts);
+        }
+    }
+    wakeIdle(wake);
+    start(starts);
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::setMaximumPoolSize(uint32_t maximumPoolSize) {
+    uint32_t wake = 0;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        if (maximumPoolSize == 0 || maximumPoolSize < m_corePoolSize.load(std::memory_order_relaxed))
+            throw lang::IllegalArgumentException("maximum pool size must be positive and at least the core size");
+
+        m_maximumPoolSize.store(maximumPoolSize, std::memory_order_relaxed);
+        const uint32_t poolSize = m_poolSize.load(std::memory_order_relaxed);
+        if (poolSize > maximumPoolSize)
+            wake = claimIdle(poolSize - maximumPoolSize);
+    }
+    wakeIdle(wake);
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::setKeepAliveTime(uint64_t time, const TimeUnit* unit) {
+    LockGuard<HybridLock> guard(m_lock);
+    const uint64_t nanos = unit->toNanos(time);
+    if (nanos == 0 && m_allowCoreThreadTimeOut.load(std::memory_order_relaxed))
+        throw lang::IllegalArgumentException("core threads must have a nonzero keep-alive time");
+    m_keepAliveNanos.store(nanos, std::memory_order_relaxed);
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::allowCoreThreadTimeOut(bool value) {
+    uint32_t wake = 0;
+    {
+        LockGuard<HybridLock> guard(m_lock);
+        if (value && m_keepAliveNanos.load(std::memory_order_relaxed) == 0)
+            throw lang::IllegalArgumentException("core threads must have a nonzero keep-alive time");
+
+        // Idle core threads wait without a timeout: have them start one.
+        if (m_allowCoreThreadTimeOut.exchange(value, std::memory_order_relaxed) != value && value)
+            wake = claimIdle(UINT32_MAX);
+    }
+    wakeIdle(wake);
+}
+
+// -----------------------------------------------------------------------------
+
+Ref<RejectedExecutionHandler> ThreadPoolExecutor::getRejectedExecutionHandler() const {
+    LockGuard<HybridLock> guard(m_lock);
+    return m_handler;
+}
+
+// -----------------------------------------------------------------------------
+
+void ThreadPoolExecutor::setRejectedExecutionHandler(const Ref<RejectedExecutionHandler>& handler) {
+    if (!handler)
+        throw lang::IllegalArgumentException("handler must not be null");
+
+    Ref<RejectedExecutionHandler> shared(handler);
+    shared.share();
+    LockGuard<HybridLock> guard(m_lock);
+    m_handler.swap(shared);
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ThreadPoolExecutor::getActiveCount() const {
+    LockGuard<HybridLock> guard(m_lock);
+    uint32_t count = 0;
+    for (const Worker* worker : m_workers)
+        count += worker->m_active.load(std::memory_order_relaxed) ? 1 : 0;
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t ThreadPoolExecutor::getCompletedTaskCount() const {
+    LockGuard<HybridLock> guard(m_lock);
+    uint64_t count = m_retiredTaskCount;
+    for (const Worker* worker : m_workers)
+        count += worker->m_completedTasks.load(std::memory_order_relaxed);
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t ThreadPoolExecutor::getTaskCount() const {
+    LockGuard<HybridLock> guard(m_lock);
+    uint64_t count = m_retiredTaskCount + m_queue.size();
+    for (const Worker* worker : m_workers) {
+        count += worker->m_completedTasks.load(std::memory_order_relaxed) +
+          (worker->m_active.load(std::memory_order_relaxed) ? 1 : 0);
+    }
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+
+std::string ThreadPoolExecutor::toString() const {
+    static const char* const STATES[] = { "Running", "Shutting down", "Shutting down", "Terminated" };
+    const uint32_t state = m_runState.load(std::memory_order_acquire);
+    return Object::toString() + "[" + STATES[state] + ", pool size = " + std::to_string(getPoolSize()) +
+      ", active threads = " + std::to_string(getActiveCount()) + ", queued tasks = " +
+      std::to_string(getQueueSize()) + ", completed tasks = " + std::to_string(getCompletedTaskCount()) + "]";
+}
+
+DECAF_CLOSE_NAMESPACE3
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <sys/prctl.h>
+#include <time.h>
+
+#include "decaf/lang/Object.hpp"
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/util/concurrent/Deadline.hpp"
+#include "decaf/util/concurrent/TimeUnit.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+namespace {
+
+/*
+ * Bounds of the margin by which sleepUntil() wakes before its deadline to
+ * spin the rest. The upper bound caps the CPU time a sleep burns.
+ */
+const uint64_t MIN_SLEEP_MARGIN = 2000;
+const uint64_t MAX_SLEEP_MARGIN = 2000000;
+
+/*
+ * What clock_nanosleep() is expected to oversleep on top of the timer slack
+ * before the first sleep of a thread has been measured.
+ */
+const uint64_t WAKE_UP_LATENCY = 20000;
+
+/*
+ * The sleep margin of the calling thread, in nanoseconds, or 0 until its first
+ * sleep. Per thread since the timer slack is.
+ */
+DECAF_THREAD_LOCAL uint64_t t_sleepMargin DECAF_INITIAL_EXEC_TLS;
+
+uint64_t initialSleepMargin() {
+    const int slack = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+    const uint64_t margin = (slack > 0 ? static_cast<uint64_t> (slack) : 0) + WAKE_UP_LATENCY;
+    return std::min(std::max(margin, MIN_SLEEP_MARGIN), MAX_SLEEP_MARGIN);
+}
+
+/*
+ * Adjusts the sleep margin to a sleep that woke @a late nanoseconds past its
+ * timer, aiming a quarter above the lateness seen. A sleep that woke later
+ * than the margin allows widens it at once, since it overslept its deadline;
+ * punctual ones narrow it slowly.
+ */
+uint64_t calibrateSleepMargin(uint64_t margin, uint64_t late) {
+    const uint64_t target = std::min(std::max(late + late / 4, MIN_SLEEP_MARGIN), MAX_SLEEP_MARGIN);
+    return target > margin ? target : margin - (margin - target) / 16;
+}
+
+}
+
+constexpr uint64_t TimeUnit::MIN;
+constexpr uint64_t TimeUnit::MAX;
+constexpr uint64_t TimeUnit::C0;
+constexpr uint64_t TimeUnit::C1;
+constexpr uint64_t TimeUnit::C2;
+constexpr uint64_t TimeUnit::C3;
+constexpr uint64_t TimeUnit::C4;
+constexpr uint64_t TimeUnit::C5;
+constexpr uint64_t TimeUnit::C6;
+
+/*
+ * Constant-initialized, so usable by the constructors of other static objects,
+ * and never destroyed.
+ */
+TimeUnit TimeUnit::s_units[7] = { TimeUnit(0), TimeUnit(1), TimeUnit(2), TimeUnit(3), TimeUnit(4), TimeUnit(5),
+  TimeUnit(6) };
+
+TimeUnit* const TimeUnit::NANOSECONDS = &s_units[ORDINAL_NANOSECONDS];
+TimeUnit* const TimeUnit::MICROSECONDS = &s_units[ORDINAL_MICROSECONDS];
+TimeUnit* const TimeUnit::MILLISECONDS = &s_units[ORDINAL_MILLISECONDS];
+TimeUnit* const TimeUnit::SECONDS = &s_units[ORDINAL_SECONDS];
+TimeUnit* const TimeUnit::MINUTES = &s_units[ORDINAL_MINUTES];
+TimeUnit* const TimeUnit::HOURS = &s_units[ORDINAL_HOURS];
+TimeUnit* const TimeUnit::DAYS = &s_units[ORDINAL_DAYS];
+
+// -----------------------------------------------------------------------------
+
+std::string TimeUnit::toString() const {
+    static const char* const NAMES[] = { "NANOSECONDS", "MICROSECONDS", "MILLISECONDS", "SECONDS", "MINUTES",
+      "HOURS", "DAYS" };
+    return NAMES[m_ordinal];
+}
+
+// -----------------------------------------------------------------------------
+
+std::string TimeUnit::toShortString() const {
+    static const char* const NAMES[] = { "ns", "us", "ms", "s", "m", "h", "d" };
+    return NAMES[m_ordinal];
+}
+
+// -----------------------------------------------------------------------------
+
+void TimeUnit::sleep(uint64_t timeout) const {
+    if (timeout != 0)
+        sleepUntil(Deadline::afterNanos(toNanos(timeout)));
+}
+
+// -----------------------------------------------------------------------------
+
+void TimeUnit::sleepUntil(const Deadline& deadline) {
+    uint64_t margin = t_sleepMargin;
+    if (margin == 0)
+        margin = initialSleepMargin();
+
+    const uint64_t end = deadline.nanos();
+    uint64_t now = Deadline::now();
+    while (now < end && end - now > margin) {
+        const uint64_t wakeAt = end - margin;
+        struct timespec time;
+        Deadline::at(wakeAt).toTimespec(time);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, 0);
+        now = Deadline::now();
+        // A sleep cut short by a signal says nothing of the timer: sleep again.
+        if (now >= wakeAt)
+            margin = calibrateSleepMargin(margin, now - wakeAt);
+    }
+    t_sleepMargin = margin;
+
+    while (now < end) {
+        lang::detail::cpuRelax();
+        now = Deadline::now();
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimeUnit::timedWait(lang::Object* obj, uint64_t timeout) const {
+    if (timeout == 0)
+        return;
+    const uint64_t nanos = toNanos(timeout);
+    obj->wait(nanos / NANOS_PER_MILLI, nanos % NANOS_PER_MILLI);
+}
+
+DECAF_CLOSE_NAMESPACE3
@@ -0,0 +1,598 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <climits>
+#include <exception>
+#include <pthread.h>
+#include <sched.h>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalArgumentException.hpp"
+#include "decaf/lang/ReferenceCount.hpp"
+#include "decaf/lang/System.hpp"
+#include "decaf/util/concurrent/CancellationException.hpp"
+#include "decaf/util/concurrent/RejectedExecutionException.hpp"
+#include "decaf/util/concurrent/TimeoutException.hpp"
+#include "decaf/util/concurrent/TimingWheelExecutor.hpp"
+
+DECAF_OPEN_NAMESPACE3(decaf, util, concurrent)
+
+using decaf::lang::Ref;
+using decaf::lang::Runnable;
+using decaf::lang::System;
+using decaf::lang::detail::ReferenceCount;
+using decaf::lang::detail::futexWait;
+using decaf::lang::detail::futexWaitUntil;
+using decaf::lang::detail::futexWake;
+using decaf::util::concurrent::detail::WheelNode;
+
+namespace {
+
+uint64_t saturatingAdd(uint64_t lhs, uint64_t rhs) {
+    return (lhs > UINT64_MAX - rhs) ? UINT64_MAX : lhs + rhs;
+}
+
+}
+
+/*
+ * A scheduled command and its future.
+ *
+ * The state moves from PENDING, on the executor's list of new tasks, to
+ * SCHEDULED, in the wheel, to RUNNING and back to SCHEDULED for as long as a
+ * periodic task runs, and ends in DONE, FAILED or CANCELLED. Only cancel()
+ * and the ticker change it, and whichever of the two wins a transition out of
+ * PENDING or SCHEDULED decides what happens to the task: cancel() moving a
+ * task out of SCHEDULED hands it back to the ticker through the executor's
+ * list of cancelled tasks, since only the ticker may unlink it from the wheel.
+ *
+ * The executor holds a reference to the task from schedule() until the
+ * ticker is done with it.
+ */
+class TimingWheelExecutor::Task : public ScheduledFuture, public WheelNode {
+  public:
+    enum State { PENDING, SCHEDULED, RUNNING, DONE, FAILED, CANCELLED };
+
+    Task(TimingWheelExecutor* executor, const Ref<Runnable>& command, uint64_t deadline, uint64_t period,
+      bool fixedRate) : m_executor(executor), m_command(command), m_nextPending(0), m_deadline(deadline),
+      m_period(period), m_fixedRate(fixedRate), m_state(PENDING), m_waiters(0) {
+    }
+
+    virtual ~Task() { }
+
+    virtual bool cancel(bool mayInterruptIfRunning);
+
+    virtual bool isCancelled() const {
+        return m_state.load(std::memory_order_acquire) == CANCELLED;
+    }
+
+    virtual bool isDone() const {
+        return m_state.load(std::memory_order_acquire) >= DONE;
+    }
+
+    virtual void get() {
+        await(Deadline::never());
+    }
+
+    virtual void get(uint64_t timeout, const TimeUnit* unit) {
+        await(Deadline::after(timeout, unit));
+    }
+
+    virtual uint64_t getDelay(const TimeUnit* unit) const {
+        const uint64_t deadline = m_deadline.load(std::memory_order_relaxed);
+        const uint64_t now = System::fastNanoTime();
+        return unit->convert(deadline > now ? deadline - now : 0, TimeUnit::NANOSECONDS);
+    }
+
+    /*
+     * Moves the task from @a from to @a to, and wakes the threads in get() if
+     * that completes it.
+     */
+    bool transition(uint32_t from, uint32_t to) {
+        if (!m_state.compare_exchange_strong(from, to, std::memory_order_acq_rel))
+            return false;
+        if (to >= DONE && m_waiters.load(std::memory_order_seq_cst) != 0)
+            futexWake(m_state, INT_MAX);
+        return true;
+    }
+
+    TimingWheelExecutor* const m_executor;
+    const Ref<Runnable> m_command;
+    Task* m_nextPending;
+    std::atomic<uint64_t> m_deadline;
+    const uint64_t m_period;
+    const bool m_fixedRate;
+    std::atomic<uint32_t> m_state;
+    std::atomic<uint32_t> m_waiters;
+    std::exception_ptr m_exception;
+
+  private:
+    void await(const Deadline& deadline);
+};
+
+// -----------------------------------------------------------------------------
+
+bool TimingWheelExecutor::Task::cancel(bool) {
+    uint32_t state = m_state.load(std::memory_order_acquire);
+    do {
+        if (state >= DONE)
+            return false;
+    } while (!m_state.compare_exchange_weak(state, CANCELLED, std::memory_order_acq_rel));
+
+    if (m_waiters.load(std::memory_order_seq_cst) != 0)
+        futexWake(m_state, INT_MAX);
+
+    // A pending task is dropped by the ticker when it finds it cancelled, and
+    // a running one when it returns; only the wheel needs telling.
+    if (state == SCHEDULED)
+        m_executor->cancelled(this);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::Task::await(const Deadline& deadline) {
+    uint32_t state = m_state.load(std::memory_order_acquire);
+    if (state < DONE) {
+        struct timespec time;
+        const struct timespec* until = deadline.toTimespec(time);
+
+        // Pairs with transition() and cancel(): either the waiter is seen
+        // there, or the final state is seen here.
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        while ((state = m_state.load(std::memory_order_seq_cst)) < DONE) {
+            if (!futexWaitUntil(m_state, state, until)) {
+                state = m_state.load(std::memory_order_acquire);
+                break;
+            }
+        }
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    if (state == CANCELLED)
+        throw CancellationException("task was cancelled");
+    if (state == FAILED)
+        std::rethrow_exception(m_exception);
+    if (state != DONE)
+        throw TimeoutException("task did not complete in time");
+}
+
+// -----------------------------------------------------------------------------
+
+TimingWheelExecutor::TimingWheelExecutor(uint64_t tick, const TimeUnit* unit) : m_tickNanos(unit->toNanos(tick)),
+  m_origin(System::fastNanoTime()), m_scheduled(0), m_cancelled(0), m_runState(RUNNING), m_signal(0), m_parked(0),
+  m_pendingCount(0), m_nextTick(0), m_size(0), m_unclaimed(0), m_periodicCancelled(false) {
+    if (m_tickNanos < 1000)
+        throw lang::IllegalArgumentException("tick must be at least a microsecond");
+
+    m_ticker = std::thread(&TimingWheelExecutor::runTicker, this);
+    pthread_setname_np(m_ticker.native_handle(), "decaf-timer");
+}
+
+// -----------------------------------------------------------------------------
+
+TimingWheelExecutor::~TimingWheelExecutor() {
+    shutdownNow();
+    if (m_ticker.joinable())
+        m_ticker.join();
+
+    // Whatever the ticker did not see: tasks rejected after it terminated,
+    // and tasks it took out of the wheel as their cancel() was about to hand
+    // them back, which must not find the executor gone.
+    discardScheduled();
+    acceptCancelled();
+    while (m_unclaimed != 0) {
+        sched_yield();
+        acceptCancelled();
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::execute(const Ref<Runnable>& command) {
+    enqueue(command, 0, 0, false, TimeUnit::NANOSECONDS);
+}
+
+// -----------------------------------------------------------------------------
+
+Ref<ScheduledFuture> TimingWheelExecutor::schedule(const Ref<Runnable>& command, uint64_t delay,
+  const TimeUnit* unit) {
+    return enqueue(command, delay, 0, false, unit);
+}
+
+// -----------------------------------------------------------------------------
+
+Ref<ScheduledFuture> TimingWheelExecutor::scheduleAtFixedRate(const Ref<Runnable>& command,
+  uint64_t initialDelay, uint64_t period, const TimeUnit* unit) {
+    if (period == 0)
+        throw lang::IllegalArgumentException("period must be positive");
+    return enqueue(command, initialDelay, period, true, unit);
+}
+
+// -----------------------------------------------------------------------------
+
+Ref<ScheduledFuture> TimingWheelExecutor::scheduleWithFixedDelay(const Ref<Runnable>& command,
+  uint64_t initialDelay, uint64_t delay, const TimeUnit* unit) {
+    if (delay == 0)
+        throw lang::IllegalArgumentException("delay must be positive");
+    return enqueue(command, initialDelay, delay, false, unit);
+}
+
+// -----------------------------------------------------------------------------
+
+Ref<ScheduledFuture> TimingWheelExecutor::enqueue(const Ref<Runnable>& command, uint64_t delay, uint64_t period,
+  bool fixedRate, const TimeUnit* unit) {
+    if (!command)
+        throw lang::IllegalArgumentException("command must not be null");
+    if (m_runState.load(std::memory_order_acquire) != RUNNING)
+        throw RejectedExecutionException("executor has been shut down");
+
+    Ref<Runnable> shared(command);
+    shared.share();
+    const uint64_t deadline = saturatingAdd(System::fastNanoTime(), unit->toNanos(delay));
+    Task* task = new Task(this, shared, deadline, unit->toNanos(period), fixedRate);
+    Ref<ScheduledFuture> future(task);
+    future.share();
+    ReferenceCount::retain(*task);
+    push(m_scheduled, task);
+
+    if (m_parked.load(std::memory_order_seq_cst) != 0 && m_parked.exchange(0, std::memory_order_relaxed) != 0)
+        wakeTicker();
+
+    // Shut down since the check above: take the task back unless the ticker
+    // already accepted it. It stays on the list either way.
+    if (m_runState.load(std::memory_order_seq_cst) != RUNNING && task->transition(Task::PENDING, Task::CANCELLED))
+        throw RejectedExecutionException("executor has been shut down");
+    return future;
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::push(std::atomic<Task*>& list, Task* task) {
+    Task* head = list.load(std::memory_order_relaxed);
+    do {
+        task->m_nextPending = head;
+    } while (!list.compare_exchange_weak(head, task, std::memory_order_seq_cst, std::memory_order_relaxed));
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::cancelled(Task* task) {
+    // The ticker picks the task up on its next tick; a parked ticker has an
+    // empty wheel, and so no cancelled tasks worth waking it for.
+    push(m_cancelled, task);
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::wakeTicker() {
+    m_signal.fetch_add(1, std::memory_order_release);
+    futexWake(m_signal, 1);
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::shutdown() {
+    uint32_t state = RUNNING;
+    if (m_runState.compare_exchange_strong(state, SHUTDOWN, std::memory_order_seq_cst))
+        wakeTicker();
+}
+
+// -----------------------------------------------------------------------------
+
+std::vector<Ref<Runnable> > TimingWheelExecutor::shutdownNow() {
+    uint32_t state = m_runState.load(std::memory_order_relaxed);
+    do {
+        if (state >= STOP)
+            return std::vector<Ref<Runnable> >();
+    } while (!m_runState.compare_exchange_weak(state, STOP, std::memory_order_seq_cst));
+
+    wakeTicker();
+    if (std::this_thread::get_id() == m_ticker.get_id())
+        return std::vector<Ref<Runnable> >();
+
+    // The ticker hands the commands over as it terminates.
+    awaitTerminationUntil(Deadline::never());
+    std::vector<Ref<Runnable> > drained;
+    drained.swap(m_drained);
+    return drained;
+}
+
+// -----------------------------------------------------------------------------
+
+bool TimingWheelExecutor::isShutdown() const {
+    return m_runState.load(std::memory_order_acquire) != RUNNING;
+}
+
+// -----------------------------------------------------------------------------
+
+bool TimingWheelExecutor::isTerminated() const {
+    return m_runState.load(std::memory_order_acquire) == TERMINATED;
+}
+
+// -----------------------------------------------------------------------------
+
+bool TimingWheelExecutor::awaitTermination(uint64_t timeout, const TimeUnit* unit) {
+    return awaitTerminationUntil(Deadline::after(timeout, unit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool TimingWheelExecutor::awaitTerminationUntil(const Deadline& deadline) {
+    struct timespec time;
+    const struct timespec* until = deadline.toTimespec(time);
+    for (uint32_t state; (state = m_runState.load(std::memory_order_acquire)) != TERMINATED; ) {
+        if (!futexWaitUntil(m_runState, state, until))
+            return m_runState.load(std::memory_order_acquire) == TERMINATED;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::runTicker() {
+    for (;;) {
+        const uint32_t signal = m_signal.load(std::memory_order_acquire);
+        acceptScheduled();
+        acceptCancelled();
+
+        const uint32_t state = m_runState.load(std::memory_order_acquire);
+        if (state >= STOP) {
+            stop();
+            break;
+        }
+        if (state == SHUTDOWN && !m_periodicCancelled) {
+            cancelPeriodic();
+            m_periodicCancelled = true;
+        }
+
+        advance(System::fastNanoTime());
+        m_pendingCount.store(m_size, std::memory_order_relaxed);
+
+        if (state == SHUTDOWN && m_size == 0 && m_scheduled.load(std::memory_order_acquire) == 0)
+            break;
+        waitForTick(signal);
+    }
+
+    m_pendingCount.store(0, std::memory_order_relaxed);
+    m_runState.store(TERMINATED, std::memory_order_release);
+    futexWake(m_runState, INT_MAX);
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::acceptScheduled() {
+    Task* task = m_scheduled.exchange(0, std::memory_order_acquire);
+    while (task != 0) {
+        Task* next = task->m_nextPending;
+        if (task->transition(Task::PENDING, Task::SCHEDULED))
+            insert(task);
+        else
+            ReferenceCount::release(*task);
+        task = next;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::acceptCancelled() {
+    Task* task = m_cancelled.exchange(0, std::memory_order_acquire);
+    while (task != 0) {
+        Task* next = task->m_nextPending;
+        if (task->isLinked()) {
+            task->unlink();
+            m_size--;
+        } else {
+            m_unclaimed--;
+        }
+        ReferenceCount::release(*task);
+        task = next;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::discardScheduled() {
+    Task* task = m_scheduled.exchange(0, std::memory_order_acquire);
+    while (task != 0) {
+        Task* next = task->m_nextPending;
+        task->transition(Task::PENDING, Task::CANCELLED);
+        ReferenceCount::release(*task);
+        task = next;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t TimingWheelExecutor::tickOf(uint64_t nanos) const {
+    if (nanos <= m_origin)
+        return 0;
+    const uint64_t elapsed = nanos - m_origin;
+    return elapsed / m_tickNanos + (elapsed % m_tickNanos != 0 ? 1 : 0);
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::insert(Task* task) {
+    uint64_t expires = tickOf(task->m_deadline.load(std::memory_order_relaxed));
+    WheelNode* slot;
+    if (expires < m_nextTick) {
+        slot = &m_root[m_nextTick & (ROOT_SLOTS - 1)];
+    } else {
+        uint64_t ticks = expires - m_nextTick;
+        if (ticks < ROOT_SLOTS) {
+            slot = &m_root[expires & (ROOT_SLOTS - 1)];
+        } else {
+            if (ticks > MAX_TICKS)
+                expires = m_nextTick + MAX_TICKS;
+            uint32_t level = 0;
+            while (ticks >= (1ull << (ROOT_BITS + (level + 1) * LEVEL_BITS)) && level < LEVELS - 1)
+                level++;
+            slot = &m_levels[level][(expires >> (ROOT_BITS + level * LEVEL_BITS)) & (LEVEL_SLOTS - 1)];
+        }
+    }
+    task->linkBefore(*slot);
+    m_size++;
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::advance(uint64_t now) {
+    if (now < m_origin)
+        return;
+    const uint64_t currentTick = (now - m_origin) / m_tickNanos;
+    while (m_nextTick <= currentTick) {
+        const uint64_t tick = m_nextTick;
+        if ((tick & (ROOT_SLOTS - 1)) == 0) {
+            // The root wrapped around: bring the next slot of each level down,
+            // for as long as the level below it wrapped around too.
+            for (uint32_t level = 0; level < LEVELS; level++) {
+                const uint64_t index = (tick >> (ROOT_BITS + level * LEVEL_BITS)) & (LEVEL_SLOTS - 1);
+                cascade(m_levels[level][index]);
+                if (index != 0)
+                    break;
+            }
+        }
+        m_nextTick = tick + 1;
+        expire(m_root[tick & (ROOT_SLOTS - 1)]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::cascade(WheelNode& slot) {
+    WheelNode tasks;
+    tasks.takeAll(slot);
+    while (tasks.isLinked()) {
+        Task* task = static_cast<Task*> (tasks.m_next);
+        task->unlink();
+        m_size--;
+        insert(task);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::expire(WheelNode& slot) {
+    WheelNode tasks;
+    tasks.takeAll(slot);
+    while (tasks.isLinked()) {
+        Task* task = static_cast<Task*> (tasks.m_next);
+        task->unlink();
+        m_size--;
+        if (task->transition(Task::SCHEDULED, Task::RUNNING))
+            run(task);
+        else
+            m_unclaimed++;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::run(Task* task) {
+    try {
+        task->m_command->Run();
+    } catch (...) {
+        task->m_exception = std::current_exception();
+        task->transition(Task::RUNNING, Task::FAILED);
+        ReferenceCount::release(*task);
+        return;
+    }
+
+    if (task->m_period == 0) {
+        task->transition(Task::RUNNING, Task::DONE);
+    } else if (m_runState.load(std::memory_order_acquire) != RUNNING) {
+        task->transition(Task::RUNNING, Task::CANCELLED);
+    } else {
+        const uint64_t deadline = task->m_fixedRate ? task->m_deadline.load(std::memory_order_relaxed)
+                                                    : System::fastNanoTime();
+        task->m_deadline.store(saturatingAdd(deadline, task->m_period), std::memory_order_relaxed);
+        if (task->transition(Task::RUNNING, Task::SCHEDULED)) {
+            insert(task);
+            return;
+        }
+    }
+    ReferenceCount::release(*task);
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::cancelPeriodic() {
+    WheelNode* slots[1 + LEVELS] = { m_root, m_levels[0], m_levels[1], m_levels[2], m_levels[3] };
+    for (uint32_t level = 0; level <= LEVELS; level++) {
+        const uint64_t count = (level == 0) ? ROOT_SLOTS : LEVEL_SLOTS;
+        for (uint64_t index = 0; index < count; index++) {
+            WheelNode& slot = slots[level][index];
+            for (WheelNode* node = slot.m_next; node != &slot; ) {
+                Task* task = static_cast<Task*> (node);
+                node = node->m_next;
+                if (task->m_period == 0)
+                    continue;
+                task->unlink();
+                m_size--;
+                if (task->transition(Task::SCHEDULED, Task::CANCELLED))
+                    ReferenceCount::release(*task);
+                else
+                    m_unclaimed++;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::stop() {
+    WheelNode* slots[1 + LEVELS] = { m_root, m_levels[0], m_levels[1], m_levels[2], m_levels[3] };
+    for (uint32_t level = 0; level <= LEVELS; level++) {
+        const uint64_t count = (level == 0) ? ROOT_SLOTS : LEVEL_SLOTS;
+        for (uint64_t index = 0; index < count; index++) {
+            WheelNode& slot = slots[level][index];
+            while (slot.isLinked()) {
+                Task* task = static_cast<Task*> (slot.m_next);
+                task->unlink();
+                m_size--;
+                if (task->transition(Task::SCHEDULED, Task::CANCELLED)) {
+                    m_drained.push_back(task->m_command);
+                    ReferenceCount::release(*task);
+                } else {
+                    m_unclaimed++;
+                }
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void TimingWheelExecutor::waitForTick(uint32_t signal) {
+    if (m_scheduled.load(std::memory_order_relaxed) != 0)
+        return;
+
+    if (m_size == 0) {
+        // Pairs with enqueue(): either the task pushed is seen here, or the
+        // ticker is seen parked there.
+        m_parked.store(1, std::memory_order_seq_cst);
+        if (m_scheduled.load(std::memory_order_seq_cst) == 0)
+            futexWait(m_signal, signal);
+        m_parked.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    struct timespec time;
+    futexWaitUntil(m_signal, signal, Deadline::at(m_origin + m_nextTick * m_tickNanos).toTimespec(time));
+}
+
+DECAF_CLOSE_NAMESPACE3
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalMonitorStateException.hpp"
+#include "decaf/util/concurrent/locks/ConditionObject.hpp"
+#include "decaf/util/concurrent/locks/ReentrantLock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+using decaf::lang::detail::futexWait;
+using decaf::lang::detail::futexWaitUntil;
+using detail::ConditionWaiter;
+
+ConditionObject::ConditionObject(ReentrantLock& lock) : m_lock(lock), m_head(0), m_tail(0) {
+}
+
+// -----------------------------------------------------------------------------
+
+ConditionObject::~ConditionObject() {
+}
+
+// -----------------------------------------------------------------------------
+
+void ConditionObject::await() {
+    awaitUntil(Deadline::never());
+}
+
+// -----------------------------------------------------------------------------
+
+bool ConditionObject::await(const uint64_t& t, const TimeUnit* unit) {
+    return awaitUntil(Deadline::after(t, unit));
+}
+
+// -----------------------------------------------------------------------------
+
+int64_t ConditionObject::awaitNanos(const uint64_t& nanosTimeout) {
+    const Deadline deadline = Deadline::afterNanos(nanosTimeout);
+    awaitUntil(deadline);
+    return deadline.remainingNanos();
+}
+
+// -----------------------------------------------------------------------------
+
+void ConditionObject::signal() {
+    checkHeld();
+
+    ConditionWaiter* waiter = m_head;
+    if (waiter == 0)
+        return;
+
+    m_head = waiter->m_next;
+    if (m_head == 0)
+        m_tail = 0;
+    waiter->m_next = 0;
+    m_lock.transfer(waiter, waiter);
+}
+
+// -----------------------------------------------------------------------------
+
+void ConditionObject::signalAll() {
+    checkHeld();
+
+    if (m_head == 0)
+        return;
+
+    m_lock.transfer(m_head, m_tail);
+    m_head = m_tail = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ConditionObject::awaitUntil(const Deadline& deadline) {
+    checkHeld();
+
+    struct timespec time;
+    const struct timespec* until = deadline.toTimespec(time);
+
+    ConditionWaiter waiter;
+    if (m_tail != 0)
+        m_tail->m_next = &waiter;
+    else
+        m_head = &waiter;
+    m_tail = &waiter;
+
+    const uint32_t holds = m_lock.release();
+
+    bool signalled = true;
+    while (waiter.m_wakeup.load(std::memory_order_acquire) == 0) {
+        if (!futexWaitUntil(waiter.m_wakeup, 0, until)) {
+            signalled = false;
+            break;
+        }
+    }
+
+    m_lock.acquire(holds);
+    if (signalled)
+        return true;
+
+    // Timed out, but a signal may have raced with the timeout; with the lock
+    // held again, find out where the waiter ended up.
+    switch (waiter.m_state) {
+      case ConditionWaiter::WAITING: {
+        ConditionWaiter* previous = 0;
+        for (ConditionWaiter* current = m_head; current != &waiter; current = current->m_next)
+            previous = current;
+        (previous != 0 ? previous->m_next : m_head) = waiter.m_next;
+        if (m_tail == &waiter)
+            m_tail = previous;
+        return false;
+      }
+
+      case ConditionWaiter::TRANSFERRED:
+        m_lock.untransfer(&waiter);
+        return true;
+
+      case ConditionWaiter::WOKEN:
+        // The releasing thread is about to set the futex: wait for it, since
+        // the waiter must outlive its last access.
+        while (waiter.m_wakeup.load(std::memory_order_acquire) == 0)
+            futexWait(waiter.m_wakeup, 0);
+        return true;
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void ConditionObject::checkHeld() const {
+    if (!m_lock.isHeldByCurrentThread())
+        throw lang::IllegalMonitorStateException("current thread does not hold the lock");
+}
+
+DECAF_CLOSE_NAMESPACE4
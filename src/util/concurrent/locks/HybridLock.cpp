@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/UnsupportedOperationException.hpp"
+#include "decaf/util/concurrent/locks/HybridLock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+using decaf::lang::detail::futexWaitUntil;
+
+HybridLock::~HybridLock() {
+}
+
+// -----------------------------------------------------------------------------
+
+bool HybridLock::tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return tryLockUntil(Deadline::after(t, timeUnit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool HybridLock::tryLockUntil(const Deadline& deadline) {
+    if (tryLock())
+        return true;
+    struct timespec time;
+    return lockSlow(deadline.toTimespec(time));
+}
+
+// -----------------------------------------------------------------------------
+
+Condition* HybridLock::newCondition() {
+    throw lang::UnsupportedOperationException("HybridLock does not support conditions");
+}
+
+// -----------------------------------------------------------------------------
+
+bool HybridLock::lockSlow(const struct timespec* deadline) {
+    uint32_t state = 0;
+    if (m_spin.spin([this, &state]() {
+          state = 0;
+          return (m_state.load(std::memory_order_relaxed) == 0 &&
+            m_state.compare_exchange_strong(state, 1, std::memory_order_acquire));
+      }))
+        return true;
+
+    // Sleep, leaving the state marked as having sleepers so that the release
+    // that lets this thread in wakes the next one.
+    if (state != 2)
+        state = m_state.exchange(2, std::memory_order_acquire);
+    while (state != 0) {
+        if (!futexWaitUntil(m_state, 2, deadline))
+            return false;
+        state = m_state.exchange(2, std::memory_order_acquire);
+    }
+    return true;
+}
+
+DECAF_CLOSE_NAMESPACE4
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/lang/UnsupportedOperationException.hpp"
+#include "decaf/util/concurrent/locks/MCSLock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+using decaf::lang::detail::SpinThenYield;
+using detail::MCSNode;
+
+/*
+ * Frees the cached nodes of an exiting thread. The nodes of locks the thread
+ * still holds are not in its cache, and go to the cache of whichever thread
+ * releases them.
+ */
+class MCSLock::NodeCacheReleaser {
+  public:
+    ~NodeCacheReleaser();
+};
+
+DECAF_THREAD_LOCAL MCSNode* MCSLock::t_freeNodes DECAF_INITIAL_EXEC_TLS = 0;
+
+// -----------------------------------------------------------------------------
+
+MCSLock::NodeCacheReleaser::~NodeCacheReleaser() {
+    MCSNode* node = t_freeNodes;
+    t_freeNodes = 0;
+    while (node != 0) {
+        MCSNode* next = node->m_next.load(std::memory_order_relaxed);
+        node->~MCSNode();
+        free(node);
+        node = next;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+MCSLock::~MCSLock() {
+}
+
+// -----------------------------------------------------------------------------
+
+bool MCSLock::tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return tryLockUntil(Deadline::after(t, timeUnit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool MCSLock::tryLockUntil(const Deadline& deadline) {
+    SpinThenYield backoff;
+    while (!tryLock()) {
+        if (deadline.hasPassed())
+            return false;
+        backoff.pause();
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+Condition* MCSLock::newCondition() {
+    throw lang::UnsupportedOperationException("MCSLock does not support conditions");
+}
+
+// -----------------------------------------------------------------------------
+
+MCSNode* MCSLock::allocateNode() {
+    static thread_local NodeCacheReleaser t_releaser;
+    (void) t_releaser;
+
+    void* memory;
+    if (posix_memalign(&memory, alignof(MCSNode), sizeof(MCSNode)) != 0)
+        throw std::bad_alloc();
+    MCSNode* node = new (memory) MCSNode;
+    node->m_next.store(0, std::memory_order_relaxed);
+    node->m_locked.store(1, std::memory_order_relaxed);
+    return node;
+}
+
+// -----------------------------------------------------------------------------
+
+void MCSLock::lockSlow(MCSNode* predecessor, MCSNode* node) {
+    predecessor->m_next.store(node, std::memory_order_release);
+
+    SpinThenYield backoff;
+    while (node->m_locked.load(std::memory_order_acquire) != 0)
+        backoff.pause();
+}
+
+// -----------------------------------------------------------------------------
+
+MCSNode* MCSLock::awaitSuccessor(MCSNode* node) {
+    // The successor swapped itself in as the tail but has yet to link
+    // itself: a window of a few instructions, unless it got preempted.
+    SpinThenYield backoff;
+    MCSNode* successor;
+    while ((successor = node->m_next.load(std::memory_order_acquire)) == 0)
+        backoff.pause();
+    return successor;
+}
+
+DECAF_CLOSE_NAMESPACE4
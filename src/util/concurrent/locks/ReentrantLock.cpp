@@ -15,63 +15,312 @@
  * limitations under the License.
  */
 
-#include <time.h>
-
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalMonitorStateException.hpp"
+#include "decaf/lang/ThreadRecord.hpp"
+#include "decaf/util/concurrent/locks/ConditionObject.hpp"
 #include "decaf/util/concurrent/locks/ReentrantLock.hpp"
 
 DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
 
-// -----------------------------------------------------------------------------
-
-ReentrantLock::ReentrantLock() {
-    pthread_mutexattr_init(&m_mutexAttr);
-    pthread_mutexattr_settype(&m_mutexAttr, PTHREAD_MUTEX_RECURSIVE);
+using decaf::lang::detail::ThreadRecord;
+using decaf::lang::detail::futexWaitUntil;
+using decaf::lang::detail::futexWake;
+using detail::ConditionWaiter;
+using detail::LockWaiter;
 
-    pthread_mutex_init(&m_mutex, &m_mutexAttr);
+ReentrantLock::ReentrantLock(bool fair) : m_state(0), m_fair(fair), m_owner(0), m_holdCount(0), m_queueLength(0),
+  m_queueHead(0), m_queueTail(0), m_transferredHead(0), m_transferredTail(0) {
 }
 
 // -----------------------------------------------------------------------------
 
 ReentrantLock::~ReentrantLock() {
-    pthread_mutex_unlock(&m_mutex);
-    
-    pthread_mutex_destroy(&m_mutex);
-    pthread_mutexattr_destroy(&m_mutexAttr);
 }
 
 // -----------------------------------------------------------------------------
 
 void ReentrantLock::lock() {
-    pthread_mutex_lock(&m_mutex);
+    const uint32_t self = ThreadRecord::current().id();
+    if (m_owner.load(std::memory_order_relaxed) == self) {
+        ++m_holdCount;
+        return;
+    }
+
+    if (m_fair) {
+        acquireFair(1, 0);
+        return;
+    }
+
+    if (!tryLockState())
+        lockState(0);
+    m_owner.store(self, std::memory_order_relaxed);
+    m_holdCount = 1;
 }
 
 // -----------------------------------------------------------------------------
 
 void ReentrantLock::unlock() {
-    pthread_mutex_unlock(&m_mutex);
+    if (!isHeldByCurrentThread())
+        throw lang::IllegalMonitorStateException("current thread does not hold the lock");
+
+    if (m_holdCount > 1) {
+        --m_holdCount;
+        return;
+    }
+
+    if (m_fair || m_transferredHead != 0) {
+        release();
+        return;
+    }
+
+    m_holdCount = 0;
+    m_owner.store(0, std::memory_order_relaxed);
+    unlockState();
 }
 
 // -----------------------------------------------------------------------------
 
 bool ReentrantLock::tryLock() {
-    return ((pthread_mutex_trylock(&m_mutex) == 0) ? true : false);
+    const uint32_t self = ThreadRecord::current().id();
+    if (m_owner.load(std::memory_order_relaxed) == self) {
+        ++m_holdCount;
+        return true;
+    }
+
+    if (m_fair) {
+        // The owner hands a fair lock straight over to the first thread in
+        // the queue, so the lock is only ever free with nobody queued.
+        lockState(0);
+        const bool acquired = (m_owner.load(std::memory_order_relaxed) == 0);
+        if (acquired)
+            m_owner.store(self, std::memory_order_relaxed);
+        unlockState();
+        if (!acquired)
+            return false;
+    } else if (tryLockState()) {
+        m_owner.store(self, std::memory_order_relaxed);
+    } else {
+        return false;
+    }
+
+    m_holdCount = 1;
+    return true;
 }
 
 // -----------------------------------------------------------------------------
 
 bool ReentrantLock::tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
-    uint64_t nanos = TimeUnit::NANOSECONDS->convert(t, timeUnit);
-    
-    struct timespec timeout { 0, 0 };
-    clock_gettime(CLOCK_REALTIME, &timeout);
-    
-    time_t sec { nanos / 1000000000 };
-    long   nsec { (((static_cast<double>(nanos) / static_cast<double>(1000000000)) - sec) * 1000000000) };
-    
-    timeout.tv_sec  += sec;
-    timeout.tv_nsec += nsec;
-    
-    return ((pthread_mutex_timedlock(&m_mutex, &timeout) == 0) ? true : false);
+    return tryLockUntil(Deadline::after(t, timeUnit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantLock::tryLockUntil(const Deadline& deadline) {
+    const uint32_t self = ThreadRecord::current().id();
+    if (m_owner.load(std::memory_order_relaxed) == self) {
+        ++m_holdCount;
+        return true;
+    }
+
+    struct timespec time;
+    const struct timespec* until = deadline.toTimespec(time);
+    if (m_fair)
+        return acquireFair(1, until);
+
+    if (!tryLockState() && !lockState(until))
+        return false;
+
+    m_owner.store(self, std::memory_order_relaxed);
+    m_holdCount = 1;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+Condition* ReentrantLock::newCondition() {
+    return new ConditionObject(*this);
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ReentrantLock::getHoldCount() const {
+    return isHeldByCurrentThread() ? m_holdCount : 0;
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantLock::acquire(uint32_t holds) {
+    if (m_fair) {
+        acquireFair(holds, 0);
+        return;
+    }
+
+    if (!tryLockState())
+        lockState(0);
+    m_owner.store(ThreadRecord::current().id(), std::memory_order_relaxed);
+    m_holdCount = holds;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantLock::acquireFair(uint32_t holds, const struct timespec* deadline) {
+    LockWaiter waiter(ThreadRecord::current().id());
+
+    lockState(0);
+    if (m_owner.load(std::memory_order_relaxed) == 0) {
+        m_owner.store(waiter.m_thread, std::memory_order_relaxed);
+        unlockState();
+        m_holdCount = holds;
+        return true;
+    }
+
+    if (m_queueTail != 0)
+        m_queueTail->m_next = &waiter;
+    else
+        m_queueHead = &waiter;
+    m_queueTail = &waiter;
+    m_queueLength.fetch_add(1, std::memory_order_relaxed);
+    unlockState();
+
+    bool acquired = true;
+    while (waiter.m_wakeup.load(std::memory_order_acquire) == 0) {
+        if (!futexWaitUntil(waiter.m_wakeup, 0, deadline)) {
+            acquired = false;
+            break;
+        }
+    }
+
+    if (!acquired) {
+        // The lock may have been handed over just as the wait timed out; the
+        // state settles which happened first.
+        lockState(0);
+        acquired = (waiter.m_wakeup.load(std::memory_order_relaxed) != 0);
+        if (!acquired) {
+            LockWaiter* previous = 0;
+            for (LockWaiter* current = m_queueHead; current != &waiter; current = current->m_next)
+                previous = current;
+            (previous != 0 ? previous->m_next : m_queueHead) = waiter.m_next;
+            if (m_queueTail == &waiter)
+                m_queueTail = previous;
+            m_queueLength.fetch_sub(1, std::memory_order_relaxed);
+        }
+        unlockState();
+        if (!acquired)
+            return false;
+    }
+
+    m_holdCount = holds;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ReentrantLock::release() {
+    const uint32_t holds = m_holdCount;
+    m_holdCount = 0;
+
+    // Only the owner touches the transferred list, the lock guards it.
+    ConditionWaiter* signalled = m_transferredHead;
+    if (signalled != 0) {
+        m_transferredHead = signalled->m_next;
+        if (m_transferredHead == 0)
+            m_transferredTail = 0;
+        signalled->m_state = ConditionWaiter::WOKEN;
+    }
+
+    LockWaiter* successor = 0;
+    if (m_fair) {
+        lockState(0);
+        if ((successor = m_queueHead) != 0) {
+            // Hand the lock over: it is never free while threads are queued,
+            // so no thread can barge in ahead of them.
+            m_queueHead = successor->m_next;
+            if (m_queueHead == 0)
+                m_queueTail = 0;
+            m_queueLength.fetch_sub(1, std::memory_order_relaxed);
+            m_owner.store(successor->m_thread, std::memory_order_relaxed);
+            successor->m_wakeup.store(1, std::memory_order_release);
+        } else {
+            m_owner.store(0, std::memory_order_relaxed);
+        }
+    } else {
+        m_owner.store(0, std::memory_order_relaxed);
+    }
+    unlockState();
+
+    // The successor may already have returned, and its waiter be gone: a
+    // futex wake of a stale address is harmless, at worst a spurious wake-up.
+    if (successor != 0)
+        futexWake(successor->m_wakeup, 1);
+
+    // Wake the signalled thread only once the lock is free, so that it does
+    // not go straight back to sleep on it. A WOKEN waiter that timed out
+    // meanwhile waits for this store before it returns, keeping its futex
+    // alive.
+    if (signalled != 0) {
+        signalled->m_wakeup.store(1, std::memory_order_release);
+        futexWake(signalled->m_wakeup, 1);
+    }
+    return holds;
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantLock::transfer(ConditionWaiter* first, ConditionWaiter* last) {
+    for (ConditionWaiter* waiter = first; waiter != 0; waiter = waiter->m_next)
+        waiter->m_state = ConditionWaiter::TRANSFERRED;
+
+    if (m_transferredTail != 0)
+        m_transferredTail->m_next = first;
+    else
+        m_transferredHead = first;
+    m_transferredTail = last;
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantLock::untransfer(ConditionWaiter* waiter) {
+    ConditionWaiter* previous = 0;
+    for (ConditionWaiter* current = m_transferredHead; current != waiter; current = current->m_next)
+        previous = current;
+
+    (previous != 0 ? previous->m_next : m_transferredHead) = waiter->m_next;
+    if (m_transferredTail == waiter)
+        m_transferredTail = previous;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantLock::lockState(const struct timespec* deadline) {
+    uint32_t state = 0;
+    if (m_state.compare_exchange_strong(state, 1, std::memory_order_acquire))
+        return true;
+
+    if (m_spin.spin([this, &state]() {
+          state = 0;
+          return (m_state.load(std::memory_order_relaxed) == 0 &&
+            m_state.compare_exchange_strong(state, 1, std::memory_order_acquire));
+      }))
+        return true;
+
+    // Sleep, leaving the state marked as having sleepers so that the release
+    // that lets this thread in wakes the next one. Threads queueing for the
+    // guard of a fair lock are not waiting for the lock itself.
+    const uint32_t queued = m_fair ? 0 : 1;
+    m_queueLength.fetch_add(queued, std::memory_order_relaxed);
+    bool acquired = true;
+    if (state != 2)
+        state = m_state.exchange(2, std::memory_order_acquire);
+    while (state != 0) {
+        if (!futexWaitUntil(m_state, 2, deadline)) {
+            acquired = false;
+            break;
+        }
+        state = m_state.exchange(2, std::memory_order_acquire);
+    }
+    m_queueLength.fetch_sub(queued, std::memory_order_relaxed);
+    return acquired;
 }
 
-DECAF_CLOSE_NAMESPACE4
\ No newline at end of file
+DECAF_CLOSE_NAMESPACE4
@@ -0,0 +1,551 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <time.h>
+#include <vector>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalMonitorStateException.hpp"
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/lang/ThreadRecord.hpp"
+#include "decaf/lang/UnsupportedOperationException.hpp"
+#include "decaf/util/concurrent/locks/ReentrantReadWriteLock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+using decaf::lang::detail::ThreadRecord;
+
+namespace {
+
+/*
+ * The table of visible readers, shared by every lock: 4096 slots of 8 bytes,
+ * as in the BRAVO paper. A slot holds the lock its reader has read-locked.
+ */
+const uint32_t VISIBLE_READERS_BITS = 12;
+const uint32_t VISIBLE_READERS = 1u << VISIBLE_READERS_BITS;
+const uint32_t NO_SLOT = UINT32_MAX;
+
+alignas(64) std::atomic<const void*> s_visibleReaders[VISIBLE_READERS];
+
+/*
+ * How many times longer than the last revocation took readers must do
+ * without the bias before it is restored.
+ */
+const uint64_t INHIBIT_MULTIPLIER = 9;
+
+/*
+ * Without asymmetric barriers, a reader leaving may miss the writer waiting
+ * for it, which then sleeps for increasingly long periods in between scans.
+ */
+const uint64_t MIN_REVOCATION_NAP = 1000;
+const uint64_t MAX_REVOCATION_NAP = 1000000;
+
+/*
+ * The read locks the current thread holds, and how: in a visible slot, or
+ * counted centrally (NO_SLOT). Threads rarely hold more than a few, which fit
+ * in a plain array: a thread_local of a POD type needs no guard on access.
+ * Further ones spill over to a vector.
+ */
+struct ReadHold {
+    const void* m_lock;
+    uint32_t m_count;
+    uint32_t m_slot;
+};
+
+thread_local std::vector<ReadHold> t_spilledReadHolds;
+
+struct ReadHolds {
+    static const uint32_t INLINE_HOLDS = 8;
+
+    ReadHold m_holds[INLINE_HOLDS];
+    uint32_t m_size;
+    bool m_spilled;
+
+    /*
+     * The ThreadRecord identifier of the thread, cached here to save a second
+     * thread_local lookup on the fast path.
+     */
+    uint32_t m_thread;
+
+    uint32_t thread() {
+        if (m_thread == 0)
+            m_thread = ThreadRecord::current().id();
+        return m_thread;
+    }
+
+    ReadHold* find(const void* lock) {
+        for (uint32_t i = m_size; i-- > 0;) {
+            if (m_holds[i].m_lock == lock)
+                return &m_holds[i];
+        }
+
+        if (m_spilled) {
+            for (std::vector<ReadHold>::iterator hold = t_spilledReadHolds.begin(); hold != t_spilledReadHolds.end(); ++hold) {
+                if (hold->m_lock == lock)
+                    return &*hold;
+            }
+        }
+        return 0;
+    }
+
+    void add(const void* lock, uint32_t slot) {
+        const ReadHold hold = { lock, 1, slot };
+        if (m_size < INLINE_HOLDS) {
+            m_holds[m_size++] = hold;
+        } else {
+            t_spilledReadHolds.push_back(hold);
+            m_spilled = true;
+        }
+    }
+
+    void remove(ReadHold* hold) {
+        if (hold >= m_holds && hold < m_holds + INLINE_HOLDS) {
+            *hold = m_holds[--m_size];
+        } else {
+            *hold = t_spilledReadHolds.back();
+            t_spilledReadHolds.pop_back();
+            m_spilled = !t_spilledReadHolds.empty();
+        }
+    }
+};
+
+thread_local ReadHolds t_readHolds;
+
+uint32_t slotOf(const void* lock, uint32_t thread) {
+    const uint64_t hash = (reinterpret_cast<uintptr_t> (lock) + thread * 0x9e3779b97f4a7c15ull) * 0xbf58476d1ce4e5b9ull;
+    return static_cast<uint32_t> (hash >> (64 - VISIBLE_READERS_BITS));
+}
+
+bool isBefore(const struct timespec& a, const struct timespec& b) {
+    return a.tv_sec < b.tv_sec || (a.tv_sec == b.tv_sec && a.tv_nsec < b.tv_nsec);
+}
+
+bool hasPassed(const struct timespec* deadline) {
+    if (deadline == 0)
+        return false;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec > deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec >= deadline->tv_nsec);
+}
+
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantReadWriteLock::ReadLock::lock() {
+    ReadHolds& holds = t_readHolds;
+    if (ReadHold* hold = holds.find(&m_lock)) {
+        ++hold->m_count;
+        return;
+    }
+
+    uint32_t slot;
+    m_lock.acquireRead(holds.thread(), 0, false, slot);
+    holds.add(&m_lock, slot);
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantReadWriteLock::ReadLock::unlock() {
+    ReadHolds& holds = t_readHolds;
+    ReadHold* hold = holds.find(&m_lock);
+    if (hold == 0)
+        throw lang::IllegalMonitorStateException("current thread does not hold the read lock");
+
+    if (--hold->m_count > 0)
+        return;
+
+    const uint32_t slot = hold->m_slot;
+    holds.remove(hold);
+    m_lock.releaseRead(slot);
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::ReadLock::tryLock() {
+    ReadHolds& holds = t_readHolds;
+    if (ReadHold* hold = holds.find(&m_lock)) {
+        ++hold->m_count;
+        return true;
+    }
+
+    uint32_t slot;
+    if (!m_lock.acquireRead(holds.thread(), 0, true, slot))
+        return false;
+    holds.add(&m_lock, slot);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::ReadLock::tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return tryLockUntil(Deadline::after(t, timeUnit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::ReadLock::tryLockUntil(const Deadline& deadline) {
+    if (ReadHold* hold = t_readHolds.find(&m_lock)) {
+        ++hold->m_count;
+        return true;
+    }
+
+    struct timespec time;
+    uint32_t slot;
+    if (!m_lock.acquireRead(t_readHolds.thread(), deadline.toTimespec(time), false, slot))
+        return false;
+    t_readHolds.add(&m_lock, slot);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+Condition* ReentrantReadWriteLock::ReadLock::newCondition() {
+    throw lang::UnsupportedOperationException("read locks do not support conditions");
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantReadWriteLock::WriteLock::lock() {
+    if (m_lock.isWriteLockedByCurrentThread()) {
+        ++m_lock.m_writeHolds;
+        return;
+    }
+    m_lock.acquireWrite(0, false);
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantReadWriteLock::WriteLock::unlock() {
+    if (!m_lock.isWriteLockedByCurrentThread())
+        throw lang::IllegalMonitorStateException("current thread does not hold the write lock");
+
+    if (--m_lock.m_writeHolds > 0)
+        return;
+    m_lock.releaseWrite();
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::WriteLock::tryLock() {
+    if (m_lock.isWriteLockedByCurrentThread()) {
+        ++m_lock.m_writeHolds;
+        return true;
+    }
+    return m_lock.acquireWrite(0, true);
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::WriteLock::tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return tryLockUntil(Deadline::after(t, timeUnit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::WriteLock::tryLockUntil(const Deadline& deadline) {
+    if (m_lock.isWriteLockedByCurrentThread()) {
+        ++m_lock.m_writeHolds;
+        return true;
+    }
+
+    struct timespec time;
+    return m_lock.acquireWrite(deadline.toTimespec(time), false);
+}
+
+// -----------------------------------------------------------------------------
+
+Condition* ReentrantReadWriteLock::WriteLock::newCondition() {
+    throw lang::UnsupportedOperationException("ReentrantReadWriteLock does not support conditions");
+}
+
+// -----------------------------------------------------------------------------
+
+ReentrantReadWriteLock::ReentrantReadWriteLock() : m_readBias(true), m_inhibitUntil(0), m_writer(0),
+  m_writeHolds(0), m_sharedReaders(0), m_waitingReaders(0), m_waitingWriters(0), m_readersWakeup(0),
+  m_writersWakeup(0), m_revoking(false), m_revocationWakeup(0), m_readLock(*this), m_writeLock(*this) {
+    pthread_mutex_init(&m_mutex, 0);
+}
+
+// -----------------------------------------------------------------------------
+
+ReentrantReadWriteLock::~ReentrantReadWriteLock() {
+    pthread_mutex_destroy(&m_mutex);
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::isWriteLockedByCurrentThread() const {
+    return m_writer.load(std::memory_order_relaxed) == ThreadRecord::current().id();
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ReentrantReadWriteLock::getWriteHoldCount() const {
+    return isWriteLockedByCurrentThread() ? m_writeHolds : 0;
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ReentrantReadWriteLock::getReadHoldCount() const {
+    const ReadHold* hold = t_readHolds.find(this);
+    return hold != 0 ? hold->m_count : 0;
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ReentrantReadWriteLock::getReadLockCount() const {
+    uint32_t readers = 0;
+    for (uint32_t slot = 0; slot < VISIBLE_READERS; ++slot) {
+        if (s_visibleReaders[slot].load(std::memory_order_relaxed) == this)
+            ++readers;
+    }
+
+    pthread_mutex_t* mutex = const_cast<pthread_mutex_t*> (&m_mutex);
+    pthread_mutex_lock(mutex);
+    readers += m_sharedReaders;
+    pthread_mutex_unlock(mutex);
+    return readers;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::acquireRead(uint32_t self, const struct timespec* deadline, bool tryOnly,
+  uint32_t& slot) {
+    slot = enterVisible(self);
+    if (slot != NO_SLOT)
+        return true;
+
+    pthread_mutex_lock(&m_mutex);
+    // Unless it already holds the write lock, a new reader lets waiting
+    // writers go first, so that a steady flow of readers cannot starve them;
+    // tryLock() barges in regardless.
+    bool blocked, timedOut = false;
+    while ((blocked = (m_writer.load(std::memory_order_relaxed) != 0 ||
+      (!tryOnly && m_waitingWriters.load(std::memory_order_relaxed) != 0)) &&
+      m_writer.load(std::memory_order_relaxed) != self) && !tryOnly && !timedOut)
+        timedOut = !waitLocked(m_readersWakeup, m_waitingReaders, deadline);
+
+    if (blocked) {
+        std::atomic<uint32_t>* wakeup = nextWakeupLocked();
+        pthread_mutex_unlock(&m_mutex);
+        wake(wakeup);
+        return false;
+    }
+
+    ++m_sharedReaders;
+    if (m_writer.load(std::memory_order_relaxed) == 0 && !m_readBias.load(std::memory_order_relaxed) &&
+      Deadline::now() >= m_inhibitUntil.load(std::memory_order_relaxed))
+        m_readBias.store(true, std::memory_order_relaxed);
+    pthread_mutex_unlock(&m_mutex);
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantReadWriteLock::releaseRead(uint32_t slot) {
+    if (slot != NO_SLOT) {
+        leaveVisible(slot);
+        return;
+    }
+
+    pthread_mutex_lock(&m_mutex);
+    std::atomic<uint32_t>* wakeup = (--m_sharedReaders == 0) ? nextWakeupLocked() : 0;
+    pthread_mutex_unlock(&m_mutex);
+    wake(wakeup);
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::acquireWrite(const struct timespec* deadline, bool tryOnly) {
+    const uint32_t self = ThreadRecord::current().id();
+
+    pthread_mutex_lock(&m_mutex);
+    bool blocked, timedOut = false;
+    while ((blocked = (m_writer.load(std::memory_order_relaxed) != 0 || m_sharedReaders != 0)) && !tryOnly && !timedOut)
+        timedOut = !waitLocked(m_writersWakeup, m_waitingWriters, deadline);
+
+    if (blocked) {
+        // Pass on a wake-up this thread may have taken from another writer.
+        std::atomic<uint32_t>* wakeup = nextWakeupLocked();
+        pthread_mutex_unlock(&m_mutex);
+        wake(wakeup);
+        return false;
+    }
+
+    m_writer.store(self, std::memory_order_relaxed);
+    m_writeHolds = 1;
+    const bool biased = m_readBias.load(std::memory_order_relaxed);
+    if (biased)
+        m_readBias.store(false, std::memory_order_seq_cst);
+    pthread_mutex_unlock(&m_mutex);
+
+    if (!biased)
+        return true;
+
+    const uint64_t start = Deadline::now();
+    if (revokeBias(deadline, tryOnly)) {
+        const uint64_t end = Deadline::now();
+        m_inhibitUntil.store(end + (end - start) * INHIBIT_MULTIPLIER, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Readers are still in: give up the lock, and the bias back to them.
+    pthread_mutex_lock(&m_mutex);
+    m_writer.store(0, std::memory_order_relaxed);
+    m_writeHolds = 0;
+    m_readBias.store(true, std::memory_order_relaxed);
+    std::atomic<uint32_t>* wakeup = nextWakeupLocked();
+    pthread_mutex_unlock(&m_mutex);
+    wake(wakeup);
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantReadWriteLock::releaseWrite() {
+    pthread_mutex_lock(&m_mutex);
+    m_writer.store(0, std::memory_order_relaxed);
+    std::atomic<uint32_t>* wakeup = nextWakeupLocked();
+    pthread_mutex_unlock(&m_mutex);
+    wake(wakeup);
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t ReentrantReadWriteLock::enterVisible(uint32_t self) {
+    if (!m_readBias.load(std::memory_order_relaxed))
+        return NO_SLOT;
+
+    const uint32_t slot = slotOf(this, self);
+    const void* expected = 0;
+    if (!s_visibleReaders[slot].compare_exchange_strong(expected, this, std::memory_order_seq_cst))
+        return NO_SLOT;
+
+    // Dekker-style: either the writer sees the slot when it scans the table,
+    // or this reader sees the bias revoked.
+    if (m_readBias.load(std::memory_order_seq_cst))
+        return slot;
+
+    leaveVisible(slot);
+    return NO_SLOT;
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantReadWriteLock::leaveVisible(uint32_t slot) {
+    s_visibleReaders[slot].store(0, std::memory_order_release);
+
+    // Pairs with the asymmetric barrier in revokeBias(): either the writer
+    // sees the slot empty, or this reader sees it waiting.
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    if (m_revoking.load(std::memory_order_relaxed)) {
+        m_revocationWakeup.fetch_add(1, std::memory_order_release);
+        lang::detail::futexWake(m_revocationWakeup, 1);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::revokeBias(const struct timespec* deadline, bool tryOnly) {
+    bool revoked = true;
+    for (uint32_t slot = 0; slot < VISIBLE_READERS && revoked; ++slot) {
+        lang::detail::SpinWait spin;
+        uint64_t nap = MIN_REVOCATION_NAP;
+        for (;;) {
+            const uint32_t sequence = m_revocationWakeup.load(std::memory_order_acquire);
+            if (s_visibleReaders[slot].load(std::memory_order_seq_cst) != this)
+                break;
+            if (tryOnly || hasPassed(deadline)) {
+                revoked = false;
+                break;
+            }
+            if (spin.pauses() < lang::detail::SpinWait::MAX_PAUSES && lang::detail::isSpinningUseful()) {
+                spin.spinOnce();
+                continue;
+            }
+
+            // A long read-side critical section: ask the readers to wake us
+            // as they leave, and scan the slot again before sleeping.
+            if (!m_revoking.load(std::memory_order_relaxed)) {
+                m_revoking.store(true, std::memory_order_seq_cst);
+                if (ThreadRecord::hasAsymmetricBarrier())
+                    ThreadRecord::asymmetricBarrier();
+                continue;
+            }
+
+            struct timespec time;
+            const struct timespec* until = deadline;
+            if (!ThreadRecord::hasAsymmetricBarrier()) {
+                const struct timespec* wakeup = Deadline::afterNanos(nap).toTimespec(time);
+                if (deadline == 0 || isBefore(*wakeup, *deadline))
+                    until = wakeup;
+                nap = std::min(nap * 2, MAX_REVOCATION_NAP);
+            }
+            lang::detail::futexWaitUntil(m_revocationWakeup, sequence, until);
+        }
+    }
+
+    m_revoking.store(false, std::memory_order_relaxed);
+    return revoked;
+}
+
+// -----------------------------------------------------------------------------
+
+bool ReentrantReadWriteLock::waitLocked(std::atomic<uint32_t>& wakeup, std::atomic<uint32_t>& waiting,
+  const struct timespec* deadline) {
+    const uint32_t sequence = wakeup.load(std::memory_order_relaxed);
+    waiting.fetch_add(1, std::memory_order_relaxed);
+    pthread_mutex_unlock(&m_mutex);
+
+    const bool woken = lang::detail::futexWaitUntil(wakeup, sequence, deadline);
+
+    pthread_mutex_lock(&m_mutex);
+    waiting.fetch_sub(1, std::memory_order_relaxed);
+    return woken;
+}
+
+// -----------------------------------------------------------------------------
+
+std::atomic<uint32_t>* ReentrantReadWriteLock::nextWakeupLocked() {
+    if (m_writer.load(std::memory_order_relaxed) != 0)
+        return 0;
+
+    std::atomic<uint32_t>* wakeup = 0;
+    if (m_waitingWriters.load(std::memory_order_relaxed) != 0) {
+        if (m_sharedReaders == 0)
+            wakeup = &m_writersWakeup;
+    } else if (m_waitingReaders.load(std::memory_order_relaxed) != 0) {
+        wakeup = &m_readersWakeup;
+    }
+
+    if (wakeup != 0)
+        wakeup->fetch_add(1, std::memory_order_relaxed);
+    return wakeup;
+}
+
+// -----------------------------------------------------------------------------
+
+void ReentrantReadWriteLock::wake(std::atomic<uint32_t>* wakeup) {
+    if (wakeup != 0)
+        lang::detail::futexWake(*wakeup, wakeup == &m_writersWakeup ? 1 : INT_MAX);
+}
+
+DECAF_CLOSE_NAMESPACE4
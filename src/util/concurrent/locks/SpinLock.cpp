@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/lang/UnsupportedOperationException.hpp"
+#include "decaf/util/concurrent/locks/SpinLock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+using decaf::lang::detail::SpinThenYield;
+
+SpinLock::~SpinLock() {
+}
+
+// -----------------------------------------------------------------------------
+
+bool SpinLock::tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return tryLockUntil(Deadline::after(t, timeUnit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool SpinLock::tryLockUntil(const Deadline& deadline) {
+    SpinThenYield backoff;
+    while (!tryLock()) {
+        if (deadline.hasPassed())
+            return false;
+        backoff.pause();
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+Condition* SpinLock::newCondition() {
+    throw lang::UnsupportedOperationException("SpinLock does not support conditions");
+}
+
+// -----------------------------------------------------------------------------
+
+void SpinLock::lockSlow() {
+    SpinThenYield backoff;
+    do {
+        // Spin on reads, which do not take the cache line away from the
+        // holder, until the lock looks free.
+        while (m_locked.load(std::memory_order_relaxed))
+            backoff.pause();
+    } while (m_locked.exchange(true, std::memory_order_acquire));
+}
+
+DECAF_CLOSE_NAMESPACE4
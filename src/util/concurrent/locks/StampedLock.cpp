@@ -0,0 +1,368 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <climits>
+
+#include "decaf/lang/Futex.hpp"
+#include "decaf/lang/IllegalMonitorStateException.hpp"
+#include "decaf/lang/UnsupportedOperationException.hpp"
+#include "decaf/util/concurrent/locks/StampedLock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+StampedLock::StampedLock() : m_state(ORIGIN), m_waiters(0), m_wakeup(0), m_readLockView(*this),
+  m_writeLockView(*this), m_readWriteLockView(*this) {
+}
+
+// -----------------------------------------------------------------------------
+
+StampedLock::~StampedLock() {
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::writeLock() {
+    const uint64_t stamp = tryAcquireWrite();
+    return (stamp != 0) ? stamp : acquire(true, 0);
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryWriteLock() {
+    return tryAcquireWrite();
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryWriteLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return tryWriteLockUntil(Deadline::after(t, timeUnit));
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryWriteLockUntil(const Deadline& deadline) {
+    const uint64_t stamp = tryAcquireWrite();
+    if (stamp != 0)
+        return stamp;
+
+    struct timespec time;
+    return acquire(true, deadline.toTimespec(time));
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::readLock() {
+    const uint64_t stamp = tryAcquireRead();
+    return (stamp != 0) ? stamp : acquire(false, 0);
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryReadLock() {
+    return tryAcquireRead();
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryReadLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return tryReadLockUntil(Deadline::after(t, timeUnit));
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryReadLockUntil(const Deadline& deadline) {
+    const uint64_t stamp = tryAcquireRead();
+    if (stamp != 0)
+        return stamp;
+
+    struct timespec time;
+    return acquire(false, deadline.toTimespec(time));
+}
+
+// -----------------------------------------------------------------------------
+
+void StampedLock::unlockWrite(uint64_t stamp) {
+    const uint64_t state = m_state.load(std::memory_order_relaxed);
+    if ((stamp & WBIT) == 0 || (state & SBITS) != (stamp & SBITS))
+        throw lang::IllegalMonitorStateException("stamp does not match a write lock held on this lock");
+
+    // Clears WBIT and, by carrying over it, increments the version.
+    m_state.fetch_add(WBIT, std::memory_order_seq_cst);
+    signalWaiters();
+}
+
+// -----------------------------------------------------------------------------
+
+void StampedLock::unlockRead(uint64_t stamp) {
+    const uint64_t state = m_state.load(std::memory_order_relaxed);
+    if ((stamp & RBITS) == 0 || (state & RBITS) == 0 || (state & SBITS) != (stamp & SBITS))
+        throw lang::IllegalMonitorStateException("stamp does not match a read lock held on this lock");
+
+    const uint64_t readers = m_state.fetch_sub(1, std::memory_order_seq_cst) & RBITS;
+    if (readers == 1 || readers == RFULL)
+        signalWaiters();
+}
+
+// -----------------------------------------------------------------------------
+
+void StampedLock::unlock(uint64_t stamp) {
+    if ((stamp & WBIT) != 0)
+        unlockWrite(stamp);
+    else
+        unlockRead(stamp);
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryConvertToWriteLock(uint64_t stamp) {
+    uint64_t state = m_state.load(std::memory_order_relaxed);
+    for (;;) {
+        if ((state & SBITS) != (stamp & SBITS))
+            return 0;
+        if ((stamp & WBIT) != 0)
+            return stamp;
+
+        // From a read lock, the caller's must be the only read hold; from an
+        // optimistic read, there must be none.
+        const uint64_t ownHolds = ((stamp & RBITS) != 0) ? 1 : 0;
+        if ((state & RBITS) != ownHolds)
+            return 0;
+
+        const uint64_t next = ((state - ownHolds) | WBIT) & ~WWAIT;
+        if (m_state.compare_exchange_weak(state, next, std::memory_order_seq_cst))
+            return next;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryConvertToReadLock(uint64_t stamp) {
+    uint64_t state = m_state.load(std::memory_order_relaxed);
+    for (;;) {
+        if ((state & SBITS) != (stamp & SBITS))
+            return 0;
+
+        if ((stamp & WBIT) != 0) {
+            // Releases the write lock, bumping the version, and takes a read
+            // hold in the same step.
+            const uint64_t next = state + WBIT + 1;
+            if (m_state.compare_exchange_weak(state, next, std::memory_order_seq_cst)) {
+                signalWaiters();
+                return next & ~WWAIT;
+            }
+        } else if ((stamp & RBITS) != 0) {
+            return stamp;
+        } else {
+            if ((state & RBITS) >= RFULL)
+                return 0;
+            const uint64_t next = state + 1;
+            if (m_state.compare_exchange_weak(state, next, std::memory_order_seq_cst))
+                return next & ~WWAIT;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryConvertToOptimisticRead(uint64_t stamp) {
+    const uint64_t state = m_state.load(std::memory_order_acquire);
+    if ((state & SBITS) != (stamp & SBITS))
+        return 0;
+
+    if ((stamp & WBIT) != 0) {
+        const uint64_t next = m_state.fetch_add(WBIT, std::memory_order_seq_cst) + WBIT;
+        signalWaiters();
+        return next & SBITS;
+    }
+
+    if ((stamp & RBITS) != 0) {
+        const uint64_t previous = m_state.fetch_sub(1, std::memory_order_seq_cst);
+        if ((previous & RBITS) == 1 || (previous & RBITS) == RFULL)
+            signalWaiters();
+        return previous & SBITS;
+    }
+    return stamp;
+}
+
+// -----------------------------------------------------------------------------
+
+bool StampedLock::tryUnlockWrite() {
+    if ((m_state.load(std::memory_order_relaxed) & WBIT) == 0)
+        return false;
+
+    m_state.fetch_add(WBIT, std::memory_order_seq_cst);
+    signalWaiters();
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+bool StampedLock::tryUnlockRead() {
+    uint64_t state = m_state.load(std::memory_order_relaxed);
+    do {
+        if ((state & RBITS) == 0)
+            return false;
+    } while (!m_state.compare_exchange_weak(state, state - 1, std::memory_order_seq_cst));
+
+    if ((state & RBITS) == 1 || (state & RBITS) == RFULL)
+        signalWaiters();
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryAcquireWrite() {
+    uint64_t state = m_state.load(std::memory_order_relaxed);
+    while ((state & (WBIT | RBITS)) == 0) {
+        const uint64_t next = (state | WBIT) & ~WWAIT;
+        if (m_state.compare_exchange_weak(state, next, std::memory_order_seq_cst))
+            return next;
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::tryAcquireRead() {
+    uint64_t state = m_state.load(std::memory_order_relaxed);
+    while ((state & (WBIT | WWAIT)) == 0 && (state & RBITS) < RFULL) {
+        if (m_state.compare_exchange_weak(state, state + 1, std::memory_order_seq_cst))
+            return state + 1;
+    }
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+
+uint64_t StampedLock::acquire(bool write, const struct timespec* deadline) {
+    uint64_t stamp = 0;
+    if (m_spin.spin([&]() { return (stamp = write ? tryAcquireWrite() : tryAcquireRead()) != 0; }))
+        return stamp;
+
+    for (;;) {
+        // Announce this thread before checking the state one last time, so
+        // that a release either lets it in or sees it and wakes it up.
+        m_waiters.fetch_add(1, std::memory_order_seq_cst);
+        if (write)
+            m_state.fetch_or(WWAIT, std::memory_order_seq_cst);
+        const uint32_t sequence = m_wakeup.load(std::memory_order_seq_cst);
+
+        stamp = write ? tryAcquireWrite() : tryAcquireRead();
+        const bool timedOut = (stamp == 0 && !lang::detail::futexWaitUntil(m_wakeup, sequence, deadline));
+        m_waiters.fetch_sub(1, std::memory_order_relaxed);
+
+        if (stamp == 0 && !timedOut)
+            stamp = write ? tryAcquireWrite() : tryAcquireRead();
+        if (stamp != 0)
+            return stamp;
+
+        if (timedOut) {
+            if (write) {
+                // Let the readers this writer held back in; writers still
+                // waiting set the bit again once woken.
+                m_state.fetch_and(~WWAIT, std::memory_order_seq_cst);
+                signalWaiters();
+            }
+            return 0;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void StampedLock::signalWaiters() {
+    if (m_waiters.load(std::memory_order_seq_cst) != 0) {
+        m_wakeup.fetch_add(1, std::memory_order_seq_cst);
+        lang::detail::futexWake(m_wakeup, INT_MAX);
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+void StampedLock::ReadLockView::lock() {
+    m_lock.readLock();
+}
+
+// -----------------------------------------------------------------------------
+
+void StampedLock::ReadLockView::unlock() {
+    if (!m_lock.tryUnlockRead())
+        throw lang::IllegalMonitorStateException("the lock is not read locked");
+}
+
+// -----------------------------------------------------------------------------
+
+bool StampedLock::ReadLockView::tryLock() {
+    return m_lock.tryReadLock() != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+bool StampedLock::ReadLockView::tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return m_lock.tryReadLock(t, timeUnit) != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+bool StampedLock::ReadLockView::tryLockUntil(const Deadline& deadline) {
+    return m_lock.tryReadLockUntil(deadline) != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+Condition* StampedLock::ReadLockView::newCondition() {
+    throw lang::UnsupportedOperationException("StampedLock does not support conditions");
+}
+
+// -----------------------------------------------------------------------------
+
+void StampedLock::WriteLockView::lock() {
+    m_lock.writeLock();
+}
+
+// -----------------------------------------------------------------------------
+
+void StampedLock::WriteLockView::unlock() {
+    if (!m_lock.tryUnlockWrite())
+        throw lang::IllegalMonitorStateException("the lock is not write locked");
+}
+
+// -----------------------------------------------------------------------------
+
+bool StampedLock::WriteLockView::tryLock() {
+    return m_lock.tryWriteLock() != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+bool StampedLock::WriteLockView::tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return m_lock.tryWriteLock(t, timeUnit) != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+bool StampedLock::WriteLockView::tryLockUntil(const Deadline& deadline) {
+    return m_lock.tryWriteLockUntil(deadline) != 0;
+}
+
+// -----------------------------------------------------------------------------
+
+Condition* StampedLock::WriteLockView::newCondition() {
+    throw lang::UnsupportedOperationException("StampedLock does not support conditions");
+}
+
+DECAF_CLOSE_NAMESPACE4
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2014, Janvier D. Anonical. All rights reserved.
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "decaf/lang/SpinWait.hpp"
+#include "decaf/lang/UnsupportedOperationException.hpp"
+#include "decaf/util/concurrent/locks/TicketLock.hpp"
+
+DECAF_OPEN_NAMESPACE4(decaf, util, concurrent, locks)
+
+using decaf::lang::detail::SpinThenYield;
+using decaf::lang::detail::cpuRelax;
+using decaf::lang::detail::isSpinningUseful;
+
+namespace {
+
+/*
+ * How long, in pauses, a waiter expects each thread ahead of it to hold the
+ * lock: a short critical section.
+ */
+const uint32_t PAUSES_PER_HOLDER = 32;
+
+}
+
+// -----------------------------------------------------------------------------
+
+TicketLock::~TicketLock() {
+}
+
+// -----------------------------------------------------------------------------
+
+bool TicketLock::tryLock(const uint64_t& t, const TimeUnit* timeUnit) {
+    return tryLockUntil(Deadline::after(t, timeUnit));
+}
+
+// -----------------------------------------------------------------------------
+
+bool TicketLock::tryLockUntil(const Deadline& deadline) {
+    SpinThenYield backoff;
+    while (!tryLock()) {
+        if (deadline.hasPassed())
+            return false;
+        backoff.pause();
+    }
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+
+Condition* TicketLock::newCondition() {
+    throw lang::UnsupportedOperationException("TicketLock does not support conditions");
+}
+
+// -----------------------------------------------------------------------------
+
+void TicketLock::lockSlow(uint32_t ticket) {
+    const bool proportional = isSpinningUseful();
+    SpinThenYield backoff;
+    for (uint32_t serving; (serving = m_serving.load(std::memory_order_acquire)) != ticket; ) {
+        // Every thread ahead but the holder has a critical section to go
+        // through before this one's turn: sit those out without touching the
+        // lock, whose cache line each release invalidates.
+        if (proportional) {
+            for (uint32_t pauses = (ticket - serving - 1) * PAUSES_PER_HOLDER; pauses > 0; --pauses)
+                cpuRelax();
+        }
+        backoff.pause();
+    }
+}
+
+DECAF_CLOSE_NAMESPACE4